@@ -649,7 +649,7 @@ void ScintillaGTK::Init() {
 		caret.period = 0;
 	}
 
-	for (TickReason tr = tickCaret; tr <= tickDwell; tr = static_cast<TickReason>(tr + 1)) {
+	for (TickReason tr = tickCaret; tr <= tickStyleAhead; tr = static_cast<TickReason>(tr + 1)) {
 		timers[tr].reason = tr;
 		timers[tr].scintilla = this;
 	}
@@ -660,7 +660,7 @@ void ScintillaGTK::Init() {
 }
 
 void ScintillaGTK::Finalise() {
-	for (TickReason tr = tickCaret; tr <= tickDwell; tr = static_cast<TickReason>(tr + 1)) {
+	for (TickReason tr = tickCaret; tr <= tickStyleAhead; tr = static_cast<TickReason>(tr + 1)) {
 		FineTickerCancel(tr);
 	}
 	if (accessible) {
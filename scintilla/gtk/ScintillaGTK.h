@@ -102,7 +102,7 @@ private:
 		guint timer;
 		TimeThunk() noexcept : reason(tickCaret), scintilla(nullptr), timer(0) {}
 	};
-	TimeThunk timers[tickDwell+1];
+	TimeThunk timers[tickStyleAhead+1];
 	bool FineTickerRunning(TickReason reason) override;
 	void FineTickerStart(TickReason reason, int millis, int tolerance) override;
 	void FineTickerCancel(TickReason reason) override;
@@ -549,6 +549,7 @@ typedef sptr_t (*SciFnDirect)(sptr_t ptr, unsigned int iMessage, uptr_t wParam,
 #define SC_IDLESTYLING_TOVISIBLE 1
 #define SC_IDLESTYLING_AFTERVISIBLE 2
 #define SC_IDLESTYLING_ALL 3
+#define SC_IDLESTYLING_AHEAD 4
 #define SCI_SETIDLESTYLING 2692
 #define SCI_GETIDLESTYLING 2693
 #define SC_WRAP_NONE 0
@@ -864,6 +865,10 @@ typedef sptr_t (*SciFnDirect)(sptr_t ptr, unsigned int iMessage, uptr_t wParam,
 #define SCI_INDICATOREND 2509
 #define SCI_SETPOSITIONCACHE 2514
 #define SCI_GETPOSITIONCACHE 2515
+#define SCI_SETPOSITIONCACHESHARED 2750
+#define SCI_GETPOSITIONCACHESHARED 2751
+#define SCI_GETPOSITIONCACHEHITS 2752
+#define SCI_GETPOSITIONCACHEMISSES 2753
 #define SCI_COPYALLOWLINE 2519
 #define SCI_GETCHARACTERPOINTER 2520
 #define SCI_GETRANGEPOINTER 2643
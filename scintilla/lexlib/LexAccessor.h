@@ -162,8 +162,9 @@ public:
 				// Too big for buffer so send directly
 				pAccess->SetStyleFor(pos - startSeg + 1, attr);
 			} else {
+				// Check the whole run once so the compiler can turn the loop into a fill.
+				assert((startPosStyling + validLen + static_cast<Sci_Position>(pos - startSeg)) < Length());
 				for (Sci_PositionU i = startSeg; i <= pos; i++) {
-					assert((startPosStyling + validLen) < Length());
 					styleBuf[validLen++] = attr;
 				}
 			}
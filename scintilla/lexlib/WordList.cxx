@@ -9,6 +9,7 @@
 #include <cassert>
 #include <cstring>
 
+#include <vector>
 #include <algorithm>
 #include <iterator>
 
@@ -60,10 +61,156 @@ static char **ArrayFromWordList(char *wordlist, size_t slen, int *len, bool only
 	return keywords;
 }
 
+/**
+ * The sorted words as a trie of nodes and edges held in arrays. The edges of each node are
+ * contiguous and ordered by character and the first character is looked up directly.
+ * Following one edge per character means that the cost of a lookup depends on the length
+ * of the word being checked rather than on how many words share its first character.
+ */
+class WordList::Trie {
+	struct Node {
+		int firstEdge;
+		int countEdges;
+		bool terminal;
+	};
+	struct Edge {
+		unsigned char ch;
+		int node;
+	};
+	std::vector<Node> nodes;
+	std::vector<Edge> edges;
+	int rootChildren[256];
+	int Add(char * const *words, int first, int last, size_t depth);
+public:
+	Trie(char * const *words, int len);
+	int Child(int node, unsigned char ch) const noexcept;
+	int Walk(int node, const char *s, const char *end) const noexcept;
+	bool Terminal(int node) const noexcept {
+		return nodes[node].terminal;
+	}
+	bool PrefixOf(const char *s) const noexcept;
+	bool AbbreviationOf(int node, const char *s, bool isSubword, bool firstCharacter, char marker) const noexcept;
+	bool SuffixOf(int node, const char *s, size_t lengthS, size_t maxSuffix) const noexcept;
+};
+
+WordList::Trie::Trie(char * const *words, int len) {
+	Add(words, 0, len, 0);
+	std::fill(rootChildren, std::end(rootChildren), -1);
+	for (int e = 0; e < nodes[0].countEdges; e++) {
+		rootChildren[edges[e].ch] = edges[e].node;
+	}
+}
+
+/**
+ * Adds a node for the range of sorted words that share their first depth characters
+ * followed by the nodes for each different next character.
+ */
+int WordList::Trie::Add(char * const *words, int first, int last, size_t depth) {
+	const int node = static_cast<int>(nodes.size());
+	nodes.push_back({0, 0, false});
+	// A word ending at this node, along with any duplicates, sorts before longer words
+	while ((first < last) && !words[first][depth]) {
+		nodes[node].terminal = true;
+		first++;
+	}
+	int countEdges = 0;
+	for (int i = first; i < last; countEdges++) {
+		const char ch = words[i][depth];
+		while ((i < last) && (words[i][depth] == ch))
+			i++;
+	}
+	const int firstEdge = static_cast<int>(edges.size());
+	nodes[node].firstEdge = firstEdge;
+	nodes[node].countEdges = countEdges;
+	edges.resize(firstEdge + countEdges);
+	int edge = firstEdge;
+	for (int i = first; i < last;) {
+		const char ch = words[i][depth];
+		int next = i;
+		while ((next < last) && (words[next][depth] == ch))
+			next++;
+		// Adding the child may reallocate edges so store into it afterwards
+		const int child = Add(words, i, next, depth + 1);
+		edges[edge++] = {static_cast<unsigned char>(ch), child};
+		i = next;
+	}
+	return node;
+}
+
+int WordList::Trie::Child(int node, unsigned char ch) const noexcept {
+	if (node == 0)
+		return rootChildren[ch];
+	const Edge *begin = edges.data() + nodes[node].firstEdge;
+	const Edge *end = begin + nodes[node].countEdges;
+	const Edge *it = std::lower_bound(begin, end, ch, [](const Edge &edge, unsigned char c) noexcept {
+		return edge.ch < c;
+	});
+	return ((it != end) && (it->ch == ch)) ? it->node : -1;
+}
+
+/// Follow the characters from s to end starting at node, returning -1 when there is no path.
+int WordList::Trie::Walk(int node, const char *s, const char *end) const noexcept {
+	while ((node >= 0) && (s < end)) {
+		node = Child(node, *s);
+		s++;
+	}
+	return node;
+}
+
+/// Is there a '^' element that is a prefix of s?
+bool WordList::Trie::PrefixOf(const char *s) const noexcept {
+	int node = Child(0, '^');
+	while (node >= 0) {
+		if (Terminal(node))
+			return true;
+		if (!*s)
+			break;
+		node = Child(node, *s);
+		s++;
+	}
+	return false;
+}
+
+/**
+ * Match the rest of s for InListAbbreviated where the characters before s led to node.
+ * A marker straight after a matched character is skipped and makes the word a subword so it
+ * may end early, while the character after a skipped marker is compared literally.
+ */
+bool WordList::Trie::AbbreviationOf(int node, const char *s, bool isSubword, bool firstCharacter, char marker) const noexcept {
+	const int skipped = Child(node, marker);
+	if (!*s) {
+		if (Terminal(node) || isSubword)
+			return true;
+		// A single character does not match a word with a marker as its second character
+		// unless that marker ends the word.
+		return (skipped >= 0) && (!firstCharacter || Terminal(skipped));
+	}
+	if (*s != marker) {
+		const int child = Child(node, *s);
+		if ((child >= 0) && AbbreviationOf(child, s + 1, isSubword, false, marker))
+			return true;
+	}
+	if (skipped >= 0) {
+		const int child = Child(skipped, *s);
+		if ((child >= 0) && AbbreviationOf(child, s + 1, true, false, marker))
+			return true;
+	}
+	return false;
+}
+
+/// Is a suffix of s, no longer than maxSuffix, a path from node to the end of a word?
+bool WordList::Trie::SuffixOf(int node, const char *s, size_t lengthS, size_t maxSuffix) const noexcept {
+	const char *end = s + lengthS;
+	for (size_t lengthSuffix = 0; lengthSuffix <= maxSuffix; lengthSuffix++) {
+		const int suffixEnd = Walk(node, end - lengthSuffix, end);
+		if ((suffixEnd >= 0) && Terminal(suffixEnd))
+			return true;
+	}
+	return false;
+}
+
 WordList::WordList(bool onlyLineEnds_) :
-	words(0), list(0), len(0), onlyLineEnds(onlyLineEnds_) {
-	// Prevent warnings by static analyzers about uninitialized starts.
-	starts[0] = -1;
+	words(0), list(0), len(0), onlyLineEnds(onlyLineEnds_), trie(nullptr) {
 }
 
 WordList::~WordList() {
@@ -93,6 +240,8 @@ void WordList::Clear() noexcept {
 		delete []list;
 		delete []words;
 	}
+	delete trie;
+	trie = nullptr;
 	words = nullptr;
 	list = nullptr;
 	len = 0;
@@ -147,11 +296,7 @@ bool WordList::Set(const char *s) {
 	words = wordsTemp;
 	list = listTemp;
 	len = lenTemp;
-	std::fill(starts, std::end(starts), -1);
-	for (int l = len - 1; l >= 0; l--) {
-		unsigned char indexChar = words[l][0];
-		starts[indexChar] = l;
-	}
+	trie = new Trie(words, len);
 	return true;
 }
 
@@ -161,40 +306,12 @@ bool WordList::Set(const char *s) {
  * so '^GTK_' matches 'GTK_X', 'GTK_MAJOR_VERSION', and 'GTK_'.
  */
 bool WordList::InList(const char *s) const noexcept {
-	if (0 == words)
+	if (!trie)
 		return false;
-	const unsigned char firstChar = s[0];
-	int j = starts[firstChar];
-	if (j >= 0) {
-		while (words[j][0] == firstChar) {
-			if (s[1] == words[j][1]) {
-				const char *a = words[j] + 1;
-				const char *b = s + 1;
-				while (*a && *a == *b) {
-					a++;
-					b++;
-				}
-				if (!*a && !*b)
-					return true;
-			}
-			j++;
-		}
-	}
-	j = starts[static_cast<unsigned int>('^')];
-	if (j >= 0) {
-		while (words[j][0] == '^') {
-			const char *a = words[j] + 1;
-			const char *b = s;
-			while (*a && *a == *b) {
-				a++;
-				b++;
-			}
-			if (!*a)
-				return true;
-			j++;
-		}
-	}
-	return false;
+	const int node = trie->Walk(0, s, s + strlen(s));
+	if ((node >= 0) && trie->Terminal(node))
+		return true;
+	return trie->PrefixOf(s);
 }
 
 /** similar to InList, but word s can be a substring of keyword.
@@ -203,50 +320,12 @@ bool WordList::InList(const char *s) const noexcept {
  * The marker is ~ in this case.
  */
 bool WordList::InListAbbreviated(const char *s, const char marker) const noexcept {
-	if (0 == words)
+	if (!trie)
 		return false;
-	const unsigned char firstChar = s[0];
-	int j = starts[firstChar];
-	if (j >= 0) {
-		while (words[j][0] == firstChar) {
-			bool isSubword = false;
-			int start = 1;
-			if (words[j][1] == marker) {
-				isSubword = true;
-				start++;
-			}
-			if (s[1] == words[j][start]) {
-				const char *a = words[j] + start;
-				const char *b = s + 1;
-				while (*a && *a == *b) {
-					a++;
-					if (*a == marker) {
-						isSubword = true;
-						a++;
-					}
-					b++;
-				}
-				if ((!*a || isSubword) && !*b)
-					return true;
-			}
-			j++;
-		}
-	}
-	j = starts[static_cast<unsigned int>('^')];
-	if (j >= 0) {
-		while (words[j][0] == '^') {
-			const char *a = words[j] + 1;
-			const char *b = s;
-			while (*a && *a == *b) {
-				a++;
-				b++;
-			}
-			if (!*a)
-				return true;
-			j++;
-		}
-	}
-	return false;
+	const int node = trie->Child(0, s[0]);
+	if ((node >= 0) && trie->AbbreviationOf(node, s + 1, false, true, marker))
+		return true;
+	return trie->PrefixOf(s);
 }
 
 /** similar to InListAbbreviated, but word s can be a abridged version of a keyword.
@@ -257,56 +336,30 @@ bool WordList::InListAbbreviated(const char *s, const char marker) const noexcep
 * No multiple markers check is done and wont work.
 */
 bool WordList::InListAbridged(const char *s, const char marker) const noexcept {
-	if (0 == words)
+	if (!trie)
 		return false;
-	const unsigned char firstChar = s[0];
-	int j = starts[firstChar];
-	if (j >= 0) {
-		while (words[j][0] == firstChar) {
-			const char *a = words[j];
-			const char *b = s;
-			while (*a && *a == *b) {
-				a++;
-				if (*a == marker) {
-					a++;
-					const size_t suffixLengthA = strlen(a);
-					const size_t suffixLengthB = strlen(b);
-					if (suffixLengthA >= suffixLengthB)
-						break;
-					b = b + suffixLengthB - suffixLengthA - 1;
-				}
-				b++;
-			}
-			if (!*a  && !*b)
-				return true;
-			j++;
-		}
-	}
-
-	j = starts[static_cast<unsigned int>(marker)];
-	if (j >= 0) {
-		while (words[j][0] == marker) {
-			const char *a = words[j] + 1;
-			const char *b = s;
-			const size_t suffixLengthA = strlen(a);
-			const size_t suffixLengthB = strlen(b);
-			if (suffixLengthA > suffixLengthB) {
-				j++;
-				continue;
-			}
-			b = b + suffixLengthB - suffixLengthA;
-
-			while (*a && *a == *b) {
-				a++;
-				b++;
-			}
-			if (!*a && !*b)
+	const size_t lengthS = strlen(s);
+	const char *end = s + lengthS;
+	int node = trie->Child(0, s[0]);
+	const char *b = s + 1;
+	while (node >= 0) {
+		// A word with a marker after the matched prefix must end with the rest of s
+		const int skipped = trie->Child(node, marker);
+		if ((skipped >= 0) && trie->SuffixOf(skipped, s, lengthS, end - b))
+			return true;
+		if (b == end) {
+			if (trie->Terminal(node))
 				return true;
-			j++;
+			break;
 		}
+		if (*b == marker)
+			break;
+		node = trie->Child(node, *b);
+		b++;
 	}
 
-	return false;
+	const int suffixOnly = trie->Child(0, marker);
+	return (suffixOnly >= 0) && trie->SuffixOf(suffixOnly, s, lengthS, lengthS);
 }
 
 const char *WordList::WordAt(int n) const noexcept {
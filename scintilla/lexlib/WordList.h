@@ -13,12 +13,13 @@ namespace Scintilla {
 /**
  */
 class WordList {
+	class Trie;
 	// Each word contains at least one character - a empty word acts as sentinel at the end.
 	char **words;
 	char *list;
 	int len;
 	bool onlyLineEnds;	///< Delimited by any white space or only line ends
-	int starts[256];
+	Trie *trie;	///< Built by Set so that lookups take time proportional to the word length
 public:
 	explicit WordList(bool onlyLineEnds_ = false);
 	~WordList();
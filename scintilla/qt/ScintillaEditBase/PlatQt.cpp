@@ -12,6 +12,19 @@
 // Scintilla platform layer for Qt QML/Quick
 
 #include <cstdio>
+#include <cmath>
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PLATQT_SSE2
+#include <emmintrin.h>
+#elif (defined(__aarch64__) && !defined(__AARCH64EB__)) || defined(_M_ARM64)
+#define PLATQT_NEON
+#include <arm_neon.h>
+#endif
 
 #include "PlatQt.h"
 #include "Scintilla.h"
@@ -42,13 +55,17 @@
 #include <QDesktopWidget>
 #include <QTextLayout>
 #include <QTextLine>
+#include <QGlyphRun>
+#include <QFontInfo>
 #include <QLibrary>
 #ifdef PLAT_QT_QML
-#include <QQuickPaintedItem>
+#include <QQuickItem>
 #include <QScreen>
 #include <QList>
 #include <QPair>
 
+#include "ScintillaEditBase.h"
+
 extern void ProcessScintillaContextMenu(Scintilla::Point pt, Scintilla::Window & w, const QList<QPair<QString, QPair<int, bool>>> & menu);
 #endif
 
@@ -111,10 +128,22 @@ QString UnicodeFromText(QTextCodec *codec, std::string_view text) {
 	return codec->toUnicode(text.data(), static_cast<int>(text.length()));
 }
 
+// Advances of characters which are measured without shaping, see MeasureWidthsFromAdvances.
+class CharacterAdvances {
+public:
+	int logicalDpi = 0;
+	bool asciiAdditive = false;	// printable ASCII is laid out with just these advances
+	bool asciiUniform = false;	// and all printable ASCII characters have the same advance
+	bool fixedPitch = false;
+	XYPOSITION ascii[0x80] = {};
+	std::unordered_map<unsigned int, XYPOSITION> others;	// only filled for fixed pitch fonts
+};
+
 class FontAndCharacterSet {
 public:
 	int characterSet;
 	QFont *pfont;
+	std::unique_ptr<CharacterAdvances> advances;
 	FontAndCharacterSet(int characterSet_, QFont *pfont):
 		characterSet(characterSet_), pfont(pfont) {
 	}
@@ -203,7 +232,7 @@ void SurfaceImpl::Clear()
 	painterOwned = false;
 }
 
-void SurfaceImpl::Init(bool signatureFlag, PainterID pid)    // wid is QQuickPaintedItem here
+void SurfaceImpl::Init(bool signatureFlag, PainterID pid)    // wid is QQuickItem here
 {
     Q_UNUSED(signatureFlag);
     Release();
@@ -214,7 +243,7 @@ void SurfaceImpl::Init(bool signatureFlag, PainterID pid)    // wid is QQuickPai
 #endif
 }
 
-void SurfaceImpl::Init(WindowID wid)    // wid is QQuickPaintedItem here
+void SurfaceImpl::Init(WindowID wid)    // wid is QQuickItem here
 {
 	Release();
 #ifdef PLAT_QT_QML
@@ -531,12 +560,188 @@ void SurfaceImpl::SetClip(PRectangle rc)
 	GetPainter()->setClipRect(QRectFFromPRect(rc));
 }
 
+namespace {
+
+// True if all bytes are printable ASCII, 16 bytes are checked at a time where SIMD is available.
+bool IsPrintableASCII(std::string_view text) noexcept
+{
+	const unsigned char *p = reinterpret_cast<const unsigned char *>(text.data());
+	const unsigned char *end = p + text.length();
+#if defined(PLATQT_SSE2)
+	// As signed bytes everything from 0x80 is negative, so one range check covers both ends.
+	const __m128i vBelow = _mm_set1_epi8(0x1F);
+	const __m128i vAbove = _mm_set1_epi8(0x7F);
+	while (end - p >= 16) {
+		const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		const __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(bytes, vBelow), _mm_cmplt_epi8(bytes, vAbove));
+		if (_mm_movemask_epi8(printable) != 0xFFFF)
+			return false;
+		p += 16;
+	}
+#elif defined(PLATQT_NEON)
+	const uint8x16_t vBelow = vdupq_n_u8(0x1F);
+	const uint8x16_t vAbove = vdupq_n_u8(0x7F);
+	while (end - p >= 16) {
+		const uint8x16_t bytes = vld1q_u8(p);
+		if (vminvq_u8(vandq_u8(vcgtq_u8(bytes, vBelow), vcltq_u8(bytes, vAbove))) == 0)
+			return false;
+		p += 16;
+	}
+#endif
+	for (; p < end; p++) {
+		if (*p < 0x20 || *p > 0x7E)
+			return false;
+	}
+	return true;
+}
+
+// Characters which are drawn as one glyph with their own advance in a fixed pitch font:
+// Latin, Greek, Cyrillic, Armenian, kana, CJK ideographs and Hangul syllables without
+// combining marks or format characters.
+bool IsSimpleCharacter(unsigned int ch) noexcept
+{
+	if ((ch >= 0x300 && ch < 0x370) || ch == 0xAD)
+		return false;
+	return (ch >= 0xA0 && ch < 0x483) || (ch >= 0x48A && ch < 0x590) ||
+		(ch >= 0x1E00 && ch < 0x2000) ||
+		(ch >= 0x3041 && ch < 0x3099) || (ch >= 0x30A0 && ch < 0x3100) ||
+		(ch >= 0x4E00 && ch < 0xA000) || (ch >= 0xAC00 && ch < 0xD7A4);
+}
+
+// A sequence containing every pair of printable ASCII characters (a de Bruijn sequence
+// built from the Lyndon words of length 1 and 2), its layout shows whether kerning or
+// ligatures change any advance.
+QString PairsOfPrintableASCII()
+{
+	const int first = 0x20;
+	const int count = 0x7F - first;
+	QString pairs;
+	pairs.reserve(count * count + 1);
+	for (int a = 0; a < count; a++) {
+		pairs.append(QChar(first + a));
+		for (int b = a + 1; b < count; b++) {
+			pairs.append(QChar(first + a));
+			pairs.append(QChar(first + b));
+		}
+	}
+	pairs.append(QChar(first));
+	return pairs;
+}
+
+std::unique_ptr<CharacterAdvances> MeasureAdvances(const QFont &font, QPaintDevice *device, int logicalDpi)
+{
+	std::unique_ptr<CharacterAdvances> advances = std::make_unique<CharacterAdvances>();
+	advances->logicalDpi = logicalDpi;
+	advances->fixedPitch = QFontInfo(font).fixedPitch();
+	QFontMetricsF metrics(font, device);
+	for (int ch = 0x20; ch < 0x7F; ch++) {
+		advances->ascii[ch] = metrics.width(QChar(ch));
+	}
+
+	const QString pairs = PairsOfPrintableASCII();
+	QTextLayout tlay(pairs, font, device);
+	tlay.beginLayout();
+	QTextLine tl = tlay.createLine();
+	tlay.endLayout();
+	const QList<QGlyphRun> runs = tl.glyphRuns();
+	if (runs.size() != 1)
+		return advances;	// some characters come from a fallback font
+	const QVector<QPointF> glyphPositions = runs.front().positions();
+	if (glyphPositions.size() != pairs.size())
+		return advances;	// ligatures
+	XYPOSITION x = 0;
+	for (int i = 0; i < pairs.size(); i++) {
+		if (std::abs(glyphPositions[i].x() - glyphPositions[0].x() - x) > 0.01)
+			return advances;	// kerning
+		x += advances->ascii[pairs[i].unicode()];
+	}
+	if (std::abs(tl.naturalTextWidth() - x) > 0.01)
+		return advances;
+
+	advances->asciiAdditive = true;
+	advances->asciiUniform = std::all_of(advances->ascii + 0x21, advances->ascii + 0x7F,
+		[&advances](XYPOSITION advance) { return advance == advances->ascii[0x20]; });
+	return advances;
+}
+
+// Fills positions from the advances of single characters when the text needs no shaping,
+// so no QTextLayout is needed for the common case of code in one font.
+// Returns false if the text has to be laid out.
+bool MeasureWidthsFromAdvances(FontAndCharacterSet *fcs, QPaintDevice *device, bool unicodeMode,
+	std::string_view text, XYPOSITION *positions)
+{
+	const int logicalDpi = device ? device->logicalDpiY() : 0;
+	if (!fcs->advances || fcs->advances->logicalDpi != logicalDpi)
+		fcs->advances = MeasureAdvances(*fcs->pfont, device, logicalDpi);
+	CharacterAdvances *advances = fcs->advances.get();
+	if (!advances->asciiAdditive)
+		return false;
+
+	const size_t length = text.length();
+	if (IsPrintableASCII(text)) {
+		if (advances->asciiUniform) {
+			const XYPOSITION advance = advances->ascii[0x20];
+			for (size_t i = 0; i < length; i++) {
+				positions[i] = advance * static_cast<XYPOSITION>(i + 1);
+			}
+		} else {
+			XYPOSITION x = 0;
+			for (size_t i = 0; i < length; i++) {
+				x += advances->ascii[static_cast<unsigned char>(text[i])];
+				positions[i] = x;
+			}
+		}
+		return true;
+	}
+
+	// Other characters are only taken from the table for fixed pitch fonts, where they do
+	// not kern with their neighbours. All bytes of a character get its end position.
+	if (!unicodeMode || !advances->fixedPitch)
+		return false;
+	const unsigned char *us = reinterpret_cast<const unsigned char *>(text.data());
+	std::unique_ptr<QFontMetricsF> metrics;
+	XYPOSITION x = 0;
+	size_t i = 0;
+	while (i < length) {
+		if (us[i] < 0x80) {
+			if (us[i] < 0x20 || us[i] > 0x7E)
+				return false;
+			x += advances->ascii[us[i]];
+			positions[i++] = x;
+			continue;
+		}
+		const int utf8Status = UTF8Classify(us + i, length - i);
+		if (utf8Status & UTF8MaskInvalid)
+			return false;
+		const unsigned int ch = UnicodeFromUTF8(us + i);
+		if (!IsSimpleCharacter(ch))
+			return false;
+		std::unordered_map<unsigned int, XYPOSITION>::const_iterator it = advances->others.find(ch);
+		if (it == advances->others.end()) {
+			if (!metrics)
+				metrics = std::make_unique<QFontMetricsF>(*fcs->pfont, device);
+			it = advances->others.emplace(ch, metrics->width(QChar(ch))).first;
+		}
+		x += it->second;
+		const size_t end = i + (utf8Status & UTF8MaskWidth);
+		while (i < end) {
+			positions[i++] = x;
+		}
+	}
+	return true;
+}
+
+}
+
 void SurfaceImpl::MeasureWidths(Font &font,
 				std::string_view text,
                                 XYPOSITION *positions)
 {
 	if (!font.GetID())
 		return;
+	if ((unicodeMode || !codePage) &&
+		MeasureWidthsFromAdvances(AsFontAndCharacterSet(font), GetPaintDevice(), unicodeMode, text, positions))
+		return;
 	SetCodec(font);
 	QString su = UnicodeFromText(codec, text);
 	QTextLayout tlay(su, *FontPointer(font), GetPaintDevice());
@@ -682,9 +887,9 @@ Surface *Surface::Allocate(int)
 namespace {
 
 #ifdef PLAT_QT_QML
-QQuickPaintedItem *window(WindowID wid) noexcept
+QQuickItem *window(WindowID wid) noexcept
 {
-	return static_cast<QQuickPaintedItem *>(wid);
+	return static_cast<QQuickItem *>(wid);
 }
 #else
 QWidget *window(WindowID wid) noexcept
@@ -718,7 +923,7 @@ PRectangle Window::GetPosition() const
 {
 	// Before any size allocated pretend its 1000 wide so not scrolled
 #ifdef PLAT_QT_QML
-	return wid ? PRectFromQRectF(window(wid)->contentsBoundingRect()) : PRectangle(0, 0, 1000, 1000);
+	return wid ? PRectFromQRectF(window(wid)->boundingRect()) : PRectangle(0, 0, 1000, 1000);
 #else
 	return wid ? PRectFromQRect(window(wid)->frameGeometry()) : PRectangle(0, 0, 1000, 1000);
 #endif
@@ -788,14 +993,33 @@ void Window::Show(bool show)
 
 void Window::InvalidateAll()
 {
-	if (wid)
+	if (wid) {
+#ifdef PLAT_QT_QML
+		// the editor caches its painted lines and has to know what to paint again
+		ScintillaEditBase *editor = qobject_cast<ScintillaEditBase *>(window(wid));
+		if (editor) {
+			editor->InvalidateAll();
+			return;
+		}
+#endif
 		window(wid)->update();
+	}
 }
 
 void Window::InvalidateRectangle(PRectangle rc)
 {
-	if (wid)
+	if (wid) {
+#ifdef PLAT_QT_QML
+		ScintillaEditBase *editor = qobject_cast<ScintillaEditBase *>(window(wid));
+		if (editor) {
+			editor->InvalidateRectangle(QRectFromPRect(rc));
+		} else {
+			window(wid)->update();
+		}
+#else
 		window(wid)->update(QRectFromPRect(rc));
+#endif
+	}
 }
 
 void Window::SetFont(Font &font)
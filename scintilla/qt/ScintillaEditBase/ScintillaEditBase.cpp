@@ -30,6 +30,14 @@
 #include <QPoint>
 #include <QPair>
 #include <QList>
+#include <QQuickWindow>
+#include <QSGNode>
+#include <QSGSimpleTextureNode>
+#include <QSGSimpleRectNode>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
 #endif
 
 #define INDIC_INPUTMETHOD 24
@@ -54,7 +62,7 @@ using namespace Scintilla;
 
 ScintillaEditBase::ScintillaEditBase(QQuickItem/*QWidget*/ *parent)
 #ifdef PLAT_QT_QML
-: QQuickPaintedItem(parent)
+: QQuickItem(parent)
 #else
 : QAbstractScrollArea(parent)
 #endif
@@ -63,6 +71,8 @@ ScintillaEditBase::ScintillaEditBase(QQuickItem/*QWidget*/ *parent)
 , dataInputMethodHints(Qt::ImhNone)
 //, aLongTouchTimer(this)
 , aLastTouchPressTime(-1)
+, tileTopLine(0), tileLineHeight(0), tileWidth(0), tileXOffset(0), tileDevicePixelRatio(1.0), tilePartialLine(-1)
+, caretVisible(false)
 #endif
 , sqt(0), preeditPos(-1), wheelDelta(0)
 {
@@ -135,9 +145,6 @@ ScintillaEditBase::ScintillaEditBase(QQuickItem/*QWidget*/ *parent)
 
     //connect(&aLongTouchTimer, SIGNAL(timeout()), this, SLOT(onLongTouch()));
 #endif
-
-	// TODO: performance optimizations... ?
-	//setRenderTarget(QQuickPaintedItem::FramebufferObject);
 }
 
 ScintillaEditBase::~ScintillaEditBase() {}
@@ -194,7 +201,7 @@ void ScintillaEditBase::enableUpdate(bool enable)
     enableUpdateFlag = enable;
     if( enableUpdateFlag )
     {
-        update();
+        polish();
     }
 }
 
@@ -242,7 +249,7 @@ bool ScintillaEditBase::event(QEvent *event)
 		result = QAbstractScrollArea::event(event);
 #else
 		//grabMouse();
-		result = QQuickPaintedItem::event(event);
+		result = QQuickItem::event(event);
 #endif
 	} else if (event->type() == QEvent::Hide) {
 #ifndef PLAT_QT_QML
@@ -250,13 +257,13 @@ bool ScintillaEditBase::event(QEvent *event)
 		result = QAbstractScrollArea::event(event);
 #else
 		//ungrabMouse();
-		result = QQuickPaintedItem::event(event);
+		result = QQuickItem::event(event);
 #endif
 	} else {
 #ifndef PLAT_QT_QML
 		result = QAbstractScrollArea::event(event);
 #else
-		result = QQuickPaintedItem::event(event);
+		result = QQuickItem::event(event);
 #endif
 	}
 
@@ -265,10 +272,284 @@ bool ScintillaEditBase::event(QEvent *event)
 
 #ifdef PLAT_QT_QML
 
-void ScintillaEditBase::paint(QPainter *painter)
+namespace {
+
+// Node for one line tile, owns its texture.
+class TileNode : public QSGSimpleTextureNode {
+public:
+	~TileNode() override
+	{
+		delete texture();
+	}
+
+	void ReplaceTexture(QSGTexture *newTexture)
+	{
+		QSGTexture *oldTexture = texture();
+		setTexture(newTexture);
+		delete oldTexture;
+	}
+};
+
+class EditorNode : public QSGNode {
+public:
+	std::map<int, TileNode *> tileNodes;
+	QSGSimpleRectNode *caretNode = nullptr;
+};
+
+// Lines beyond the view which are kept for scrolling, in multiples of the view height.
+const int tileCacheViews = 2;
+
+}
+
+void ScintillaEditBase::InvalidateRectangle(const QRect &rect)
+{
+	const int lineHeight = sqt->vs.lineHeight;
+	if (rect.isEmpty() || lineHeight <= 0) {
+		return;
+	}
+	const int topLine = sqt->TopLineOfMain();
+	const int lineFirst = topLine + std::max(rect.top(), 0) / lineHeight;
+	const int lineLast = topLine + std::max(rect.bottom(), 0) / lineHeight;
+	InvalidateLines(lineFirst, lineLast);
+
+	// Invalidations only cover the visible part of the document, so cached lines
+	// outside of the view may be outdated as well: an area reaching down to the
+	// end of the view means lines may have been inserted or removed, the whole
+	// view is invalidated for changes of the styles, folding and so on.
+	const int viewHeight = static_cast<int>(height());
+	if (rect.bottom() >= viewHeight - 1) {
+		InvalidateLines(lineLast + 1, INT_MAX);
+		if (rect.top() <= 0) {
+			InvalidateLines(0, lineFirst - 1);
+		}
+	}
+	polish();
+}
+
+void ScintillaEditBase::InvalidateAll()
+{
+	InvalidateLines(0, INT_MAX);
+	polish();
+}
+
+void ScintillaEditBase::InvalidateHiddenLines(int lineFirst, int lineLast)
+{
+	const int lineHeight = sqt->vs.lineHeight;
+	if (tiles.empty() || lineHeight <= 0) {
+		return;
+	}
+	// Visible lines are invalidated by Scintilla itself and may be being painted now.
+	const int topLine = sqt->TopLineOfMain();
+	const int lineEndView = topLine + (static_cast<int>(std::ceil(height())) + lineHeight - 1) / lineHeight;
+	InvalidateLines(lineFirst, std::min(lineLast, topLine - 1));
+	InvalidateLines(std::max(lineFirst, lineEndView), lineLast);
+}
+
+void ScintillaEditBase::InvalidateLines(int lineFirst, int lineLast)
+{
+	for (auto it = tiles.begin(); it != tiles.end(); ++it) {
+		const int tileFirst = it->first;
+		const int first = std::max(lineFirst, tileFirst);
+		const int last = std::min(lineLast, tileFirst + tileLines - 1);
+		for (int line = first; line <= last; line++) {
+			it->second.validLines &= ~(1u << (line - tileFirst));
+		}
+	}
+}
+
+void ScintillaEditBase::PaintTileLines(LineTile &tile, int tileFirst, int lineFirst, int lineEnd)
+{
+	// Mark the lines before painting, invalidations while painting clear the bits again.
+	for (int line = lineFirst; line < lineEnd; line++) {
+		tile.validLines |= 1u << (line - tileFirst);
+	}
+
+	const int topLine = sqt->TopLineOfMain();
+	const int lineHeight = sqt->vs.lineHeight;
+	QPainter painter(&tile.image);
+	// Scintilla paints in client coordinates
+	painter.translate(0, (topLine - tileFirst) * lineHeight);
+	const QRect rcPaint(0, (lineFirst - topLine) * lineHeight, tileWidth, (lineEnd - lineFirst) * lineHeight);
+	sqt->PartialPaintQml(PRectFromQRect(rcPaint), &painter);
+	tile.imageChanged = true;
+}
+
+void ScintillaEditBase::updatePolish()
+{
+	// may change the line height, so do it before the tiles are checked
+	sqt->RefreshStyleData();
+
+	const int lineHeight = sqt->vs.lineHeight;
+	const int viewWidth = static_cast<int>(std::ceil(width()));
+	const int viewHeight = static_cast<int>(std::ceil(height()));
+	const qreal devicePixelRatio = window() ? window()->effectiveDevicePixelRatio() : 1.0;
+	const int xOffset = sqt->xOffset;
+	if (lineHeight != tileLineHeight || viewWidth != tileWidth ||
+		xOffset != tileXOffset || devicePixelRatio != tileDevicePixelRatio) {
+		tiles.clear();
+		tileLineHeight = lineHeight;
+		tileWidth = viewWidth;
+		tileXOffset = xOffset;
+		tileDevicePixelRatio = devicePixelRatio;
+	}
+
+	const int topLine = sqt->TopLineOfMain();
+	tileTopLine = topLine;
+	if (viewWidth <= 0 || viewHeight <= 0 || lineHeight <= 0) {
+		tiles.clear();
+		caretVisible = false;
+		update();
+		return;
+	}
+
+	// The last line may be visible only partly, the margin is clipped to the view
+	// for it, so it is painted again when it becomes visible completely.
+	const int linesOnScreen = viewHeight / lineHeight;
+	const int lineEndView = topLine + (viewHeight + lineHeight - 1) / lineHeight;
+	if (tilePartialLine >= 0 && tilePartialLine >= topLine && tilePartialLine < topLine + linesOnScreen) {
+		InvalidateLines(tilePartialLine, tilePartialLine);
+	}
+	tilePartialLine = (viewHeight % lineHeight) ? topLine + linesOnScreen : -1;
+
+	// Styling which does not come with a modification, such as a lexer restyling
+	// the document, is only seen as a change of the style clock of the document.
+	const int styleClock = sqt->pdoc->GetStyleClock();
+	for (auto it = tiles.begin(); it != tiles.end(); ++it) {
+		if (it->second.styleClock != styleClock) {
+			it->second.validLines = 0;
+		}
+	}
+
+	// The main caret is drawn as a node, so it is hidden while painting the text.
+	const bool caretAsNode = sqt->CaretAsNode();
+	const bool caretOn = sqt->caret.on;
+	if (caretAsNode) {
+		sqt->caret.on = false;
+	}
+	for (int tileFirst = topLine - topLine % tileLines; tileFirst < lineEndView; tileFirst += tileLines) {
+		LineTile &tile = tiles[tileFirst];
+		if (tile.image.isNull()) {
+			tile.image = QImage(QSize(viewWidth, tileLines * lineHeight) * devicePixelRatio, QImage::Format_RGB32);
+			tile.image.setDevicePixelRatio(devicePixelRatio);
+			tile.image.fill(QColorFromCA(sqt->vs.styles[STYLE_DEFAULT].back));
+			tile.validLines = 0;
+			tile.imageChanged = true;
+		}
+		const int lineFirst = std::max(tileFirst, topLine);
+		const int lineEnd = std::min(tileFirst + tileLines, lineEndView);
+		int line = lineFirst;
+		while (line < lineEnd) {
+			if (tile.validLines & (1u << (line - tileFirst))) {
+				line++;
+				continue;
+			}
+			int lineEndRun = line + 1;
+			while (lineEndRun < lineEnd && !(tile.validLines & (1u << (lineEndRun - tileFirst)))) {
+				lineEndRun++;
+			}
+			PaintTileLines(tile, tileFirst, line, lineEndRun);
+			line = lineEndRun;
+		}
+	}
+	if (caretAsNode) {
+		sqt->caret.on = caretOn;
+	}
+	// Painting styles the lines it shows, which does not change lines painted before.
+	const int styleClockPainted = sqt->pdoc->GetStyleClock();
+	for (int tileFirst = topLine - topLine % tileLines; tileFirst < lineEndView; tileFirst += tileLines) {
+		tiles[tileFirst].styleClock = styleClockPainted;
+	}
+
+	// Drop tiles far away from the view and tiles which have to be painted completely again.
+	const int cacheLines = tileCacheViews * std::max(linesOnScreen, tileLines);
+	for (auto it = tiles.begin(); it != tiles.end();) {
+		const int tileFirst = it->first;
+		const bool inView = tileFirst < lineEndView && tileFirst + tileLines > topLine;
+		const bool farAway = tileFirst + tileLines < topLine - cacheLines || tileFirst > lineEndView + cacheLines;
+		if (!inView && (farAway || it->second.validLines == 0)) {
+			it = tiles.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	UpdateCaretRect();
+	update();
+}
+
+void ScintillaEditBase::UpdateCaretRect()
+{
+	caretVisible = false;
+	if (!sqt->CaretAsNode() || !sqt->caret.active || !sqt->caret.on || !sqt->vs.IsCaretVisible()) {
+		return;
+	}
+	const Point pt = sqt->LocationFromPosition(sqt->sel.Range(0).caret);
+	XYPOSITION x = pt.x;
+	if (x > sqt->vs.textStart - sqt->xOffset) {
+		// Move back so overlaps both character cells, as EditView does.
+		x -= 0.51f;
+	}
+	x = std::round(x);
+	const int lineHeight = sqt->vs.lineHeight;
+	if (x < sqt->vs.textStart || pt.y + lineHeight <= 0 || pt.y >= height()) {
+		return;
+	}
+	caretRect = QRectF(x, pt.y, sqt->vs.caretWidth, lineHeight);
+	caretColour = QColorFromCA(sqt->vs.caretcolour);
+	caretVisible = true;
+}
+
+// Runs on the render thread while the GUI thread is blocked.
+QSGNode *ScintillaEditBase::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
 {
-	//sqt->PartialPaintQml(PRectFromQRect(/*boundingRect().toRect()*/painter->clipRegion().boundingRect()), painter);
-	sqt->PartialPaintQml(PRectFromQRect(boundingRect().toRect()), painter);
+	Q_UNUSED(data);
+	EditorNode *root = static_cast<EditorNode *>(oldNode);
+	if (!root) {
+		root = new EditorNode();
+	}
+
+	for (auto it = root->tileNodes.begin(); it != root->tileNodes.end();) {
+		if (tiles.find(it->first) == tiles.end()) {
+			root->removeChildNode(it->second);
+			delete it->second;
+			it = root->tileNodes.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	for (auto it = tiles.begin(); it != tiles.end(); ++it) {
+		LineTile &tile = it->second;
+		TileNode *&node = root->tileNodes[it->first];
+		if (!node) {
+			node = new TileNode();
+			node->setFiltering(QSGTexture::Nearest);
+			root->prependChildNode(node);
+			tile.imageChanged = true;
+		}
+		if (tile.imageChanged) {
+			// the texture shares the image data, painting into the tile later detaches it
+			node->ReplaceTexture(window()->createTextureFromImage(tile.image));
+			tile.imageChanged = false;
+		}
+		node->setRect(QRectF(0, (it->first - tileTopLine) * tileLineHeight,
+			tileWidth, tileLines * tileLineHeight));
+	}
+
+	if (caretVisible) {
+		if (!root->caretNode) {
+			root->caretNode = new QSGSimpleRectNode();
+			root->appendChildNode(root->caretNode);
+		}
+		root->caretNode->setRect(caretRect);
+		root->caretNode->setColor(caretColour);
+	} else if (root->caretNode) {
+		root->removeChildNode(root->caretNode);
+		delete root->caretNode;
+		root->caretNode = nullptr;
+	}
+
+	return root;
 }
 
 #else
@@ -289,7 +570,7 @@ void ScintillaEditBase::wheelEvent(QWheelEvent *event)
 		else
 			QAbstractScrollArea::wheelEvent(event);
 #else
-			QQuickPaintedItem::wheelEvent(event);
+			QQuickItem::wheelEvent(event);
 #endif
 	} else {
 		if (QApplication::keyboardModifiers() & Qt::ControlModifier) {
@@ -310,13 +591,13 @@ void ScintillaEditBase::wheelEvent(QWheelEvent *event)
 #ifdef PLAT_QT_QML
 				// Scroll
 				int linesToScroll = 3;
-				//QQuickPaintedItem::wheelEvent(event);
+				//QQuickItem::wheelEvent(event);
 				if (event->delta() > 0) {
 					sqt->ScrollTo(sqt->topLine-linesToScroll);
 				} else {
 					sqt->ScrollTo(sqt->topLine+linesToScroll);
 				}
-				QQuickPaintedItem::wheelEvent(event);
+				QQuickItem::wheelEvent(event);
 #else
 				QAbstractScrollArea::wheelEvent(event);
 			}
@@ -330,7 +611,7 @@ void ScintillaEditBase::focusInEvent(QFocusEvent *event)
 	sqt->SetFocusState(true);
 
 #ifdef PLAT_QT_QML
-	QQuickPaintedItem::focusInEvent(event);
+	QQuickItem::focusInEvent(event);
 #else
 	QAbstractScrollArea::focusInEvent(event);
 #endif
@@ -341,7 +622,7 @@ void ScintillaEditBase::focusOutEvent(QFocusEvent *event)
 	sqt->SetFocusState(false);
 
 #ifdef PLAT_QT_QML
-	QQuickPaintedItem::focusOutEvent(event);
+	QQuickItem::focusOutEvent(event);
 #else
 	QAbstractScrollArea::focusOutEvent(event);
 #endif
@@ -358,7 +639,8 @@ void ScintillaEditBase::geometryChanged(const QRectF &newGeometry, const QRectF
 		sqt->ChangeSize();
 		emit resized();
 
-		QQuickPaintedItem::geometryChanged(newGeometry, oldGeometry);
+		QQuickItem::geometryChanged(newGeometry, oldGeometry);
+		polish();
 	}
 }
 
@@ -383,7 +665,7 @@ void ScintillaEditBase::keyPressEvent(QKeyEvent *event)
 	// assumed to be shortcuts not handled by scintilla.
 	if (QApplication::keyboardModifiers() & Qt::MetaModifier) {
 #ifdef PLAT_QT_QML
-		QQuickPaintedItem::keyPressEvent(event);
+		QQuickItem::keyPressEvent(event);
 #else
 		QAbstractScrollArea::keyPressEvent(event);
 #endif
@@ -1161,7 +1443,7 @@ void ScintillaEditBase::touchEvent(QTouchEvent *event)
     }
     else
     {
-        QQuickPaintedItem::touchEvent(event);
+        QQuickItem::touchEvent(event);
         return;
     }
 
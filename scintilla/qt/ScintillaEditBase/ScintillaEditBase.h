@@ -19,6 +19,7 @@
 
 #include <string_view>
 #include <vector>
+#include <map>
 #include <memory>
 
 #include "Platform.h"
@@ -27,7 +28,9 @@
 #ifdef PLAT_QT_QML
 #include <QFont>
 #include <QTimer>
-#include <QQuickPaintedItem>
+#include <QQuickItem>
+#include <QImage>
+#include <QColor>
 #else
 #include <QAbstractScrollArea>
 #endif
@@ -61,10 +64,15 @@ class SurfaceImpl;
 // This is needed to optimize the user interaction on touch devices.
 // In this modus the scintilla editor control runs alway with a (maximal)
 // surface area to show the control completely. Updating the implicitSize
-// of the scintilla editor control is handled in the overloaded paint(.) method.
+// of the scintilla editor control is handled in UpdateQuickView().
+//
+// The text is rendered with the Qt Quick scene graph: bands of lines are
+// painted into images which are used as textures. The bands are kept while
+// scrolling and only invalidated lines are painted again. The caret is a
+// separate node, so blinking does not repaint any text.
 class EXPORT_IMPORT_API ScintillaEditBase : public
 #ifdef PLAT_QT_QML
-	QQuickPaintedItem
+	QQuickItem
 #else
 	QAbstractScrollArea
 #endif
@@ -115,6 +123,14 @@ public:
 	Q_INVOKABLE void enableUpdate(bool enable);
 	Q_INVOKABLE void debug();
 	Q_INVOKABLE virtual void cmdContextMenu(int menuID);
+
+	// Called by the platform layer for Window::InvalidateRectangle() and
+	// Window::InvalidateAll(), rect is in client coordinates.
+	void InvalidateRectangle(const QRect &rect);
+	void InvalidateAll();
+	// Called by ScintillaQt for modifications, lines are display lines. Invalidations
+	// are clipped to the view so cached lines outside of it are invalidated here.
+	void InvalidateHiddenLines(int lineFirst, int lineLast);
 #endif
 
 public slots:
@@ -202,7 +218,8 @@ signals:
 protected:
 	bool event(QEvent *event) override;
 #ifdef PLAT_QT_QML
-	void paint(QPainter *painter) override;
+	void updatePolish() override;
+	QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
 #else
 	void paintEvent(QPaintEvent *event) override;
 #endif	
@@ -264,6 +281,18 @@ private:
 
     void UpdateQuickView();
 
+	struct LineTile {
+		QImage image;
+		unsigned int validLines;	// bit n is set if display line first+n is painted
+		bool imageChanged;			// texture has to be created again
+		int styleClock;				// style clock of the document when painted
+	};
+	static constexpr int tileLines = 16;
+
+	void InvalidateLines(int lineFirst, int lineLast);
+	void PaintTileLines(LineTile &tile, int tileFirst, int lineFirst, int lineEnd);
+	void UpdateCaretRect();
+
 // TODO: set context menu callback... to add more menu items to context menu...
     //QPoint mousePressedPoint;
 	bool enableUpdateFlag;
@@ -276,6 +305,19 @@ private:
 	Qt::InputMethodHints dataInputMethodHints;
     //QTimer aLongTouchTimer;
     qint64 aLastTouchPressTime;
+
+	// Line tiles keyed by their first display line, painted on the GUI thread
+	// in updatePolish() and read by updatePaintNode() while the GUI thread is blocked.
+	std::map<int, LineTile> tiles;
+	int tileTopLine;
+	int tileLineHeight;
+	int tileWidth;
+	int tileXOffset;
+	qreal tileDevicePixelRatio;
+	int tilePartialLine;		// display line at the bottom which is visible only partly, or -1
+	QRectF caretRect;
+	QColor caretColour;
+	bool caretVisible;
 #endif
 
 	Scintilla::ScintillaQt *sqt;
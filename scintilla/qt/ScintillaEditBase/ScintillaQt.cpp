@@ -13,6 +13,9 @@
 
 #include "ScintillaQt.h"
 #include "PlatQt.h"
+#ifdef PLAT_QT_QML
+#include "ScintillaEditBase.h"
+#endif
 
 #include <QApplication>
 #include <QDrag>
@@ -29,7 +32,7 @@ using namespace Scintilla;
 
 
 #ifdef PLAT_QT_QML
-ScintillaQt::ScintillaQt(QQuickPaintedItem *parent)
+ScintillaQt::ScintillaQt(QQuickItem *parent)
 #else
 ScintillaQt::ScintillaQt(QAbstractScrollArea *parent)
 #endif
@@ -55,7 +58,7 @@ ScintillaQt::ScintillaQt(QAbstractScrollArea *parent)
 
 	Init();
 
-	for (TickReason tr = tickCaret; tr <= tickDwell; tr = static_cast<TickReason>(tr + 1)) {
+	for (TickReason tr = tickCaret; tr <= tickStyleAhead; tr = static_cast<TickReason>(tr + 1)) {
 		timers[tr] = 0;
 	}
 }
@@ -309,7 +312,9 @@ void ScintillaQt::ScrollText(Sci::Line linesToMove)
 	int dy = vs.lineHeight * (linesToMove);
 	scrollArea->viewport()->scroll(0, dy);
 #else
+	// the painted lines are cached, only the newly visible lines have to be painted
 	Q_UNUSED(linesToMove);
+	scrollArea->polish();
 #endif
 }
 
@@ -499,6 +504,51 @@ void ScintillaQt::NotifyURIDropped(const char *uri)
 	NotifyParent(scn);
 }
 
+#ifdef PLAT_QT_QML
+// ScintillaEditBase caches painted lines beyond the view which are not covered
+// by the invalidations of Editor, so tell it about every visible change.
+void ScintillaQt::NotifyModified(Document *document, DocModification mh, void *userData)
+{
+	ScintillaBase::NotifyModified(document, mh, userData);
+	ScintillaEditBase *editor = qobject_cast<ScintillaEditBase *>(scrollArea);
+	if (!editor) {
+		return;
+	}
+	Sci::Line lineFirst = 0;
+	Sci::Line lineLast = 0;
+	if (mh.modificationType & (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT | SC_MOD_CHANGESTYLE | SC_MOD_CHANGEINDICATOR)) {
+		lineFirst = pdoc->SciLineFromPosition(mh.position);
+		lineLast = mh.linesAdded ? pdoc->LinesTotal() : pdoc->SciLineFromPosition(mh.position + mh.length);
+	} else if (mh.modificationType & SC_MOD_CHANGEFOLD) {
+		// Fold changes can change the fold margin of all following lines
+		lineFirst = std::max<Sci::Line>(mh.line - 1, 0);
+		lineLast = pdoc->LinesTotal();
+	} else if (mh.modificationType & (SC_MOD_CHANGEMARKER | SC_MOD_CHANGEMARGIN)) {
+		lineFirst = mh.line;
+		lineLast = mh.line;
+	} else {
+		return;
+	}
+	const int displayFirst = static_cast<int>(pcs->DisplayFromDoc(lineFirst));
+	const int displayLast = (lineLast >= pdoc->LinesTotal() - 1) ?
+		INT_MAX : static_cast<int>(pcs->DisplayLastFromDoc(lineLast));
+	editor->InvalidateHiddenLines(displayFirst, displayLast);
+}
+#endif
+
+void ScintillaQt::TickFor(TickReason reason)
+{
+#ifdef PLAT_QT_QML
+	if (reason == tickCaret && CaretAsNode()) {
+		// Blinking only shows or hides the caret node, the line is not painted again.
+		caret.on = !caret.on;
+		scrollArea->polish();
+		return;
+	}
+#endif
+	ScintillaBase::TickFor(reason);
+}
+
 bool ScintillaQt::FineTickerRunning(TickReason reason)
 {
 	return timers[reason] != 0;
@@ -514,7 +564,7 @@ void ScintillaQt::FineTickerStart(TickReason reason, int millis, int /* toleranc
 // called during destruction.
 void ScintillaQt::CancelTimers()
 {
-	for (TickReason tr = tickCaret; tr <= tickDwell; tr = static_cast<TickReason>(tr + 1)) {
+	for (TickReason tr = tickCaret; tr <= tickStyleAhead; tr = static_cast<TickReason>(tr + 1)) {
 		if (timers[tr]) {
 			killTimer(timers[tr]);
 			timers[tr] = 0;
@@ -901,7 +951,7 @@ void ScintillaQt::PartialPaintQml(const PRectangle & rect, QPainter *painter)
 
 		// Queue a full repaint.
 #ifdef PLAT_QT_QML
-		scrollArea->update();
+		wMain.InvalidateAll();
 #else
 		scrollArea->viewport()->update();
 #endif
@@ -913,6 +963,20 @@ void ScintillaQt::PartialPaintQml(const PRectangle & rect, QPainter *painter)
 #endif
 }
 
+#ifdef PLAT_QT_QML
+// A simple line caret is drawn by ScintillaEditBase as its own scene graph node.
+// Other carets (block, overstrike, multiple selections, dragging) are painted with the text.
+bool ScintillaQt::CaretAsNode() const
+{
+	return sel.Count() == 1 &&
+		!posDrag.IsValid() &&
+		!inOverstrike &&
+		!view.imeCaretBlockOverride &&
+		!BidirectionalEnabled() &&
+		(vs.caretStyle & CARETSTYLE_INS_MASK) == CARETSTYLE_LINE;
+}
+#endif
+
 void ScintillaQt::DragEnter(const Point &point)
 {
 	SetDragPosition(SPositionFromLocation(point,
@@ -952,7 +1016,7 @@ void ScintillaQt::DropUrls(const QMimeData *data)
 
 void ScintillaQt::timerEvent(QTimerEvent *event)
 {
-	for (TickReason tr=tickCaret; tr<=tickDwell; tr = static_cast<TickReason>(tr+1)) {
+	for (TickReason tr=tickCaret; tr<=tickStyleAhead; tr = static_cast<TickReason>(tr+1)) {
 		if (timers[tr] == event->timerId()) {
 			TickFor(tr);
 		}
@@ -19,6 +19,7 @@
 #include <cassert>
 #include <cstring>
 #include <cctype>
+#include <climits>
 #include <cstdio>
 #include <ctime>
 #include <cmath>
@@ -64,7 +65,7 @@
 
 #include <QObject>
 #ifdef PLAT_QT_QML
-#include <QQuickPaintedItem>
+#include <QQuickItem>
 #else
 #include <QAbstractScrollArea>
 #endif
@@ -81,9 +82,9 @@ class ScintillaQt : public QObject, public ScintillaBase {
 
 public:
 #ifdef PLAT_QT_QML
-	explicit ScintillaQt(QQuickPaintedItem *parent);
+	explicit ScintillaQt(QQuickItem *parent);
 	void UpdateInfos(int winId);
-	QQuickPaintedItem * GetScrollArea() { return scrollArea; }
+	QQuickItem * GetScrollArea() { return scrollArea; }
     void selectCurrentWord();
 #else
 	explicit ScintillaQt(QAbstractScrollArea *parent);
@@ -133,7 +134,11 @@ private:
 	void NotifyFocus(bool focus) override;
 	void NotifyParent(SCNotification scn) override;
 	void NotifyURIDropped(const char *uri);
-	int timers[tickDwell+1];
+#ifdef PLAT_QT_QML
+	void NotifyModified(Document *document, DocModification mh, void *userData) override;
+#endif
+	int timers[tickStyleAhead+1];
+	void TickFor(TickReason reason) override;
 	bool FineTickerRunning(TickReason reason) override;
 	void FineTickerStart(TickReason reason, int millis, int tolerance) override;
 	void CancelTimers();
@@ -161,6 +166,7 @@ private:
 
 #ifdef PLAT_QT_QML
 	QPainter * GetPainter() { return currentPainter; }
+	bool CaretAsNode() const;
 #endif
 
 protected:
@@ -178,7 +184,7 @@ protected:
 
 private:
 #ifdef PLAT_QT_QML
-	QQuickPaintedItem *scrollArea;      // is a ScintillaEditBase
+	QQuickItem *scrollArea;      // is a ScintillaEditBase
 #else
 	QAbstractScrollArea *scrollArea;
 #endif
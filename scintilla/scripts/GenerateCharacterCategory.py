@@ -15,32 +15,38 @@ def findCategories(filename):
     print(values)
     return [v[2:] for v in values]
 
+# Characters are looked up in a two-stage table: the index has an entry for
+# each block of 2**blockShift characters that selects one of the distinct
+# blocks which hold the category of each character.
+blockShift = 7
+
+def twoStageTable(categoryValues):
+    blockSize = 1 << blockShift
+    blocks = {}
+    index = []
+    for start in range(0, len(categoryValues), blockSize):
+        block = tuple(categoryValues[start:start+blockSize])
+        index.append(blocks.setdefault(block, len(blocks)))
+    print(len(index), "index entries", len(blocks), "distinct blocks")
+    return index, list(blocks.keys())
+
+def numberLines(values, perLine):
+    return ["".join("%d," % v for v in values[i:i+perLine]) for i in range(0, len(values), perLine)]
+
 def updateCharacterCategory(filename):
     values = ["// Created with Python %s,  Unicode %s" % (
         platform.python_version(), unicodedata.unidata_version)]
 
-    startRange = 0
-    category = unicodedata.category(chr(startRange))
-    table = []
-    for ch in range(sys.maxunicode):
-        uch = chr(ch)
-        current = unicodedata.category(uch)
-        if current != category:
-            value = startRange * 32 + categories.index(category)
-            table.append(value)
-            category = current
-            startRange = ch
-    value = startRange * 32 + categories.index(category)
-    table.append(value)
-
-    # the sentinel value is used to simplify CharacterCategoryMap::Optimize()
-    category = 'Cn'
-    value = (sys.maxunicode + 1)*32 + categories.index(category)
-    table.append(value)
-
-    values.extend(["%d," % value for value in table])
-
-    Regenerate(filename, "//", values)
+    categoryValues = [categories.index(unicodedata.category(chr(ch)))
+        for ch in range(sys.maxunicode + 1)]
+
+    index, blocks = twoStageTable(categoryValues)
+    values.extend(numberLines(index, 32))
+    blockLines = []
+    for block in blocks:
+        blockLines.extend(numberLines(block, 32))
+
+    Regenerate(filename, "//", values, blockLines)
 
 categories = findCategories("../lexlib/CharacterCategory.h")
 
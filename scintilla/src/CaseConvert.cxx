@@ -575,8 +575,8 @@ class CaseConverter : public ICaseConverter {
 		ConversionString() noexcept : conversion{} {
 		}
 	};
-	// Conversions are initially store in a vector of structs but then decomposed into
-	// parallel arrays as that is about 10% faster to search.
+	// Conversions are initially stored in a vector of structs but then moved into
+	// a two-stage table so that finding a conversion takes 2 array accesses.
 	struct CharacterConversion {
 		int character;
 		ConversionString conversion;
@@ -593,8 +593,13 @@ class CaseConverter : public ICaseConverter {
 	};
 	typedef std::vector<CharacterConversion> CharacterToConversion;
 	CharacterToConversion characterToConversion;
-	// The parallel arrays
-	std::vector<int> characters;
+	// blockIndex has an entry for each block of 128 characters up to the last
+	// character with a conversion. It selects one of the distinct blocks in
+	// blocks which hold, for each character, its position in conversions.
+	// Position 0 is an empty conversion used for characters without a conversion.
+	enum { blockShift = 7, blockSize = 1 << blockShift, blockMask = blockSize - 1 };
+	std::vector<unsigned short> blockIndex;
+	std::vector<unsigned short> blocks;
 	std::vector<ConversionString> conversions;
 
 public:
@@ -602,19 +607,19 @@ public:
 	}
 	virtual ~CaseConverter() = default;
 	bool Initialised() const noexcept {
-		return !characters.empty();
+		return !blockIndex.empty();
 	}
 	void Add(int character, const char *conversion) {
 		characterToConversion.emplace_back(character, conversion);
 	}
-	const char *Find(int character) {
-		const std::vector<int>::iterator it = std::lower_bound(characters.begin(), characters.end(), character);
-		if (it == characters.end())
+	const char *Find(int character) const noexcept {
+		const size_t block = static_cast<unsigned int>(character) >> blockShift;
+		if (block >= blockIndex.size())
 			return nullptr;
-		else if (*it == character)
-			return conversions[it - characters.begin()].conversion;
-		else
+		const size_t position = blocks[(blockIndex[block] << blockShift) | (character & blockMask)];
+		if (position == 0)
 			return nullptr;
+		return conversions[position].conversion;
 	}
 	size_t CaseConvertString(char *converted, size_t sizeConverted, const char *mixed, size_t lenMixed) override {
 		size_t lenConverted = 0;
@@ -661,11 +666,27 @@ public:
 	}
 	void FinishedAdding() {
 		std::sort(characterToConversion.begin(), characterToConversion.end());
-		characters.reserve(characterToConversion.size());
-		conversions.reserve(characterToConversion.size());
+		const int lastCharacter = characterToConversion.empty() ? 0 : characterToConversion.back().character;
+		// Lay out the positions for every character then share identical blocks
+		std::vector<unsigned short> positions(((lastCharacter >> blockShift) + 1) << blockShift);
+		conversions.reserve(characterToConversion.size() + 1);
+		conversions.emplace_back();
 		for (const CharacterConversion &chConv : characterToConversion) {
-			characters.push_back(chConv.character);
-			conversions.push_back(chConv.conversion);
+			if (positions[chConv.character] == 0) {
+				positions[chConv.character] = static_cast<unsigned short>(conversions.size());
+				conversions.push_back(chConv.conversion);
+			}
+		}
+		blockIndex.reserve(positions.size() >> blockShift);
+		for (auto start = positions.cbegin(); start != positions.cend(); start += blockSize) {
+			size_t block = 0;
+			while ((block < blocks.size()) && !std::equal(start, start + blockSize, blocks.cbegin() + block)) {
+				block += blockSize;
+			}
+			if (block == blocks.size()) {
+				blocks.insert(blocks.end(), start, start + blockSize);
+			}
+			blockIndex.push_back(static_cast<unsigned short>(block >> blockShift));
 		}
 		// Empty the original calculated data completely
 		CharacterToConversion().swap(characterToConversion);
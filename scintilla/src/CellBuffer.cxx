@@ -17,8 +17,17 @@
 #include <string_view>
 #include <vector>
 #include <algorithm>
+#include <functional>
 #include <memory>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SCI_LINE_END_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SCI_LINE_END_NEON
+#include <arm_neon.h>
+#endif
+
 #include "Platform.h"
 
 #include "Scintilla.h"
@@ -308,6 +317,7 @@ public:
 Action::Action() noexcept {
 	at = startAction;
 	position = 0;
+	data = nullptr;
 	lenData = 0;
 	mayCoalesce = false;
 }
@@ -316,13 +326,9 @@ Action::~Action() {
 }
 
 void Action::Create(actionType at_, Sci::Position position_, const char *data_, Sci::Position lenData_, bool mayCoalesce_) {
-	data = nullptr;
 	position = position_;
 	at = at_;
-	if (lenData_) {
-		data = std::make_unique<char[]>(lenData_);
-		memcpy(&data[0], data_, lenData_);
-	}
+	data = data_;
 	lenData = lenData_;
 	mayCoalesce = mayCoalesce_;
 }
@@ -332,6 +338,68 @@ void Action::Clear() noexcept {
 	lenData = 0;
 }
 
+UndoText::UndoText() noexcept : current(0) {
+}
+
+UndoText::~UndoText() {
+}
+
+// Copy text to the end of the current chunk, starting a new chunk when it does not fit.
+// Text longer than chunkSize is given a chunk of its own size.
+const char *UndoText::Append(const char *s, size_t length) {
+	if (chunks.empty() || (chunks[current].size - chunks[current].used < length)) {
+		const size_t next = chunks.empty() ? 0 : current + 1;
+		if ((next < chunks.size()) && (chunks[next].size < length)) {
+			// Spare chunk too small
+			chunks.resize(next);
+		}
+		if (next == chunks.size()) {
+			Chunk chunk;
+			chunk.size = std::max(length, chunkSize);
+			chunk.text = std::make_unique<char[]>(chunk.size);
+			chunks.push_back(std::move(chunk));
+		}
+		current = next;
+		chunks[current].used = 0;
+	}
+	Chunk &chunk = chunks[current];
+	char *textAppended = chunk.text.get() + chunk.used;
+	memcpy(textAppended, s, length);
+	chunk.used += length;
+	return textAppended;
+}
+
+// Remove all text after end which must be the end of some appended text.
+// One empty chunk is kept to avoid reallocating when text is appended again.
+void UndoText::TruncateTo(const char *end) noexcept {
+	const std::less_equal<const char *> lessEqual;
+	size_t chunk = current;
+	while ((chunk > 0) && !(lessEqual(chunks[chunk].text.get(), end) &&
+		lessEqual(end, chunks[chunk].text.get() + chunks[chunk].used))) {
+		chunk--;
+	}
+	if (chunk < chunks.size()) {
+		chunks[chunk].used = end - chunks[chunk].text.get();
+		if (chunks.size() > chunk + 2) {
+			chunks.resize(chunk + 2);
+		}
+	}
+	current = chunk;
+}
+
+void UndoText::Clear() noexcept {
+	chunks.clear();
+	current = 0;
+}
+
+size_t UndoText::Allocated() const noexcept {
+	size_t allocated = 0;
+	for (const Chunk &chunk : chunks) {
+		allocated += chunk.size;
+	}
+	return allocated;
+}
+
 // The undo history stores a sequence of user operations that represent the user's view of the
 // commands executed on the text.
 // Each user operation contains a sequence of text insertion and text deletion actions.
@@ -358,6 +426,7 @@ UndoHistory::UndoHistory() {
 	undoSequenceDepth = 0;
 	savePoint = 0;
 	tentativePoint = -1;
+	lastActionWithText = -1;
 
 	actions[currentAction].Create(startAction);
 }
@@ -374,6 +443,22 @@ void UndoHistory::EnsureUndoRoom() {
 	}
 }
 
+// Actions from action onwards are being replaced so release their text which is at
+// the end of the undo text.
+void UndoHistory::DiscardTextFrom(int action) noexcept {
+	int act = action - 1;
+	while ((act > 0) && !actions[act].data) {
+		act--;
+	}
+	if ((act > 0) && actions[act].data) {
+		text.TruncateTo(actions[act].data + actions[act].lenData);
+		lastActionWithText = act;
+	} else {
+		text.Clear();
+		lastActionWithText = -1;
+	}
+}
+
 const char *UndoHistory::AppendAction(actionType at, Sci::Position position, const char *data, Sci::Position lengthData,
 	bool &startSequence, bool mayCoalesce) {
 	EnsureUndoRoom();
@@ -438,12 +523,19 @@ const char *UndoHistory::AppendAction(actionType at, Sci::Position position, con
 		currentAction++;
 	}
 	startSequence = oldCurrentAction != currentAction;
-	const int actionWithData = currentAction;
-	actions[currentAction].Create(at, position, data, lengthData, mayCoalesce);
+	if (lastActionWithText >= currentAction) {
+		DiscardTextFrom(currentAction);
+	}
+	const char *dataStored = nullptr;
+	if (lengthData) {
+		dataStored = text.Append(data, lengthData);
+		lastActionWithText = currentAction;
+	}
+	actions[currentAction].Create(at, position, dataStored, lengthData, mayCoalesce);
 	currentAction++;
 	actions[currentAction].Create(startAction);
 	maxAction = currentAction;
-	return actions[actionWithData].data.get();
+	return dataStored;
 }
 
 void UndoHistory::BeginUndoAction() {
@@ -485,6 +577,8 @@ void UndoHistory::DeleteUndoHistory() {
 	actions[currentAction].Create(startAction);
 	savePoint = 0;
 	tentativePoint = -1;
+	text.Clear();
+	lastActionWithText = -1;
 }
 
 void UndoHistory::SetSavePoint() noexcept {
@@ -638,6 +732,11 @@ const char *CellBuffer::RangePointer(Sci::Position position, Sci::Position range
 	return substance.RangePointer(position, rangeLength);
 }
 
+// Text from position that is contiguous in memory, limited by rangeLength and the gap.
+const char *CellBuffer::TextSpan(Sci::Position position, Sci::Position rangeLength, Sci::Position &lengthSpan) const noexcept {
+	return substance.SpanPointer(position, rangeLength, lengthSpan);
+}
+
 Sci::Position CellBuffer::GapPosition() const noexcept {
 	return substance.GapPosition();
 }
@@ -678,13 +777,53 @@ bool CellBuffer::SetStyleFor(Sci::Position position, Sci::Position lengthStyle,
 	bool changed = false;
 	PLATFORM_ASSERT(lengthStyle == 0 ||
 		(lengthStyle > 0 && lengthStyle + position <= style.Length()));
-	while (lengthStyle--) {
-		const char curVal = style.ValueAt(position);
-		if (curVal != styleValue) {
-			style.SetValueAt(position, styleValue);
+	// Work on the contiguous spans either side of the gap so the comparison and fill
+	// are done by the vectorized C library routines instead of per cell.
+	while (lengthStyle > 0) {
+		Sci::Position lengthSpan = 0;
+		char *span = style.SpanPointer(position, lengthStyle, lengthSpan);
+		// All bytes equal the first byte when the span matches itself shifted by one.
+		if ((span[0] != styleValue) || (memcmp(span, span + 1, lengthSpan - 1) != 0)) {
+			memset(span, styleValue, lengthSpan);
+			changed = true;
+		}
+		position += lengthSpan;
+		lengthStyle -= lengthSpan;
+	}
+	return changed;
+}
+
+bool CellBuffer::SetStyles(Sci::Position position, Sci::Position lengthStyle, const char *styles,
+	Sci::Position &startMod, Sci::Position &endMod) noexcept {
+	if (!hasStyles) {
+		return false;
+	}
+	bool changed = false;
+	PLATFORM_ASSERT(lengthStyle == 0 ||
+		(lengthStyle > 0 && lengthStyle + position <= style.Length()));
+	while (lengthStyle > 0) {
+		Sci::Position lengthSpan = 0;
+		char *span = style.SpanPointer(position, lengthStyle, lengthSpan);
+		if (memcmp(span, styles, lengthSpan) != 0) {
+			// Only scan for the ends of the changed range once a difference is known.
+			Sci::Position first = 0;
+			while (span[first] == styles[first]) {
+				first++;
+			}
+			Sci::Position last = lengthSpan - 1;
+			while (span[last] == styles[last]) {
+				last--;
+			}
+			memcpy(span + first, styles + first, last - first + 1);
+			if (!changed) {
+				startMod = position + first;
+			}
+			endMod = position + last;
 			changed = true;
 		}
-		position++;
+		position += lengthSpan;
+		lengthStyle -= lengthSpan;
+		styles += lengthSpan;
 	}
 	return changed;
 }
@@ -936,6 +1075,56 @@ CountWidths CountCharacterWidthsUTF8(std::string_view sv) noexcept {
 	return cw;
 }
 
+// Skip over whole blocks of bytes that can not contain a line end or the final byte of a
+// multi-byte line end (NEL, LS, PS), returning the start of the first block that may.
+// At least one byte is always left before end so callers can peek past a '\r'.
+// Without SIMD support, returns ptr so the caller's byte loop does all the work.
+const char *SkipLineEndFreeBlocks(const char *ptr, const char *end, bool utf8LineEnds) noexcept {
+	constexpr ptrdiff_t blockSize = 16;
+#if defined(SCI_LINE_END_SSE2)
+	const __m128i vLF = _mm_set1_epi8('\n');
+	const __m128i vCR = _mm_set1_epi8('\r');
+	// NEL, LS and PS end with 0x85, 0xa8, and 0xa9 respectively.
+	// Without UTF-8 line ends these compare against '\n' again which is harmless.
+	const __m128i vNEL = _mm_set1_epi8(utf8LineEnds ? static_cast<char>(0x85) : '\n');
+	const __m128i vLS = _mm_set1_epi8(utf8LineEnds ? static_cast<char>(0xa8) : '\n');
+	const __m128i vPS = _mm_set1_epi8(utf8LineEnds ? static_cast<char>(0xa9) : '\n');
+	while (end - ptr > blockSize) {
+		const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+		__m128i found = _mm_or_si128(_mm_cmpeq_epi8(block, vLF), _mm_cmpeq_epi8(block, vCR));
+		found = _mm_or_si128(found, _mm_cmpeq_epi8(block, vNEL));
+		found = _mm_or_si128(found, _mm_cmpeq_epi8(block, vLS));
+		found = _mm_or_si128(found, _mm_cmpeq_epi8(block, vPS));
+		if (_mm_movemask_epi8(found) != 0) {
+			break;
+		}
+		ptr += blockSize;
+	}
+#elif defined(SCI_LINE_END_NEON)
+	const uint8x16_t vLF = vdupq_n_u8('\n');
+	const uint8x16_t vCR = vdupq_n_u8('\r');
+	const uint8x16_t vNEL = vdupq_n_u8(utf8LineEnds ? 0x85 : '\n');
+	const uint8x16_t vLS = vdupq_n_u8(utf8LineEnds ? 0xa8 : '\n');
+	const uint8x16_t vPS = vdupq_n_u8(utf8LineEnds ? 0xa9 : '\n');
+	while (end - ptr > blockSize) {
+		const uint8x16_t block = vld1q_u8(reinterpret_cast<const uint8_t *>(ptr));
+		uint8x16_t found = vorrq_u8(vceqq_u8(block, vLF), vceqq_u8(block, vCR));
+		found = vorrq_u8(found, vceqq_u8(block, vNEL));
+		found = vorrq_u8(found, vceqq_u8(block, vLS));
+		found = vorrq_u8(found, vceqq_u8(block, vPS));
+		if (vmaxvq_u8(found) != 0) {
+			break;
+		}
+		ptr += blockSize;
+	}
+#else
+	(void)end;
+	(void)utf8LineEnds;
+	(void)blockSize;
+#endif
+	return ptr;
+}
+
 }
 
 bool CellBuffer::MaintainingLineCharacterIndex() const noexcept {
@@ -1032,7 +1221,13 @@ void CellBuffer::BasicInsertString(Sci::Position position, const char *s, Sci::P
 		}
 
 		do {
-			// skip to line end
+			// skip blocks without line ends then skip bytes to line end
+			const char *blockEnd = SkipLineEndFreeBlocks(ptr, end, utf8LineEnds != 0);
+			if (blockEnd != ptr) {
+				ptr = blockEnd;
+				chBeforePrev = ptr[-2];
+				chPrev = ptr[-1];
+			}
 			ch = *ptr++;
 			uint8_t type;
 			while ((type = eolTable[ch]) == 0 && ptr < end) {
@@ -1277,7 +1472,7 @@ void CellBuffer::PerformUndoStep() {
 		}
 		BasicDeleteChars(actionStep.position, actionStep.lenData);
 	} else if (actionStep.at == removeAction) {
-		BasicInsertString(actionStep.position, actionStep.data.get(), actionStep.lenData);
+		BasicInsertString(actionStep.position, actionStep.data, actionStep.lenData);
 	}
 	uh.CompletedUndoStep();
 }
@@ -1297,7 +1492,7 @@ const Action &CellBuffer::GetRedoStep() const {
 void CellBuffer::PerformRedoStep() {
 	const Action &actionStep = uh.GetRedoStep();
 	if (actionStep.at == insertAction) {
-		BasicInsertString(actionStep.position, actionStep.data.get(), actionStep.lenData);
+		BasicInsertString(actionStep.position, actionStep.data, actionStep.lenData);
 	} else if (actionStep.at == removeAction) {
 		BasicDeleteChars(actionStep.position, actionStep.lenData);
 	}
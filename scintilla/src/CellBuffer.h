@@ -34,7 +34,7 @@ class Action {
 public:
 	actionType at;
 	Sci::Position position;
-	std::unique_ptr<char[]> data;
+	const char *data;	///< Owned by the UndoText of the history
 	Sci::Position lenData;
 	bool mayCoalesce;
 
@@ -50,18 +50,50 @@ public:
 	void Clear() noexcept;
 };
 
+/**
+ * Holds the text of undo actions in large chunks so that each action does not need
+ * its own allocation. Text is only added to and removed from the end.
+ */
+class UndoText {
+	struct Chunk {
+		std::unique_ptr<char[]> text;
+		size_t size = 0;
+		size_t used = 0;
+	};
+	std::vector<Chunk> chunks;
+	size_t current;
+public:
+	static constexpr size_t chunkSize = 0x10000;
+
+	UndoText() noexcept;
+	// Deleted so UndoText objects can not be copied.
+	UndoText(const UndoText &) = delete;
+	UndoText(UndoText &&) = delete;
+	void operator=(const UndoText &) = delete;
+	void operator=(UndoText &&) = delete;
+	~UndoText();
+
+	const char *Append(const char *s, size_t length);
+	void TruncateTo(const char *end) noexcept;
+	void Clear() noexcept;
+	size_t Allocated() const noexcept;
+};
+
 /**
  *
  */
 class UndoHistory {
 	std::vector<Action> actions;
+	UndoText text;
 	int maxAction;
 	int currentAction;
 	int undoSequenceDepth;
 	int savePoint;
 	int tentativePoint;
+	int lastActionWithText;
 
 	void EnsureUndoRoom();
+	void DiscardTextFrom(int action) noexcept;
 
 public:
 	UndoHistory();
@@ -149,6 +181,7 @@ public:
 	void GetStyleRange(unsigned char *buffer, Sci::Position position, Sci::Position lengthRetrieve) const;
 	const char *BufferPointer();
 	const char *RangePointer(Sci::Position position, Sci::Position rangeLength) noexcept;
+	const char *TextSpan(Sci::Position position, Sci::Position rangeLength, Sci::Position &lengthSpan) const noexcept;
 	Sci::Position GapPosition() const noexcept;
 
 	Sci::Position Length() const noexcept;
@@ -174,6 +207,9 @@ public:
 	/// @return true if the style of a character is changed.
 	bool SetStyleAt(Sci::Position position, char styleValue) noexcept;
 	bool SetStyleFor(Sci::Position position, Sci::Position lengthStyle, char styleValue) noexcept;
+	/// Copy a run of styles, setting startMod and endMod to the first and last changed positions.
+	bool SetStyles(Sci::Position position, Sci::Position lengthStyle, const char *styles,
+		Sci::Position &startMod, Sci::Position &endMod) noexcept;
 
 	const char *DeleteChars(Sci::Position position, Sci::Position deleteLength, bool &startSequence);
 
@@ -16,10 +16,15 @@
 #include <string>
 #include <string_view>
 #include <vector>
+#include <map>
 #include <forward_list>
 #include <algorithm>
+#include <functional>
 #include <memory>
 #include <chrono>
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 #ifndef NO_CXX11_REGEX
 #include <regex>
@@ -49,8 +54,557 @@
 
 using namespace Scintilla;
 
+namespace Scintilla {
+
+/**
+ * StyleAhead lexes a window of text after the styled part of a document on a worker thread.
+ * When the worker starts it copies the text, styles, line starts, fold levels and line states of
+ * the window and of some context before and after it, so starting a worker takes time in
+ * proportion to the window and not to the document.
+ * If the lexer asks for anything that was not copied then the worker stops and its results from
+ * that point are dropped so the UI thread styles that text instead.
+ * Results are handed back in chunks that the UI thread applies to the document as long as the
+ * document has not been modified in the meantime. The UI thread never waits for the worker.
+ * Only one thread at a time may call into the lexer instance so the worker must be stopped
+ * before the lexer is used or changed on the UI thread.
+ */
+class StyleAhead : public IDocument {
+public:
+	struct DecorationFill {
+		int indicator;
+		Sci::Position position;
+		int value;
+		Sci::Position fillLength;
+	};
+	struct Chunk {
+		Sci::Position start = 0;	///< First position styled, may be before the end of the previous chunk
+		std::vector<char> styles;
+		std::vector<std::pair<Sci::Line, int>> levels;
+		std::vector<std::pair<Sci::Line, int>> lineStates;
+		std::vector<std::pair<Sci::Position, Sci::Position>> lexerStates;
+		std::vector<DecorationFill> decorations;
+		int errorStatus = 0;
+	};
+	// Lex this many bytes, rounded up to whole lines, between publishing results
+	static constexpr Sci::Position chunkSize = 0x40000;
+	// Each worker lexes this many bytes, rounded up to whole lines
+	static constexpr Sci::Position windowSize = 0x100000;
+	// Copied before and after the window for lexers that look back or ahead
+	static constexpr Sci::Line contextLines = 64;
+	static constexpr Sci::Position contextBytes = 0x4000;
+private:
+	ILexer5 *instance;
+	const int modificationClock;
+	const int codePage;
+	const int lineEndTypes;
+	const int tabInChars;
+	const Sci::Position lengthDocument;
+	const Sci::Line linesDocument;
+	Sci::Position textStart;	///< Document position of text[0]
+	Sci::Line lineFirst;	///< Document line of levels[0]
+	Sci::Position lexEnd;
+	std::vector<char> text;
+	std::vector<char> styles;
+	std::vector<Sci::Position> lineStarts;	///< One more than levels
+	std::vector<int> levels;
+	std::vector<int> lineStates;
+	Sci::Position endStyled;
+	int currentIndicator;
+	Chunk current;
+	mutable bool outside;	///< Lexer asked for something that was not copied
+
+	std::atomic<bool> cancel;
+	std::mutex mutex;
+	std::vector<Chunk> completed;
+	bool finished;
+	bool failed;
+	std::thread worker;
+
+	Sci::Position TextEnd() const noexcept;
+	bool Copied(Sci::Position position, Sci::Position length) const noexcept;
+	bool CopiedLine(Sci::Line line) const noexcept;
+	unsigned char CharAt(Sci::Position position) const noexcept;
+	Sci::Position NextPosition(Sci::Position pos, int moveDir) const noexcept;
+	void Run();
+public:
+	StyleAhead(Document *pdoc, ILexer5 *instance_);
+	// Deleted so StyleAhead objects can not be copied.
+	StyleAhead(const StyleAhead &) = delete;
+	StyleAhead(StyleAhead &&) = delete;
+	StyleAhead &operator=(const StyleAhead &) = delete;
+	StyleAhead &operator=(StyleAhead &&) = delete;
+	virtual ~StyleAhead();
+
+	static bool Supports(const Document *pdoc) noexcept;
+	bool Current(const Document *pdoc) const noexcept;
+	bool Take(std::vector<Chunk> &chunks);
+	bool Failed() const noexcept;
+	void Stop() noexcept;
+
+	int SCI_METHOD Version() const override;
+	void SCI_METHOD SetErrorStatus(int status) override;
+	Sci_Position SCI_METHOD Length() const override;
+	void SCI_METHOD GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const override;
+	char SCI_METHOD StyleAt(Sci_Position position) const override;
+	Sci_Position SCI_METHOD LineFromPosition(Sci_Position position) const override;
+	Sci_Position SCI_METHOD LineStart(Sci_Position line) const override;
+	int SCI_METHOD GetLevel(Sci_Position line) const override;
+	int SCI_METHOD SetLevel(Sci_Position line, int level) override;
+	int SCI_METHOD GetLineState(Sci_Position line) const override;
+	int SCI_METHOD SetLineState(Sci_Position line, int state) override;
+	void SCI_METHOD StartStyling(Sci_Position position) override;
+	bool SCI_METHOD SetStyleFor(Sci_Position length, char style) override;
+	bool SCI_METHOD SetStyles(Sci_Position length, const char *styles_) override;
+	void SCI_METHOD DecorationSetCurrentIndicator(int indicator) override;
+	void SCI_METHOD DecorationFillRange(Sci_Position position, int value, Sci_Position fillLength) override;
+	void SCI_METHOD ChangeLexerState(Sci_Position start, Sci_Position end) override;
+	int SCI_METHOD CodePage() const override;
+	bool SCI_METHOD IsDBCSLeadByte(char ch) const override;
+	const char * SCI_METHOD BufferPointer() override;
+	int SCI_METHOD GetLineIndentation(Sci_Position line) override;
+	Sci_Position SCI_METHOD LineEnd(Sci_Position line) const override;
+	Sci_Position SCI_METHOD GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const override;
+	int SCI_METHOD GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const override;
+};
+
+}
+
+StyleAhead::StyleAhead(Document *pdoc, ILexer5 *instance_) :
+	instance(instance_),
+	modificationClock(pdoc->GetModificationClock()),
+	codePage(pdoc->dbcsCodePage),
+	lineEndTypes(pdoc->GetLineEndTypesActive()),
+	tabInChars(pdoc->tabInChars),
+	lengthDocument(pdoc->Length()),
+	linesDocument(pdoc->LinesTotal()),
+	textStart(0),
+	lineFirst(0),
+	lexEnd(0),
+	endStyled(pdoc->GetEndStyled()),
+	currentIndicator(0),
+	outside(false),
+	cancel(false),
+	finished(false),
+	failed(false) {
+	const Sci::Line lineStyled = pdoc->SciLineFromPosition(endStyled);
+	lexEnd = pdoc->LineStart(pdoc->SciLineFromPosition(std::min(endStyled + windowSize, lengthDocument)) + 1);
+	textStart = std::min(pdoc->LineStart(std::max<Sci::Line>(lineStyled - contextLines, 0)),
+		std::max<Sci::Position>(endStyled - contextBytes, 0));
+	const Sci::Line lineLexEnd = pdoc->SciLineFromPosition(lexEnd);
+	const Sci::Position textEnd = std::min(std::max(pdoc->LineStart(lineLexEnd + contextLines), lexEnd + contextBytes),
+		lengthDocument);
+	text.resize(textEnd - textStart);
+	pdoc->GetCharRange(text.data(), textStart, text.size());
+	styles.resize(text.size());
+	pdoc->GetStyleRange(reinterpret_cast<unsigned char *>(styles.data()), textStart, styles.size());
+	lineFirst = pdoc->SciLineFromPosition(textStart);
+	const Sci::Line lineLast = std::min(pdoc->SciLineFromPosition(textEnd) + 1, linesDocument);
+	lineStarts.resize(lineLast - lineFirst + 1);
+	levels.resize(lineLast - lineFirst);
+	lineStates.resize(lineLast - lineFirst);
+	for (Sci::Line line = lineFirst; line < lineLast; line++) {
+		lineStarts[line - lineFirst] = pdoc->LineStart(line);
+		levels[line - lineFirst] = pdoc->GetLevel(line);
+		lineStates[line - lineFirst] = pdoc->GetLineState(line);
+	}
+	lineStarts.back() = pdoc->LineStart(lineLast);
+	current.start = endStyled;
+	worker = std::thread(&StyleAhead::Run, this);
+}
+
+StyleAhead::~StyleAhead() {
+	Stop();
+}
+
+// DBCS lexing needs the code page tables of Document so is left to the UI thread
+bool StyleAhead::Supports(const Document *pdoc) noexcept {
+	return (pdoc->dbcsCodePage == 0) || (pdoc->dbcsCodePage == SC_CP_UTF8);
+}
+
+bool StyleAhead::Current(const Document *pdoc) const noexcept {
+	return modificationClock == pdoc->GetModificationClock();
+}
+
+Sci::Position StyleAhead::TextEnd() const noexcept {
+	return textStart + text.size();
+}
+
+bool StyleAhead::Copied(Sci::Position position, Sci::Position length) const noexcept {
+	return (position >= textStart) && (position + length <= TextEnd());
+}
+
+bool StyleAhead::CopiedLine(Sci::Line line) const noexcept {
+	return (line >= lineFirst) && (line < lineFirst + static_cast<Sci::Line>(levels.size()));
+}
+
+unsigned char StyleAhead::CharAt(Sci::Position position) const noexcept {
+	if (!Copied(position, 1)) {
+		if ((position >= 0) && (position < lengthDocument))
+			outside = true;
+		return 0;
+	}
+	return text[position - textStart];
+}
+
+void StyleAhead::Run() {
+	try {
+		while (!cancel && (endStyled < lexEnd)) {
+			const Sci::Position start = LineStart(LineFromPosition(endStyled));
+			const Sci::Position end = std::min(
+				LineStart(LineFromPosition(std::min(start + chunkSize, lexEnd)) + 1), lexEnd);
+			current.start = std::min(current.start, start);
+			const int styleStart = (start > 0) ? StyleAt(start - 1) : 0;
+			instance->Lex(start, end - start, styleStart, this);
+			instance->Fold(start, end - start, styleStart, this);
+			if (outside || (endStyled < end)) {
+				// Lexer needed text that was not copied or did not style the range it
+				// was given so leave this part to the UI thread
+				break;
+			}
+			current.styles.assign(styles.begin() + (current.start - textStart), styles.begin() + (endStyled - textStart));
+			Chunk chunk = std::move(current);
+			current = Chunk();
+			current.start = endStyled;
+			std::lock_guard<std::mutex> guard(mutex);
+			completed.push_back(std::move(chunk));
+		}
+	} catch (...) {
+		// Failure to lex ahead is not fatal as the UI thread styles whatever is left.
+		outside = true;
+	}
+	std::lock_guard<std::mutex> guard(mutex);
+	failed = !cancel && (outside || (endStyled < lexEnd));
+	finished = true;
+}
+
+// Move completed chunks into chunks without waiting.
+// Returns true when the worker has finished and there will be no more chunks.
+bool StyleAhead::Take(std::vector<Chunk> &chunks) {
+	std::lock_guard<std::mutex> guard(mutex);
+	chunks = std::move(completed);
+	completed.clear();
+	return finished;
+}
+
+// Whether the worker stopped before the end of its window. Only valid after Take returned true.
+bool StyleAhead::Failed() const noexcept {
+	return failed;
+}
+
+void StyleAhead::Stop() noexcept {
+	cancel = true;
+	if (worker.joinable()) {
+		try {
+			worker.join();
+		} catch (...) {
+			// Only fails when the thread can not be joined
+		}
+	}
+}
+
+int SCI_METHOD StyleAhead::Version() const {
+	return dvRelease4;
+}
+
+void SCI_METHOD StyleAhead::SetErrorStatus(int status) {
+	current.errorStatus = status;
+}
+
+Sci_Position SCI_METHOD StyleAhead::Length() const {
+	return lengthDocument;
+}
+
+void SCI_METHOD StyleAhead::GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const {
+	if ((position < 0) || (lengthRetrieve <= 0) || (position + lengthRetrieve > lengthDocument))
+		return;
+	if (!Copied(position, lengthRetrieve)) {
+		outside = true;
+		memset(buffer, 0, lengthRetrieve);
+		return;
+	}
+	memcpy(buffer, text.data() + position - textStart, lengthRetrieve);
+}
+
+char SCI_METHOD StyleAhead::StyleAt(Sci_Position position) const {
+	if ((position < 0) || (position >= lengthDocument))
+		return 0;
+	if (!Copied(position, 1)) {
+		outside = true;
+		return 0;
+	}
+	return styles[position - textStart];
+}
+
+Sci_Position SCI_METHOD StyleAhead::LineFromPosition(Sci_Position position) const {
+	if (position <= 0)
+		return 0;
+	if (position >= lengthDocument)
+		return linesDocument - 1;
+	if (!Copied(position, 0)) {
+		outside = true;
+		return lineFirst;
+	}
+	const auto itEnd = lineStarts.begin() + levels.size();
+	const auto it = std::upper_bound(lineStarts.begin(), itEnd, position);
+	return lineFirst + std::max<Sci::Line>(it - lineStarts.begin() - 1, 0);
+}
+
+Sci_Position SCI_METHOD StyleAhead::LineStart(Sci_Position line) const {
+	if (line <= 0)
+		return 0;
+	if (line >= linesDocument)
+		return lengthDocument;
+	if (!CopiedLine(line) && (line != lineFirst + static_cast<Sci::Line>(levels.size()))) {
+		outside = true;
+		return textStart;
+	}
+	return lineStarts[line - lineFirst];
+}
+
+int SCI_METHOD StyleAhead::GetLevel(Sci_Position line) const {
+	if ((line < 0) || (line >= linesDocument))
+		return SC_FOLDLEVELBASE;
+	if (!CopiedLine(line)) {
+		outside = true;
+		return SC_FOLDLEVELBASE;
+	}
+	return levels[line - lineFirst];
+}
+
+int SCI_METHOD StyleAhead::SetLevel(Sci_Position line, int level) {
+	if ((line < 0) || (line >= linesDocument))
+		return SC_FOLDLEVELBASE;
+	if (!CopiedLine(line)) {
+		outside = true;
+		return SC_FOLDLEVELBASE;
+	}
+	const int prev = levels[line - lineFirst];
+	if (prev != level) {
+		levels[line - lineFirst] = level;
+		current.levels.emplace_back(line, level);
+	}
+	return prev;
+}
+
+int SCI_METHOD StyleAhead::GetLineState(Sci_Position line) const {
+	if ((line < 0) || (line >= linesDocument))
+		return 0;
+	if (!CopiedLine(line)) {
+		outside = true;
+		return 0;
+	}
+	return lineStates[line - lineFirst];
+}
+
+int SCI_METHOD StyleAhead::SetLineState(Sci_Position line, int state) {
+	if ((line < 0) || (line >= linesDocument))
+		return 0;
+	if (!CopiedLine(line)) {
+		outside = true;
+		return 0;
+	}
+	const int statePrevious = lineStates[line - lineFirst];
+	if (statePrevious != state) {
+		lineStates[line - lineFirst] = state;
+		current.lineStates.emplace_back(line, state);
+	}
+	return statePrevious;
+}
+
+void SCI_METHOD StyleAhead::StartStyling(Sci_Position position) {
+	if (!Copied(position, 0)) {
+		outside = true;
+		return;
+	}
+	endStyled = position;
+	current.start = std::min(current.start, endStyled);
+}
+
+bool SCI_METHOD StyleAhead::SetStyleFor(Sci_Position length, char style) {
+	if ((length < 0) || !Copied(endStyled, length)) {
+		outside = outside || (endStyled + length <= lengthDocument);
+		return false;
+	}
+	std::fill(styles.begin() + (endStyled - textStart), styles.begin() + (endStyled - textStart + length), style);
+	endStyled += length;
+	return true;
+}
+
+bool SCI_METHOD StyleAhead::SetStyles(Sci_Position length, const char *styles_) {
+	if ((length < 0) || !Copied(endStyled, length)) {
+		outside = outside || (endStyled + length <= lengthDocument);
+		return false;
+	}
+	std::copy(styles_, styles_ + length, styles.begin() + (endStyled - textStart));
+	endStyled += length;
+	return true;
+}
+
+void SCI_METHOD StyleAhead::DecorationSetCurrentIndicator(int indicator) {
+	currentIndicator = indicator;
+}
+
+void SCI_METHOD StyleAhead::DecorationFillRange(Sci_Position position, int value, Sci_Position fillLength) {
+	current.decorations.push_back({currentIndicator, position, value, fillLength});
+}
+
+void SCI_METHOD StyleAhead::ChangeLexerState(Sci_Position start, Sci_Position end) {
+	current.lexerStates.emplace_back(start, end);
+}
+
+int SCI_METHOD StyleAhead::CodePage() const {
+	return codePage;
+}
+
+bool SCI_METHOD StyleAhead::IsDBCSLeadByte(char) const {
+	return false;
+}
+
+// Only a window of the document is copied so there is no pointer to the whole text.
+// No lexer currently calls this so treat the call as needing text that was not copied.
+const char * SCI_METHOD StyleAhead::BufferPointer() {
+	outside = true;
+	cancel = true;
+	return text.data();
+}
+
+int SCI_METHOD StyleAhead::GetLineIndentation(Sci_Position line) {
+	int indent = 0;
+	if ((line >= 0) && (line < linesDocument)) {
+		for (Sci::Position i = LineStart(line); i < lengthDocument; i++) {
+			const unsigned char ch = CharAt(i);
+			if (ch == ' ')
+				indent++;
+			else if (ch == '\t')
+				indent = ((indent / tabInChars) + 1) * tabInChars;
+			else
+				return indent;
+		}
+	}
+	return indent;
+}
+
+Sci_Position SCI_METHOD StyleAhead::LineEnd(Sci_Position line) const {
+	if (line >= linesDocument - 1) {
+		return LineStart(line + 1);
+	}
+	Sci::Position position = LineStart(line + 1);
+	if ((SC_LINE_END_TYPE_UNICODE == lineEndTypes) && (position >= 3)) {
+		const unsigned char bytes[] = {
+			CharAt(position-3),
+			CharAt(position-2),
+			CharAt(position-1),
+		};
+		if (UTF8IsSeparator(bytes)) {
+			return position - UTF8SeparatorLength;
+		}
+		if (UTF8IsNEL(bytes+1)) {
+			return position - UTF8NELLength;
+		}
+	}
+	position--; // Back over CR or LF
+	// When line terminator is CR+LF, may need to go back one more
+	if ((position > LineStart(line)) && (CharAt(position - 1) == '\r')) {
+		position--;
+	}
+	return position;
+}
+
+// Only handles UTF-8 as DBCS documents are not styled ahead
+Sci::Position StyleAhead::NextPosition(Sci::Position pos, int moveDir) const noexcept {
+	if (moveDir > 0) {
+		if (pos >= lengthDocument)
+			return pos;
+		const unsigned char leadByte = CharAt(pos);
+		if (UTF8IsAscii(leadByte))
+			return pos + 1;
+		const int widthCharBytes = UTF8BytesOfLead[leadByte];
+		unsigned char charBytes[UTF8MaxBytes] = {leadByte,0,0,0};
+		for (int b=1; b<widthCharBytes && (pos+b < lengthDocument); b++)
+			charBytes[b] = CharAt(pos+b);
+		const int utf8status = UTF8Classify(charBytes, widthCharBytes);
+		return pos + ((utf8status & UTF8MaskInvalid) ? 1 : (utf8status & UTF8MaskWidth));
+	} else {
+		if (pos <= 0)
+			return pos;
+		// Back over up to 3 trail bytes to a lead byte of a character that ends at pos
+		for (Sci::Position start = pos - 1; (start >= 0) && (start >= pos - UTF8MaxBytes); start--) {
+			const unsigned char ch = CharAt(start);
+			if (!UTF8IsTrailByte(ch)) {
+				if (start < pos - 1) {
+					unsigned char charBytes[UTF8MaxBytes] = {0,0,0,0};
+					for (Sci::Position b = start; b < pos; b++)
+						charBytes[b - start] = CharAt(b);
+					const int utf8status = UTF8Classify(charBytes, static_cast<int>(pos - start));
+					if (!(utf8status & UTF8MaskInvalid) && ((utf8status & UTF8MaskWidth) == pos - start))
+						return start;
+				}
+				break;
+			}
+		}
+		return pos - 1;
+	}
+}
+
+// Return -1  on out-of-bounds
+Sci_Position SCI_METHOD StyleAhead::GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const {
+	Sci::Position pos = positionStart;
+	if (codePage) {
+		const int increment = (characterOffset > 0) ? 1 : -1;
+		while (characterOffset != 0) {
+			const Sci::Position posNext = NextPosition(pos, increment);
+			if (posNext == pos)
+				return INVALID_POSITION;
+			pos = posNext;
+			characterOffset -= increment;
+		}
+	} else {
+		pos = positionStart + characterOffset;
+		if ((pos < 0) || (pos > lengthDocument))
+			return INVALID_POSITION;
+	}
+	return pos;
+}
+
+int SCI_METHOD StyleAhead::GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const {
+	int character;
+	int bytesInCharacter = 1;
+	const unsigned char leadByte = (position >= 0 && position < lengthDocument) ? CharAt(position) : 0;
+	if (codePage && !UTF8IsAscii(leadByte)) {
+		const int widthCharBytes = UTF8BytesOfLead[leadByte];
+		unsigned char charBytes[UTF8MaxBytes] = {leadByte,0,0,0};
+		for (int b=1; b<widthCharBytes && (position+b < lengthDocument); b++)
+			charBytes[b] = CharAt(position+b);
+		const int utf8status = UTF8Classify(charBytes, widthCharBytes);
+		if (utf8status & UTF8MaskInvalid) {
+			// Report as singleton surrogate values which are invalid Unicode
+			character =  0xDC80 + leadByte;
+		} else {
+			bytesInCharacter = utf8status & UTF8MaskWidth;
+			character = UnicodeFromUTF8(charBytes);
+		}
+	} else {
+		character = leadByte;
+	}
+	if (pWidth) {
+		*pWidth = bytesInCharacter;
+	}
+	return character;
+}
+
+LexInterface::LexInterface(Document *pdoc_) noexcept :
+	pdoc(pdoc_), instance(nullptr), performingStyle(false), styleAheadFailed(-1) {
+}
+
+LexInterface::~LexInterface() {
+	StopStyleAhead();
+}
+
 void LexInterface::Colourise(Sci::Position start, Sci::Position end) {
 	if (pdoc && instance && !performingStyle) {
+		// The lexer can only be used by one thread at a time
+		StopStyleAhead();
+
 		// Protect against reentrance, which may occur, for example, when
 		// fold points are discovered while performing styling and the folding
 		// code looks for child lines which may trigger styling.
@@ -77,6 +631,92 @@ void LexInterface::Colourise(Sci::Position start, Sci::Position end) {
 	}
 }
 
+// Apply chunks styled by the worker that are still valid for the document.
+// Returns true when the worker has finished.
+bool LexInterface::TakeStyleAhead() {
+	std::vector<StyleAhead::Chunk> chunks;
+	const bool finished = styleAhead->Take(chunks);
+	// Applying chunks notifies watchers which may ask for styling
+	performingStyle = true;
+	for (const StyleAhead::Chunk &chunk : chunks) {
+		const Sci::Position chunkEnd = chunk.start + chunk.styles.size();
+		if (!styleAhead->Current(pdoc) || (chunk.start > pdoc->GetEndStyled())) {
+			// Document changed or styles do not join up
+			break;
+		}
+		if (chunkEnd <= pdoc->GetEndStyled()) {
+			// Already styled on this thread
+			continue;
+		}
+		pdoc->StartStyling(chunk.start);
+		pdoc->SetStyles(chunk.styles.size(), chunk.styles.data());
+		for (const std::pair<Sci::Line, int> &lineState : chunk.lineStates) {
+			pdoc->SetLineState(lineState.first, lineState.second);
+		}
+		for (const std::pair<Sci::Line, int> &level : chunk.levels) {
+			pdoc->SetLevel(level.first, level.second);
+		}
+		for (const std::pair<Sci::Position, Sci::Position> &lexerState : chunk.lexerStates) {
+			pdoc->ChangeLexerState(lexerState.first, lexerState.second);
+		}
+		for (const StyleAhead::DecorationFill &fill : chunk.decorations) {
+			pdoc->DecorationSetCurrentIndicator(fill.indicator);
+			pdoc->DecorationFillRange(fill.position, fill.value, fill.fillLength);
+		}
+		if (chunk.errorStatus) {
+			pdoc->SetErrorStatus(chunk.errorStatus);
+		}
+	}
+	performingStyle = false;
+	return finished;
+}
+
+// Called in idle time once the visible text is styled. Applies what the worker has done so far
+// without waiting for it and starts a worker on the next window when the last one has finished.
+// Returns false when the worker can not be used and the text should be styled on this thread.
+bool LexInterface::StyleAheadIdle() {
+	if (!pdoc || !instance || performingStyle || !StyleAhead::Supports(pdoc))
+		return false;
+	if (styleAhead && !styleAhead->Current(pdoc)) {
+		StopStyleAhead();
+	}
+	if (styleAhead && TakeStyleAhead()) {
+		if (styleAhead->Failed()) {
+			styleAheadFailed = pdoc->GetEndStyled();
+		}
+		StopStyleAhead();
+	}
+	if (!styleAhead && (pdoc->GetEndStyled() < pdoc->Length())) {
+		if (pdoc->GetEndStyled() == styleAheadFailed) {
+			// The lexer needed more than the worker copied so style from here on this thread
+			return false;
+		}
+		styleAhead = std::make_unique<StyleAhead>(pdoc, instance);
+	}
+	return true;
+}
+
+bool LexInterface::StyleAheadRunning() const noexcept {
+	return static_cast<bool>(styleAhead);
+}
+
+// Use what the worker has already styled then, if that does not reach pos, stop the worker
+// so the lexer can style synchronously.
+void LexInterface::StyleAheadTo(Sci::Position pos) {
+	if (styleAhead && !performingStyle) {
+		if (styleAhead->Current(pdoc)) {
+			TakeStyleAhead();
+		}
+		if (pos > pdoc->GetEndStyled()) {
+			StopStyleAhead();
+		}
+	}
+}
+
+void LexInterface::StopStyleAhead() noexcept {
+	styleAhead.reset();
+}
+
 int LexInterface::LineEndTypesSupported() {
 	if (instance) {
 		return instance->LineEndTypesSupported();
@@ -119,6 +759,7 @@ Document::Document(int options) :
 	lineEndBitSet = SC_LINE_END_TYPE_DEFAULT;
 	endStyled = 0;
 	styleClock = 0;
+	modificationClock = 0;
 	enteredModification = 0;
 	enteredStyling = 0;
 	enteredReadOnlyCount = 0;
@@ -306,7 +947,7 @@ void Document::TentativeUndo() {
 						modFlags |= SC_MULTILINEUNDOREDO;
 				}
 				NotifyModified(DocModification(modFlags, action.position, action.lenData,
-											   linesAdded, action.data.get()));
+											   linesAdded, action.data));
 			}
 
 			const bool endSavePoint = cb.IsSavePoint();
@@ -327,6 +968,10 @@ Sci::Line Document::MarkerNext(Sci::Line lineStart, int mask) const noexcept {
 	return Markers()->MarkerNext(lineStart, mask);
 }
 
+Sci::Line Document::MarkerPrevious(Sci::Line lineStart, int mask) const noexcept {
+	return Markers()->MarkerPrevious(lineStart, mask);
+}
+
 int Document::AddMark(Sci::Line line, int markerNum) {
 	if (line >= 0 && line <= LinesTotal()) {
 		const int prev = Markers()->AddMark(line, markerNum, LinesTotal());
@@ -366,9 +1011,18 @@ void Document::DeleteMarkFromHandle(int markerHandle) {
 
 void Document::DeleteAllMarks(int markerNum) {
 	bool someChanges = false;
-	for (Sci::Line line = 0; line < LinesTotal(); line++) {
-		if (Markers()->DeleteMark(line, markerNum, true))
-			someChanges = true;
+	if ((markerNum >= -1) && (markerNum <= MARKER_MAX)) {
+		// Only visit lines with the marker
+		const int mask = (markerNum == -1) ? ~0 : static_cast<int>(1U << markerNum);
+		for (Sci::Line line = MarkerNext(0, mask); line >= 0; line = MarkerNext(line + 1, mask)) {
+			if (Markers()->DeleteMark(line, markerNum, true))
+				someChanges = true;
+		}
+	} else {
+		for (Sci::Line line = 0; line < LinesTotal(); line++) {
+			if (Markers()->DeleteMark(line, markerNum, true))
+				someChanges = true;
+		}
 	}
 	if (someChanges) {
 		DocModification mh(SC_MOD_CHANGEMARKER);
@@ -1183,6 +1837,8 @@ EncodingFamily Document::CodePageFamily() const noexcept {
 }
 
 void Document::ModifiedAt(Sci::Position pos) noexcept {
+	// Any change invalidates text copied for styling ahead, even after endStyled
+	modificationClock++;
 	if (endStyled > pos)
 		endStyled = pos;
 }
@@ -1381,7 +2037,7 @@ Sci::Position Document::Undo() {
 						modFlags |= SC_MULTILINEUNDOREDO;
 				}
 				NotifyModified(DocModification(modFlags, action.position, action.lenData,
-											   linesAdded, action.data.get()));
+											   linesAdded, action.data));
 			}
 
 			const bool endSavePoint = cb.IsSavePoint();
@@ -1441,7 +2097,7 @@ Sci::Position Document::Redo() {
 				}
 				NotifyModified(
 					DocModification(modFlags, action.position, action.lenData,
-									linesAdded, action.data.get()));
+									linesAdded, action.data));
 			}
 
 			const bool endSavePoint = cb.IsSavePoint();
@@ -1972,6 +2628,7 @@ bool Document::HasCaseFolder() const noexcept {
 
 void Document::SetCaseFolder(CaseFolder *pcf_) noexcept {
 	pcf.reset(pcf_);
+	foldTable.clear();
 }
 
 Document::CharacterExtracted Document::ExtractCharacter(Sci::Position position) const noexcept {
@@ -2030,6 +2687,12 @@ Sci::Position Document::FindText(Sci::Position minPos, Sci::Position maxPos, con
 			pos = NextPosition(pos, increment);
 		}
 		if (caseSensitive) {
+			// Every byte is a character start in single byte encodings and, as long as the
+			// search does not start with a trail byte, every match is a character start in UTF-8.
+			if (forward && (!dbcsCodePage ||
+				((SC_CP_UTF8 == dbcsCodePage) && !UTF8IsTrailByte(search[0])))) {
+				return FindBytes(pos, limitPos, std::string_view(search, lengthFind), nullptr, word, wordStart);
+			}
 			const Sci::Position endSearch = (startPos <= endPos) ? endPos - lengthFind + 1 : endPos;
 			const char charStartSearch =  search[0];
 			while (forward ? (pos < endSearch) : (pos >= endSearch)) {
@@ -2138,6 +2801,20 @@ Sci::Position Document::FindText(Sci::Position minPos, Sci::Position maxPos, con
 			const Sci::Position endSearch = (startPos <= endPos) ? endPos - lengthFind + 1 : endPos;
 			std::vector<char> searchThing(lengthFind + 1);
 			pcf->Fold(&searchThing[0], searchThing.size(), search, lengthFind);
+			if (forward) {
+				if (foldTable.empty()) {
+					// Single byte folding only depends on the byte so remember it for each byte
+					foldTable.resize(0x100);
+					for (size_t ch = 0; ch < foldTable.size(); ch++) {
+						const char chMixed = static_cast<char>(ch);
+						char folded[2];
+						pcf->Fold(folded, sizeof(folded), &chMixed, 1);
+						foldTable[ch] = folded[0];
+					}
+				}
+				return FindBytes(pos, limitPos, std::string_view(searchThing.data(), lengthFind),
+					foldTable.data(), word, wordStart);
+			}
 			while (forward ? (pos < endSearch) : (pos >= endSearch)) {
 				bool found = (pos + lengthFind) <= limitPos;
 				for (int indexSearch = 0; (indexSearch < lengthFind) && found; indexSearch++) {
@@ -2158,6 +2835,61 @@ Sci::Position Document::FindText(Sci::Position minPos, Sci::Position maxPos, con
 	return -1;
 }
 
+// Search forward from pos for bytes ending at or before limitPos.
+// The text is examined in blocks, starting small for nearby matches then doubling, which
+// are used in place when they do not straddle the gap and are otherwise copied.
+// When foldBytes is set, each block is copied and case folded through that table so
+// that bytes should already be folded.
+// Candidates are found with memchr for a single byte or a Boyer-Moore-Horspool skip table.
+Sci::Position Document::FindBytes(Sci::Position pos, Sci::Position limitPos, std::string_view bytes,
+	const char *foldBytes, bool word, bool wordStart) {
+	constexpr Sci::Position lengthBlockMaximum = 0x10000;
+	Sci::Position lengthBlock = 0x100;
+	const Sci::Position lengthFind = bytes.length();
+	limitPos = std::min(limitPos, LengthNoExcept());
+	const std::boyer_moore_horspool_searcher<std::string_view::const_iterator> searcher(bytes.begin(), bytes.end());
+	std::vector<char> copied;
+	while ((pos + lengthFind) <= limitPos) {
+		const Sci::Position lengthText = std::min(lengthBlock + lengthFind - 1, limitPos - pos);
+		Sci::Position lengthSpan = 0;
+		const char *text = cb.TextSpan(pos, lengthText, lengthSpan);
+		if (foldBytes || (lengthSpan < lengthText)) {
+			copied.resize(lengthText);
+			cb.GetCharRange(copied.data(), pos, lengthText);
+			if (foldBytes) {
+				for (char &ch : copied) {
+					ch = foldBytes[static_cast<unsigned char>(ch)];
+				}
+			}
+			text = copied.data();
+		}
+		const char *textEnd = text + lengthText;
+		const char *candidate = text;
+		while (candidate < textEnd) {
+			const char *found = textEnd;
+			if (lengthFind == 1) {
+				const void *foundByte = memchr(candidate, bytes[0], textEnd - candidate);
+				if (foundByte) {
+					found = static_cast<const char *>(foundByte);
+				}
+			} else {
+				found = searcher(candidate, textEnd).first;
+			}
+			if (found == textEnd) {
+				break;
+			}
+			const Sci::Position posFound = pos + (found - text);
+			if (MatchesWordOptions(word, wordStart, posFound, lengthFind)) {
+				return posFound;
+			}
+			candidate = found + 1;
+		}
+		pos += lengthText - lengthFind + 1;
+		lengthBlock = std::min(lengthBlock * 2, lengthBlockMaximum);
+	}
+	return -1;
+}
+
 const char *Document::SubstituteByPosition(const char *text, Sci::Position *length) {
 	if (regex)
 		return regex->SubstituteByPosition(this, text, length);
@@ -2230,15 +2962,10 @@ bool SCI_METHOD Document::SetStyles(Sci_Position length, const char *styles) {
 		bool didChange = false;
 		Sci::Position startMod = 0;
 		Sci::Position endMod = 0;
-		for (int iPos = 0; iPos < length; iPos++, endStyled++) {
-			PLATFORM_ASSERT(endStyled < Length());
-			if (cb.SetStyleAt(endStyled, styles[iPos])) {
-				if (!didChange) {
-					startMod = endStyled;
-				}
-				didChange = true;
-				endMod = endStyled;
-			}
+		PLATFORM_ASSERT(length <= 0 || endStyled + length <= Length());
+		if (length > 0) {
+			didChange = cb.SetStyles(endStyled, length, styles, startMod, endMod);
+			endStyled += length;
 		}
 		if (didChange) {
 			const DocModification mh(SC_MOD_CHANGESTYLE | SC_PERFORMED_USER,
@@ -2254,9 +2981,12 @@ void Document::EnsureStyledTo(Sci::Position pos) {
 	if ((enteredStyling == 0) && (pos > GetEndStyled())) {
 		IncrementStyleClock();
 		if (pli && !pli->UseContainerLexing()) {
-			const Sci::Line lineEndStyled = SciLineFromPosition(GetEndStyled());
-			const Sci::Position endStyledTo = LineStart(lineEndStyled);
-			pli->Colourise(endStyledTo, pos);
+			pli->StyleAheadTo(pos);
+			if (pos > GetEndStyled()) {
+				const Sci::Line lineEndStyled = SciLineFromPosition(GetEndStyled());
+				const Sci::Position endStyledTo = LineStart(lineEndStyled);
+				pli->Colourise(endStyledTo, pos);
+			}
 		} else {
 			// Ask the watchers to style, and stop as soon as one responds.
 			for (std::vector<WatcherWithUserData>::iterator it = watchers.begin();
@@ -2275,6 +3005,16 @@ void Document::StyleToAdjustingLineDuration(Sci::Position pos) {
 	durationStyleOneLine.AddSample(lineLast - lineFirst, epStyling.Duration());
 }
 
+// Style the rest of the document on a worker thread. Returns false if that is not possible
+// and idle styling should be performed on this thread.
+bool Document::StyleAheadIdle() {
+	return (enteredStyling == 0) && pli && !pli->UseContainerLexing() && pli->StyleAheadIdle();
+}
+
+bool Document::StyleAheadRunning() const noexcept {
+	return pli && pli->StyleAheadRunning();
+}
+
 void Document::LexerChanged() {
 	// Tell the watchers the lexer has changed.
 	for (const WatcherWithUserData &watcher : watchers) {
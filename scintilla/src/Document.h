@@ -168,17 +168,24 @@ constexpr int LevelNumber(int level) noexcept {
 	return level & SC_FOLDLEVELNUMBERMASK;
 }
 
+class StyleAhead;
+
 class LexInterface {
 protected:
 	Document *pdoc;
 	ILexer5 *instance;
 	bool performingStyle;	///< Prevent reentrance
+	std::unique_ptr<StyleAhead> styleAhead;	///< Worker styling after the styled text
+	Sci::Position styleAheadFailed;	///< Where the last worker stopped before the end of its window
+	bool TakeStyleAhead();
 public:
-	explicit LexInterface(Document *pdoc_) noexcept : pdoc(pdoc_), instance(nullptr), performingStyle(false) {
-	}
-	virtual ~LexInterface() {
-	}
+	explicit LexInterface(Document *pdoc_) noexcept;
+	virtual ~LexInterface();
 	void Colourise(Sci::Position start, Sci::Position end);
+	bool StyleAheadIdle();
+	bool StyleAheadRunning() const noexcept;
+	void StyleAheadTo(Sci::Position pos);
+	void StopStyleAhead() noexcept;
 	virtual int LineEndTypesSupported();
 	bool UseContainerLexing() const noexcept {
 		return instance == nullptr;
@@ -232,8 +239,10 @@ private:
 	CharClassify charClass;
 	CharacterCategoryMap charMap;
 	std::unique_ptr<CaseFolder> pcf;
+	std::vector<char> foldTable;
 	Sci::Position endStyled;
 	int styleClock;
+	int modificationClock;
 	int enteredModification;
 	int enteredStyling;
 	int enteredReadOnlyCount;
@@ -399,6 +408,7 @@ public:
 	}
 	int GetMark(Sci::Line line) const noexcept;
 	Sci::Line MarkerNext(Sci::Line lineStart, int mask) const noexcept;
+	Sci::Line MarkerPrevious(Sci::Line lineStart, int mask) const noexcept;
 	int AddMark(Sci::Line line, int markerNum);
 	void AddMarkSet(Sci::Line line, int valueSet);
 	void DeleteMark(Sci::Line line, int markerNum);
@@ -458,8 +468,11 @@ public:
 	Sci::Position GetEndStyled() const noexcept { return endStyled; }
 	void EnsureStyledTo(Sci::Position pos);
 	void StyleToAdjustingLineDuration(Sci::Position pos);
+	bool StyleAheadIdle();
+	bool StyleAheadRunning() const noexcept;
 	void LexerChanged();
 	int GetStyleClock() const noexcept { return styleClock; }
+	int GetModificationClock() const noexcept { return modificationClock; }
 	void IncrementStyleClock() noexcept;
 	void SCI_METHOD DecorationSetCurrentIndicator(int indicator) override;
 	void SCI_METHOD DecorationFillRange(Sci_Position position, int value, Sci_Position fillLength) override;
@@ -504,6 +517,8 @@ public:
 	Sci::Position BraceMatch(Sci::Position position, Sci::Position maxReStyle, Sci::Position startPos, bool useStartPos) noexcept;
 
 private:
+	Sci::Position FindBytes(Sci::Position pos, Sci::Position limitPos, std::string_view bytes,
+		const char *foldBytes, bool word, bool wordStart);
 	void NotifyModifyAttempt();
 	void NotifySavePoint(bool atSavePoint);
 	void NotifyModified(DocModification mh);
@@ -571,7 +586,7 @@ public:
 		position(act.position),
 		length(act.lenData),
 		linesAdded(linesAdded_),
-		text(act.data.get()),
+		text(act.data),
 		line(0),
 		foldLevelNow(0),
 		foldLevelPrev(0),
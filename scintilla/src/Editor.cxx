@@ -5073,6 +5073,14 @@ void Editor::TickFor(TickReason reason) {
 			}
 			FineTickerCancel(tickDwell);
 			break;
+		case tickStyleAhead:
+			// Collect what the style ahead worker has done in idle time
+			FineTickerCancel(tickStyleAhead);
+			if ((idleStyling == SC_IDLESTYLING_AHEAD) && (pdoc->GetEndStyled() < pdoc->Length())) {
+				needIdleStyling = true;
+				SetIdle(true);
+			}
+			break;
 		default:
 			// tickPlatform handled by subclass
 			break;
@@ -5156,7 +5164,8 @@ Sci::Position Editor::PositionAfterMaxStyling(Sci::Position posMax, bool scrolli
 }
 
 void Editor::StartIdleStyling(bool truncatedLastStyling) {
-	if ((idleStyling == SC_IDLESTYLING_ALL) || (idleStyling == SC_IDLESTYLING_AFTERVISIBLE)) {
+	if ((idleStyling == SC_IDLESTYLING_ALL) || (idleStyling == SC_IDLESTYLING_AFTERVISIBLE) ||
+		(idleStyling == SC_IDLESTYLING_AHEAD)) {
 		if (pdoc->GetEndStyled() < pdoc->Length()) {
 			// Style remainder of document in idle time
 			needIdleStyling = true;
@@ -5189,8 +5198,22 @@ void Editor::IdleStyling() {
 	const Sci::Position posAfterArea = PositionAfterArea(GetClientRectangle());
 	const Sci::Position endGoal = (idleStyling >= SC_IDLESTYLING_AFTERVISIBLE) ?
 		pdoc->Length() : posAfterArea;
-	const Sci::Position posAfterMax = PositionAfterMaxStyling(endGoal, false);
-	pdoc->StyleToAdjustingLineDuration(posAfterMax);
+	if ((idleStyling == SC_IDLESTYLING_AHEAD) && (pdoc->GetEndStyled() >= posAfterArea) &&
+		pdoc->StyleAheadIdle()) {
+		// Text after the view is being styled on a worker thread and any
+		// results it has produced have now been merged into the document.
+		if (pdoc->StyleAheadRunning()) {
+			// Look for more results on a timer rather than spinning in idle
+			if (!FineTickerRunning(tickStyleAhead)) {
+				FineTickerStart(tickStyleAhead, 20, 5);
+			}
+			needIdleStyling = false;
+			return;
+		}
+	} else {
+		const Sci::Position posAfterMax = PositionAfterMaxStyling(endGoal, false);
+		pdoc->StyleToAdjustingLineDuration(posAfterMax);
+	}
 	if (pdoc->GetEndStyled() >= endGoal) {
 		needIdleStyling = false;
 	}
@@ -6785,6 +6808,19 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 	case SCI_GETPOSITIONCACHE:
 		return view.posCache.GetSize();
 
+	case SCI_SETPOSITIONCACHESHARED:
+		view.posCache.SetSharedBudget(wParam);
+		break;
+
+	case SCI_GETPOSITIONCACHESHARED:
+		return view.posCache.GetSharedBudget();
+
+	case SCI_GETPOSITIONCACHEHITS:
+		return PositionCache::SharedHits();
+
+	case SCI_GETPOSITIONCACHEMISSES:
+		return PositionCache::SharedMisses();
+
 	case SCI_SETSCROLLWIDTH:
 		PLATFORM_ASSERT(wParam > 0);
 		if ((wParam > 0) && (wParam != static_cast<unsigned int>(scrollWidth))) {
@@ -7009,13 +7045,8 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 	case SCI_MARKERNEXT:
 		return pdoc->MarkerNext(static_cast<Sci::Line>(wParam), static_cast<int>(lParam));
 
-	case SCI_MARKERPREVIOUS: {
-			for (Sci::Line iLine = static_cast<Sci::Line>(wParam); iLine >= 0; iLine--) {
-				if ((pdoc->GetMark(iLine) & lParam) != 0)
-					return iLine;
-			}
-		}
-		return -1;
+	case SCI_MARKERPREVIOUS:
+		return pdoc->MarkerPrevious(static_cast<Sci::Line>(wParam), static_cast<int>(lParam));
 
 	case SCI_MARKERDEFINEPIXMAP:
 		if (wParam <= MARKER_MAX) {
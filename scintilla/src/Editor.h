@@ -516,7 +516,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	void ButtonUpWithModifiers(Point pt, unsigned int curTime, int modifiers);
 
 	bool Idle();
-	enum TickReason { tickCaret, tickScroll, tickWiden, tickDwell, tickPlatform };
+	enum TickReason { tickCaret, tickScroll, tickWiden, tickDwell, tickStyleAhead, tickPlatform };
 	virtual void TickFor(TickReason reason);
 	virtual bool FineTickerRunning(TickReason reason);
 	virtual void FineTickerStart(TickReason reason, int millis, int tolerance);
@@ -532,7 +532,8 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	void StartIdleStyling(bool truncatedLastStyling);
 	void StyleAreaBounded(PRectangle rcArea, bool scrolling);
 	constexpr bool SynchronousStylingToVisible() const noexcept {
-		return (idleStyling == SC_IDLESTYLING_NONE) || (idleStyling == SC_IDLESTYLING_AFTERVISIBLE);
+		return (idleStyling == SC_IDLESTYLING_NONE) || (idleStyling == SC_IDLESTYLING_AFTERVISIBLE) ||
+			(idleStyling == SC_IDLESTYLING_AHEAD);
 	}
 	void IdleStyling();
 	virtual void IdleWork();
@@ -12,6 +12,7 @@
 #include <stdexcept>
 #include <string_view>
 #include <vector>
+#include <map>
 #include <forward_list>
 #include <algorithm>
 #include <memory>
@@ -22,6 +23,7 @@
 #include "Position.h"
 #include "SplitVector.h"
 #include "Partitioning.h"
+#include "SparseVector.h"
 #include "CellBuffer.h"
 #include "PerLine.h"
 
@@ -89,22 +91,37 @@ void MarkerHandleSet::CombineWith(MarkerHandleSet *other) noexcept {
 	mhList.splice_after(mhList.before_begin(), other->mhList);
 }
 
+LineMarkers::LineMarkers() : handleCurrent(0) {
+}
+
 LineMarkers::~LineMarkers() {
 }
 
 void LineMarkers::Init() {
 	markers.DeleteAll();
+	markedLines.clear();
+	handleNumbers.clear();
 }
 
 void LineMarkers::InsertLine(Sci::Line line) {
 	if (markers.Length()) {
 		markers.Insert(line, 0);
+		for (const std::unique_ptr<SparseVector<int>> &lines : markedLines) {
+			if (lines) {
+				lines->InsertSpace(line, 1);
+			}
+		}
 	}
 }
 
 void LineMarkers::InsertLines(Sci::Line line, Sci::Line lines) {
 	if (markers.Length()) {
 		markers.InsertEmpty(line, lines);
+		for (const std::unique_ptr<SparseVector<int>> &linesMarked : markedLines) {
+			if (linesMarked) {
+				linesMarked->InsertSpace(line, lines);
+			}
+		}
 	}
 }
 
@@ -113,15 +130,72 @@ void LineMarkers::RemoveLine(Sci::Line line) {
 	if (markers.Length()) {
 		if (line > 0) {
 			MergeMarkers(line - 1);
+		} else {
+			ForgetHandles(line, -1, true);
 		}
 		markers.Delete(line);
+		for (const std::unique_ptr<SparseVector<int>> &lines : markedLines) {
+			if (lines) {
+				lines->DeletePosition(line);
+			}
+		}
+	}
+}
+
+void LineMarkers::AddToCount(Sci::Line line, int markerNum, int delta) {
+	if ((markerNum < 0) || (markerNum > MARKER_MAX)) {
+		return;
+	}
+	if (markedLines.empty()) {
+		markedLines.resize(MARKER_MAX + 1);
+	}
+	std::unique_ptr<SparseVector<int>> &lines = markedLines[markerNum];
+	if (!lines) {
+		lines = std::make_unique<SparseVector<int>>();
+		lines->InsertSpace(0, markers.Length());
+	}
+	lines->SetValueAt(line, lines->ValueAt(line) + delta);
+}
+
+int LineMarkers::CountOnLine(Sci::Line line, int markerNum) const noexcept {
+	if ((markerNum >= 0) && (static_cast<size_t>(markerNum) < markedLines.size()) && markedLines[markerNum]) {
+		return markedLines[markerNum]->ValueAt(line);
+	}
+	return 0;
+}
+
+// Remove the handles that are about to be deleted from line from handleNumbers.
+// A markerNum of -1 is for all the handles on the line.
+void LineMarkers::ForgetHandles(Sci::Line line, int markerNum, bool all) {
+	if (markers.Length() && (line >= 0) && (line < markers.Length()) && markers[line]) {
+		int which = 0;
+		while (const MarkerHandleNumber *pnmh = markers[line]->GetMarkerHandleNumber(which)) {
+			if ((markerNum == -1) || (pnmh->number == markerNum)) {
+				handleNumbers.erase(pnmh->handle);
+				if (!all) {
+					break;
+				}
+			}
+			which++;
+		}
 	}
 }
 
 Sci::Line LineMarkers::LineFromHandle(int markerHandle) const noexcept {
-	for (Sci::Line line = 0; line < markers.Length(); line++) {
-		if (markers[line] && markers[line]->Contains(markerHandle)) {
-			return line;
+	// The handle's line is not recorded as that would change with each line inserted
+	// or removed before it, so check each line marked with the handle's marker number.
+	const std::map<int, int>::const_iterator it = handleNumbers.find(markerHandle);
+	if (it == handleNumbers.end()) {
+		return -1;
+	}
+	const int markerNum = it->second;
+	if ((static_cast<size_t>(markerNum) < markedLines.size()) && markedLines[markerNum]) {
+		const SparseVector<int> *lines = markedLines[markerNum].get();
+		for (Sci::Position element = 0; element < lines->Elements(); element++) {
+			const Sci::Line line = lines->PositionOfElement(element);
+			if (markers[line] && markers[line]->Contains(markerHandle)) {
+				return line;
+			}
 		}
 	}
 	return -1;
@@ -149,6 +223,15 @@ void LineMarkers::MergeMarkers(Sci::Line line) {
 			markers[line] = std::make_unique<MarkerHandleSet>();
 		markers[line]->CombineWith(markers[line + 1].get());
 		markers[line + 1].reset();
+		for (const std::unique_ptr<SparseVector<int>> &lines : markedLines) {
+			if (lines) {
+				const int countNext = lines->ValueAt(line + 1);
+				if (countNext) {
+					lines->SetValueAt(line, lines->ValueAt(line) + countNext);
+					lines->SetValueAt(line + 1, 0);
+				}
+			}
+		}
 	}
 }
 
@@ -162,13 +245,42 @@ int LineMarkers::MarkValue(Sci::Line line) const noexcept {
 Sci::Line LineMarkers::MarkerNext(Sci::Line lineStart, int mask) const noexcept {
 	if (lineStart < 0)
 		lineStart = 0;
-	const Sci::Line length = markers.Length();
-	for (Sci::Line iLine = lineStart; iLine < length; iLine++) {
-		const MarkerHandleSet *onLine = markers[iLine].get();
-		if (onLine && ((onLine->MarkValue() & mask) != 0))
-			return iLine;
+	if (lineStart >= markers.Length())
+		return -1;
+	Sci::Line lineNext = -1;
+	for (size_t markerNum = 0; markerNum < markedLines.size(); markerNum++) {
+		const SparseVector<int> *lines = markedLines[markerNum].get();
+		if (lines && (mask & (1U << markerNum))) {
+			Sci::Line line = lineStart;
+			if (!lines->ValueAt(lineStart)) {
+				// Every element after the first starts at a marked line
+				const Sci::Position element = lines->ElementFromPosition(lineStart) + 1;
+				line = (element < lines->Elements()) ? lines->PositionOfElement(element) : -1;
+			}
+			if ((line >= 0) && ((lineNext < 0) || (line < lineNext)))
+				lineNext = line;
+		}
 	}
-	return -1;
+	return lineNext;
+}
+
+Sci::Line LineMarkers::MarkerPrevious(Sci::Line lineStart, int mask) const noexcept {
+	if (lineStart >= markers.Length())
+		lineStart = markers.Length() - 1;
+	if (lineStart < 0)
+		return -1;
+	Sci::Line linePrevious = -1;
+	for (size_t markerNum = 0; markerNum < markedLines.size(); markerNum++) {
+		const SparseVector<int> *lines = markedLines[markerNum].get();
+		if (lines && (mask & (1U << markerNum))) {
+			// The element containing lineStart starts at a marked line unless it is the first
+			const Sci::Position element = lines->ElementFromPosition(lineStart);
+			const Sci::Line line = lines->PositionOfElement(element);
+			if (((element > 0) || lines->ValueAt(line)) && (line > linePrevious))
+				linePrevious = line;
+		}
+	}
+	return linePrevious;
 }
 
 int LineMarkers::AddMark(Sci::Line line, int markerNum, Sci::Line lines) {
@@ -185,6 +297,10 @@ int LineMarkers::AddMark(Sci::Line line, int markerNum, Sci::Line lines) {
 		markers[line] = std::make_unique<MarkerHandleSet>();
 	}
 	markers[line]->InsertHandle(handleCurrent, markerNum);
+	AddToCount(line, markerNum, 1);
+	if ((markerNum >= 0) && (markerNum <= MARKER_MAX)) {
+		handleNumbers[handleCurrent] = markerNum;
+	}
 
 	return handleCurrent;
 }
@@ -192,14 +308,23 @@ int LineMarkers::AddMark(Sci::Line line, int markerNum, Sci::Line lines) {
 bool LineMarkers::DeleteMark(Sci::Line line, int markerNum, bool all) {
 	bool someChanges = false;
 	if (markers.Length() && (line >= 0) && (line < markers.Length()) && markers[line]) {
+		ForgetHandles(line, markerNum, all);
 		if (markerNum == -1) {
 			someChanges = true;
 			markers[line].reset();
+			for (const std::unique_ptr<SparseVector<int>> &lines : markedLines) {
+				if (lines) {
+					lines->SetValueAt(line, 0);
+				}
+			}
 		} else {
 			someChanges = markers[line]->RemoveNumber(markerNum, all);
 			if (markers[line]->Empty()) {
 				markers[line].reset();
 			}
+			if (someChanges) {
+				AddToCount(line, markerNum, all ? -CountOnLine(line, markerNum) : -1);
+			}
 		}
 	}
 	return someChanges;
@@ -208,6 +333,15 @@ bool LineMarkers::DeleteMark(Sci::Line line, int markerNum, bool all) {
 void LineMarkers::DeleteMarkFromHandle(int markerHandle) {
 	const Sci::Line line = LineFromHandle(markerHandle);
 	if (line >= 0) {
+		handleNumbers.erase(markerHandle);
+		int which = 0;
+		while (const MarkerHandleNumber *pnmh = markers[line]->GetMarkerHandleNumber(which)) {
+			if (pnmh->handle == markerHandle) {
+				AddToCount(line, pnmh->number, -1);
+				break;
+			}
+			which++;
+		}
 		markers[line]->RemoveHandle(markerHandle);
 		if (markers[line]->Empty()) {
 			markers[line].reset();
@@ -44,13 +44,23 @@ public:
 	MarkerHandleNumber const *GetMarkerHandleNumber(int which) const noexcept;
 };
 
+template <typename T>
+class SparseVector;
+
 class LineMarkers : public PerLine {
 	SplitVector<std::unique_ptr<MarkerHandleSet>> markers;
+	/// For each marker number, how many markers of that number are on each line so that
+	/// searches only visit marked lines. Created when a marker number is first added.
+	std::vector<std::unique_ptr<SparseVector<int>>> markedLines;
+	/// The marker number of each handle so that finding a handle only visits the lines with that number.
+	std::map<int, int> handleNumbers;
 	/// Handles are allocated sequentially and should never have to be reused as 32 bit ints are very big.
 	int handleCurrent;
+	void AddToCount(Sci::Line line, int markerNum, int delta);
+	int CountOnLine(Sci::Line line, int markerNum) const noexcept;
+	void ForgetHandles(Sci::Line line, int markerNum, bool all);
 public:
-	LineMarkers() : handleCurrent(0) {
-	}
+	LineMarkers();
 	// Deleted so LineMarkers objects can not be copied.
 	LineMarkers(const LineMarkers &) = delete;
 	LineMarkers(LineMarkers &&) = delete;
@@ -64,6 +74,7 @@ public:
 
 	int MarkValue(Sci::Line line) const noexcept;
 	Sci::Line MarkerNext(Sci::Line lineStart, int mask) const noexcept;
+	Sci::Line MarkerPrevious(Sci::Line lineStart, int mask) const noexcept;
 	int AddMark(Sci::Line line, int markerNum, Sci::Line lines);
 	void MergeMarkers(Sci::Line line);
 	bool DeleteMark(Sci::Line line, int markerNum, bool all);
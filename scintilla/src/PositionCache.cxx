@@ -15,9 +15,13 @@
 #include <string_view>
 #include <vector>
 #include <map>
+#include <set>
+#include <tuple>
 #include <algorithm>
 #include <iterator>
 #include <memory>
+#include <atomic>
+#include <mutex>
 
 #include "Platform.h"
 
@@ -675,7 +679,7 @@ PositionCacheEntry::PositionCacheEntry() noexcept :
 
 // Copy constructor not currently used, but needed for being element in std::vector.
 PositionCacheEntry::PositionCacheEntry(const PositionCacheEntry &other) :
-	styleNumber(other.styleNumber), len(other.styleNumber), clock(other.styleNumber), positions(nullptr) {
+	styleNumber(other.styleNumber), len(other.len), clock(other.clock), positions(nullptr) {
 	if (other.positions) {
 		const size_t lenData = len + (len / sizeof(XYPOSITION)) + 1;
 		positions = std::make_unique<XYPOSITION[]>(lenData);
@@ -735,6 +739,15 @@ unsigned int PositionCacheEntry::Hash(unsigned int styleNumber_, const char *s,
 	return ret;
 }
 
+// Memory allocated by an entry for a string of len_ bytes
+size_t PositionCacheEntry::MemorySize(unsigned int len_) noexcept {
+	return (len_ + (len_ / sizeof(XYPOSITION)) + 1) * sizeof(XYPOSITION);
+}
+
+size_t PositionCacheEntry::MemorySize() const noexcept {
+	return positions ? MemorySize(len) : 0;
+}
+
 bool PositionCacheEntry::NewerThan(const PositionCacheEntry &other) const noexcept {
 	return clock > other.clock;
 }
@@ -745,14 +758,201 @@ void PositionCacheEntry::ResetClock() noexcept {
 	}
 }
 
+namespace Scintilla {
+
+// Properties of a style and document that determine the widths of its text.
+// The code page decides how bytes are grouped into characters when measuring.
+struct PositionCacheFont {
+	std::string fontName;
+	int weight;
+	bool italic;
+	int sizeZoomed;
+	int characterSet;
+	int extraFontFlag;
+	int technology;
+	int logPixelsY;
+	int codePage;
+	PositionCacheFont(const Style &style, int technology_, int logPixelsY_, int codePage_) :
+		fontName(style.fontName ? style.fontName : ""), weight(style.weight), italic(style.italic),
+		sizeZoomed(style.sizeZoomed), characterSet(style.characterSet), extraFontFlag(style.extraFontFlag),
+		technology(technology_), logPixelsY(logPixelsY_), codePage(codePage_) {
+	}
+	bool operator<(const PositionCacheFont &other) const noexcept {
+		return std::tie(fontName, weight, italic, sizeZoomed, characterSet, extraFontFlag, technology, logPixelsY, codePage) <
+			std::tie(other.fontName, other.weight, other.italic, other.sizeZoomed, other.characterSet,
+				other.extraFontFlag, other.technology, other.logPixelsY, other.codePage);
+	}
+};
+
+// Memory taken by the shared table. Space is claimed before it is allocated so
+// threads storing at the same time can not go over the budget together.
+class PositionCacheMemory {
+	std::atomic<size_t> budget;
+	std::atomic<size_t> used;
+public:
+	PositionCacheMemory() noexcept : budget(0), used(0) {
+	}
+	bool Reserve(size_t size) noexcept {
+		const size_t before = used.fetch_add(size);
+		if (before + size > budget) {
+			used.fetch_sub(size);
+			return false;
+		}
+		return true;
+	}
+	void Release(size_t size) noexcept {
+		used.fetch_sub(size);
+	}
+	void SetBudget(size_t budget_) noexcept {
+		budget = budget_;
+	}
+	size_t Budget() const noexcept {
+		return budget;
+	}
+	size_t Used() const noexcept {
+		return used;
+	}
+};
+
+// Set associative table of measurements for one font. Each shard has its own lock
+// so views measuring with different fonts do not contend.
+class PositionCacheShard {
+	static constexpr unsigned int clockMaximum = 0xF0000000U;
+	static constexpr size_t ways = 4;
+	static constexpr size_t sets = 0x400;
+	PositionCacheMemory &memory;
+	std::mutex mutex;
+	std::vector<PositionCacheEntry> pces;
+	unsigned int clock = 1;
+public:
+	explicit PositionCacheShard(PositionCacheMemory &memory_) noexcept : memory(memory_) {
+	}
+	bool Retrieve(unsigned int hashValue, const char *s, unsigned int len, XYPOSITION *positions) {
+		std::lock_guard<std::mutex> guard(mutex);
+		if (pces.empty()) {
+			return false;
+		}
+		const size_t first = (hashValue % sets) * ways;
+		for (size_t way = first; way < first + ways; way++) {
+			if (pces[way].Retrieve(0, s, len, positions)) {
+				return true;
+			}
+		}
+		return false;
+	}
+	// Replace the oldest entry in the set. The table is only allocated once it fits in
+	// the budget and if the new entry does not fit then the oldest entry is just discarded.
+	void Store(unsigned int hashValue, const char *s, unsigned int len, const XYPOSITION *positions) {
+		std::lock_guard<std::mutex> guard(mutex);
+		if (pces.empty()) {
+			if (!memory.Reserve(sets * ways * sizeof(PositionCacheEntry))) {
+				return;
+			}
+			pces.resize(sets * ways);
+		}
+		const size_t first = (hashValue % sets) * ways;
+		size_t oldest = first;
+		for (size_t way = first + 1; way < first + ways; way++) {
+			if (pces[oldest].NewerThan(pces[way])) {
+				oldest = way;
+			}
+		}
+		memory.Release(pces[oldest].MemorySize());
+		pces[oldest].Clear();
+		if (memory.Reserve(PositionCacheEntry::MemorySize(len))) {
+			clock++;
+			if (clock == clockMaximum) {
+				for (PositionCacheEntry &pce : pces) {
+					pce.ResetClock();
+				}
+				clock = 2;
+			}
+			pces[oldest].Set(0, s, len, positions, clock);
+		}
+	}
+};
+
+namespace {
+
+// Process-wide measurements, shared by the PositionCache objects that have a budget.
+// The budget is the largest of those views' budgets so one view can not take the
+// cache away from others. Lowering it does not discard measurements: space is given
+// back as entries are replaced.
+// Shards are never deleted so views can hold on to pointers to them.
+class SharedPositionCache {
+	std::mutex mutex;
+	std::map<PositionCacheFont, std::unique_ptr<PositionCacheShard>> shards;
+	std::multiset<size_t> budgets;
+	PositionCacheMemory memory;
+	std::atomic<size_t> hits;
+	std::atomic<size_t> misses;
+public:
+	SharedPositionCache() noexcept : hits(0), misses(0) {
+	}
+	PositionCacheShard *Shard(const PositionCacheFont &font) {
+		std::lock_guard<std::mutex> guard(mutex);
+		std::unique_ptr<PositionCacheShard> &shard = shards[font];
+		if (!shard) {
+			shard = std::make_unique<PositionCacheShard>(memory);
+		}
+		return shard.get();
+	}
+	bool Retrieve(PositionCacheShard *shard, unsigned int hashValue, const char *s, unsigned int len, XYPOSITION *positions) {
+		if (shard->Retrieve(hashValue, s, len, positions)) {
+			hits++;
+			return true;
+		}
+		misses++;
+		return false;
+	}
+	void Store(PositionCacheShard *shard, unsigned int hashValue, const char *s, unsigned int len, const XYPOSITION *positions) {
+		shard->Store(hashValue, s, len, positions);
+	}
+	// A view changed its budget from budgetOld to budgetNew
+	void ChangeBudget(size_t budgetOld, size_t budgetNew) {
+		std::lock_guard<std::mutex> guard(mutex);
+		if (budgetOld > 0) {
+			budgets.erase(budgets.find(budgetOld));
+		}
+		if (budgetNew > 0) {
+			budgets.insert(budgetNew);
+		}
+		memory.SetBudget(budgets.empty() ? 0 : *budgets.rbegin());
+	}
+	size_t Budget() const noexcept {
+		return memory.Budget();
+	}
+	size_t Used() const noexcept {
+		return memory.Used();
+	}
+	size_t Hits() const noexcept {
+		return hits;
+	}
+	size_t Misses() const noexcept {
+		return misses;
+	}
+};
+
+SharedPositionCache &Shared() {
+	static SharedPositionCache shared;
+	return shared;
+}
+
+}
+
+}
+
 PositionCache::PositionCache() {
 	clock = 1;
 	pces.resize(0x400);
 	allClear = true;
+	codePageShards = 0;
+	sharedBudget = 0;
 }
 
 PositionCache::~PositionCache() {
 	Clear();
+	SetSharedBudget(0);
 }
 
 void PositionCache::Clear() noexcept {
@@ -763,6 +963,8 @@ void PositionCache::Clear() noexcept {
 	}
 	clock = 1;
 	allClear = true;
+	// Fonts may have changed
+	shardForStyle.clear();
 }
 
 void PositionCache::SetSize(size_t size_) {
@@ -770,12 +972,40 @@ void PositionCache::SetSize(size_t size_) {
 	pces.resize(size_);
 }
 
+PositionCacheShard *PositionCache::ShardForStyle(Surface *surface, const ViewStyle &vstyle, unsigned int styleNumber,
+	int codePage) {
+	if (codePage != codePageShards) {
+		// Document encoding changed so every style maps to a different shard
+		shardForStyle.clear();
+		codePageShards = codePage;
+	}
+	if (styleNumber >= shardForStyle.size()) {
+		shardForStyle.resize(vstyle.styles.size(), std::pair<FontID, PositionCacheShard *>(nullptr, nullptr));
+	}
+	const Style &style = vstyle.styles[styleNumber];
+	std::pair<FontID, PositionCacheShard *> &entry = shardForStyle[styleNumber];
+	if (!entry.second || (entry.first != style.font.GetID())) {
+		entry.first = style.font.GetID();
+		entry.second = Shared().Shard(PositionCacheFont(style, vstyle.technology, surface->LogPixelsY(), codePage));
+	}
+	return entry.second;
+}
+
 void PositionCache::MeasureWidths(Surface *surface, const ViewStyle &vstyle, unsigned int styleNumber,
 	const char *s, unsigned int len, XYPOSITION *positions, const Document *pdoc) {
 
 	allClear = false;
+	PositionCacheShard *shard = nullptr;
+	unsigned int hashShared = 0;
 	size_t probe = pces.size();	// Out of bounds
-	if ((!pces.empty()) && (len < 30)) {
+	if ((!pces.empty()) && (len <= BreakFinder::lengthStartSubdivision) && (sharedBudget > 0)) {
+		// Shared table can hold the segments produced by BreakFinder
+		shard = ShardForStyle(surface, vstyle, styleNumber, pdoc->dbcsCodePage);
+		hashShared = PositionCacheEntry::Hash(0, s, len);
+		if (Shared().Retrieve(shard, hashShared, s, len, positions)) {
+			return;
+		}
+	} else if ((!pces.empty()) && (len < 30)) {
 		// Only store short strings in the cache so it doesn't churn with
 		// long comments with only a single comment.
 
@@ -811,12 +1041,13 @@ void PositionCache::MeasureWidths(Surface *surface, const ViewStyle &vstyle, uns
 	} else {
 		surface->MeasureWidths(fontStyle, std::string_view(s, len), positions);
 	}
-	if (probe < pces.size()) {
+	if (shard) {
+		Shared().Store(shard, hashShared, s, len, positions);
+	} else if (probe < pces.size()) {
 		// Store into cache
 		clock++;
-		if (clock > 60000) {
-			// Since there are only 16 bits for the clock, wrap it round and
-			// reset all cache entries so none get stuck with a high clock.
+		if (clock > 0xF0000000U) {
+			// Wrap the clock round and reset all cache entries so none get stuck with a high clock.
 			for (PositionCacheEntry &pce : pces) {
 				pce.ResetClock();
 			}
@@ -825,3 +1056,27 @@ void PositionCache::MeasureWidths(Surface *surface, const ViewStyle &vstyle, uns
 		pces[probe].Set(styleNumber, s, len, positions, clock);
 	}
 }
+
+// A budget of 0 makes this view use its own table instead of the shared table.
+void PositionCache::SetSharedBudget(size_t budget) {
+	if (budget != sharedBudget) {
+		Shared().ChangeBudget(sharedBudget, budget);
+		sharedBudget = budget;
+	}
+}
+
+size_t PositionCache::GetSharedBudget() const noexcept {
+	return sharedBudget;
+}
+
+size_t PositionCache::SharedHits() noexcept {
+	return Shared().Hits();
+}
+
+size_t PositionCache::SharedMisses() noexcept {
+	return Shared().Misses();
+}
+
+size_t PositionCache::SharedMemory() noexcept {
+	return Shared().Used();
+}
@@ -180,8 +180,8 @@ public:
 
 class PositionCacheEntry {
 	unsigned int styleNumber:8;
-	unsigned int len:8;
-	unsigned int clock:16;
+	unsigned int len:24;
+	unsigned int clock;
 	std::unique_ptr<XYPOSITION []> positions;
 public:
 	PositionCacheEntry() noexcept;
@@ -196,6 +196,8 @@ public:
 	void Clear() noexcept;
 	bool Retrieve(unsigned int styleNumber_, const char *s_, unsigned int len_, XYPOSITION *positions_) const noexcept;
 	static unsigned int Hash(unsigned int styleNumber_, const char *s, unsigned int len_) noexcept;
+	static size_t MemorySize(unsigned int len_) noexcept;
+	size_t MemorySize() const noexcept;
 	bool NewerThan(const PositionCacheEntry &other) const noexcept;
 	void ResetClock() noexcept;
 };
@@ -265,10 +267,23 @@ public:
 	bool More() const noexcept;
 };
 
+class PositionCacheShard;
+
+/**
+ * Measurements are cached in a table shared by all views in the process when this view
+ * has a memory budget, otherwise in this view's own table. The shared table is divided
+ * into a shard for each font so views with the same fonts reuse measurements.
+ */
 class PositionCache {
 	std::vector<PositionCacheEntry> pces;
 	unsigned int clock;
 	bool allClear;
+	// Shard of the shared table for each style along with the font it was found for
+	// and the document code page the shards were found for
+	std::vector<std::pair<FontID, PositionCacheShard *>> shardForStyle;
+	int codePageShards;
+	size_t sharedBudget;
+	PositionCacheShard *ShardForStyle(Surface *surface, const ViewStyle &vstyle, unsigned int styleNumber, int codePage);
 public:
 	PositionCache();
 	// Deleted so PositionCache objects can not be copied.
@@ -282,6 +297,11 @@ public:
 	size_t GetSize() const noexcept { return pces.size(); }
 	void MeasureWidths(Surface *surface, const ViewStyle &vstyle, unsigned int styleNumber,
 		const char *s, unsigned int len, XYPOSITION *positions, const Document *pdoc);
+	void SetSharedBudget(size_t budget);
+	size_t GetSharedBudget() const noexcept;
+	static size_t SharedHits() noexcept;
+	static size_t SharedMisses() noexcept;
+	static size_t SharedMemory() noexcept;
 };
 
 }
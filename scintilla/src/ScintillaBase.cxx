@@ -603,6 +603,7 @@ LexState::LexState(Document *pdoc_) : LexInterface(pdoc_) {
 }
 
 LexState::~LexState() {
+	StopStyleAhead();
 	if (instance) {
 		instance->Release();
 		instance = nullptr;
@@ -622,7 +623,10 @@ LexState *ScintillaBase::DocumentLexState() {
 	if (!pdoc->GetLexInterface()) {
 		pdoc->SetLexInterface(std::make_unique<LexState>(pdoc));
 	}
-	return dynamic_cast<LexState *>(pdoc->GetLexInterface());
+	LexState *pls = dynamic_cast<LexState *>(pdoc->GetLexInterface());
+	// Calls on the lexer instance may not overlap with a style-ahead worker
+	pls->StopStyleAhead();
+	return pls;
 }
 
 void LexState::SetLexerModule(const LexerModule *lex) {
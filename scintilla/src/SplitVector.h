@@ -323,6 +323,31 @@ public:
 		}
 	}
 
+	/// Return a pointer to the run of elements starting at position that is
+	/// contiguous in memory without moving the gap.
+	/// The run is limited to rangeLength elements and its length is returned in lengthSpan.
+	T *SpanPointer(ptrdiff_t position, ptrdiff_t rangeLength, ptrdiff_t &lengthSpan) noexcept {
+		PLATFORM_ASSERT((position >= 0) && (rangeLength >= 0) && (position + rangeLength <= lengthBody));
+		if (position < part1Length) {
+			lengthSpan = std::min(rangeLength, part1Length - position);
+			return body.data() + position;
+		} else {
+			lengthSpan = rangeLength;
+			return body.data() + position + gapLength;
+		}
+	}
+
+	const T *SpanPointer(ptrdiff_t position, ptrdiff_t rangeLength, ptrdiff_t &lengthSpan) const noexcept {
+		PLATFORM_ASSERT((position >= 0) && (rangeLength >= 0) && (position + rangeLength <= lengthBody));
+		if (position < part1Length) {
+			lengthSpan = std::min(rangeLength, part1Length - position);
+			return body.data() + position;
+		} else {
+			lengthSpan = rangeLength;
+			return body.data() + position + gapLength;
+		}
+	}
+
 	/// Return the position of the gap within the buffer.
 	ptrdiff_t GapPosition() const noexcept {
 		return part1Length;
@@ -61,6 +61,20 @@ class TestPerformance(unittest.TestCase):
 		self.xite.DoEvents()
 		self.assert_(self.ed.Length > 0)
 
+	def testHugeLineLengths(self):
+		# Loading large files: cost of finding line ends for different line lengths
+		for lineLength in [10, 80, 1000, 10000]:
+			self.ed.ClearAll()
+			oneLine = ("x" * (lineLength - 1) + "\n").encode('utf-8')
+			data = oneLine * (100000000 // lineLength)
+			start = timer()
+			self.ed.AddText(len(data), data)
+			end = timer()
+			duration = end - start
+			print("%6.3f testHugeLineLengths %d" % (duration, lineLength))
+			self.assertEquals(self.ed.LineCount, 100000000 // lineLength + 1)
+		self.xite.DoEvents()
+
 	def testHugeInserts(self):
 		data = (string.ascii_letters + string.digits + "\n").encode('utf-8')
 		data = data * 100000
@@ -129,5 +143,67 @@ class TestPerformance(unittest.TestCase):
 		print("%6.3f testUTF8Searches" % duration)
 		self.xite.DoEvents()
 
+	def testUTF8FoldSearches(self):
+		# Case-insensitive search folds every non-ASCII character
+		self.ed.SetCodePage(65001)
+		oneLine = "Ελληνικά Кириллица Straße ÀÉÎÕÜ 折りたたみ\n".encode('utf-8')
+		manyLines = oneLine * 100000
+		manyLines = manyLines + "Ωμέγα\n".encode('utf-8')
+		self.ed.AddText(len(manyLines), manyLines)
+		searchString = "ωμέγα".encode('utf-8')
+		start = timer()
+		for i in range(10):
+			self.ed.TargetStart = 0
+			self.ed.TargetEnd = self.ed.Length-1
+			self.ed.SearchFlags = 0
+			pos = self.ed.SearchInTarget(len(searchString), searchString)
+			self.assert_(pos > 0)
+		end = timer()
+		duration = end - start
+		print("%6.3f testUTF8FoldSearches" % duration)
+		self.xite.DoEvents()
+
+	def testLexPythonUnicodeIdentifiers(self):
+		# Identifiers outside ASCII are classified by Unicode general category
+		self.ed.SetCodePage(65001)
+		self.ed.LexerLanguage = b"python"
+		oneLine = "def συνάρτηση(переменная, 変数): return переменная + 変数 * συνάρτηση\n".encode('utf-8')
+		data = oneLine * 50000
+		self.ed.AddText(len(data), data)
+		start = timer()
+		self.ed.Colourise(0, self.ed.Length)
+		end = timer()
+		duration = end - start
+		print("%6.3f testLexPythonUnicodeIdentifiers" % duration)
+		self.assertEquals(self.ed.EndStyled, self.ed.Length)
+		self.ed.Lexer = self.ed.SCLEX_CONTAINER
+		self.xite.DoEvents()
+
+	def testLexSQLKeywords(self):
+		# Lexing a large SQL file with thousands of keywords, many sharing first characters
+		sqlWords = ("select insert update delete from where group order by having join left right "
+			"inner outer on as and or not null is in like between exists case when then else end "
+			"create table view index drop alter add column constraint primary key foreign "
+			"references set values into union all distinct count sum min max avg cast convert").split()
+		suffixes = ["", "_all", "_any", "_by", "_columns", "_data", "_id", "_name", "_stats", "_time"]
+		keywords = [word + suffix + (str(i) if i else "")
+			for word in sqlWords for suffix in suffixes for i in range(5)]
+		self.ed.LexerLanguage = b"sql"
+		self.ed.SetKeyWords(0, " ".join(keywords).encode('utf-8'))
+		self.ed.SetKeyWords(1, " ".join(keywords[1::2]).encode('utf-8'))
+		oneLine = ("select s.name_id, c.count_all, sum(total) as sum_stats from sales s "
+			"inner join customers c on s.customer = c.id where s.set_data is not null "
+			"and c.column_name like 'sel%' group by s.name_id order by sum_stats;\n").encode('utf-8')
+		data = oneLine * 50000
+		self.ed.AddText(len(data), data)
+		start = timer()
+		self.ed.Colourise(0, self.ed.Length)
+		end = timer()
+		duration = end - start
+		print("%6.3f testLexSQLKeywords %d" % (duration, len(keywords)))
+		self.assertEquals(self.ed.EndStyled, self.ed.Length)
+		self.ed.Lexer = self.ed.SCLEX_CONTAINER
+		self.xite.DoEvents()
+
 if __name__ == '__main__':
 	Xite.main("performanceTests")
@@ -0,0 +1,29 @@
+#-------------------------------------------------
+#
+# Compares the tiles of ScintillaEditBase for Qt Quick after scrolling and
+# editing with painting the whole view again.
+# Build ../../qt/ScintillaEditBase first then run with:
+#     qmake && make && ./testTiles
+#
+#-------------------------------------------------
+
+QT       += qml quick core gui testlib
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+TARGET = testTiles
+TEMPLATE = app
+CONFIG += console testcase
+CONFIG -= app_bundle
+CONFIG += c++1z
+
+ARCH_PATH = x86
+
+SOURCES += \
+    testTiles.cpp
+
+INCLUDEPATH += ../../include ../../src ../../lexlib ../../qt/ScintillaEditBase
+
+DEFINES += SCINTILLA_QT_QML=1 SCI_LEXER=1 _CRT_SECURE_NO_DEPRECATE=1
+
+LIBS += -L../../bin-$${ARCH_PATH} -lScintillaEditBase
+PRE_TARGETDEPS += ../../bin-$${ARCH_PATH}/libScintillaEditBase.a
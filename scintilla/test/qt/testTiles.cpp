@@ -0,0 +1,179 @@
+// Test the tiles of ScintillaEditBase for Qt Quick
+// Lines are painted into tiles which are kept while scrolling, so after any
+// sequence of scrolling and editing the view has to look the same as a view
+// which paints everything from scratch.
+// Rendered with the software backend of Qt Quick without a display, so the
+// images of the two views are the same pixel for pixel.
+
+#include <string>
+
+#include <QApplication>
+#include <QImage>
+#include <QQuickWindow>
+#include <QtTest>
+
+#include "Platform.h"
+#include "Scintilla.h"
+#include "SciLexer.h"
+#include "ScintillaEditBase.h"
+
+namespace {
+
+const int viewWidth = 400;
+// Not a multiple of the line height so the last line is visible partly.
+const int viewHeight = 301;
+
+std::string Source() {
+	std::string text;
+	for (int line = 0; line < 2000; line++) {
+		text += "int value" + std::to_string(line) + " = " + std::to_string(line * 7) + "; // comment\n";
+		if (line % 50 == 10) {
+			text += "/* block\n   comment */\n";
+		}
+	}
+	return text;
+}
+
+class View {
+public:
+	QQuickWindow window;
+	ScintillaEditBase *editor;
+
+	// Shows the document or, without one, a new document with C++ source.
+	explicit View(sptr_t document = 0) {
+		window.resize(viewWidth, viewHeight);
+		editor = new ScintillaEditBase(window.contentItem());
+		editor->setSize(QSizeF(viewWidth, viewHeight));
+		editor->send(SCI_SETCARETPERIOD, 0);
+		editor->send(SCI_SETMARGINTYPEN, 0, SC_MARGIN_NUMBER);
+		editor->send(SCI_SETMARGINWIDTHN, 0, 40);
+		editor->send(SCI_STYLESETFORE, SCE_C_COMMENT, 0x008000);
+		editor->send(SCI_STYLESETFORE, SCE_C_COMMENTLINE, 0x008000);
+		editor->send(SCI_STYLESETFORE, SCE_C_WORD, 0x800000);
+		editor->send(SCI_STYLESETFORE, SCE_C_NUMBER, 0x808000);
+		if (document) {
+			editor->send(SCI_SETDOCPOINTER, 0, document);
+		} else {
+			editor->sends(SCI_SETLEXERLANGUAGE, 0, "cpp");
+			editor->sends(SCI_SETKEYWORDS, 0, "int");
+			editor->sends(SCI_SETTEXT, 0, Source().c_str());
+		}
+		window.show();
+		QTest::qWaitForWindowExposed(&window);
+	}
+
+	QImage Grab() {
+		return window.grabWindow();
+	}
+
+	// The same state painted by a new view which has no tiles yet.
+	QImage Repainted() {
+		View reference(editor->send(SCI_GETDOCPOINTER));
+		reference.editor->send(SCI_SETZOOM, editor->send(SCI_GETZOOM));
+		reference.editor->send(SCI_SETSEL, editor->send(SCI_GETANCHOR), editor->send(SCI_GETCURRENTPOS));
+		reference.editor->send(SCI_SETFIRSTVISIBLELINE, editor->send(SCI_GETFIRSTVISIBLELINE));
+		reference.editor->send(SCI_SETXOFFSET, editor->send(SCI_GETXOFFSET));
+		return reference.Grab();
+	}
+
+	void ScrollTo(int line) {
+		editor->send(SCI_SETFIRSTVISIBLELINE, line);
+		Grab();
+	}
+
+	void InsertAtLine(int line, const char *text) {
+		editor->sends(SCI_INSERTTEXT, editor->send(SCI_POSITIONFROMLINE, line), text);
+	}
+};
+
+}
+
+class TestTiles : public QObject {
+	Q_OBJECT
+
+private slots:
+	void scrolled();
+	void edited();
+	void restyled();
+	void zoomed();
+};
+
+void TestTiles::scrolled() {
+	View view;
+	QCOMPARE(view.Grab(), view.Repainted());
+	for (const int lines : {3, 16, 40, -35, -24, 500, -497, 1}) {
+		view.editor->send(SCI_LINESCROLL, 0, lines);
+		QCOMPARE(view.Grab(), view.Repainted());
+	}
+	view.editor->send(SCI_SETXOFFSET, 30);
+	QCOMPARE(view.Grab(), view.Repainted());
+	view.editor->send(SCI_LINESCROLL, 0, -4);
+	QCOMPARE(view.Grab(), view.Repainted());
+}
+
+void TestTiles::edited() {
+	View view;
+	view.ScrollTo(100);
+	view.ScrollTo(120);
+
+	// Above the view among cached lines
+	view.InsertAtLine(105, "int inserted;\nint inserted2;\n");
+	QCOMPARE(view.Grab(), view.Repainted());
+	view.ScrollTo(100);
+	QCOMPARE(view.Grab(), view.Repainted());
+
+	// Below the view among cached lines
+	view.ScrollTo(140);
+	view.ScrollTo(100);
+	view.editor->send(SCI_SETSEL, view.editor->send(SCI_POSITIONFROMLINE, 130),
+		view.editor->send(SCI_POSITIONFROMLINE, 133));
+	view.editor->send(SCI_SETFIRSTVISIBLELINE, 100);
+	view.editor->sends(SCI_REPLACESEL, 0, "");
+	QCOMPARE(view.Grab(), view.Repainted());
+	view.ScrollTo(125);
+	QCOMPARE(view.Grab(), view.Repainted());
+
+	// In the view
+	view.InsertAtLine(130, "int typed = 1;\n");
+	QCOMPARE(view.Grab(), view.Repainted());
+	view.ScrollTo(100);
+	QCOMPARE(view.Grab(), view.Repainted());
+}
+
+void TestTiles::restyled() {
+	View view;
+	view.ScrollTo(200);
+	view.ScrollTo(230);
+
+	// Opening a comment above the view restyles every line after it, including
+	// cached lines which are not invalidated by the modification.
+	view.InsertAtLine(150, "/*\n");
+	QCOMPARE(view.Grab(), view.Repainted());
+	view.ScrollTo(200);
+	QCOMPARE(view.Grab(), view.Repainted());
+
+	view.editor->sends(SCI_SETKEYWORDS, 0, "int value100");
+	view.ScrollTo(230);
+	QCOMPARE(view.Grab(), view.Repainted());
+}
+
+void TestTiles::zoomed() {
+	View view;
+	view.ScrollTo(50);
+	view.editor->send(SCI_ZOOMIN);
+	QCOMPARE(view.Grab(), view.Repainted());
+	view.ScrollTo(40);
+	QCOMPARE(view.Grab(), view.Repainted());
+}
+
+int main(int argc, char *argv[]) {
+	if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+	}
+	qputenv("QT_QUICK_BACKEND", "software");
+	QApplication app(argc, argv);
+	TestTiles test;
+	return QTest::qExec(&test, argc, argv);
+}
+
+#include "testTiles.moc"
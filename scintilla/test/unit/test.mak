@@ -12,15 +12,28 @@ CXXFLAGS = /EHsc /std:c++17 /D_HAS_AUTO_PTR_ETC=1 /wd 4805 $(INCLUDEDIRS)
 TESTSRC=test*.cxx
 # Files being tested from scintilla/src directory
 TESTEDSRC=\
+ ../../lexlib/CharacterCategory.cxx \
  ../../lexlib/WordList.cxx \
+ ../../src/CaseConvert.cxx \
+ ../../src/CaseFolder.cxx \
  ../../src/CellBuffer.cxx \
  ../../src/CharClassify.cxx \
  ../../src/ContractionState.cxx \
  ../../src/Decoration.cxx \
+ ../../src/Document.cxx \
+ ../../src/Indicator.cxx \
+ ../../src/KeyMap.cxx \
+ ../../src/LineMarker.cxx \
  ../../src/PerLine.cxx \
+ ../../src/PositionCache.cxx \
+ ../../src/RESearch.cxx \
  ../../src/RunStyles.cxx \
+ ../../src/Selection.cxx \
+ ../../src/Style.cxx \
  ../../src/UniConversion.cxx \
- ../../src/UniqueString.cxx
+ ../../src/UniqueString.cxx \
+ ../../src/ViewStyle.cxx \
+ ../../src/XPM.cxx
 
 TESTS=$(EXE)
 
@@ -0,0 +1,50 @@
+// Unit Tests for Scintilla internal data structures
+// Encoding: UTF-8
+
+#include <cstring>
+
+#include <string>
+
+#include "CaseConvert.h"
+
+#include "catch.hpp"
+
+using namespace Scintilla;
+
+// Test CaseConvert.
+
+TEST_CASE("CaseConvert") {
+
+	SECTION("Ascii") {
+		REQUIRE(std::string(CaseConvert('A', CaseConversionFold)) == "a");
+		REQUIRE(std::string(CaseConvert('a', CaseConversionUpper)) == "A");
+		REQUIRE(std::string(CaseConvert('Z', CaseConversionLower)) == "z");
+		REQUIRE(CaseConvert('a', CaseConversionFold) == nullptr);
+		REQUIRE(CaseConvert('1', CaseConversionUpper) == nullptr);
+	}
+
+	SECTION("Symmetric") {
+		REQUIRE(std::string(CaseConvert(0x3A6, CaseConversionFold)) == "φ");
+		REQUIRE(std::string(CaseConvert(0x3C6, CaseConversionUpper)) == "Φ");
+		REQUIRE(std::string(CaseConvert(0x410, CaseConversionLower)) == "а");
+	}
+
+	SECTION("Complex") {
+		REQUIRE(std::string(CaseConvert(0xDF, CaseConversionFold)) == "ss");
+		REQUIRE(std::string(CaseConvert(0xDF, CaseConversionUpper)) == "SS");
+		REQUIRE(CaseConvert(0xDF, CaseConversionLower) == nullptr);
+	}
+
+	SECTION("NoConversion") {
+		REQUIRE(CaseConvert(-1, CaseConversionFold) == nullptr);
+		REQUIRE(CaseConvert(0x3042, CaseConversionFold) == nullptr);
+		REQUIRE(CaseConvert(0x10FFFF, CaseConversionUpper) == nullptr);
+		REQUIRE(CaseConvert(0x110000, CaseConversionLower) == nullptr);
+	}
+
+	SECTION("String") {
+		REQUIRE(CaseConvertString("ΦΑΣΗ Straße", CaseConversionFold) == "φαση strasse");
+		REQUIRE(CaseConvertString("φάση straße", CaseConversionUpper) == "ΦΆΣΗ STRASSE");
+		REQUIRE(CaseConvertString("折り Abc", CaseConversionLower) == "折り abc");
+	}
+}
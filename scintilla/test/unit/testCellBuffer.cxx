@@ -3,10 +3,12 @@
 #include <cstddef>
 #include <cstring>
 #include <stdexcept>
+#include <string>
 #include <string_view>
 #include <vector>
 #include <algorithm>
 #include <memory>
+#include <iterator>
 
 #include "Platform.h"
 
@@ -128,6 +130,33 @@ TEST_CASE("CellBuffer") {
 		REQUIRE(!cb.CanRedo());
 	}
 
+	SECTION("UndoReplacesRedo") {
+		bool startSequence = false;
+		cb.InsertString(0, "abc", 3, startSequence);
+		cb.InsertString(0, "xyz", 3, startSequence);
+		REQUIRE(memcmp(cb.BufferPointer(), "xyzabc", 6) == 0);
+		int steps = cb.StartUndo();
+		REQUIRE(steps == 1);
+		cb.PerformUndoStep();
+		REQUIRE(cb.CanRedo());
+		// New action discards the text of the undone action
+		const char *cpChange = cb.InsertString(3, "def", 3, startSequence);
+		REQUIRE(memcmp(cpChange, "def", 3) == 0);
+		REQUIRE(!cb.CanRedo());
+		REQUIRE(memcmp(cb.BufferPointer(), "abcdef", 6) == 0);
+		steps = cb.StartUndo();
+		REQUIRE(steps == 2);
+		cb.PerformUndoStep();
+		cb.PerformUndoStep();
+		REQUIRE(cb.Length() == 0);
+		steps = cb.StartRedo();
+		REQUIRE(steps == 2);
+		cb.PerformRedoStep();
+		cb.PerformRedoStep();
+		REQUIRE(cb.Length() == 6);
+		REQUIRE(memcmp(cb.BufferPointer(), "abcdef", 6) == 0);
+	}
+
 	SECTION("LineEndTypes") {
 		REQUIRE(cb.GetLineEndTypes() == 0);
 		cb.SetLineEndTypes(1);
@@ -145,6 +174,95 @@ TEST_CASE("CellBuffer") {
 		REQUIRE(cb.Length() == 0);
 	}
 
+	SECTION("LongLines") {
+		// Lines of varying lengths so line ends fall at many offsets within blocks
+		cb.SetLineEndTypes(1);
+		const char *lineEnds[] = { "\n", "\r\n", "\r", "\xc2\x85", "\xe2\x80\xa8", "\xe2\x80\xa9" };
+		std::string text;
+		std::vector<Sci::Position> starts;
+		for (size_t line = 0; line < 120; line++) {
+			starts.push_back(text.length());
+			// Include UTF-8 characters with trail bytes that are also line end trail bytes
+			text.append(line, 'x');
+			if (line % 7 == 3) {
+				text.append("\xe2\x82\xa9");	// WON SIGN U+20A9
+			}
+			text.append(lineEnds[line % std::size(lineEnds)]);
+		}
+		starts.push_back(text.length());
+		bool startSequence = false;
+		cb.InsertString(0, text.c_str(), text.length(), startSequence);
+		REQUIRE(cb.Lines() == static_cast<Sci::Line>(starts.size()));
+		for (size_t line = 0; line < starts.size(); line++) {
+			REQUIRE(cb.LineStart(line) == starts[line]);
+		}
+	}
+
+	SECTION("StylesAcrossGap") {
+		bool startSequence = false;
+		cb.InsertString(0, sText, sLength, startSequence);
+		// Inserting in the middle leaves the style gap inside the text
+		cb.InsertString(4, "XY", 2, startSequence);
+		const Sci::Position length = cb.Length();
+		REQUIRE(cb.SetStyleFor(2, 8, 3));
+		REQUIRE(!cb.SetStyleFor(2, 8, 3));
+		for (Sci::Position pos = 0; pos < length; pos++) {
+			REQUIRE(cb.StyleAt(pos) == ((pos >= 2 && pos < 10) ? 3 : 0));
+		}
+		REQUIRE(cb.SetStyleFor(9, 1, 0));
+		REQUIRE(cb.SetStyleFor(0, length, 0));
+
+		const char styles[] = "\0\0\0\1\0\0\0\2\0\0\0";
+		Sci::Position startMod = -1;
+		Sci::Position endMod = -1;
+		REQUIRE(!cb.SetStyles(0, length, std::string(length, '\0').c_str(), startMod, endMod));
+		REQUIRE(cb.SetStyles(0, length, styles, startMod, endMod));
+		REQUIRE(startMod == 3);
+		REQUIRE(endMod == 7);
+		for (Sci::Position pos = 0; pos < length; pos++) {
+			REQUIRE(cb.StyleAt(pos) == styles[pos]);
+		}
+		REQUIRE(!cb.SetStyles(0, length, styles, startMod, endMod));
+	}
+
+}
+
+TEST_CASE("UndoText") {
+
+	UndoText text;
+
+	SECTION("Append") {
+		REQUIRE(text.Allocated() == 0);
+		const char *abc = text.Append("abc", 3);
+		const char *de = text.Append("de", 2);
+		REQUIRE(memcmp(abc, "abc", 3) == 0);
+		REQUIRE(de == abc + 3);
+		REQUIRE(text.Allocated() == UndoText::chunkSize);
+	}
+
+	SECTION("Large") {
+		const std::string large(UndoText::chunkSize + 10, 'x');
+		const char *abc = text.Append("abc", 3);
+		const char *stored = text.Append(large.c_str(), large.length());
+		REQUIRE(memcmp(abc, "abc", 3) == 0);
+		REQUIRE(memcmp(stored, large.c_str(), large.length()) == 0);
+		REQUIRE(text.Allocated() == UndoText::chunkSize * 2 + 10);
+	}
+
+	SECTION("Truncate") {
+		const char *abc = text.Append("abc", 3);
+		const std::string large(UndoText::chunkSize, 'x');
+		text.Append(large.c_str(), large.length());
+		text.Append(large.c_str(), large.length());
+		REQUIRE(text.Allocated() == UndoText::chunkSize * 3);
+		text.TruncateTo(abc + 3);
+		// One spare chunk retained
+		REQUIRE(text.Allocated() == UndoText::chunkSize * 2);
+		const char *de = text.Append("de", 2);
+		REQUIRE(de == abc + 3);
+		text.Clear();
+		REQUIRE(text.Allocated() == 0);
+	}
 }
 
 TEST_CASE("CharacterIndex") {
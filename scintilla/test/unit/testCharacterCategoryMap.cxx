@@ -0,0 +1,58 @@
+// Unit Tests for Scintilla internal data structures
+
+#include <cstddef>
+
+#include <vector>
+
+#include "CharacterCategory.h"
+
+#include "catch.hpp"
+
+using namespace Scintilla;
+
+// Test CharacterCategoryMap.
+
+TEST_CASE("CharacterCategoryMap") {
+
+	const CharacterCategoryMap ctm;
+
+	SECTION("LowerValues") {
+		REQUIRE(ctm.CategoryFor('A') == ccLu);
+		REQUIRE(ctm.CategoryFor('a') == ccLl);
+		REQUIRE(ctm.CategoryFor('1') == ccNd);
+		REQUIRE(ctm.CategoryFor(' ') == ccZs);
+		REQUIRE(ctm.CategoryFor('\t') == ccCc);
+	}
+
+	SECTION("HigherValues") {
+		REQUIRE(ctm.CategoryFor(0x3C6) == ccLl);	// GREEK SMALL LETTER PHI
+		REQUIRE(ctm.CategoryFor(0x3042) == ccLo);	// HIRAGANA LETTER A
+		REQUIRE(ctm.CategoryFor(0x2028) == ccZl);	// LINE SEPARATOR
+		REQUIRE(ctm.CategoryFor(0xD800) == ccCs);	// First high surrogate
+		REQUIRE(ctm.CategoryFor(0xE000) == ccCo);	// First private use
+		REQUIRE(ctm.CategoryFor(0x1F600) == ccSo);	// GRINNING FACE
+		REQUIRE(ctm.CategoryFor(0x10FFFD) == ccCo);	// Last private use
+	}
+
+	SECTION("OutOfRange") {
+		REQUIRE(ctm.CategoryFor(-1) == ccCn);
+		REQUIRE(ctm.CategoryFor(0x110000) == ccCn);
+	}
+
+	SECTION("Optimize") {
+		CharacterCategoryMap ctmOptimized;
+		ctmOptimized.Optimize(0x10000);
+		REQUIRE(ctmOptimized.Size() == 0x10000);
+		for (int ch = 0; ch < 0x11000; ch++) {
+			REQUIRE(ctmOptimized.CategoryFor(ch) == CategoriseCharacter(ch));
+		}
+	}
+
+	SECTION("Identifiers") {
+		REQUIRE(IsXidStart(0x3C6));
+		REQUIRE(!IsXidStart('1'));
+		REQUIRE(IsXidContinue('1'));
+		REQUIRE(!IsXidContinue(0x309B));	// Omitted from XID_Continue
+		REQUIRE(IsIdContinue(0x309B));
+	}
+}
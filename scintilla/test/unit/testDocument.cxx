@@ -0,0 +1,482 @@
+// Unit Tests for Scintilla internal data structures
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <forward_list>
+#include <algorithm>
+#include <memory>
+#include <iterator>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "Platform.h"
+
+#include "ILoader.h"
+#include "ILexer.h"
+#include "Scintilla.h"
+
+#include "CharacterCategory.h"
+#include "Position.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "CellBuffer.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "CaseFolder.h"
+#include "Document.h"
+
+#include "catch.hpp"
+
+using namespace Scintilla;
+
+// Test Document.
+
+namespace {
+
+// A document with the case folding Editor sets up for ASCII.
+struct DocPlus {
+	Document document;
+
+	explicit DocPlus(std::string_view text, int codePage=0) : document(SC_DOCUMENTOPTION_DEFAULT) {
+		document.SetDBCSCodePage(codePage);
+		std::unique_ptr<CaseFolderTable> pcf = std::make_unique<CaseFolderTable>();
+		pcf->StandardASCII();
+		document.SetCaseFolder(pcf.release());
+		document.SetUndoCollection(false);
+		document.InsertString(0, text.data(), text.length());
+	}
+
+	// Leave the gap of the buffer at position so that searches straddle it.
+	void MoveGap(Sci::Position position) {
+		document.InsertString(position, "!", 1);
+		document.DeleteChars(position, 1);
+	}
+
+	Sci::Position Find(Sci::Position minPos, Sci::Position maxPos, std::string_view needle, int flags) {
+		Sci::Position lengthFound = needle.length();
+		return document.FindText(minPos, maxPos, needle.data(), flags, &lengthFound);
+	}
+};
+
+char FoldASCII(char ch) noexcept {
+	return (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch - 'A' + 'a') : ch;
+}
+
+// The byte by byte search that Document::FindText performed before FindBytes.
+// Searches backwards when minPos is greater than maxPos.
+Sci::Position FindSimple(std::string_view text, Sci::Position minPos, Sci::Position maxPos, std::string_view needle, bool caseSensitive) {
+	const Sci::Position lengthFind = needle.length();
+	const auto matches = [&](Sci::Position pos) {
+		for (Sci::Position i = 0; i < lengthFind; i++) {
+			const char ch = text[pos + i];
+			if (caseSensitive ? (ch != needle[i]) : (FoldASCII(ch) != FoldASCII(needle[i])))
+				return false;
+		}
+		return true;
+	};
+	if (minPos <= maxPos) {
+		for (Sci::Position pos = minPos; pos + lengthFind <= maxPos; pos++) {
+			if (matches(pos))
+				return pos;
+		}
+	} else {
+		for (Sci::Position pos = minPos - lengthFind; pos >= maxPos; pos--) {
+			if (matches(pos))
+				return pos;
+		}
+	}
+	return -1;
+}
+
+// Text from a small alphabet so that short needles occur often and long needles rarely.
+std::string Generated(size_t length) {
+	std::string text;
+	unsigned int seed = 1;
+	const char alphabet[] = "abcABC \n";
+	for (size_t i = 0; i < length; i++) {
+		seed = seed * 1103515245 + 12345;
+		text.push_back(alphabet[(seed >> 16) % (sizeof(alphabet) - 1)]);
+	}
+	return text;
+}
+
+
+// Styles comments "/* */" which may span lines as 1, digits as 2 and braces as 3.
+// Folds on braces outside comments. The comment state and brace depth at the end
+// of each line are kept in the line state so lexing can start at any line.
+class LexerTest final : public ILexer5 {
+public:
+	static constexpr int styleComment = 1;
+	static constexpr int styleNumber = 2;
+	static constexpr int styleBrace = 3;
+
+	int SCI_METHOD Version() const override {
+		return lvRelease5;
+	}
+	void SCI_METHOD Release() override {
+		delete this;
+	}
+	const char * SCI_METHOD PropertyNames() override {
+		return "";
+	}
+	int SCI_METHOD PropertyType(const char *) override {
+		return 0;
+	}
+	const char * SCI_METHOD DescribeProperty(const char *) override {
+		return "";
+	}
+	Sci_Position SCI_METHOD PropertySet(const char *, const char *) override {
+		return -1;
+	}
+	const char * SCI_METHOD DescribeWordListSets() override {
+		return "";
+	}
+	Sci_Position SCI_METHOD WordListSet(int, const char *) override {
+		return -1;
+	}
+	void SCI_METHOD Lex(Sci_PositionU startPos, Sci_Position lengthDoc, int, IDocument *pAccess) override {
+		const Sci_Position end = startPos + lengthDoc;
+		const Sci_Position start = pAccess->LineStart(pAccess->LineFromPosition(startPos));
+		const Sci_Position line = pAccess->LineFromPosition(start);
+		const int state = (line > 0) ? pAccess->GetLineState(line - 1) : 0;
+		bool inComment = state & 1;
+		int depth = state >> 1;
+		std::vector<char> text(end - start);
+		pAccess->GetCharRange(text.data(), start, text.size());
+		std::vector<char> styles(text.size());
+		const bool atEnd = end == pAccess->Length();
+		for (size_t i = 0; i < text.size(); i++) {
+			const char ch = text[i];
+			const char chNext = (i + 1 < text.size()) ? text[i + 1] : '\0';
+			if (inComment) {
+				styles[i] = styleComment;
+				if ((ch == '*') && (chNext == '/')) {
+					styles[++i] = styleComment;
+					inComment = false;
+				}
+			} else if ((ch == '/') && (chNext == '*')) {
+				styles[i] = styleComment;
+				styles[++i] = styleComment;
+				inComment = true;
+			} else if (ch >= '0' && ch <= '9') {
+				styles[i] = styleNumber;
+			} else if (ch == '{' || ch == '}') {
+				styles[i] = styleBrace;
+				depth += (ch == '{') ? 1 : ((depth > 0) ? -1 : 0);
+			}
+			if ((text[i] == '\n') || ((i + 1 >= text.size()) && atEnd)) {
+				pAccess->SetLineState(pAccess->LineFromPosition(start + i), (inComment ? 1 : 0) | (depth << 1));
+			}
+		}
+		pAccess->StartStyling(start);
+		pAccess->SetStyles(styles.size(), styles.data());
+	}
+	void SCI_METHOD Fold(Sci_PositionU startPos, Sci_Position lengthDoc, int, IDocument *pAccess) override {
+		const Sci_Position end = startPos + lengthDoc;
+		for (Sci_Position line = pAccess->LineFromPosition(startPos); pAccess->LineStart(line) < end; line++) {
+			const int depthStart = (line > 0) ? (pAccess->GetLineState(line - 1) >> 1) : 0;
+			const int depthEnd = pAccess->GetLineState(line) >> 1;
+			pAccess->SetLevel(line, (SC_FOLDLEVELBASE + depthStart) | ((depthEnd > depthStart) ? SC_FOLDLEVELHEADERFLAG : 0));
+		}
+	}
+	void * SCI_METHOD PrivateCall(int, void *) override {
+		return nullptr;
+	}
+	int SCI_METHOD LineEndTypesSupported() override {
+		return SC_LINE_END_TYPE_DEFAULT;
+	}
+	int SCI_METHOD AllocateSubStyles(int, int) override {
+		return -1;
+	}
+	int SCI_METHOD SubStylesStart(int) override {
+		return -1;
+	}
+	int SCI_METHOD SubStylesLength(int) override {
+		return 0;
+	}
+	int SCI_METHOD StyleFromSubStyle(int subStyle) override {
+		return subStyle;
+	}
+	int SCI_METHOD PrimaryStyleFromStyle(int style) override {
+		return style;
+	}
+	void SCI_METHOD FreeSubStyles() override {
+	}
+	void SCI_METHOD SetIdentifiers(int, const char *) override {
+	}
+	int SCI_METHOD DistanceToSecondaryStyles() override {
+		return 0;
+	}
+	const char * SCI_METHOD GetSubStyleBases() override {
+		return "";
+	}
+	int SCI_METHOD NamedStyles() override {
+		return 4;
+	}
+	const char * SCI_METHOD NameOfStyle(int) override {
+		return "";
+	}
+	const char * SCI_METHOD TagsOfStyle(int) override {
+		return "";
+	}
+	const char * SCI_METHOD DescriptionOfStyle(int) override {
+		return "";
+	}
+	const char * SCI_METHOD GetName() override {
+		return "test";
+	}
+	int SCI_METHOD GetIdentifier() override {
+		return 0;
+	}
+	const char * SCI_METHOD PropertyGet(const char *) override {
+		return "";
+	}
+};
+
+// Owns a LexerTest the way LexState owns the lexer of a document.
+class LexInterfaceTest : public LexInterface {
+public:
+	explicit LexInterfaceTest(Document *pdoc_) : LexInterface(pdoc_) {
+		instance = new LexerTest();
+	}
+	~LexInterfaceTest() override {
+		// The worker has to stop before the lexer it uses is released
+		StopStyleAhead();
+		instance->Release();
+		instance = nullptr;
+	}
+};
+
+// Lines with comments over several lines, numbers and nested braces.
+std::string GeneratedCode(size_t length) {
+	std::string text;
+	unsigned int seed = 7;
+	const char *pieces[] = { "{", "}", "/*", "*/", "12", "word", " ", "\n", "\n", "x = 3;\n" };
+	while (text.length() < length) {
+		seed = seed * 1103515245 + 12345;
+		text.append(pieces[(seed >> 16) % std::size(pieces)]);
+	}
+	return text;
+}
+
+// Styles the whole document with the lexer on this thread.
+void StyleSynchronously(Document &document) {
+	document.SetLexInterface(std::make_unique<LexInterfaceTest>(&document));
+	document.EnsureStyledTo(document.Length());
+}
+
+// Styles the way Editor::IdleStyling does with SC_IDLESTYLING_AHEAD, calling between
+// before each idle step. Returns the number of times it had to style on this thread.
+template <typename Between>
+int StyleAheadToEnd(Document &document, Between between) {
+	int synchronous = 0;
+	const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	while (document.GetEndStyled() < document.Length()) {
+		REQUIRE(std::chrono::steady_clock::now() - startTime < std::chrono::seconds(60));
+		between();
+		if (document.StyleAheadIdle()) {
+			if (document.StyleAheadRunning()) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		} else {
+			synchronous++;
+			document.EnsureStyledTo(std::min<Sci::Position>(document.GetEndStyled() + 0x1000, document.Length()));
+		}
+	}
+	return synchronous;
+}
+
+int StyleAheadToEnd(Document &document) {
+	return StyleAheadToEnd(document, []() noexcept {});
+}
+
+// Styles, fold levels and line states have to be identical.
+void RequireSameLexing(const Document &a, const Document &b) {
+	REQUIRE(a.Length() == b.Length());
+	REQUIRE(a.LinesTotal() == b.LinesTotal());
+	std::vector<unsigned char> stylesA(a.Length());
+	std::vector<unsigned char> stylesB(b.Length());
+	a.GetStyleRange(stylesA.data(), 0, stylesA.size());
+	b.GetStyleRange(stylesB.data(), 0, stylesB.size());
+	REQUIRE(stylesA == stylesB);
+	std::vector<int> levelsA;
+	std::vector<int> levelsB;
+	std::vector<int> statesA;
+	std::vector<int> statesB;
+	for (Sci::Line line = 0; line < a.LinesTotal(); line++) {
+		levelsA.push_back(a.GetLevel(line));
+		levelsB.push_back(b.GetLevel(line));
+		statesA.push_back(a.GetLineState(line));
+		statesB.push_back(b.GetLineState(line));
+	}
+	REQUIRE(levelsA == levelsB);
+	REQUIRE(statesA == statesB);
+}
+
+}
+
+TEST_CASE("DocumentFindText") {
+
+	SECTION("Simple") {
+		DocPlus doc("Scintilla scintilla");
+		REQUIRE(0 == doc.Find(0, 19, "Scintilla", SCFIND_MATCHCASE));
+		REQUIRE(10 == doc.Find(0, 19, "scintilla", SCFIND_MATCHCASE));
+		REQUIRE(0 == doc.Find(0, 19, "scintilla", 0));
+		REQUIRE(10 == doc.Find(1, 19, "SCINTILLA", 0));
+		REQUIRE(-1 == doc.Find(0, 19, "SCINTILLA", SCFIND_MATCHCASE));
+		REQUIRE(2 == doc.Find(0, 19, "i", SCFIND_MATCHCASE));
+		// The match has to end before maxPos
+		REQUIRE(-1 == doc.Find(11, 18, "cintilla", SCFIND_MATCHCASE));
+		REQUIRE(11 == doc.Find(11, 19, "cintilla", SCFIND_MATCHCASE));
+		// Backwards
+		REQUIRE(10 == doc.Find(19, 0, "scintilla", 0));
+		REQUIRE(0 == doc.Find(18, 0, "scintilla", 0));
+		REQUIRE(17 == doc.Find(19, 0, "l", SCFIND_MATCHCASE));
+	}
+
+	SECTION("WholeWord") {
+		DocPlus doc("ab abc abcd abc");
+		REQUIRE(3 == doc.Find(0, 15, "abc", SCFIND_MATCHCASE | SCFIND_WHOLEWORD));
+		REQUIRE(12 == doc.Find(4, 15, "abc", SCFIND_MATCHCASE | SCFIND_WHOLEWORD));
+		REQUIRE(3 == doc.Find(0, 15, "ABC", SCFIND_WHOLEWORD));
+		REQUIRE(7 == doc.Find(4, 15, "abc", SCFIND_MATCHCASE | SCFIND_WORDSTART));
+	}
+
+	SECTION("StraddleGap") {
+		const std::string text = "one two three four five six seven";
+		const Sci::Position length = text.length();
+		for (Sci::Position gap = 0; gap <= length; gap++) {
+			DocPlus doc(text);
+			doc.MoveGap(gap);
+			for (Sci::Position start = 0; start < length; start += 3) {
+				for (Sci::Position end = start + 4; end < length; end += 5) {
+					const std::string needle = text.substr(start, end - start);
+					REQUIRE(start == doc.Find(0, length, needle, SCFIND_MATCHCASE));
+					REQUIRE(start == doc.Find(0, length, needle, 0));
+					REQUIRE(start == doc.Find(length, 0, needle, 0));
+				}
+			}
+		}
+	}
+
+	SECTION("CompareWithSimple") {
+		// Longer than the largest block so the blocks overlap by the needle length
+		const std::string text = Generated(0x30000);
+		const Sci::Position length = text.length();
+		const Sci::Position gaps[] = { 0, 1, 0xFF, 0x100, 0x301, 0x10007, length / 2, length - 3, length };
+		const std::string_view needles[] = { "a", "C", "\n", "ab", "aB", "abc", " c\nA", "cbaCBA", "abcabcab", "ABCABCABCABCAB", "zz" };
+		const Sci::Position ranges[][2] = { {0, length}, {1, length - 1}, {0x105, 0x20000}, {length, 0}, {0x20000, 0x105}, {7, 7} };
+		for (const Sci::Position gap : gaps) {
+			DocPlus doc(text);
+			doc.MoveGap(gap);
+			for (const std::string_view needle : needles) {
+				for (const auto &range : ranges) {
+					for (const bool caseSensitive : { true, false }) {
+						const Sci::Position expected = FindSimple(text, range[0], range[1], needle, caseSensitive);
+						const Sci::Position found = doc.Find(range[0], range[1], needle, caseSensitive ? SCFIND_MATCHCASE : 0);
+						REQUIRE(expected == found);
+					}
+				}
+			}
+		}
+	}
+
+	SECTION("UTF8") {
+		// "Ä" is C3 84 so a search for the trail byte alone must not match
+		const std::string text = "xx\xC3\x84yy\xC3\x84zz";
+		DocPlus doc(text, SC_CP_UTF8);
+		doc.MoveGap(4);
+		REQUIRE(2 == doc.Find(0, 10, "\xC3\x84", SCFIND_MATCHCASE));
+		REQUIRE(6 == doc.Find(3, 10, "\xC3\x84z", SCFIND_MATCHCASE));
+		REQUIRE(6 == doc.Find(10, 0, "\xC3\x84", SCFIND_MATCHCASE));
+		REQUIRE(-1 == doc.Find(0, 10, "\x84", SCFIND_MATCHCASE));
+		REQUIRE(4 == doc.Find(0, 10, "YY", 0));
+	}
+}
+
+TEST_CASE("DocumentStyleAhead") {
+
+	// Several worker windows, each published in several chunks
+	const std::string text = GeneratedCode(0x140000);
+
+	SECTION("SameAsColourise") {
+		DocPlus docSynchronous(text);
+		StyleSynchronously(docSynchronous.document);
+		DocPlus docAhead(text);
+		docAhead.document.SetLexInterface(std::make_unique<LexInterfaceTest>(&docAhead.document));
+		REQUIRE(0 == StyleAheadToEnd(docAhead.document));
+		RequireSameLexing(docSynchronous.document, docAhead.document);
+	}
+
+	SECTION("EditWhileStylingAhead") {
+		DocPlus docAhead(text);
+		Document &document = docAhead.document;
+		document.SetLexInterface(std::make_unique<LexInterfaceTest>(&document));
+		int step = 0;
+		StyleAheadToEnd(document, [&]() {
+			step++;
+			if (document.StyleAheadRunning() && (step % 5 == 0) && (step < 60)) {
+				// Alternate edits before and after the styled text, opening and closing comments
+				const Sci::Position endStyled = document.GetEndStyled();
+				const Sci::Position position = (step % 10 == 0) ?
+					endStyled / 2 : std::min(endStyled + 0x20000, document.Length());
+				const char *insertion = (step % 15 == 0) ? "/*" : ((step % 20 == 0) ? "*/\n{" : "7}\n");
+				document.InsertString(position, insertion, strlen(insertion));
+				if (step % 25 == 0) {
+					document.DeleteChars(position / 3, 5);
+				}
+			}
+		});
+		DocPlus docSynchronous(std::string_view(nullptr, 0));
+		std::string textEdited(document.Length(), '\0');
+		document.GetCharRange(textEdited.data(), 0, textEdited.length());
+		docSynchronous.document.InsertString(0, textEdited.data(), textEdited.length());
+		StyleSynchronously(docSynchronous.document);
+		RequireSameLexing(docSynchronous.document, document);
+	}
+
+	SECTION("EnsureStyledWhileStylingAhead") {
+		DocPlus docSynchronous(text);
+		StyleSynchronously(docSynchronous.document);
+		DocPlus docAhead(text);
+		Document &document = docAhead.document;
+		document.SetLexInterface(std::make_unique<LexInterfaceTest>(&document));
+		REQUIRE(document.StyleAheadIdle());
+		REQUIRE(document.StyleAheadRunning());
+		// Styling far ahead takes what the worker has done then stops it and lexes the rest
+		document.EnsureStyledTo(0x100000);
+		REQUIRE(document.GetEndStyled() >= 0x100000);
+		StyleAheadToEnd(document);
+		RequireSameLexing(docSynchronous.document, document);
+	}
+
+	SECTION("StopWhileStylingAhead") {
+		DocPlus docAhead(text);
+		Document &document = docAhead.document;
+		document.SetLexInterface(std::make_unique<LexInterfaceTest>(&document));
+		REQUIRE(document.StyleAheadIdle());
+		REQUIRE(document.StyleAheadRunning());
+		document.GetLexInterface()->StopStyleAhead();
+		REQUIRE(!document.StyleAheadRunning());
+	}
+
+	SECTION("DestroyWhileStylingAhead") {
+		for (int i = 0; i < 10; i++) {
+			std::unique_ptr<DocPlus> docAhead = std::make_unique<DocPlus>(text);
+			docAhead->document.SetLexInterface(std::make_unique<LexInterfaceTest>(&docAhead->document));
+			REQUIRE(docAhead->document.StyleAheadIdle());
+			REQUIRE(docAhead->document.StyleAheadRunning());
+			std::this_thread::sleep_for(std::chrono::microseconds(i * 300));
+			// Destroying the document stops the worker before the lexer is released
+			docAhead.reset();
+		}
+	}
+}
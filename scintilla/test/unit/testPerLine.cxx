@@ -5,6 +5,7 @@
 #include <stdexcept>
 #include <string_view>
 #include <vector>
+#include <map>
 #include <forward_list>
 #include <algorithm>
 #include <memory>
@@ -127,6 +128,48 @@ TEST_CASE("LineMarkers") {
 		REQUIRE(-1 == line3);
 	}
 
+	SECTION("MarkerNextMask") {
+		lm.AddMark(1, 1, 5);
+		lm.AddMark(3, 2, 5);
+		REQUIRE(3 == lm.MarkerNext(0, 4));
+		REQUIRE(1 == lm.MarkerNext(1, 2));
+		REQUIRE(-1 == lm.MarkerNext(2, 2));
+		REQUIRE(-1 == lm.MarkerNext(0, 8));
+		REQUIRE(-1 == lm.MarkerNext(5, 6));
+	}
+
+	SECTION("MarkerPrevious") {
+		lm.AddMark(1, 1, 5);
+		lm.AddMark(3, 2, 5);
+		REQUIRE(3 == lm.MarkerPrevious(4, 6));
+		REQUIRE(3 == lm.MarkerPrevious(3, 6));
+		REQUIRE(1 == lm.MarkerPrevious(2, 6));
+		REQUIRE(1 == lm.MarkerPrevious(4, 2));
+		REQUIRE(-1 == lm.MarkerPrevious(0, 6));
+		REQUIRE(-1 == lm.MarkerPrevious(4, 8));
+		// Beyond the end starts from the last line
+		REQUIRE(3 == lm.MarkerPrevious(100, 4));
+		lm.AddMark(0, 2, 5);
+		REQUIRE(0 == lm.MarkerPrevious(2, 4));
+	}
+
+	SECTION("DeleteFollowedBySearch") {
+		const int handle1 = lm.AddMark(2, 1, 5);
+		lm.AddMark(2, 1, 5);
+		lm.AddMark(4, 1, 5);
+		REQUIRE(lm.DeleteMark(2, 1, false));
+		REQUIRE(2 == lm.MarkerNext(0, 2));
+		REQUIRE(lm.DeleteMark(2, 1, true));
+		REQUIRE(4 == lm.MarkerNext(0, 2));
+		REQUIRE(-1 == lm.LineFromHandle(handle1));
+		const int handle2 = lm.AddMark(1, 3, 5);
+		lm.DeleteMarkFromHandle(handle2);
+		REQUIRE(-1 == lm.MarkerNext(0, 8));
+		REQUIRE(lm.DeleteMark(4, -1, false));
+		REQUIRE(-1 == lm.MarkerNext(0, 2));
+		REQUIRE(-1 == lm.MarkerPrevious(4, 2));
+	}
+
 	SECTION("MergeMarkers") {
 		lm.AddMark(1, 1, 5);
 		lm.AddMark(2, 2, 5);
@@ -158,6 +201,55 @@ TEST_CASE("LineMarkers") {
 		REQUIRE(0 == lm.MarkValue(5));
 		REQUIRE(1 == lm.LineFromHandle(handle1));
 		REQUIRE(4 == lm.LineFromHandle(handle2));
+		REQUIRE(1 == lm.MarkerNext(0, 6));
+		REQUIRE(4 == lm.MarkerNext(2, 6));
+		REQUIRE(4 == lm.MarkerPrevious(6, 6));
+		// Removing a marked line moves its markers to the line before
+		lm.RemoveLine(4);
+		REQUIRE(4 == lm.MarkValue(3));
+		REQUIRE(3 == lm.LineFromHandle(handle2));
+		REQUIRE(3 == lm.MarkerNext(2, 4));
+		lm.RemoveLine(2);
+		lm.RemoveLine(2);
+		REQUIRE(6 == lm.MarkValue(1));
+		REQUIRE(1 == lm.LineFromHandle(handle2));
+		REQUIRE(1 == lm.MarkerNext(0, 4));
+		REQUIRE(-1 == lm.MarkerNext(2, 6));
+		// Inserting at a marked line moves its markers down
+		lm.InsertLine(1);
+		REQUIRE(2 == lm.MarkerNext(0, 2));
+		REQUIRE(2 == lm.MarkerPrevious(3, 4));
+		REQUIRE(2 == lm.LineFromHandle(handle1));
+	}
+
+	SECTION("LineFromHandle") {
+		const int handle1 = lm.AddMark(1, 1, 6);
+		const int handle2 = lm.AddMark(3, 1, 6);
+		const int handle3 = lm.AddMark(3, 2, 6);
+		const int handle4 = lm.AddMark(0, 3, 6);
+		REQUIRE(1 == lm.LineFromHandle(handle1));
+		REQUIRE(3 == lm.LineFromHandle(handle2));
+		REQUIRE(3 == lm.LineFromHandle(handle3));
+		REQUIRE(0 == lm.LineFromHandle(handle4));
+		REQUIRE(-1 == lm.LineFromHandle(handle4 + 1));
+		// Deleting one marker number leaves the other handles on the line
+		REQUIRE(lm.DeleteMark(3, 1, false));
+		REQUIRE(-1 == lm.LineFromHandle(handle2));
+		REQUIRE(3 == lm.LineFromHandle(handle3));
+		// Merged handles are found on the line before
+		lm.RemoveLine(3);
+		REQUIRE(2 == lm.LineFromHandle(handle3));
+		// Removing the first line deletes its markers
+		lm.RemoveLine(0);
+		REQUIRE(-1 == lm.LineFromHandle(handle4));
+		REQUIRE(0 == lm.LineFromHandle(handle1));
+		lm.DeleteMarkFromHandle(handle1);
+		REQUIRE(-1 == lm.LineFromHandle(handle1));
+		REQUIRE(lm.DeleteMark(1, -1, false));
+		REQUIRE(-1 == lm.LineFromHandle(handle3));
+		const int handle5 = lm.AddMark(2, 4, 6);
+		lm.Init();
+		REQUIRE(-1 == lm.LineFromHandle(handle5));
 	}
 }
 
@@ -0,0 +1,299 @@
+// Unit Tests for Scintilla internal data structures
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <forward_list>
+#include <algorithm>
+#include <memory>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+
+#include "Platform.h"
+
+#include "ILoader.h"
+#include "ILexer.h"
+#include "Scintilla.h"
+
+#include "CharacterCategory.h"
+#include "Position.h"
+#include "UniqueString.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "ContractionState.h"
+#include "CellBuffer.h"
+#include "KeyMap.h"
+#include "Indicator.h"
+#include "LineMarker.h"
+#include "Style.h"
+#include "ViewStyle.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "CaseFolder.h"
+#include "Document.h"
+#include "UniConversion.h"
+#include "Selection.h"
+#include "PositionCache.h"
+
+#include "catch.hpp"
+
+using namespace Scintilla;
+
+// Needed by ViewStyle, normally provided by the platform layer.
+
+Font::Font() noexcept : fid(nullptr) {
+}
+
+Font::~Font() {
+}
+
+void Font::Create(const FontParameters &) {
+}
+
+void Font::Release() {
+	fid = nullptr;
+}
+
+ColourDesired Platform::Chrome() {
+	return ColourDesired(0xe0, 0xe0, 0xe0);
+}
+
+ColourDesired Platform::ChromeHighlight() {
+	return ColourDesired(0xff, 0xff, 0xff);
+}
+
+const char *Platform::DefaultFont() {
+	return "Monospace";
+}
+
+int Platform::DefaultFontSize() {
+	return 10;
+}
+
+// Test PositionCache.
+
+namespace {
+
+// Measures every byte as 8 pixels wide and counts the calls that reach it.
+class SurfaceMeasure : public Surface {
+public:
+	int measures = 0;
+	void Init(WindowID) override {}
+	void Init(SurfaceID, WindowID) override {}
+	void InitPixMap(int, int, Surface *, WindowID) override {}
+	void Release() override {}
+	bool Initialised() override { return true; }
+	void PenColour(ColourDesired) override {}
+	int LogPixelsY() override { return 72; }
+	int DeviceHeightFont(int points) override { return points; }
+	void MoveTo(int, int) override {}
+	void LineTo(int, int) override {}
+	void Polygon(Point *, size_t, ColourDesired, ColourDesired) override {}
+	void RectangleDraw(PRectangle, ColourDesired, ColourDesired) override {}
+	void FillRectangle(PRectangle, ColourDesired) override {}
+	void FillRectangle(PRectangle, Surface &) override {}
+	void RoundedRectangle(PRectangle, ColourDesired, ColourDesired) override {}
+	void AlphaRectangle(PRectangle, int, ColourDesired, int, ColourDesired, int, int) override {}
+	void GradientRectangle(PRectangle, const std::vector<ColourStop> &, GradientOptions) override {}
+	void DrawRGBAImage(PRectangle, int, int, const unsigned char *) override {}
+	void Ellipse(PRectangle, ColourDesired, ColourDesired) override {}
+	void Copy(PRectangle, Point, Surface &) override {}
+	std::unique_ptr<IScreenLineLayout> Layout(const IScreenLine *) override { return {}; }
+	void DrawTextNoClip(PRectangle, Font &, XYPOSITION, std::string_view, ColourDesired, ColourDesired) override {}
+	void DrawTextClipped(PRectangle, Font &, XYPOSITION, std::string_view, ColourDesired, ColourDesired) override {}
+	void DrawTextTransparent(PRectangle, Font &, XYPOSITION, std::string_view, ColourDesired) override {}
+	void MeasureWidths(Font &, std::string_view text, XYPOSITION *positions) override {
+		measures++;
+		for (size_t i = 0; i < text.length(); i++) {
+			positions[i] = static_cast<XYPOSITION>((i + 1) * 8);
+		}
+	}
+	XYPOSITION WidthText(Font &, std::string_view text) override { return static_cast<XYPOSITION>(text.length() * 8); }
+	XYPOSITION Ascent(Font &) override { return 8; }
+	XYPOSITION Descent(Font &) override { return 2; }
+	XYPOSITION InternalLeading(Font &) override { return 0; }
+	XYPOSITION Height(Font &) override { return 10; }
+	XYPOSITION AverageCharWidth(Font &) override { return 8; }
+	void SetClip(PRectangle) override {}
+	void FlushCachedState() override {}
+	void SetUnicodeMode(bool) override {}
+	void SetDBCSMode(int) override {}
+	void SetBidiR2L(bool) override {}
+};
+
+// Each section measures with its own font name so starts with an empty shard
+// of the process-wide shared table.
+struct Measurer {
+	SurfaceMeasure surface;
+	ViewStyle vs;
+	Document document;
+	explicit Measurer(const char *fontName) : document(SC_DOCUMENTOPTION_DEFAULT) {
+		vs.styles[0].fontName = fontName;
+	}
+	XYPOSITION Measure(PositionCache &pc, std::string_view text) {
+		std::vector<XYPOSITION> positions(text.length());
+		pc.MeasureWidths(&surface, vs, 0, text.data(), static_cast<unsigned int>(text.length()), positions.data(), &document);
+		return positions.back();
+	}
+};
+
+constexpr size_t budgetLarge = 0x800000;
+
+}
+
+TEST_CASE("PositionCache") {
+
+	SECTION("NotSharedByDefault") {
+		Measurer measurer("NotSharedByDefault");
+		PositionCache pc;
+		REQUIRE(pc.GetSharedBudget() == 0);
+		const size_t hits = PositionCache::SharedHits();
+		const size_t misses = PositionCache::SharedMisses();
+		REQUIRE(measurer.Measure(pc, "abc") == 24);
+		REQUIRE(measurer.Measure(pc, "abc") == 24);
+		// Found in the view's own table
+		REQUIRE(measurer.surface.measures == 1);
+		REQUIRE(PositionCache::SharedHits() == hits);
+		REQUIRE(PositionCache::SharedMisses() == misses);
+	}
+
+	SECTION("HitsAndMisses") {
+		Measurer measurer("HitsAndMisses");
+		PositionCache pc;
+		pc.SetSharedBudget(budgetLarge);
+		REQUIRE(pc.GetSharedBudget() == budgetLarge);
+		const size_t hits = PositionCache::SharedHits();
+		const size_t misses = PositionCache::SharedMisses();
+		REQUIRE(measurer.Measure(pc, "abc") == 24);
+		REQUIRE(PositionCache::SharedMisses() == misses + 1);
+		REQUIRE(measurer.Measure(pc, "abc") == 24);
+		REQUIRE(PositionCache::SharedHits() == hits + 1);
+		REQUIRE(measurer.Measure(pc, "abcd") == 32);
+		REQUIRE(PositionCache::SharedMisses() == misses + 2);
+		REQUIRE(measurer.surface.measures == 2);
+
+		// Another view with the same font reuses the measurements
+		PositionCache pcOther;
+		pcOther.SetSharedBudget(budgetLarge);
+		REQUIRE(measurer.Measure(pcOther, "abcd") == 32);
+		REQUIRE(PositionCache::SharedHits() == hits + 2);
+		REQUIRE(measurer.surface.measures == 2);
+
+		// but not a view with a different font
+		Measurer measurerOther("HitsAndMissesOther");
+		PositionCache pcOtherFont;
+		pcOtherFont.SetSharedBudget(budgetLarge);
+		REQUIRE(measurerOther.Measure(pcOtherFont, "abcd") == 32);
+		REQUIRE(PositionCache::SharedMisses() == misses + 3);
+		REQUIRE(measurerOther.surface.measures == 1);
+	}
+
+	SECTION("TableCounted") {
+		Measurer measurer("TableCounted");
+		PositionCache pc;
+		pc.SetSharedBudget(budgetLarge);
+		const size_t memory = PositionCache::SharedMemory();
+		measurer.Measure(pc, "abc");
+		// The table of the new shard and the entry
+		REQUIRE(PositionCache::SharedMemory() > memory + PositionCacheEntry::MemorySize(3));
+		const size_t memoryTable = PositionCache::SharedMemory();
+		measurer.Measure(pc, "abcd");
+		REQUIRE(PositionCache::SharedMemory() == memoryTable + PositionCacheEntry::MemorySize(4));
+	}
+
+	SECTION("Budget") {
+		size_t sizeTable = 0;
+		{
+			Measurer measurer("BudgetTable");
+			PositionCache pc;
+			pc.SetSharedBudget(budgetLarge);
+			const size_t memory = PositionCache::SharedMemory();
+			measurer.Measure(pc, "abc");
+			sizeTable = PositionCache::SharedMemory() - memory - PositionCacheEntry::MemorySize(3);
+		}
+
+		// A table that does not fit in the budget is not allocated
+		Measurer measurerNoTable("BudgetNoTable");
+		PositionCache pc;
+		pc.SetSharedBudget(PositionCache::SharedMemory() + sizeTable - 1);
+		const size_t memory = PositionCache::SharedMemory();
+		measurerNoTable.Measure(pc, "abc");
+		measurerNoTable.Measure(pc, "abc");
+		REQUIRE(measurerNoTable.surface.measures == 2);
+		REQUIRE(PositionCache::SharedMemory() == memory);
+
+		// Room for the table and one entry
+		Measurer measurerOne("BudgetOne");
+		PositionCache pcOne;
+		pc.SetSharedBudget(0);
+		pcOne.SetSharedBudget(memory + sizeTable + PositionCacheEntry::MemorySize(3));
+		measurerOne.Measure(pcOne, "abc");
+		measurerOne.Measure(pcOne, "xyz");
+		REQUIRE(measurerOne.surface.measures == 2);
+		measurerOne.Measure(pcOne, "abc");
+		REQUIRE(measurerOne.surface.measures == 2);
+		measurerOne.Measure(pcOne, "xyz");
+		REQUIRE(measurerOne.surface.measures == 3);
+		REQUIRE(PositionCache::SharedMemory() == pcOne.GetSharedBudget());
+	}
+
+	SECTION("LargestBudget") {
+		Measurer measurer("LargestBudget");
+		PositionCache pcLarge;
+		pcLarge.SetSharedBudget(budgetLarge);
+		{
+			// A view with a budget too small for a table does not limit other views
+			PositionCache pcSmall;
+			pcSmall.SetSharedBudget(1);
+			measurer.Measure(pcSmall, "abc");
+			measurer.Measure(pcLarge, "abc");
+			REQUIRE(measurer.surface.measures == 1);
+		}
+		// Turning sharing off in one view leaves it on in others
+		PositionCache pcOff;
+		pcOff.SetSharedBudget(budgetLarge);
+		pcOff.SetSharedBudget(0);
+		measurer.Measure(pcLarge, "abc");
+		measurer.Measure(pcOff, "abc");
+		REQUIRE(measurer.surface.measures == 2);
+		measurer.Measure(pcLarge, "abc");
+		REQUIRE(measurer.surface.measures == 2);
+	}
+
+	SECTION("Eviction") {
+		// Find 5 strings that go in the same set of 4 entries out of the 0x400 sets in a shard
+		std::vector<std::string> sameSet;
+		const unsigned int setFirst = PositionCacheEntry::Hash(0, "w0", 2) % 0x400;
+		for (int i = 0; sameSet.size() < 5; i++) {
+			const std::string word = "w" + std::to_string(i);
+			if (PositionCacheEntry::Hash(0, word.c_str(), static_cast<unsigned int>(word.length())) % 0x400 == setFirst) {
+				sameSet.push_back(word);
+			}
+		}
+		Measurer measurer("Eviction");
+		PositionCache pc;
+		pc.SetSharedBudget(budgetLarge);
+		for (const std::string &word : sameSet) {
+			measurer.Measure(pc, word);
+		}
+		REQUIRE(measurer.surface.measures == 5);
+		// The oldest was replaced by the fifth
+		const size_t memory = PositionCache::SharedMemory();
+		for (size_t i = 1; i < sameSet.size(); i++) {
+			measurer.Measure(pc, sameSet[i]);
+		}
+		REQUIRE(measurer.surface.measures == 5);
+		measurer.Measure(pc, sameSet[0]);
+		REQUIRE(measurer.surface.measures == 6);
+		// and replaced the second, giving back its memory
+		REQUIRE(PositionCache::SharedMemory() == memory -
+			PositionCacheEntry::MemorySize(static_cast<unsigned int>(sameSet[1].length())) +
+			PositionCacheEntry::MemorySize(static_cast<unsigned int>(sameSet[0].length())));
+	}
+}
@@ -321,6 +321,26 @@ TEST_CASE("SplitVector") {
 		REQUIRE(lengthAfterInsertion == sv.GapPosition());
 	}
 
+	SECTION("SpanPointer") {
+		sv.InsertFromArray(0, testArray, 0, lengthTestArray);
+		sv.Insert(2, 99);
+		REQUIRE(3 == sv.GapPosition());
+		ptrdiff_t lengthSpan = 0;
+		// Span before the gap stops at the gap without moving it
+		int *span = sv.SpanPointer(1, 4, lengthSpan);
+		REQUIRE(2 == lengthSpan);
+		REQUIRE(4 == span[0]);
+		REQUIRE(99 == span[1]);
+		REQUIRE(3 == sv.GapPosition());
+		span = sv.SpanPointer(3, 2, lengthSpan);
+		REQUIRE(2 == lengthSpan);
+		for (int i=0; i<lengthSpan; i++) {
+			REQUIRE(sv.ValueAt(3+i) == span[i]);
+		}
+		sv.SpanPointer(0, 2, lengthSpan);
+		REQUIRE(2 == lengthSpan);
+	}
+
 	SECTION("DeleteBackAndForth") {
 		sv.InsertValue(0, 10, 87);
 		for (int i=0; i<10; i+=2) {
@@ -41,6 +41,32 @@ TEST_CASE("WordList") {
 		REQUIRE(changed4);
 	}
 
+	SECTION("InListPrefix") {
+		wl.Set("^GTK_ else ^g");
+		REQUIRE(wl.InList("GTK_X"));
+		REQUIRE(wl.InList("GTK_"));
+		REQUIRE(!wl.InList("GTK"));
+		REQUIRE(wl.InList("gtk"));
+		REQUIRE(wl.InList("else"));
+		REQUIRE(!wl.InList("els"));
+		REQUIRE(!wl.InList(""));
+	}
+
+	SECTION("InListSharedPrefixes") {
+		wl.Set("sel select selected self s selects");
+		REQUIRE(wl.InList("s"));
+		REQUIRE(wl.InList("sel"));
+		REQUIRE(wl.InList("select"));
+		REQUIRE(wl.InList("selects"));
+		REQUIRE(!wl.InList("se"));
+		REQUIRE(!wl.InList("selec"));
+		REQUIRE(!wl.InList("selectedx"));
+		// Characters above 0x7F sort after ASCII
+		wl.Set("s\xc3\xa9 sa");
+		REQUIRE(wl.InList("s\xc3\xa9"));
+		REQUIRE(!wl.InList("s\xc3"));
+	}
+
 	SECTION("WordAt") {
 		wl.Set("else struct");
 		REQUIRE(0 == strcmp(wl.WordAt(0), "else"));
@@ -62,6 +88,19 @@ TEST_CASE("WordList") {
 		REQUIRE(!wl.InListAbbreviated("", '~'));
 	}
 
+	SECTION("InListAbbreviatedShared") {
+		wl.Set("def~ine de~lete deb x~");
+		REQUIRE(wl.InListAbbreviated("def", '~'));
+		REQUIRE(wl.InListAbbreviated("defin", '~'));
+		REQUIRE(!wl.InListAbbreviated("defines", '~'));
+		REQUIRE(wl.InListAbbreviated("del", '~'));
+		REQUIRE(wl.InListAbbreviated("deb", '~'));
+		REQUIRE(wl.InListAbbreviated("de", '~'));
+		REQUIRE(!wl.InListAbbreviated("d", '~'));
+		REQUIRE(wl.InListAbbreviated("x", '~'));
+		REQUIRE(!wl.InListAbbreviated("xy", '~'));
+	}
+
 	SECTION("InListAbridged") {
 		wl.Set("list w.~.active bo~k a~z ~_frozen");
 		REQUIRE(wl.InListAbridged("list", '~'));
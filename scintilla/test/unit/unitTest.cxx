@@ -11,13 +11,14 @@
         DecorationList
         CellBuffer
         UniConversion
+        Document (FindText, style ahead)
+        PositionCache (shared table)
 
     To do:
         PerLine *
         Range
         StyledText
         CaseFolder ...
-        Document
         RESearch
         Selection
         Style
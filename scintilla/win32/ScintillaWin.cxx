@@ -405,7 +405,7 @@ class ScintillaWin :
 	void IdleWork() override;
 	void QueueIdleWork(WorkNeeded::workItems items, Sci::Position upTo) override;
 	bool SetIdle(bool on) override;
-	UINT_PTR timers[tickDwell+1] {};
+	UINT_PTR timers[tickStyleAhead+1] {};
 	bool FineTickerRunning(TickReason reason) override;
 	void FineTickerStart(TickReason reason, int millis, int tolerance) override;
 	void FineTickerCancel(TickReason reason) override;
@@ -584,7 +584,7 @@ void ScintillaWin::Init() {
 
 void ScintillaWin::Finalise() {
 	ScintillaBase::Finalise();
-	for (TickReason tr = tickCaret; tr <= tickDwell; tr = static_cast<TickReason>(tr + 1)) {
+	for (TickReason tr = tickCaret; tr <= tickStyleAhead; tr = static_cast<TickReason>(tr + 1)) {
 		FineTickerCancel(tr);
 	}
 	SetIdle(false);
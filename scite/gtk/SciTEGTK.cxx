@@ -769,6 +769,7 @@ public:
 	void Run(int argc, char *argv[]);
 	void Execute() override;
 	void StopExecute() override;
+	void OutputTrimmed(SA::Position lengthRemoved) override;
 	static int PollTool(SciTEGTK *scitew);
 	static void ReapChild(GPid, gint, gpointer);
 	void PostOnMainThread(int cmd, Worker *pWorker) override;
@@ -1570,13 +1571,13 @@ bool SciTEGTK::HandleSaveAs(const char *savePath) {
 		SaveBuffer(savePath, sfNone);
 		break;
 	case sfHTML:
-		SaveToHTML(savePath);
+		SaveToHTML(savePath, sfNone);
 		break;
 	case sfRTF:
-		SaveToRTF(savePath);
+		SaveToRTF(savePath, 0, -1, sfNone);
 		break;
 	case sfPDF:
-		SaveToPDF(savePath);
+		SaveToPDF(savePath, sfNone);
 		break;
 	case sfTEX:
 		SaveToTEX(savePath);
@@ -2750,6 +2751,11 @@ void SciTEGTK::Execute() {
 	}
 }
 
+void SciTEGTK::OutputTrimmed(SA::Position lengthRemoved) {
+	// Text before the start of the current command's output was removed for output.max.lines
+	originalEnd = std::max(originalEnd - static_cast<int>(lengthRemoved), 0);
+}
+
 void SciTEGTK::StopExecute() {
 	if (!triedKill && pidShell) {
 #if defined(G_OS_UNIX)
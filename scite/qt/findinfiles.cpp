@@ -17,9 +17,18 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QDir>
-#include <QTextStream>
 #include <QThread>
-#include <QPair>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
 
 #include "findinfiles.h"
 
@@ -27,7 +36,7 @@
 #define _USER_EVENT_DONE                QEvent::User+2
 #define _USER_EVENT_SEARCH_IN_MSG       QEvent::User+3
 
-const QString g_strWhitespaces = "[ \t;:.-+*/=<>?!(){}\\[]";		// whitespaces and separators \[\]\{\}
+const QString g_strWhitespaces = "[ \t;:.\\-+*/=<>?!(){}\\[\\]]";		// whitespaces and separators \[\]\{\}
 
 // ************************************************************************
 
@@ -92,7 +101,9 @@ QString FindFileMsgEvent::GetMessage() const
 
 // ************************************************************************
 
-static void inc_if( int * pValue )
+static const int c_iOutputBatchLines = 256;
+
+static void inc_if( std::atomic<int> * pValue )
 {
     if( pValue )
     {
@@ -100,198 +111,221 @@ static void inc_if( int * pValue )
     }
 }
 
-static QPair<bool, QString> SingleFileSearch( const QString & sFileName,
-                                 const QString & sSearch,
-                                 bool bCaseSensitive=true,
-                                 bool bRegExpr=true,
-                                 bool bWildcard=false,
-                                 int * pFoundCount=0,
-                                 const QString & sFileTag = "",
-                                 const QString & sLineTag = "",
-                                 QObject * pObserver = 0 )
-{
-    QString sRet;
-    bool bFound = false;
-
-    QFile aFile( sFileName );
-    if( !aFile.open(QIODevice::ReadOnly | QIODevice::Text) )
-    {
-        sRet = QObject::tr("Error: can not open file ") + sFileName;
-    }
-    else
+static bool IsAscii( const QString & sText )
+{
+    for( const QChar & ch : sText )
     {
-        if( pObserver )
+        if( ch.unicode() >= 0x80 )
         {
-            QEvent * pEvent = new SearchInFileMsgEvent(sFileName);
-            QGuiApplication::postEvent(pObserver, pEvent, Qt::LowEventPriority);
+            return false;
         }
+    }
+    return true;
+}
 
-        QTextStream aInStream( &aFile );
-        //aInStream.setEncoding(QTextStream::UnicodeUTF8);
-
-        QRegExp * pRegExpr = 0;
-        if( bRegExpr )
-        {
-            pRegExpr = new QRegExp(sSearch, bCaseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive, bWildcard ? QRegExp::Wildcard : QRegExp::RegExp/*FixedString*/);
-        }
+// ************************************************************************
 
-        int iCount = 0;
-        while( !aInStream.atEnd() )
-        {
-            QString strLine = aInStream.readLine();
-            iCount++;
+// Boyer-Moore-Horspool search for a byte sequence, optionally ignoring ASCII case.
+// Only reads its tables while searching so one instance can be shared by all workers.
+class BytesMatcher
+{
+public:
+    BytesMatcher();
 
-            int iFoundPos = -1;
-            if( bRegExpr && pRegExpr )
-            {
-                iFoundPos = pRegExpr->indexIn(strLine);
-            }
-            else
-            {
-                iFoundPos = strLine.indexOf(sSearch, 0, bCaseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive);
-            }
-            if( iFoundPos >= 0 )
-            {
-                // found !
-                bFound = true;
-
-                QString strTemp = sFileTag + QDir::toNativeSeparators(sFileName) + ":" + sLineTag + QString::number( iCount ) + ": " + strLine + "\n";
-
-                if( pObserver )
-                {
-                    QEvent * pEvent = new FindFileMsgEvent(strTemp);
-                    QGuiApplication::postEvent(pObserver, pEvent, Qt::LowEventPriority);
-                }
-
-                sRet += strTemp;
-
-                // count all occurences in this line !
-                while( iFoundPos >= 0 )
-                {
-                    inc_if( pFoundCount );
-
-                    if( bRegExpr && pRegExpr )
-                    {
-                        iFoundPos = pRegExpr->indexIn(strLine, iFoundPos+1/*pRegExpr->matchedLength()*/);
-                    }
-                    else
-                    {
-                        iFoundPos = strLine.indexOf(sSearch, iFoundPos+1, bCaseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive);
-                    }
-                }
-            }
-        }
+    void Set( const QByteArray & aNeedle, bool bCaseSensitive );
+    const char * Find( const char * pStart, const char * pEnd ) const;
 
-        if( pRegExpr )
-        {
-            delete pRegExpr;
-        }
-    }
+private:
+    QByteArray      m_aNeedle;          // already folded
+    unsigned char   m_aFold[256];
+    int             m_aShift[256];
+};
 
-    return QPair<bool, QString>(bFound, sRet);
+BytesMatcher::BytesMatcher()
+{
+    Set( QByteArray(), true );
 }
 
-static QString ProcessSingleFileFind(const QString & sPath,
-          const QString & sFile,
-          const QString & sSearch,
-          bool bCaseSensitive=true,
-          bool bRegExpr=true,
-          bool bWildcard=false,
-          int * pFoundCount=0,
-          int * pFindFileCount=0,
-          int * pTotalCount=0,
-          const QString & sFileTag = "",
-          const QString & sLineTag = "",
-          QObject * pObserver = 0)
+void BytesMatcher::Set( const QByteArray & aNeedle, bool bCaseSensitive )
 {
-    QString sRet;
-    QString sName = QFileInfo(sPath, sFile).absoluteFilePath();
-    QFileInfo aItemInfo(sName);
-    if(aItemInfo.isFile())
+    for( int i = 0; i < 256; i++ )
     {
-        QPair<bool, QString> result = SingleFileSearch(sName, sSearch, bCaseSensitive, bRegExpr, bWildcard, pFoundCount, sFileTag, sLineTag, pObserver);
-
-        inc_if( pTotalCount );
+        m_aFold[i] = static_cast<unsigned char>( (!bCaseSensitive && i >= 'A' && i <= 'Z') ? i - 'A' + 'a' : i );
+    }
+    m_aNeedle = aNeedle;
+    for( int i = 0; i < m_aNeedle.size(); i++ )
+    {
+        m_aNeedle[i] = static_cast<char>( m_aFold[static_cast<unsigned char>(m_aNeedle[i])] );
+    }
+    const int iLength = m_aNeedle.size();
+    for( int i = 0; i < 256; i++ )
+    {
+        m_aShift[i] = iLength;
+    }
+    for( int i = 0; i < iLength - 1; i++ )
+    {
+        m_aShift[static_cast<unsigned char>(m_aNeedle[i])] = iLength - 1 - i;
+    }
+}
 
-        sRet += result.second;
-        if( result.first )
+const char * BytesMatcher::Find( const char * pStart, const char * pEnd ) const
+{
+    const int iLength = m_aNeedle.size();
+    if( iLength == 0 )
+    {
+        return 0;
+    }
+    const unsigned char * pNeedle = reinterpret_cast<const unsigned char *>( m_aNeedle.constData() );
+    const unsigned char chLast = pNeedle[iLength - 1];
+    const unsigned char * p = reinterpret_cast<const unsigned char *>( pStart );
+    const unsigned char * pStop = reinterpret_cast<const unsigned char *>( pEnd );
+    while( pStop - p >= iLength )
+    {
+        const unsigned char ch = m_aFold[p[iLength - 1]];
+        if( ch == chLast )
         {
-            inc_if(pFindFileCount);
+            int i = 0;
+            while( i < iLength - 1 && m_aFold[p[i]] == pNeedle[i] )
+            {
+                i++;
+            }
+            if( i == iLength - 1 )
+            {
+                return reinterpret_cast<const char *>( p );
+            }
         }
-
-        return result.second;
+        p += m_aShift[ch];
     }
-
-    return "";
+    return 0;
 }
 
-static std::pair<bool,QString> RecursiveFileSearch( const QString & sPath,
-                                    const QString & sFiles,
-                                    const QString & sSearch,
-                                    bool bCaseSensitive=true,
-                                    bool bSerachInSubDirs=true,
-                                    bool bRegExpr=true,
-                                    bool bWildcard=false,
-                                    int * pFoundCount=0,
-                                    int * pFindFileCount=0,
-                                    int * pTotalCount=0,
-                                    const QString & sFileTag = "",
-                                    const QString & sLineTag = "",
-                                    QObject * pObserver = 0,
-                                    bool * pStopFlag = 0 )
-{
-    QString sRet;
-    QDir aDir(sPath);
-    QFileInfo aPathInfo(sPath);
-    QStringList::Iterator it;
+// ************************************************************************
 
-    QStringList aFiles;
-    if( aPathInfo.isDir() )
+class FindInFilesInThread;
+
+// Unit of work for the thread pool: search one file of the list.
+class FindInFilesTask : public QRunnable
+{
+public:
+    FindInFilesTask( FindInFilesInThread * pSearch, int iFile )
+        : m_pSearch( pSearch )
+        , m_iFile( iFile )
     {
-        aFiles = aDir.entryList(sFiles.split(" "), QDir::Files);
     }
-    else
+
+    virtual void run();
+
+private:
+    FindInFilesInThread *   m_pSearch;
+    int                     m_iFile;
+};
+
+// ************************************************************************
+
+// Collects the found lines of one file in batches until the search thread posts them.
+class FindInFilesOutput
+{
+public:
+    FindInFilesOutput( const QString & sLinePrefix )
+        : m_sLinePrefix( sLinePrefix )
+        , m_iLines( 0 )
     {
-        // no directory given, just an add single file to list of files
-        aFiles.append(sPath);
     }
 
-    it = aFiles.begin();
-    while( it != aFiles.end() )
+    void AddLine( int iLineNo, const QString & sLine )
     {
-        QString strFound = ProcessSingleFileFind(sPath, *it, sSearch, bCaseSensitive, bRegExpr, bWildcard, pFoundCount, pFindFileCount, pTotalCount, sFileTag, sLineTag, pObserver);
-
-        // handle the stopping flag...
-        if( pStopFlag && *pStopFlag )
+        if( m_iLines == 0 )
+        {
+            m_aBatches.append(QString());
+        }
+        m_aBatches.last() += m_sLinePrefix + QString::number( iLineNo ) + ": " + sLine + "\n";
+        m_iLines++;
+        if( m_iLines >= c_iOutputBatchLines )
         {
-            return std::pair<bool,QString>(false, sRet);
+            m_iLines = 0;
         }
+    }
 
-        ++it;
+    QStringList TakeBatches()
+    {
+        m_iLines = 0;
+        QStringList aBatches;
+        aBatches.swap(m_aBatches);
+        return aBatches;
     }
 
-    if( bSerachInSubDirs )
+private:
+    QString     m_sLinePrefix;
+    QStringList m_aBatches;
+    int         m_iLines;
+};
+
+// ************************************************************************
+
+static bool IsUtf8( const char * pData, const char * pEnd )
+{
+    const unsigned char * p = reinterpret_cast<const unsigned char *>( pData );
+    const unsigned char * pStop = reinterpret_cast<const unsigned char *>( pEnd );
+    while( p < pStop )
     {
-        QStringList dirs = aDir.entryList(QDir::Dirs);
-        it = dirs.begin();
-        while( it != dirs.end() )
+        const unsigned char ch = *p;
+        if( ch < 0x80 )
+        {
+            p++;
+            continue;
+        }
+        int iTrail = 0;
+        unsigned int uValue = 0;
+        if( ch >= 0xC2 && ch <= 0xDF )
+        {
+            iTrail = 1;
+            uValue = ch & 0x1F;
+        }
+        else if( ch >= 0xE0 && ch <= 0xEF )
+        {
+            iTrail = 2;
+            uValue = ch & 0x0F;
+        }
+        else if( ch >= 0xF0 && ch <= 0xF4 )
         {
-            if( *it != "." && *it != ".." )
+            iTrail = 3;
+            uValue = ch & 0x07;
+        }
+        else
+        {
+            return false;
+        }
+        if( pStop - p <= iTrail )
+        {
+            return false;
+        }
+        for( int i = 1; i <= iTrail; i++ )
+        {
+            if( (p[i] & 0xC0) != 0x80 )
             {
-                std::pair<bool,QString> aRet = RecursiveFileSearch(sPath + "/" + *it, sFiles, sSearch, bCaseSensitive, bSerachInSubDirs, bRegExpr, bWildcard, pFoundCount, pFindFileCount, pTotalCount, sFileTag, sLineTag, pObserver, pStopFlag);
-                sRet += aRet.second;
-                if( !aRet.first )
-                {
-                    return std::pair<bool,QString>(aRet.first,sRet);
-                }
+                return false;
             }
-            ++it;
+            uValue = (uValue << 6) | (p[i] & 0x3F);
+        }
+        // reject overlong forms, surrogates and values above U+10FFFF
+        if( (iTrail == 2 && uValue < 0x800) || (iTrail == 3 && uValue < 0x10000) ||
+            (uValue >= 0xD800 && uValue <= 0xDFFF) || uValue > 0x10FFFF )
+        {
+            return false;
         }
+        p += iTrail + 1;
     }
-
-    return std::pair<bool,QString>(true, sRet);
+    return true;
 }
 
+// ************************************************************************
+
+// Lists the files to search and searches them on a pool of worker threads.
+// UTF-8 files are searched as bytes and lines are only decoded when they are reported or
+// when the search needs a regular expression. Other files are read through QTextStream
+// which handles byte order marks and the locale codec.
+// The results of each file are kept until all earlier files are reported so the output
+// is always in the order of the file list.
 class FindInFilesInThread : public QThread
 {
 public:
@@ -301,22 +335,22 @@ public:
                     bool bCaseSensitive=true,
                     bool bSerachInSubDirs=true,
                     bool bRegExpr=true,
-                    bool bWildcard=false,
-                    int * pFoundCount=0,
-                    int * pFindFileCount=0,
-                    int * pTotalCount=0,
+                    bool bOnlyWholeWords=false,
+                    std::atomic<int> * pFoundCount=0,
+                    std::atomic<int> * pFindFileCount=0,
+                    std::atomic<int> * pTotalCount=0,
                     const QString & sFileTag = "",
                     const QString & sLineTag = "",
                     QObject * pObserver = 0,
-                    bool * pStopFlag = 0 )
+                    std::atomic<bool> * pStopFlag = 0 )
         : QThread( pObserver )
         , m_sPath( sPath )
-        , m_sFiles( sFiles )
+        , m_aNameFilters( sFiles.split(" ") )
         , m_sSearch( sSearch )
         , m_bCaseSensitive( bCaseSensitive )
         , m_bSerachInSubDirs( bSerachInSubDirs )
-        , m_bRegExpr( bRegExpr )
-        , m_bWildcard( bWildcard )
+        , m_bRegExpr( bRegExpr || bOnlyWholeWords )
+        , m_bSearchLines( false )
         , m_pFoundCount( pFoundCount )
         , m_pFindFileCount( pFindFileCount )
         , m_pTotalCount( pTotalCount )
@@ -325,34 +359,59 @@ public:
         , m_pObserver( pObserver )
         , m_pStopFlag( pStopFlag )
     {
+        if( m_bRegExpr )
+        {
+            // handle bOnlyWholeWords as regular expression !
+            QString sPattern = bRegExpr ? sSearch : QRegularExpression::escape(sSearch);
+            if( bOnlyWholeWords )
+            {
+                sPattern = "(?:^|(?<=" + g_strWhitespaces + "))" + sPattern + "(?=" + g_strWhitespaces + "|$)";
+            }
+            m_aRegExpr.setPattern(sPattern);
+            m_aRegExpr.setPatternOptions(bCaseSensitive ? QRegularExpression::NoPatternOption : QRegularExpression::CaseInsensitiveOption);
+            // compile once here, all workers share the compiled expression
+            m_aRegExpr.optimize();
+            m_bSearchLines = true;
+        }
+        else if( (!bCaseSensitive && !IsAscii(sSearch)) || sSearch.contains('\n') || sSearch.contains('\r') )
+        {
+            // case folding of non ASCII characters needs decoded text
+            m_bSearchLines = true;
+        }
+        else
+        {
+            m_aMatcher.Set(sSearch.toUtf8(), bCaseSensitive);
+        }
     }
 
     virtual void run()
     {
-        std::pair<bool,QString> aRet = RecursiveFileSearch( m_sPath,
-                                    m_sFiles,
-                                    m_sSearch,
-                                    m_bCaseSensitive,
-                                    m_bSerachInSubDirs,
-                                    m_bRegExpr,
-                                    m_bWildcard,
-                                    m_pFoundCount,
-                                    m_pFindFileCount,
-                                    m_pTotalCount,
-                                    m_sFileTag,
-                                    m_sLineTag,
-                                    m_pObserver,
-                                    m_pStopFlag );
-        QString strLastMsg = ""+QObject::tr(">Found ")+QString::number(*m_pFoundCount)+QObject::tr(" occurences in ")+QString::number(*m_pFindFileCount)+QObject::tr(" files, searched in total files: ")+QString::number(*m_pTotalCount)+"\n";
+        if( m_bRegExpr && !m_aRegExpr.isValid() )
+        {
+            PostText(QObject::tr(">Invalid regular expression: ") + m_aRegExpr.errorString() + "\n");
+        }
+        else
+        {
+            ListFiles(m_sPath);
+            // the results are only written by the workers after the list is complete
+            m_aResults.resize(m_aFiles.size());
+            for( int i = 0; i < m_aFiles.size(); i++ )
+            {
+                m_aPool.start(new FindInFilesTask(this, i));
+            }
+            PostResults();
+            m_aPool.waitForDone();
+        }
+
+        QString strLastMsg = ""+QObject::tr(">Found ")+QString::number(m_pFoundCount->load())+QObject::tr(" occurences in ")+QString::number(m_pFindFileCount->load())+QObject::tr(" files, searched in total files: ")+QString::number(m_pTotalCount->load())+"\n";
         if( m_pObserver )
         {
             QString strResult;
-            if( !aRet.first )
+            if( IsStopped() )
             {
                 strResult = QObject::tr(">Search stoped !\n");
             }
-            QEvent * pEvent = new FindFileMsgEvent(strResult+strLastMsg);
-            QGuiApplication::postEvent(m_pObserver, pEvent, Qt::LowEventPriority);
+            PostText(strResult+strLastMsg);
 
             QEvent * pEvent2 = new FindFileDoneEvents();
             QGuiApplication::postEvent(m_pObserver, pEvent2, Qt::LowEventPriority);
@@ -365,23 +424,300 @@ public:
     {
     }
 
+    void SearchFile( int iFile );
+
 private:
-    QString     m_sPath;
-    QString     m_sFiles;
-    QString     m_sSearch;
-    bool        m_bCaseSensitive;
-    bool        m_bSerachInSubDirs;
-    bool        m_bRegExpr;
-    bool        m_bWildcard;
-    int *       m_pFoundCount;      // total occurences
-    int *       m_pFindFileCount;   // found in this number of files
-    int *       m_pTotalCount;      // searched in total files
-    QString     m_sFileTag;
-    QString     m_sLineTag;
-    QObject *   m_pObserver;
-    bool *      m_pStopFlag;
+    struct FileResult
+    {
+        FileResult() : m_bDone( false ) {}
+
+        QStringList m_aBatches;
+        bool        m_bDone;
+    };
+
+    bool IsStopped() const
+    {
+        return m_pStopFlag && *m_pStopFlag;
+    }
+
+    void PostText( const QString & sMsg )
+    {
+        if( m_pObserver )
+        {
+            QEvent * pEvent = new FindFileMsgEvent(sMsg);
+            QGuiApplication::postEvent(m_pObserver, pEvent, Qt::LowEventPriority);
+        }
+    }
+
+    void ListFiles( const QString & sPath );
+    void PostResults();
+    bool SearchBytes( const char * pData, const char * pEnd, FindInFilesOutput & aOutput );
+    bool SearchLines( const char * pData, const char * pEnd, FindInFilesOutput & aOutput );
+    bool SearchStream( const QByteArray & aContent, FindInFilesOutput & aOutput );
+    bool SearchLine( const QString & strLine, int iLineNo, FindInFilesOutput & aOutput );
+
+    QString             m_sPath;
+    QStringList         m_aNameFilters;
+    QString             m_sSearch;
+    bool                m_bCaseSensitive;
+    bool                m_bSerachInSubDirs;
+    bool                m_bRegExpr;
+    bool                m_bSearchLines;     // match decoded lines instead of bytes
+    BytesMatcher        m_aMatcher;
+    QRegularExpression  m_aRegExpr;
+    std::atomic<int> *  m_pFoundCount;      // total occurences
+    std::atomic<int> *  m_pFindFileCount;   // found in this number of files
+    std::atomic<int> *  m_pTotalCount;      // searched in total files
+    QString             m_sFileTag;
+    QString             m_sLineTag;
+    QObject *           m_pObserver;
+    std::atomic<bool> * m_pStopFlag;
+    QStringList         m_aFiles;           // in output order
+    std::vector<FileResult> m_aResults;     // one per file, guarded by m_aResultsMutex
+    QMutex              m_aResultsMutex;
+    QWaitCondition      m_aResultDone;
+    QThreadPool         m_aPool;
 };
 
+void FindInFilesTask::run()
+{
+    m_pSearch->SearchFile(m_iFile);
+}
+
+void FindInFilesInThread::ListFiles( const QString & sPath )
+{
+    if( IsStopped() )
+    {
+        return;
+    }
+
+    QFileInfo aPathInfo(sPath);
+    if( !aPathInfo.isDir() )
+    {
+        // no directory given, just search the single file
+        m_aFiles.append(sPath);
+        return;
+    }
+
+    QDir aDir(sPath);
+    const QFileInfoList aFiles = aDir.entryInfoList(m_aNameFilters, QDir::Files);
+    for( const QFileInfo & aFileInfo : aFiles )
+    {
+        m_aFiles.append(aFileInfo.absoluteFilePath());
+    }
+
+    if( m_bSerachInSubDirs )
+    {
+        const QStringList aDirs = aDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+        for( const QString & sDir : aDirs )
+        {
+            ListFiles(sPath + "/" + sDir);
+        }
+    }
+}
+
+// Posts the found lines file by file in list order while the workers search later files.
+void FindInFilesInThread::PostResults()
+{
+    QString sLastDir;
+    for( size_t i = 0; i < m_aResults.size() && !IsStopped(); i++ )
+    {
+        const QString sDir = QFileInfo(m_aFiles[static_cast<int>(i)]).absolutePath();
+        if( m_pObserver && sDir != sLastDir )
+        {
+            QEvent * pEvent = new SearchInFileMsgEvent(sDir);
+            QGuiApplication::postEvent(m_pObserver, pEvent, Qt::LowEventPriority);
+            sLastDir = sDir;
+        }
+
+        QStringList aBatches;
+        {
+            QMutexLocker aLock(&m_aResultsMutex);
+            while( !m_aResults[i].m_bDone )
+            {
+                m_aResultDone.wait(&m_aResultsMutex);
+            }
+            aBatches.swap(m_aResults[i].m_aBatches);
+        }
+        for( const QString & sBatch : aBatches )
+        {
+            PostText(sBatch);
+        }
+    }
+}
+
+void FindInFilesInThread::SearchFile( int iFile )
+{
+    const QString sFileName = m_aFiles[iFile];
+    FindInFilesOutput aOutput( m_sFileTag + QDir::toNativeSeparators(sFileName) + ":" + m_sLineTag );
+
+    QFile aFile( sFileName );
+    if( !IsStopped() && aFile.open(QIODevice::ReadOnly) )
+    {
+        inc_if( m_pTotalCount );
+
+        // read instead of mapping as a mapped file that is truncated while searching raises SIGBUS
+        const QByteArray aContent = aFile.readAll();
+        const char * pData = aContent.constData();
+        const char * pEnd = pData + aContent.size();
+        bool bFound = false;
+        if( IsUtf8(pData, pEnd) )
+        {
+            if( aContent.startsWith("\xEF\xBB\xBF") )
+            {
+                pData += 3;
+            }
+            bFound = m_bSearchLines ? SearchLines(pData, pEnd, aOutput) : SearchBytes(pData, pEnd, aOutput);
+        }
+        else
+        {
+            bFound = SearchStream(aContent, aOutput);
+        }
+        if( bFound )
+        {
+            inc_if( m_pFindFileCount );
+        }
+    }
+
+    QMutexLocker aLock(&m_aResultsMutex);
+    m_aResults[iFile].m_aBatches = aOutput.TakeBatches();
+    m_aResults[iFile].m_bDone = true;
+    m_aResultDone.wakeAll();
+}
+
+static QString DecodeLine( const char * pLineStart, const char * pLineEnd )
+{
+    if( pLineEnd > pLineStart && pLineEnd[-1] == '\r' )
+    {
+        pLineEnd--;
+    }
+    return QString::fromUtf8(pLineStart, static_cast<int>(pLineEnd - pLineStart));
+}
+
+bool FindInFilesInThread::SearchBytes( const char * pData, const char * pEnd, FindInFilesOutput & aOutput )
+{
+    bool bFound = false;
+    int iLineNo = 1;
+    const char * pCounted = pData;
+    const char * p = pData;
+    while( p < pEnd && !IsStopped() )
+    {
+        const char * pFound = m_aMatcher.Find(p, pEnd);
+        if( !pFound )
+        {
+            break;
+        }
+        // found !
+        bFound = true;
+
+        // p is always at a line start so the search back stops there at the latest
+        const char * pLineStart = pFound;
+        while( pLineStart > p && pLineStart[-1] != '\n' )
+        {
+            pLineStart--;
+        }
+        const char * pLineEnd = static_cast<const char *>( memchr(pFound, '\n', pEnd - pFound) );
+        if( !pLineEnd )
+        {
+            pLineEnd = pEnd;
+        }
+        iLineNo += static_cast<int>( std::count(pCounted, pLineStart, '\n') );
+        pCounted = pLineStart;
+
+        aOutput.AddLine(iLineNo, DecodeLine(pLineStart, pLineEnd));
+
+        // count all occurences in this line !
+        while( pFound )
+        {
+            inc_if( m_pFoundCount );
+            pFound = m_aMatcher.Find(pFound + 1, pLineEnd);
+        }
+
+        p = pLineEnd + 1;
+    }
+    return bFound;
+}
+
+bool FindInFilesInThread::SearchLines( const char * pData, const char * pEnd, FindInFilesOutput & aOutput )
+{
+    bool bFound = false;
+    int iLineNo = 0;
+    const char * p = pData;
+    while( p < pEnd && !IsStopped() )
+    {
+        const char * pLineEnd = static_cast<const char *>( memchr(p, '\n', pEnd - p) );
+        if( !pLineEnd )
+        {
+            pLineEnd = pEnd;
+        }
+        iLineNo++;
+
+        if( SearchLine(DecodeLine(p, pLineEnd), iLineNo, aOutput) )
+        {
+            bFound = true;
+        }
+
+        p = pLineEnd + 1;
+    }
+    return bFound;
+}
+
+// Searches text that is not UTF-8, QTextStream detects byte order marks and otherwise
+// decodes with the codec of the locale.
+bool FindInFilesInThread::SearchStream( const QByteArray & aContent, FindInFilesOutput & aOutput )
+{
+    bool bFound = false;
+    int iLineNo = 0;
+    QTextStream aInStream( aContent, QIODevice::ReadOnly );
+    while( !aInStream.atEnd() && !IsStopped() )
+    {
+        const QString strLine = aInStream.readLine();
+        iLineNo++;
+
+        if( SearchLine(strLine, iLineNo, aOutput) )
+        {
+            bFound = true;
+        }
+    }
+    return bFound;
+}
+
+bool FindInFilesInThread::SearchLine( const QString & strLine, int iLineNo, FindInFilesOutput & aOutput )
+{
+    int iFoundPos = -1;
+    if( m_bRegExpr )
+    {
+        iFoundPos = m_aRegExpr.match(strLine).capturedStart();
+    }
+    else
+    {
+        iFoundPos = strLine.indexOf(m_sSearch, 0, m_bCaseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive);
+    }
+    if( iFoundPos < 0 )
+    {
+        return false;
+    }
+
+    // found !
+    aOutput.AddLine(iLineNo, strLine);
+
+    // count all occurences in this line !
+    while( iFoundPos >= 0 )
+    {
+        inc_if( m_pFoundCount );
+
+        if( m_bRegExpr )
+        {
+            iFoundPos = m_aRegExpr.match(strLine, iFoundPos+1).capturedStart();
+        }
+        else
+        {
+            iFoundPos = strLine.indexOf(m_sSearch, iFoundPos+1, m_bCaseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive);
+        }
+    }
+    return true;
+}
+
 // ************************************************************************
 
 FindInFilesAsync::FindInFilesAsync()
@@ -400,27 +736,18 @@ FindInFilesAsync::~FindInFilesAsync()
 
 void FindInFilesAsync::StartSearch( const QString & sSearchDir, const QString & sSearchFiles, const QString & sFindTextIn, bool bCaseSensitive, bool bOnlyWholeWords, bool bRegularExpr )
 {
-    QString sFindText = sFindTextIn;
-
     m_iCount = 0;
     m_iFoundFileCount = 0;
     m_iTotalFileCount = 0;
 
     emit addToOutput(tr(">Internal search for ")+"\""+sFindTextIn+"\" in \"" + sSearchFiles + "\"\n" );
 
-    // handle bOnlyWholeWords as regular expression !
-    if( bOnlyWholeWords )
-    {
-        bRegularExpr = true;
-        sFindText = g_strWhitespaces + sFindTextIn + g_strWhitespaces;
-    }
-
     if( m_pFindThread==0 )
     {
         m_bStopFlag = false;
-        m_pFindThread = new FindInFilesInThread( sSearchDir, sSearchFiles, sFindText,
+        m_pFindThread = new FindInFilesInThread( sSearchDir, sSearchFiles, sFindTextIn,
                                            bCaseSensitive, /*bSerachInSubDirs=*/true,
-                                           bRegularExpr, /*bWildcard=*/false,
+                                           bRegularExpr, bOnlyWholeWords,
                                            &m_iCount, &m_iFoundFileCount, &m_iTotalFileCount,
                                            /*fileTag=*/"", /*lineTag=*/"", this, &m_bStopFlag );
         connect(m_pFindThread,SIGNAL(finished()),this,SLOT(sltFindThreadFinished()));
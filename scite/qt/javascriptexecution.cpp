@@ -0,0 +1,195 @@
+/***************************************************************************
+ *
+ * SciteQt - a port of SciTE to Qt Quick/QML
+ *
+ * Copyright (C) 2020 by Michael Neuroth
+ *
+ ***************************************************************************/
+
+#include <QJSEngine>
+#include <QJSValue>
+#include <QElapsedTimer>
+
+#include <utility>
+
+#include "javascriptexecution.h"
+#include "sciteqtenvironmentforjavascript.h"
+
+static const QString g_sJavaScriptInit = "var console = { log: env.print };\n";
+static const QString g_sJavaScriptLibrary = "function print(t) { env.print(t) }\nfunction admin(val) { env.admin(val) }\nfunction style(val) { env.style(val) }\n";
+
+// ************************************************************************
+
+JavaScriptExecution::JavaScriptExecution()
+    : m_pEngine(nullptr),
+      m_bInterrupted(false),
+      m_bRunning(false),
+      m_bIsAdmin(false)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    // only a script that can be interrupted runs in its own thread, before Qt 5.14
+    // an endless script could not be stopped and would block closing SciteQt
+    m_aThreadContext.moveToThread(&m_aThread);
+    m_aThread.start();
+#endif
+}
+
+JavaScriptExecution::~JavaScriptExecution()
+{
+    Stop();
+    if( m_aThread.isRunning() )
+    {
+        // the engine has to be deleted in the thread it was used in, this is
+        // queued after the interrupted script so it also waits for its end
+        QMetaObject::invokeMethod(&m_aThreadContext, [this]() { DeleteEngine(); }, Qt::BlockingQueuedConnection);
+        m_aThread.quit();
+        m_aThread.wait();
+    }
+    else
+    {
+        DeleteEngine();
+    }
+}
+
+bool JavaScriptExecution::Run(const QString & sScript, const QString & sFileName, bool bReuseEngine, bool bIsAdmin, const QString & sStyle)
+{
+    {
+        // locked like Stop(), so a Stop() right after starting is not undone by clearing the interrupt
+        std::lock_guard<std::mutex> guard(m_aEngineMutex);
+        if( m_bRunning )
+        {
+            return false;
+        }
+        m_bInterrupted = false;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+        if( m_pEngine != nullptr )
+        {
+            m_pEngine->setInterrupted(false);
+        }
+#endif
+        m_bRunning = true;
+    }
+
+    // the script thread is idle here, so the settings can be updated without locking
+    m_bIsAdmin = bIsAdmin;
+    m_sStyle = sStyle;
+
+    if( m_aThread.isRunning() )
+    {
+        QMetaObject::invokeMethod(&m_aThreadContext, [this, sScript, sFileName, bReuseEngine]() { Execute(sScript, sFileName, bReuseEngine); }, Qt::QueuedConnection);
+    }
+    else
+    {
+        // no thread support available (e. g. WebAssembly), run synchronously
+        Execute(sScript, sFileName, bReuseEngine);
+    }
+    return true;
+}
+
+void JavaScriptExecution::Stop()
+{
+    std::lock_guard<std::mutex> guard(m_aEngineMutex);
+    if( m_bRunning )
+    {
+        // remembered for an engine which is not yet created
+        m_bInterrupted = true;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+        if( m_pEngine != nullptr )
+        {
+            // thread safe, the engine stops at the next possible point
+            m_pEngine->setInterrupted(true);
+        }
+#endif
+    }
+}
+
+bool JavaScriptExecution::IsRunning() const
+{
+    return m_bRunning;
+}
+
+bool JavaScriptExecution::IsAdmin() const
+{
+    return m_bIsAdmin;
+}
+
+QString JavaScriptExecution::GetStyle() const
+{
+    return m_sStyle;
+}
+
+void JavaScriptExecution::Execute(const QString & sScript, const QString & sFileName, bool bReuseEngine)
+{
+    QElapsedTimer aTimer;
+    aTimer.start();
+
+    if( !bReuseEngine )
+    {
+        DeleteEngine();
+    }
+    if( m_pEngine == nullptr )
+    {
+        CreateEngine();
+    }
+
+    QJSValue result = m_pEngine->evaluate(sScript, sFileName);
+    QString sResult;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    if (m_pEngine->isInterrupted())
+    {
+        sResult = tr("Error: Script execution stopped");
+    }
+    else
+#endif
+    if (result.isError())
+    {
+        sResult = QString(tr("Error: Uncaught exception at line %1: %2")).arg(result.property("lineNumber").toInt()).arg(result.toString());
+    }
+    else
+    {
+        sResult = QString(tr("Result=%1")).arg(result.toString());
+    }
+
+    if( !bReuseEngine )
+    {
+        DeleteEngine();
+    }
+
+    const qint64 iExecutionTimeInMs = aTimer.elapsed();
+    m_bRunning = false;
+    emit Finished(sResult, iExecutionTimeInMs);
+}
+
+// Creates the engine with the env object and the small script library,
+// a reused engine keeps all global definitions of the previous scripts.
+void JavaScriptExecution::CreateEngine()
+{
+    // see: https://doc.qt.io/qt-5/qjsengine.html#details
+    QJSEngine * pEngine = new QJSEngine();
+
+    // without parent the env object is owned and deleted by the engine
+    SciteQtEnvironmentForJavaScript * pEnvironment = new SciteQtEnvironmentForJavaScript(m_bIsAdmin, m_sStyle);
+    connect(pEnvironment,&SciteQtEnvironmentForJavaScript::OnPrint,[this](const QString & text) { emit AddToOutput(text + "\n"); });
+    connect(pEnvironment,&SciteQtEnvironmentForJavaScript::OnAdmin,[this](bool value) { emit Admin(value); });
+
+    pEngine->globalObject().setProperty("env", pEngine->newQObject(pEnvironment));
+
+    // evaluated separately from the script, so the line numbers in exceptions are not shifted
+    pEngine->evaluate(g_sJavaScriptInit + g_sJavaScriptLibrary);
+
+    std::lock_guard<std::mutex> guard(m_aEngineMutex);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    pEngine->setInterrupted(m_bInterrupted);
+#endif
+    m_pEngine = pEngine;
+}
+
+void JavaScriptExecution::DeleteEngine()
+{
+    QJSEngine * pEngine = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(m_aEngineMutex);
+        std::swap(pEngine, m_pEngine);
+    }
+    delete pEngine;
+}
@@ -0,0 +1,68 @@
+/***************************************************************************
+ *
+ * SciteQt - a port of SciTE to Qt Quick/QML
+ *
+ * Copyright (C) 2020 by Michael Neuroth
+ *
+ ***************************************************************************/
+
+#ifndef JAVASCRIPTEXECUTION_H
+#define JAVASCRIPTEXECUTION_H
+
+#include <QObject>
+#include <QString>
+#include <QThread>
+
+#include <atomic>
+#include <mutex>
+
+class QJSEngine;
+
+// ************************************************************************
+
+// Runs JavaScript code in its own thread, so that the UI stays responsive
+// while a script is running and a long running script can be stopped.
+// Before Qt 5.14 a script can not be interrupted and runs synchronously.
+class JavaScriptExecution : public QObject
+{
+    Q_OBJECT
+
+public:
+    JavaScriptExecution();
+    virtual ~JavaScriptExecution();
+
+    // returns false if a script is already running
+    bool Run(const QString & sScript, const QString & sFileName, bool bReuseEngine, bool bIsAdmin, const QString & sStyle);
+    void Stop();
+    bool IsRunning() const;
+
+    // values of the admin and style settings after the last script run,
+    // only valid if no script is running
+    bool IsAdmin() const;
+    QString GetStyle() const;
+
+signals:
+    // emitted in the thread of the script, connect with a direct connection
+    void AddToOutput(const QString & text);
+    void Admin(bool value);
+    void Finished(const QString & sResult, qint64 iExecutionTimeInMs);
+
+private:
+    void Execute(const QString & sScript, const QString & sFileName, bool bReuseEngine);
+    void CreateEngine();
+    void DeleteEngine();
+
+    QThread                 m_aThread;
+    QObject                 m_aThreadContext;   // lives in m_aThread, used to queue the execution
+
+    QJSEngine *             m_pEngine;          // owner, guarded by m_aEngineMutex, only used in m_aThread
+    std::mutex              m_aEngineMutex;
+    bool                    m_bInterrupted;     // Stop() was called for this run, guarded by m_aEngineMutex
+
+    std::atomic<bool>       m_bRunning;
+
+    bool                    m_bIsAdmin;         // referenced by the env object of the script
+    QString                 m_sStyle;
+};
+
+#endif // JAVASCRIPTEXECUTION_H
@@ -28,6 +28,7 @@ HEADERS += applicationdata.h\
            ../../scintilla/lexilla/src/Lexilla.h \
            applicationui.hpp \
            findinfiles.h \
+           javascriptexecution.h \
            sciteqtenvironmentforjavascript.h \
            scriptexecution.h \
            shareutils.hpp \
@@ -37,6 +38,7 @@ SOURCES += applicationdata.cpp\
            GUIQt.cpp\
            ../../scintilla/lexilla/src/Lexilla.cxx\
            findinfiles.cpp \
+           javascriptexecution.cpp \
            sciteqtenvironmentforjavascript.cpp \
            scriptexecution.cpp \
            main.cpp \
@@ -158,7 +158,9 @@ SciTEQt::SciTEQt(QObject *parent, QQmlApplicationEngine * pEngine)
       m_width(0),
       m_height(0),
       m_maximize(false),
-      m_bParametersDialogOpen(false)
+      m_bParametersDialogOpen(false),
+      m_bOutputFlushPosted(false),
+      m_bTailCheckPosted(false)
 {
 #if defined(Q_OS_WASM)
     //propsPlatform.Set("PLAT_GTK", "1");
@@ -219,6 +221,15 @@ SciTEQt::SciTEQt(QObject *parent, QQmlApplicationEngine * pEngine)
     connect(&m_aFindInFiles,SIGNAL(currentItemChanged(QString)),this,SLOT(OnCurrentFindInFilesItemChanged(QString)));
     connect(&m_aFindInFiles,SIGNAL(searchFinished()),this,SLOT(OnFileSearchFinished()));
 
+    // print is called in the thread of the script, so collect the output like for tools
+    connect(&m_aJavaScriptExecution,&JavaScriptExecution::AddToOutput,[this](const QString & text) { QueueOutput(text); });
+    connect(&m_aJavaScriptExecution,SIGNAL(Admin(bool)),this,SLOT(OnAdmin(bool)),Qt::QueuedConnection);
+    connect(&m_aJavaScriptExecution,SIGNAL(Finished(QString,qint64)),this,SLOT(OnJavaScriptFinished(QString,qint64)),Qt::QueuedConnection);
+
+    m_aTicker.setInterval(1000);
+    connect(&m_aTicker,SIGNAL(timeout()),this,SLOT(OnTimerTick()));
+    connect(&m_aTailWatcher,SIGNAL(fileChanged(QString)),this,SLOT(OnTailFileChanged(QString)));
+
     cmdWorker.pSciTE = this;
 }
 
@@ -502,7 +513,7 @@ void SciTEQt::SaveAsRTF()
 // TODO for WASM
     if(ProcessCurrentFileDialog())
     {
-        SaveToRTF(GetPathFromUrl(m_sCurrentFileUrl));
+        SaveToRTF(GetPathFromUrl(m_sCurrentFileUrl), 0, -1, sfNone);
     }
 
     CheckAndDeleteGetContentToWriteFunctionPointer();
@@ -520,7 +531,7 @@ void SciTEQt::SaveAsPDF()
 // TODO for WASM
     if(ProcessCurrentFileDialog())
     {
-        SaveToPDF(GetPathFromUrl(m_sCurrentFileUrl));
+        SaveToPDF(GetPathFromUrl(m_sCurrentFileUrl), sfNone);
     }
 
     CheckAndDeleteGetContentToWriteFunctionPointer();
@@ -575,7 +586,7 @@ void SciTEQt::SaveAsHTML()
 // TODO for WASM
     if(ProcessCurrentFileDialog())
     {
-        SaveToHTML(GetPathFromUrl(m_sCurrentFileUrl));
+        SaveToHTML(GetPathFromUrl(m_sCurrentFileUrl), sfNone);
     }
 
     CheckAndDeleteGetContentToWriteFunctionPointer();
@@ -1011,6 +1022,7 @@ void SciTEQt::StopExecute()
     {
         m_pCurrentScriptExecution->KillExecution();
     }
+    m_aJavaScriptExecution.Stop();
 }
 
 void SciTEQt::SetFileProperties(PropSetFile &ps)
@@ -2295,38 +2307,37 @@ void SciTEQt::cmdAboutCurrentFile()
     OnAddLineToOutput(sMsg);
 }
 
-static QString g_sJavaScriptInit = "var console = { log: env.print }; ";
-static QString g_sJavaScriptLibrary = "\nfunction print(t) { env.print(t) }\nfunction admin(val) { env.admin(val) }\nfunction style(val) { env.style(val) }\n";
-
 void SciTEQt::cmdRunCurrentAsJavaScriptFile()
 {
-    QString text = QString::fromStdString(wEditor.GetText(wEditor.TextLength()+1).c_str());
+    if( m_aJavaScriptExecution.IsRunning() || jobQueue.IsExecuting() )
+    {
+        OnAddLineToOutput(tr(">Warning: a script or tool is already running !"));
+        return;
+    }
 
-    // see: https://doc.qt.io/qt-5/qjsengine.html#details
-    QJSEngine myEngine;
+    // convert directly from the buffer of the document without an intermediate copy
+    const char * pText = static_cast<const char *>(wEditor.CharacterPointer());
+    QString text = QString::fromUtf8(pText, static_cast<int>(wEditor.TextLength()));
 
-    SciteQtEnvironmentForJavaScript aSciteQtJSEnvironment(m_bIsAdmin, m_sStyle, this);
-    connect(&aSciteQtJSEnvironment,SIGNAL(OnPrint(QString)),this,SLOT(OnAddLineToOutput(QString)));
-    connect(&aSciteQtJSEnvironment,SIGNAL(OnAdmin(bool)),this,SLOT(OnAdmin(bool)));
+    // the script runs in its own thread, use Stop Executing to interrupt it
+    jobQueue.SetExecuting(true);
+    CheckMenus();
+    m_aJavaScriptExecution.Run(text, filePath.AsUTF8().c_str(), props.GetInt("javascript.reuse.engine") != 0, m_bIsAdmin, m_sStyle);
+}
 
-    QJSValue sciteEnvironment = myEngine.newQObject(&aSciteQtJSEnvironment);
-    myEngine.globalObject().setProperty("env", sciteEnvironment);
+void SciTEQt::OnJavaScriptFinished(const QString & sResult, qint64 iExecutionTimeInMs)
+{
+    // take over the settings changed by the script
+    m_bIsAdmin = m_aJavaScriptExecution.IsAdmin();
+    m_sStyle = m_aJavaScriptExecution.GetStyle();
 
-    // put javascript library at the end of the script because otherwiese the line numbers in exceptions are wrong !
-    QJSValue result = myEngine.evaluate(g_sJavaScriptInit+text+g_sJavaScriptLibrary, filePath.AsUTF8().c_str());
-    QString sResult;
-    if (result.isError())
-    {
-        sResult = QString(tr("Error: Uncaught exception at line %1: %2")).arg(result.property("lineNumber").toInt()).arg(result.toString());
-    }
-    else
-    {
-        sResult = QString(tr("Result=%1")).arg(result.toString());
-    }
+    // pending output of the script has to appear before the result
+    FlushOutput();
     OnAddLineToOutput(sResult);
+    OnAddToOutput(QString(tr(">Execution time: %1 ms")).arg(iExecutionTimeInMs)+"\n");
 
-    disconnect(&aSciteQtJSEnvironment,SIGNAL(OnAdmin(bool)),this,SLOT(OnAdmin(bool)));
-    disconnect(&aSciteQtJSEnvironment,SIGNAL(OnPrint(QString)),this,SLOT(OnAddLineToOutput(QString)));
+    jobQueue.SetExecuting(false);
+    CheckMenus();
 }
 
 void SciTEQt::cmdRunCurrentAsLuaFile()
@@ -2607,10 +2618,11 @@ int SciTEQt::ExecuteOne(const Job &jobToRun)
 
 	ScriptExecution tempScriptExecution;
     m_pCurrentScriptExecution = &tempScriptExecution;
-    connect(&tempScriptExecution,SIGNAL(AddToOutput(QString)),this,SLOT(OnAddToOutput(QString)));
+    // the output is queued directly from the execution thread and appended in blocks by the UI thread
+    QMetaObject::Connection aOutputConnection = connect(&tempScriptExecution,&ScriptExecution::AddToOutput,[this](const QString & text) { QueueOutput(text); });
     int ret = tempScriptExecution.DoScriptExecution(cmd, args, workingDirectory);
     m_pCurrentScriptExecution = 0;
-    disconnect(&tempScriptExecution,SIGNAL(AddToOutput(QString)),this,SLOT(OnAddToOutput(QString)));    
+    disconnect(aOutputConnection);
     return ret;
 }
 
@@ -2670,6 +2682,8 @@ void SciTEQt::WorkerCommand(int cmd, Worker *pWorker)
     if (cmd < WORK_PLATFORM) {
         SciTEBase::WorkerCommand(cmd, pWorker);
     } else {
+        // output of the finished command has to be in the output pane before moving on
+        FlushOutput();
 		if (cmd == TRIGGER_GOTOPOS) {
 			if ((cmdWorker.outputScroll == 1) && returnOutputToCommand)
 				wOutput.Send(SCI_GOTOPOS, cmdWorker.originalEnd);
@@ -3267,9 +3281,163 @@ void SciTEQt::OnUriDroppedFromScintilla(const QString & uri)
 
 void SciTEQt::OnAddToOutput(const QString & text)
 {
-    OutputAppendStringSynchronised(text.toStdString().c_str());
-    ShowOutputOnMainThread();
-	//QCoreApplication::processEvents();
+    QueueOutput(text);
+}
+
+static const qint64 c_iOutputFlushIntervalMs = 16;     // about once per frame
+
+// Tools and find in files may produce many small pieces of output, appending each one
+// separately to the output pane keeps the UI thread busy with scrolling and redrawing.
+// So the output is collected here and appended by the UI thread in one block, at most
+// once per frame.
+void SciTEQt::QueueOutput(const QString & text)
+{
+    const QByteArray aText = text.toUtf8();
+    bool bPostFlush = false;
+    {
+        std::lock_guard<std::mutex> guard(m_aOutputMutex);
+        m_sOutputQueued.append(aText.constData(), aText.size());
+        bPostFlush = !m_bOutputFlushPosted;
+        m_bOutputFlushPosted = true;
+    }
+    if( bPostFlush )
+    {
+        QMetaObject::invokeMethod(this, "OnFlushOutput", Qt::QueuedConnection);
+    }
+}
+
+void SciTEQt::OutputAppendStringSynchronised(const char *s, SA::Position len)
+{
+    if (len == -1)
+        len = strlen(s);
+    QueueOutput(QString::fromUtf8(s, static_cast<int>(len)));
+}
+
+// Lua print and trace are queued like tool output, so output:ClearAll() and other direct
+// access to the output pane has to append the queued output first to keep the order.
+void SciTEQt::OutputFlushQueued() noexcept
+{
+    if( QThread::currentThread() != thread() )
+    {
+        return;
+    }
+    try
+    {
+        FlushOutput();
+    }
+    catch( const std::exception & )
+    {
+        // leave the pane as it is rather than unwinding through the extension
+    }
+}
+
+// output.max.lines removed text before the start of the running command's output
+void SciTEQt::OutputTrimmed(SA::Position lengthRemoved)
+{
+    cmdWorker.originalEnd = std::max<SA::Position>(cmdWorker.originalEnd - lengthRemoved, 0);
+}
+
+void SciTEQt::OnFlushOutput()
+{
+    const qint64 iSinceLastFlush = m_aOutputFlushTimer.isValid() ? m_aOutputFlushTimer.elapsed() : c_iOutputFlushIntervalMs;
+    if( iSinceLastFlush < c_iOutputFlushIntervalMs )
+    {
+        // wait for the next frame, more output may arrive in the meantime
+        QTimer::singleShot(c_iOutputFlushIntervalMs - iSinceLastFlush, this, SLOT(OnFlushOutput()));
+        return;
+    }
+    FlushOutput();
+}
+
+// Append all queued output to the output pane, only call on the UI thread.
+void SciTEQt::FlushOutput()
+{
+    std::string sText;
+    {
+        std::lock_guard<std::mutex> guard(m_aOutputMutex);
+        sText.swap(m_sOutputQueued);
+        m_bOutputFlushPosted = false;
+    }
+    m_aOutputFlushTimer.start();
+    if( !sText.empty() )
+    {
+        OutputAppendString(sText.c_str(), sText.length());
+        ShowOutputOnMainThread();
+    }
+}
+
+static const int c_iTailCheckDelayMs = 100;     // a log file may be written many times per second
+
+void SciTEQt::TimerStart(int mask)
+{
+    const int maskNew = timerMask | mask;
+    if( timerMask != maskNew )
+    {
+        if( timerMask == 0 )
+        {
+            m_aTicker.start();
+        }
+        timerMask = maskNew;
+    }
+    UpdateTailWatcher();
+}
+
+void SciTEQt::TimerEnd(int mask)
+{
+    const int maskNew = timerMask & ~mask;
+    if( timerMask != maskNew )
+    {
+        if( maskNew == 0 )
+        {
+            m_aTicker.stop();
+        }
+        timerMask = maskNew;
+    }
+    UpdateTailWatcher();
+}
+
+// Watch the current file for changes while tail.follow is set, the ticker is the fallback
+// when the platform can not watch the file and adds it again after it was replaced.
+void SciTEQt::UpdateTailWatcher()
+{
+    QStringList aFiles;
+    if( (timerMask & timerTailFollow) && !filePath.IsUntitled() )
+    {
+        aFiles.append(ConvertGuiCharToQString(filePath.AsInternal()));
+    }
+    if( m_aTailWatcher.files() != aFiles )
+    {
+        if( !m_aTailWatcher.files().isEmpty() )
+        {
+            m_aTailWatcher.removePaths(m_aTailWatcher.files());
+        }
+        if( !aFiles.isEmpty() )
+        {
+            m_aTailWatcher.addPaths(aFiles);
+        }
+    }
+}
+
+void SciTEQt::OnTimerTick()
+{
+    OnTimer();
+    UpdateTailWatcher();
+}
+
+void SciTEQt::OnTailFileChanged(const QString & path)
+{
+    if( m_bTailCheckPosted || path != ConvertGuiCharToQString(filePath.AsInternal()) )
+    {
+        return;
+    }
+    m_bTailCheckPosted = true;
+    QTimer::singleShot(c_iTailCheckDelayMs, this, [this]() {
+        m_bTailCheckPosted = false;
+        if( (timerMask & timerTailFollow) && (0 == dialogsOnScreen) )
+        {
+            CheckTail();
+        }
+    });
 }
 
 void SciTEQt::OnCurrentFindInFilesItemChanged(const QString & currentItem)
@@ -80,6 +80,7 @@
 
 #include "applicationdata.h"
 #include "findinfiles.h"
+#include "javascriptexecution.h"
 #include "scriptexecution.h"
 
 #include <QEvent>
@@ -87,6 +88,9 @@
 //#include <QStandardItemModel>
 #include <QPrinter>
 #include <QScreen>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QFileSystemWatcher>
 
 class SciTEQt;
 
@@ -228,6 +232,10 @@ public:
 
     virtual void WorkerCommand(int cmd, Worker *pWorker) override;
 
+    virtual void TimerStart(int mask) override;
+    virtual void TimerEnd(int mask) override;
+    void UpdateTailWatcher();
+
     virtual bool event(QEvent *e) override;
 
     // overloaded method to improve the support of WASM and Android
@@ -239,6 +247,13 @@ public:
     void ProcessExecute();
     int ExecuteOne(const Job &jobToRun);
 
+    // output of tools and find in files, may be called from any thread
+    void QueueOutput(const QString & text);
+    virtual void OutputAppendStringSynchronised(const char *s, SA::Position len = -1) override;
+    virtual void OutputFlushQueued() noexcept override;
+    virtual void OutputTrimmed(SA::Position lengthRemoved) override;
+    void FlushOutput();
+
     bool isShowToolBar() const;
     void setShowToolBar(bool val);
     bool isShowStatusBar() const;
@@ -478,6 +493,9 @@ public slots:
     void OnCurrentFindInFilesItemChanged(const QString & currentItem);
     void OnAddToOutput(const QString & text);
     void OnAddLineToOutput(const QString & text);
+    void OnFlushOutput();
+    void OnTimerTick();
+    void OnTailFileChanged(const QString & path);
     Q_INVOKABLE void OnAddFileContent(const QString & sFileUri, const QString & sDecodedFileUri, const QString & sContent, bool bNewCreated, bool bSaveACopyModus);
 
     void OnStripFindVisible(bool val);
@@ -487,6 +505,7 @@ public slots:
     void OnPrimaryScreenChanged(QScreen * pScreen);
 
     void OnAdmin(bool value);
+    void OnJavaScriptFinished(const QString & sResult, qint64 iExecutionTimeInMs);
 
 signals:
     void showToolBarChanged();
@@ -625,6 +644,17 @@ private:
     QPrinter                m_aPrinter;
 
     QtCommandWorker         cmdWorker;
+
+    std::mutex              m_aOutputMutex;
+    std::string             m_sOutputQueued;        // guarded by m_aOutputMutex
+    bool                    m_bOutputFlushPosted;   // guarded by m_aOutputMutex
+    QElapsedTimer           m_aOutputFlushTimer;
+
+    QTimer                  m_aTicker;              // one second ticker for the timers of SciTEBase
+    QFileSystemWatcher      m_aTailWatcher;         // the current file while tail.follow is set
+    bool                    m_bTailCheckPosted;
+
+    JavaScriptExecution     m_aJavaScriptExecution;     // after the output queue, the script thread may still print while it is destroyed
 };
 
 #define MSGBOX_RESULT_EMPTY 0
@@ -0,0 +1,84 @@
+-- LuaPaneBenchmark.lua
+-- Times the ways a Lua script can read the whole document in the editor pane,
+-- comparing a pane call for each position or line with the bulk accessors.
+-- Open a large file then run this from the output pane with
+--   dofile("/path/to/LuaPaneBenchmark.lua")
+-- or add it to ext.lua.startup.script.
+
+local function timed(name, f)
+	local start = os.clock()
+	f()
+	print(string.format("%-44s %8.3f s", name, os.clock() - start))
+end
+
+local length = editor.Length
+local lineCount = editor.LineCount
+print(string.format("Document of %d bytes in %d lines", length, lineCount))
+
+local checkText, checkStyles, checkLines = 0, 0, 0
+
+timed("editor.CharAt[i] for each position", function()
+	local sum = 0
+	for i = 0, length - 1 do
+		sum = sum + editor.CharAt[i]
+	end
+	checkText = sum
+end)
+
+timed("scite.SendEditor(SCI_GETCHARAT, i)", function()
+	local sum = 0
+	for i = 0, length - 1 do
+		sum = sum + scite.SendEditor(SCI_GETCHARAT, i)
+	end
+	assert(sum == checkText)
+end)
+
+timed("editor:textrange(0, length)", function()
+	local text = editor:textrange(0, length)
+	local sum = 0
+	for i = 1, #text do
+		local ch = text:byte(i)
+		-- CharAt returns signed characters
+		sum = sum + (ch < 128 and ch or ch - 256)
+	end
+	assert(sum == checkText)
+end)
+
+timed("editor.StyleAt[i] for each position", function()
+	local sum = 0
+	for i = 0, length - 1 do
+		sum = sum + editor.StyleAt[i]
+	end
+	checkStyles = sum
+end)
+
+timed("editor:stylerange(0, length)", function()
+	local styles = editor:stylerange(0, length)
+	local sum = 0
+	for i = 1, #styles do
+		sum = sum + styles:byte(i)
+	end
+	assert(sum == checkStyles)
+end)
+
+timed("editor:PositionFromLine(line) for each line", function()
+	local sum = 0
+	for line = 0, lineCount - 1 do
+		sum = sum + editor:PositionFromLine(line)
+	end
+	checkLines = sum
+end)
+
+timed("editor:linestarts()", function()
+	local sum = 0
+	for _, position in ipairs(editor:linestarts()) do
+		sum = sum + position
+	end
+	assert(sum == checkLines)
+end)
+
+timed("editor:GetLine(line) for each line", function()
+	for line = 0, lineCount - 1 do
+		editor:GetLine(line)
+	end
+end)
@@ -50,28 +50,48 @@
 
 //---------- Save to HTML ----------
 
-void SciTEBase::SaveToHTML(const FilePath &saveName) {
-	RemoveFindMarks();
-	wEditor.ColouriseAll();
-	int tabSize = props.GetInt("tabsize");
-	if (tabSize == 0)
-		tabSize = 4;
-	const int wysiwyg = props.GetInt("export.html.wysiwyg", 1);
-	const int tabs = props.GetInt("export.html.tabs", 0);
-	const int folding = props.GetInt("export.html.folding", 0);
-	const int onlyStylesUsed = props.GetInt("export.html.styleused", 0);
-	const int titleFullPath = props.GetInt("export.html.title.fullpath", 0);
+namespace {
 
-	const SA::Position lengthDoc = LengthDocument();
-	TextReader acc(wEditor);
+// Characters which are copied into the output unchanged.
+constexpr bool IsPlainHTML(char ch) noexcept {
+	return ch != ' ' && ch != '\t' && ch != '\r' && ch != '\n' &&
+		ch != '<' && ch != '>' && ch != '&';
+}
+
+void AppendFoldHeader(std::string &html, SA::Line line) {
+	const std::string sLine = std::to_string(line);
+	const std::string sLineNext = std::to_string(line + 1);
+	html += "<span id=\"hd" + sLine + "\" onclick=\"toggle('" + sLineNext + "')\">";
+	html += "<span id=\"bt" + sLine + "\">- </span>";
+}
+
+// Settings and style definitions are read on the GUI thread, then the output may be generated on a worker thread.
+class HTMLGenerator : public ExportGenerator {
+public:
+	int tabSize = 4;
+	int wysiwyg = 1;
+	int tabs = 0;
+	int folding = 0;
+	int onlyStylesUsed = 0;
+	bool isUTF8 = false;
+	std::string title;
+	// For each style with the monospace font applied when used
+	std::vector<StyleDefinition> styleDefinitions;
+	HTMLGenerator(SA::ScintillaCall &sc, int folding_) : ExportGenerator(sc, 0, -1, folding_ != 0), folding(folding_) {
+	}
+	std::string Generate(const Worker *pWorker) override;
+};
+
+std::string HTMLGenerator::Generate(const Worker *pWorker) {
+	const SA::Position lengthDoc = reader.End();
 
 	constexpr int StyleLastPredefined = static_cast<int>(SA::StylesCommon::LastPredefined);
 
 	bool styleIsUsed[StyleMax + 1] = {};
 	if (onlyStylesUsed) {
 		// check the used styles
-		for (SA::Position i = 0; i < lengthDoc; i++) {
-			styleIsUsed[acc.StyleAt(i)] = true;
+		for (SA::Position i = 0; i < lengthDoc; i = reader.StyleRunEnd(i, lengthDoc)) {
+			styleIsUsed[reader.StyleAt(i)] = true;
 		}
 	} else {
 		for (int i = 0; i <= StyleMax; i++) {
@@ -80,308 +100,325 @@ void SciTEBase::SaveToHTML(const FilePath &saveName) {
 	}
 	styleIsUsed[StyleDefault] = true;
 
-	FILE *fp = saveName.Open(GUI_TEXT("wt"));
-	bool failedWrite = fp == nullptr;
-	if (fp) {
-		fputs("<!DOCTYPE html PUBLIC \"-//W3C//DTD XHTML 1.0 Transitional//EN\" \"http://www.w3.org/TR/xhtml1/DTD/xhtml1-transitional.dtd\">\n", fp);
-		fputs("<html xmlns=\"http://www.w3.org/1999/xhtml\">\n", fp);
-		fputs("<head>\n", fp);
-		if (titleFullPath)
-			fprintf(fp, "<title>%s</title>\n",
-				filePath.AsUTF8().c_str());
-		else
-			fprintf(fp, "<title>%s</title>\n",
-				filePath.Name().AsUTF8().c_str());
-		// Probably not used by robots, but making a little advertisement for those looking
-		// at the source code doesn't hurt...
-		fputs("<meta name=\"Generator\" content=\"SciTE - www.Scintilla.org\" />\n", fp);
-		if (codePage == SA::CpUtf8)
-			fputs("<meta http-equiv=\"Content-Type\" content=\"text/html; charset=utf-8\" />\n", fp);
-
-		if (folding) {
-			fputs("<script language=\"JavaScript\" type=\"text/javascript\">\n"
-			      "<!--\n"
-			      "function symbol(id, sym) {\n"
-			      " if (id.textContent==undefined) {\n"
-			      " id.innerText=sym; } else {\n"
-			      " id.textContent=sym; }\n"
-			      "}\n"
-			      "function toggle(id) {\n"
-			      "var thislayer=document.getElementById('ln'+id);\n"
-			      "id-=1;\n"
-			      "var togline=document.getElementById('hd'+id);\n"
-			      "var togsym=document.getElementById('bt'+id);\n"
-			      "if (thislayer.style.display == 'none') {\n"
-			      " thislayer.style.display='';\n"
-			      " togline.style.textDecoration='none';\n"
-			      " symbol(togsym,'- ');\n"
-			      "} else {\n"
-			      " thislayer.style.display='none';\n"
-			      " togline.style.textDecoration='underline';\n"
-			      " symbol(togsym,'+ ');\n"
-			      "}\n"
-			      "}\n"
-			      "//-->\n"
-			      "</script>\n", fp);
-		}
-
-		fputs("<style type=\"text/css\">\n", fp);
-
-		std::string bgColour;
+	std::string html;
+	html.reserve(lengthDoc + lengthDoc / 4 + 4096);
+	html += "<!DOCTYPE html PUBLIC \"-//W3C//DTD XHTML 1.0 Transitional//EN\" \"http://www.w3.org/TR/xhtml1/DTD/xhtml1-transitional.dtd\">\n";
+	html += "<html xmlns=\"http://www.w3.org/1999/xhtml\">\n";
+	html += "<head>\n";
+	html += "<title>" + title + "</title>\n";
+	// Probably not used by robots, but making a little advertisement for those looking
+	// at the source code doesn't hurt...
+	html += "<meta name=\"Generator\" content=\"SciTE - www.Scintilla.org\" />\n";
+	if (isUTF8)
+		html += "<meta http-equiv=\"Content-Type\" content=\"text/html; charset=utf-8\" />\n";
+
+	if (folding) {
+		html += "<script language=\"JavaScript\" type=\"text/javascript\">\n"
+			"<!--\n"
+			"function symbol(id, sym) {\n"
+			" if (id.textContent==undefined) {\n"
+			" id.innerText=sym; } else {\n"
+			" id.textContent=sym; }\n"
+			"}\n"
+			"function toggle(id) {\n"
+			"var thislayer=document.getElementById('ln'+id);\n"
+			"id-=1;\n"
+			"var togline=document.getElementById('hd'+id);\n"
+			"var togsym=document.getElementById('bt'+id);\n"
+			"if (thislayer.style.display == 'none') {\n"
+			" thislayer.style.display='';\n"
+			" togline.style.textDecoration='none';\n"
+			" symbol(togsym,'- ');\n"
+			"} else {\n"
+			" thislayer.style.display='none';\n"
+			" togline.style.textDecoration='underline';\n"
+			" symbol(togsym,'+ ');\n"
+			"}\n"
+			"}\n"
+			"//-->\n"
+			"</script>\n";
+	}
 
-		StyleDefinition sddef = StyleDefinitionFor(StyleDefault);
+	html += "<style type=\"text/css\">\n";
 
-		if (sddef.back.length()) {
-			bgColour = sddef.back;
-		}
+	std::string bgColour;
 
-		std::string sval = props.GetExpandedString("font.monospace");
-		StyleDefinition sdmono(sval.c_str());
+	if (styleDefinitions[StyleDefault].back.length()) {
+		bgColour = styleDefinitions[StyleDefault].back;
+	}
 
-		for (int istyle = 0; istyle <= StyleMax; istyle++) {
-			if ((istyle > StyleDefault) && (istyle <= StyleLastPredefined))
-				continue;
-			if (styleIsUsed[istyle]) {
+	for (int istyle = 0; istyle <= StyleMax; istyle++) {
+		if ((istyle > StyleDefault) && (istyle <= StyleLastPredefined))
+			continue;
+		if (styleIsUsed[istyle]) {
 
-				StyleDefinition sd = StyleDefinitionFor(istyle);
+			const StyleDefinition &sd = styleDefinitions[istyle];
 
-				if (CurrentBufferConst()->useMonoFont && sd.font.length() && sdmono.font.length()) {
-					sd.font = sdmono.font;
-					sd.size = sdmono.size;
-					sd.italics = sdmono.italics;
-					sd.weight = sdmono.weight;
+			if (sd.specified != StyleDefinition::sdNone) {
+				if (istyle == StyleDefault) {
+					html += "span {\n";
+				} else {
+					html += ".S" + std::to_string(istyle) + " {\n";
 				}
-
-				if (sd.specified != StyleDefinition::sdNone) {
-					if (istyle == StyleDefault) {
-						fprintf(fp, "span {\n");
-					} else {
-						fprintf(fp, ".S%0d {\n", istyle);
-					}
-					if (sd.italics) {
-						fprintf(fp, "\tfont-style: italic;\n");
-					}
-					if (sd.IsBold()) {
-						fprintf(fp, "\tfont-weight: bold;\n");
-					}
-					if (wysiwyg && sd.font.length()) {
-						fprintf(fp, "\tfont-family: '%s';\n", sd.font.c_str());
-					}
-					if (sd.fore.length()) {
-						fprintf(fp, "\tcolor: %s;\n", sd.fore.c_str());
-					} else if (istyle == StyleDefault) {
-						fprintf(fp, "\tcolor: #000000;\n");
-					}
-					if ((sd.specified & StyleDefinition::sdBack) && sd.back.length()) {
-						if (istyle != StyleDefault && bgColour != sd.back) {
-							fprintf(fp, "\tbackground: %s;\n", sd.back.c_str());
-							fprintf(fp, "\ttext-decoration: inherit;\n");
-						}
-					}
-					if (wysiwyg && sd.size) {
-						fprintf(fp, "\tfont-size: %0dpt;\n", sd.size);
+				if (sd.italics) {
+					html += "\tfont-style: italic;\n";
+				}
+				if (sd.IsBold()) {
+					html += "\tfont-weight: bold;\n";
+				}
+				if (wysiwyg && sd.font.length()) {
+					html += "\tfont-family: '" + sd.font + "';\n";
+				}
+				if (sd.fore.length()) {
+					html += "\tcolor: " + sd.fore + ";\n";
+				} else if (istyle == StyleDefault) {
+					html += "\tcolor: #000000;\n";
+				}
+				if ((sd.specified & StyleDefinition::sdBack) && sd.back.length()) {
+					if (istyle != StyleDefault && bgColour != sd.back) {
+						html += "\tbackground: " + sd.back + ";\n";
+						html += "\ttext-decoration: inherit;\n";
 					}
-					fprintf(fp, "}\n");
-				} else {
-					styleIsUsed[istyle] = false;	// No definition, it uses default style (32)
 				}
+				if (wysiwyg && sd.size) {
+					html += "\tfont-size: " + std::to_string(sd.size) + "pt;\n";
+				}
+				html += "}\n";
+			} else {
+				styleIsUsed[istyle] = false;	// No definition, it uses default style (32)
 			}
 		}
-		fputs("</style>\n", fp);
-		fputs("</head>\n", fp);
-		if (bgColour.length() > 0)
-			fprintf(fp, "<body bgcolor=\"%s\">\n", bgColour.c_str());
-		else
-			fputs("<body>\n", fp);
-
-		SA::Line line = acc.GetLine(0);
-		int level = LevelNumber(acc.LevelAt(line)) - static_cast<int>(SA::FoldLevel::Base);
-		int styleCurrent = acc.StyleAt(0);
-		bool inStyleSpan = false;
-		bool inFoldSpan = false;
-		// Global span for default attributes
-		if (wysiwyg) {
-			fputs("<span>", fp);
-		} else {
-			fputs("<pre>", fp);
-		}
+	}
+	html += "</style>\n";
+	html += "</head>\n";
+	if (bgColour.length() > 0)
+		html += "<body bgcolor=\"" + bgColour + "\">\n";
+	else
+		html += "<body>\n";
+
+	SA::Line line = 0;
+	int level = LevelNumber(reader.LevelAt(line)) - static_cast<int>(SA::FoldLevel::Base);
+	int styleCurrent = reader.StyleAt(0);
+	bool inStyleSpan = false;
+	bool inFoldSpan = false;
+	// Global span for default attributes
+	if (wysiwyg) {
+		html += "<span>";
+	} else {
+		html += "<pre>";
+	}
 
-		if (folding) {
-			const SA::FoldLevel lvl = acc.LevelAt(0);
-			level = LevelNumber(lvl) - static_cast<int>(SA::FoldLevel::Base);
+	if (folding) {
+		const SA::FoldLevel lvl = reader.LevelAt(0);
+		level = LevelNumber(lvl) - static_cast<int>(SA::FoldLevel::Base);
 
-			if (LevelIsHeader(lvl)) {
-				const std::string sLine = std::to_string(line);
-				const std::string sLineNext = std::to_string(line+1);
-				fprintf(fp, "<span id=\"hd%s\" onclick=\"toggle('%s')\">", sLine.c_str(), sLineNext.c_str());
-				fprintf(fp, "<span id=\"bt%s\">- </span>", sLine.c_str());
-				inFoldSpan = true;
-			} else {
-				fputs("&nbsp; ", fp);
-			}
+		if (LevelIsHeader(lvl)) {
+			AppendFoldHeader(html, line);
+			inFoldSpan = true;
+		} else {
+			html += "&nbsp; ";
 		}
+	}
 
-		if (styleIsUsed[styleCurrent]) {
-			fprintf(fp, "<span class=\"S%0d\">", styleCurrent);
-			inStyleSpan = true;
-		}
-		// Else, this style has no definition (beside default one):
-		// no span for it, except the global one
-
-		int column = 0;
-		for (SA::Position i = 0; i < lengthDoc; i++) {
-			const char ch = acc[i];
-			const int style = acc.StyleAt(i);
-
-			if (style != styleCurrent) {
-				if (inStyleSpan) {
-					fputs("</span>", fp);
-					inStyleSpan = false;
-				}
-				if (ch != '\r' && ch != '\n') {	// No need of a span for the EOL
-					if (styleIsUsed[style]) {
-						fprintf(fp, "<span class=\"S%0d\">", style);
-						inStyleSpan = true;
-					}
-					styleCurrent = style;
+	if (styleIsUsed[styleCurrent]) {
+		html += "<span class=\"S" + std::to_string(styleCurrent) + "\">";
+		inStyleSpan = true;
+	}
+	// Else, this style has no definition (beside default one):
+	// no span for it, except the global one
+
+	int column = 0;
+	// All positions before runEnd have the same style as position i.
+	SA::Position runEnd = 0;
+	for (SA::Position i = 0; i < lengthDoc; i++) {
+		if (i >= runEnd)
+			runEnd = reader.StyleRunEnd(i, lengthDoc);
+		const char ch = reader.CharAt(i);
+		const int style = reader.StyleAt(i);
+
+		if (style != styleCurrent) {
+			if (inStyleSpan) {
+				html += "</span>";
+				inStyleSpan = false;
+			}
+			if (ch != '\r' && ch != '\n') {	// No need of a span for the EOL
+				if (styleIsUsed[style]) {
+					html += "<span class=\"S" + std::to_string(style) + "\">";
+					inStyleSpan = true;
 				}
+				styleCurrent = style;
 			}
-			if (ch == ' ') {
-				if (wysiwyg) {
-					char prevCh = '\0';
-					if (column == 0) {	// At start of line, must put a &nbsp; because regular space will be collapsed
-						prevCh = ' ';
-					}
-					while (i < lengthDoc && acc[i] == ' ') {
-						if (prevCh != ' ') {
-							fputc(' ', fp);
-						} else {
-							fputs("&nbsp;", fp);
-						}
-						prevCh = acc[i];
-						i++;
-						column++;
+		}
+		if (ch == ' ') {
+			if (wysiwyg) {
+				char prevCh = '\0';
+				if (column == 0) {	// At start of line, must put a &nbsp; because regular space will be collapsed
+					prevCh = ' ';
+				}
+				while (i < lengthDoc && reader.CharAt(i) == ' ') {
+					if (prevCh != ' ') {
+						html += ' ';
+					} else {
+						html += "&nbsp;";
 					}
-					i--; // the last incrementation will be done by the for loop
-				} else {
-					fputc(' ', fp);
+					prevCh = ' ';
+					i++;
 					column++;
 				}
-			} else if (ch == '\t') {
-				const int ts = tabSize - (column % tabSize);
-				if (wysiwyg) {
-					for (int itab = 0; itab < ts; itab++) {
-						if (itab % 2) {
-							fputc(' ', fp);
-						} else {
-							fputs("&nbsp;", fp);
-						}
-					}
-					column += ts;
-				} else {
-					if (tabs) {
-						fputc(ch, fp);
-						column++;
+				i--; // the last incrementation will be done by the for loop
+			} else {
+				html += ' ';
+				column++;
+			}
+		} else if (ch == '\t') {
+			const int ts = tabSize - (column % tabSize);
+			if (wysiwyg) {
+				for (int itab = 0; itab < ts; itab++) {
+					if (itab % 2) {
+						html += ' ';
 					} else {
-						for (int itab = 0; itab < ts; itab++) {
-							fputc(' ', fp);
-						}
-						column += ts;
+						html += "&nbsp;";
 					}
 				}
-			} else if (ch == '\r' || ch == '\n') {
-				if (inStyleSpan) {
-					fputs("</span>", fp);
-					inStyleSpan = false;
-				}
-				if (inFoldSpan) {
-					fputs("</span>", fp);
-					inFoldSpan = false;
-				}
-				if (ch == '\r' && acc[i + 1] == '\n') {
-					i++;	// CR+LF line ending, skip the "extra" EOL char
-				}
-				column = 0;
-				if (wysiwyg) {
-					fputs("<br />", fp);
+				column += ts;
+			} else {
+				if (tabs) {
+					html += ch;
+					column++;
+				} else {
+					html.append(ts, ' ');
+					column += ts;
 				}
+			}
+		} else if (ch == '\r' || ch == '\n') {
+			if (inStyleSpan) {
+				html += "</span>";
+				inStyleSpan = false;
+			}
+			if (inFoldSpan) {
+				html += "</span>";
+				inFoldSpan = false;
+			}
+			if (ch == '\r' && reader.CharAt(i + 1) == '\n') {
+				i++;	// CR+LF line ending, skip the "extra" EOL char
+			}
+			column = 0;
+			if (wysiwyg) {
+				html += "<br />";
+			}
+			if (pWorker && pWorker->Cancelling()) {
+				return html;
+			}
 
-				styleCurrent = acc.StyleAt(i + 1);
-				if (folding) {
-					line = acc.GetLine(i + 1);
+			styleCurrent = reader.StyleAt(i + 1);
+			if (folding) {
+				line++;
 
-					const SA::FoldLevel lvl = acc.LevelAt(line);
-					const int newLevel = LevelNumber(lvl) - static_cast<int>(SA::FoldLevel::Base);
+				const SA::FoldLevel lvl = reader.LevelAt(line);
+				const int newLevel = LevelNumber(lvl) - static_cast<int>(SA::FoldLevel::Base);
 
-					if (newLevel < level)
-						fprintf(fp, "</span>");
-					fputc('\n', fp); // here to get clean code
-					if (newLevel > level) {
-						const std::string sLine = std::to_string(line);
-						fprintf(fp, "<span id=\"ln%s\">", sLine.c_str());
-					}
-
-					if (LevelIsHeader(lvl)) {
-						const std::string sLine = std::to_string(line);
-						const std::string sLineNext = std::to_string(line + 1);
-						fprintf(fp, "<span id=\"hd%s\" onclick=\"toggle('%s')\">", sLine.c_str(), sLineNext.c_str());
-						fprintf(fp, "<span id=\"bt%s\">- </span>", sLine.c_str());
-						inFoldSpan = true;
-					} else
-						fputs("&nbsp; ", fp);
-					level = newLevel;
-				} else {
-					fputc('\n', fp);
+				if (newLevel < level)
+					html += "</span>";
+				html += '\n'; // here to get clean code
+				if (newLevel > level) {
+					html += "<span id=\"ln" + std::to_string(line) + "\">";
 				}
 
-				if (styleIsUsed[styleCurrent] && acc[i + 1] != '\r' && acc[i + 1] != '\n') {
-					// We know it's the correct next style,
-					// but no (empty) span for an empty line
-					fprintf(fp, "<span class=\"S%0d\">", styleCurrent);
-					inStyleSpan = true;
-				}
+				if (LevelIsHeader(lvl)) {
+					AppendFoldHeader(html, line);
+					inFoldSpan = true;
+				} else
+					html += "&nbsp; ";
+				level = newLevel;
 			} else {
-				switch (ch) {
-				case '<':
-					fputs("&lt;", fp);
-					break;
-				case '>':
-					fputs("&gt;", fp);
-					break;
-				case '&':
-					fputs("&amp;", fp);
-					break;
-				default:
-					fputc(ch, fp);
-				}
-				column++;
+				html += '\n';
 			}
-		}
-
-		if (inStyleSpan) {
-			fputs("</span>", fp);
-		}
 
-		if (folding) {
-			while (level > 0) {
-				fprintf(fp, "</span>");
-				level--;
+			if (styleIsUsed[styleCurrent] && reader.CharAt(i + 1) != '\r' && reader.CharAt(i + 1) != '\n') {
+				// We know it's the correct next style,
+				// but no (empty) span for an empty line
+				html += "<span class=\"S" + std::to_string(styleCurrent) + "\">";
+				inStyleSpan = true;
 			}
-		}
-
-		if (!wysiwyg) {
-			fputs("</pre>", fp);
 		} else {
-			fputs("</span>", fp);
+			switch (ch) {
+			case '<':
+				html += "&lt;";
+				column++;
+				break;
+			case '>':
+				html += "&gt;";
+				column++;
+				break;
+			case '&':
+				html += "&amp;";
+				column++;
+				break;
+			default: {
+					// Copy the characters up to the next one needing attention in one piece
+					SA::Position endPlain = i + 1;
+					while (endPlain < runEnd && IsPlainHTML(reader.CharAt(endPlain)))
+						endPlain++;
+					html += reader.Range(i, endPlain);
+					column += static_cast<int>(endPlain - i);
+					i = endPlain - 1;
+				}
+			}
 		}
+	}
+
+	if (inStyleSpan) {
+		html += "</span>";
+	}
 
-		fputs("\n</body>\n</html>\n", fp);
-		if (fclose(fp) != 0) {
-			failedWrite = true;
+	if (folding) {
+		while (level > 0) {
+			html += "</span>";
+			level--;
 		}
 	}
-	if (failedWrite) {
-		FailedSaveMessageBox(saveName);
+
+	if (!wysiwyg) {
+		html += "</pre>";
+	} else {
+		html += "</span>";
 	}
+
+	html += "\n</body>\n</html>\n";
+	return html;
 }
 
+}
+
+void SciTEBase::SaveToHTML(const FilePath &saveName, SaveFlags sf) {
+	RemoveFindMarks();
+	wEditor.ColouriseAll();
+	const int folding = props.GetInt("export.html.folding", 0);
+	std::unique_ptr<HTMLGenerator> generator = std::make_unique<HTMLGenerator>(wEditor, folding);
+	generator->tabSize = props.GetInt("tabsize");
+	if (generator->tabSize == 0)
+		generator->tabSize = 4;
+	generator->wysiwyg = props.GetInt("export.html.wysiwyg", 1);
+	generator->tabs = props.GetInt("export.html.tabs", 0);
+	generator->onlyStylesUsed = props.GetInt("export.html.styleused", 0);
+	if (props.GetInt("export.html.title.fullpath", 0))
+		generator->title = filePath.AsUTF8();
+	else
+		generator->title = filePath.Name().AsUTF8();
+	generator->isUTF8 = codePage == SA::CpUtf8;
+
+	const std::string sval = props.GetExpandedString("font.monospace");
+	const StyleDefinition sdmono(sval.c_str());
+	for (int istyle = 0; istyle <= StyleMax; istyle++) {
+		StyleDefinition sd = StyleDefinitionFor(istyle);
+		if (CurrentBufferConst()->useMonoFont && sd.font.length() && sdmono.font.length()) {
+			sd.font = sdmono.font;
+			sd.size = sdmono.size;
+			sd.italics = sdmono.italics;
+			sd.weight = sdmono.weight;
+		}
+		generator->styleDefinitions.push_back(sd);
+	}
+
+	SaveExport(saveName, GUI_TEXT("wt"), std::move(generator), sf);
+}
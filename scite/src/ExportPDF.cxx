@@ -110,18 +110,17 @@ inline std::string getPDFRGB(const char *stylecolour) {
 	return ret;
 }
 
-void SciTEBase::SaveToPDF(const FilePath &saveName) {
+void SciTEBase::SaveToPDF(const FilePath &saveName, SaveFlags sf) {
 	// This class conveniently handles the tracking of PDF objects
 	// so that the cross-reference table can be built (PDF1.4Ref(p39))
-	// All writes to fp passes through a PDFObjectTracker object.
+	// All writes to the output pass through a PDFObjectTracker object.
 	class PDFObjectTracker {
 	private:
-		FILE *fp;
+		std::string &output;
 		std::vector<long> offsetList;
 	public:
 		int index;
-		explicit PDFObjectTracker(FILE *fp_) {
-			fp = fp_;
+		explicit PDFObjectTracker(std::string &output_) : output(output_) {
 			index = 1;
 		}
 		// Deleted so PDFObjectTracker objects can not be copied.
@@ -129,9 +128,8 @@ void SciTEBase::SaveToPDF(const FilePath &saveName) {
 		~PDFObjectTracker() {
 		}
 		void write(const char *objectData) {
-			const size_t length = strlen(objectData);
 			// note binary write used, open with "wb"
-			fwrite(objectData, sizeof(char), length, fp);
+			output += objectData;
 		}
 		void write(int objectData) {
 			char val[20];
@@ -141,7 +139,7 @@ void SciTEBase::SaveToPDF(const FilePath &saveName) {
 		// returns object number assigned to the supplied data
 		int add(const char *objectData) {
 			// save offset, then format and write object
-			offsetList.push_back(ftell(fp));
+			offsetList.push_back(static_cast<long>(output.length()));
 			write(index);
 			write(" 0 obj\n");
 			write(objectData);
@@ -152,7 +150,7 @@ void SciTEBase::SaveToPDF(const FilePath &saveName) {
 		long xref() {
 			char val[32] = "";
 			// xref start index and number of entries
-			const long xrefStart = ftell(fp);
+			const long xrefStart = static_cast<long>(output.length());
 			write("xref\n0 ");
 			write(index);
 			// a xref entry *must* be 20 bytes long (PDF1.4Ref(p64))
@@ -418,10 +416,66 @@ void SciTEBase::SaveToPDF(const FilePath &saveName) {
 			pageData += buffer;
 		}
 	};
-	PDFRender pr;
+	// Settings and style definitions are read on the GUI thread, then the output may be generated on a worker thread.
+	class PDFGenerator : public ExportGenerator {
+	public:
+		PDFRender pr;
+		int tabSize = PDF_TAB_DEFAULT;
+		explicit PDFGenerator(SA::ScintillaCall &sc) : ExportGenerator(sc, 0, -1, false) {
+		}
+		std::string Generate(const Worker *pWorker) override {
+			const SA::Position lengthDoc = reader.End();
+
+			// initialise PDF rendering
+			std::string output;
+			output.reserve(lengthDoc + lengthDoc / 4 + 4096);
+			PDFObjectTracker ot(output);
+			pr.oT = &ot;
+			pr.startPDF();
+
+			if (!lengthDoc) {	// enable zero length docs
+				pr.nextLine();
+			} else {
+				int lineIndex = 0;
+				for (SA::Position i = 0; i < lengthDoc; i++) {
+					const char ch = reader.CharAt(i);
+					const int style = reader.StyleAt(i);
+
+					if (ch == '\t') {
+						// expand tabs
+						int ts = tabSize - (lineIndex % tabSize);
+						lineIndex += ts;
+						for (; ts; ts--) {	// add ts count of spaces
+							pr.add(' ', style);	// add spaces
+						}
+					} else if (ch == '\r' || ch == '\n') {
+						if (ch == '\r' && reader.CharAt(i + 1) == '\n') {
+							i++;
+						}
+						if (pWorker && pWorker->Cancelling()) {
+							break;
+						}
+						// close and begin a newline...
+						pr.nextLine();
+						lineIndex = 0;
+					} else {
+						// write the character normally...
+						pr.add(ch, style);
+						lineIndex++;
+					}
+				}
+			}
+			// write required stuff and the PDF file
+			pr.endPDF();
+			pr.oT = nullptr;
+			return output;
+		}
+	};
 
 	RemoveFindMarks();
 	wEditor.ColouriseAll();
+	std::unique_ptr<PDFGenerator> generator = std::make_unique<PDFGenerator>(wEditor);
+	PDFRender &pr = generator->pr;
 	// read exporter flags
 	int tabSize = props.GetInt("tabsize", PDF_TAB_DEFAULT);
 	if (tabSize < 0) {
@@ -505,54 +559,7 @@ void SciTEBase::SaveToPDF(const FilePath &saveName) {
 		}
 	}
 
-	FILE *fp = saveName.Open(GUI_TEXT("wb"));
-	if (!fp) {
-		// couldn't open the file for saving, issue an error message
-		FailedSaveMessageBox(saveName);
-		return;
-	}
-	// initialise PDF rendering
-	PDFObjectTracker ot(fp);
-	pr.oT = &ot;
-	pr.startPDF();
-
-	// do here all the writing
-	const SA::Position lengthDoc = LengthDocument();
-	TextReader acc(wEditor);
-
-	if (!lengthDoc) {	// enable zero length docs
-		pr.nextLine();
-	} else {
-		int lineIndex = 0;
-		for (SA::Position i = 0; i < lengthDoc; i++) {
-			const char ch = acc[i];
-			const int style = acc.StyleAt(i);
-
-			if (ch == '\t') {
-				// expand tabs
-				int ts = tabSize - (lineIndex % tabSize);
-				lineIndex += ts;
-				for (; ts; ts--) {	// add ts count of spaces
-					pr.add(' ', style);	// add spaces
-				}
-			} else if (ch == '\r' || ch == '\n') {
-				if (ch == '\r' && acc[i + 1] == '\n') {
-					i++;
-				}
-				// close and begin a newline...
-				pr.nextLine();
-				lineIndex = 0;
-			} else {
-				// write the character normally...
-				pr.add(ch, style);
-				lineIndex++;
-			}
-		}
-	}
-	// write required stuff and close the PDF file
-	pr.endPDF();
-	if (fclose(fp) != 0) {
-		FailedSaveMessageBox(saveName);
-	}
+	generator->tabSize = tabSize;
+	SaveExport(saveName, GUI_TEXT("wb"), std::move(generator), sf);
 }
 
@@ -118,40 +118,57 @@ static std::string GetRTFStyleChange(const char *last, const char *current) { //
 	return delta;
 }
 
-void SciTEBase::SaveToStreamRTF(std::ostream &os, SA::Position start, SA::Position end) {
-	const SA::Position lengthDoc = LengthDocument();
-	if (end < 0)
-		end = lengthDoc;
-	RemoveFindMarks();
-	wEditor.ColouriseAll();
-
-	StyleDefinition defaultStyle = StyleDefinitionFor(StyleDefault);
+// Characters which are copied into the output unchanged.
+static constexpr bool IsPlainRTF(char ch, bool isUTF8) noexcept {
+	return ch != '{' && ch != '}' && ch != '\\' && ch != '\t' && ch != '\n' && ch != '\r' &&
+		!(isUTF8 && !IsASCII(ch));
+}
 
-	int tabSize = props.GetInt("export.rtf.tabsize", props.GetInt("tabsize"));
-	const int wysiwyg = props.GetInt("export.rtf.wysiwyg", 1);
-	std::string fontFace = props.GetExpandedString("export.rtf.font.face");
-	if (fontFace.length()) {
-		defaultStyle.font = fontFace;
-	} else if (defaultStyle.font.length() == 0) {
-		defaultStyle.font = RTF_FONTFACE;
+// Length of the UTF-8 character starting at position, invalid bytes are treated as
+// single characters like SCI_POSITIONAFTER.
+static SA::Position UTF8CharacterLength(const StyledTextReader &reader, SA::Position position) noexcept {
+	const unsigned char lead = reader.CharAt(position);
+	SA::Position widthCharacter = 1;
+	if (lead >= 0xC2 && lead < 0xE0)
+		widthCharacter = 2;
+	else if (lead >= 0xE0 && lead < 0xF0)
+		widthCharacter = 3;
+	else if (lead >= 0xF0 && lead < 0xF5)
+		widthCharacter = 4;
+	for (SA::Position trail = 1; trail < widthCharacter; trail++) {
+		const unsigned char ch = reader.CharAt(position + trail);
+		if (ch < 0x80 || ch >= 0xC0)
+			return 1;
 	}
-	const int fontSize = props.GetInt("export.rtf.font.size", 0);
-	if (fontSize > 0) {
-		defaultStyle.size = fontSize << 1;
-	} else if (defaultStyle.size == 0) {
-		defaultStyle.size = 10 << 1;
-	} else {
-		defaultStyle.size <<= 1;
+	return widthCharacter;
+}
+
+namespace {
+
+// Settings and style definitions are read on the GUI thread, then the output may be generated on a worker thread.
+class RTFGenerator : public ExportGenerator {
+public:
+	int tabSize = 4;
+	int wysiwyg = 1;
+	int tabs = 0;
+	bool isUTF8 = false;
+	unsigned int characterset = 0;
+	StyleDefinition defaultStyle;
+	std::vector<StyleDefinition> styleDefinitions;
+	RTFGenerator(SA::ScintillaCall &sc, SA::Position start, SA::Position end, const StyleDefinition &defaultStyle_) :
+		ExportGenerator(sc, start, end, false), defaultStyle(defaultStyle_) {
 	}
-	const bool isUTF8 = wEditor.CodePage() == SA::CpUtf8;
-	const unsigned int characterset = props.GetInt("character.set", static_cast<int>(SA::CharacterSet::Default));
-	const int tabs = props.GetInt("export.rtf.tabs", 0);
-	if (tabSize == 0)
-		tabSize = 4;
+	std::string Generate(const Worker *pWorker) override;
+};
+
+std::string RTFGenerator::Generate(const Worker *pWorker) {
+	const SA::Position start = reader.Start();
+	const SA::Position end = reader.End();
 
 	std::vector<std::string> styles;
 	std::vector<std::string> fonts;
 	std::vector<std::string> colors;
+	std::ostringstream os;
 	os << RTF_HEADEROPEN << RTF_FONTDEFOPEN;
 	fonts.push_back(defaultStyle.font);
 	os << "{\\f" << 0 << "\\fnil\\fcharset" << characterset << " " << defaultStyle.font.c_str() << ";}";
@@ -161,7 +178,7 @@ void SciTEBase::SaveToStreamRTF(std::ostream &os, SA::Position start, SA::Positi
 	for (int istyle = 0; istyle <= StyleMax; istyle++) {
 		std::ostringstream osStyle;
 
-		const StyleDefinition sd = StyleDefinitionFor(istyle);
+		const StyleDefinition &sd = styleDefinitions[istyle];
 
 		if (sd.specified != StyleDefinition::sdNone) {
 			size_t iFont = 0;
@@ -223,88 +240,131 @@ void SciTEBase::SaveToStreamRTF(std::ostream &os, SA::Position start, SA::Positi
 		       RTF_SETCOLOR "0" RTF_SETBACKGROUND "1"
 		       RTF_BOLD_OFF RTF_ITALIC_OFF;
 	std::string lastStyle = osStyleDefault.str();
+	std::string rtf = os.str();
+	rtf.reserve(rtf.length() + (end - start) + (end - start) / 8 + 1);
 	bool prevCR = false;
 	int styleCurrent = -1;
-	TextReader acc(wEditor);
 	int column = 0;
-	for (SA::Position iPos = start; iPos < end; iPos++) {
-		const char ch = acc[iPos];
-		int style = acc.StyleAt(iPos);
+	SA::Position iPos = start;
+	while (iPos < end) {
+		if (pWorker && pWorker->Cancelling()) {
+			return rtf;
+		}
+		const SA::Position runEnd = reader.StyleRunEnd(iPos, end);
+		int style = reader.StyleAt(iPos);
 		if (style > StyleMax)
 			style = 0;
 		if (style != styleCurrent) {
 			const std::string deltaStyle = GetRTFStyleChange(lastStyle.c_str(), styles[style].c_str());
 			lastStyle = styles[style];
-			if (!deltaStyle.empty())
-				os << deltaStyle;
+			rtf += deltaStyle;
 			styleCurrent = style;
 		}
-		if (ch == '{')
-			os << "\\{";
-		else if (ch == '}')
-			os << "\\}";
-		else if (ch == '\\')
-			os << "\\\\";
-		else if (ch == '\t') {
-			if (tabs) {
-				os << RTF_TAB;
-			} else {
-				const int ts = tabSize - (column % tabSize);
-				for (int itab = 0; itab < ts; itab++) {
-					os << ' ';
+		for (; iPos < runEnd; iPos++) {
+			const char ch = reader.CharAt(iPos);
+			if (ch == '{')
+				rtf += "\\{";
+			else if (ch == '}')
+				rtf += "\\}";
+			else if (ch == '\\')
+				rtf += "\\\\";
+			else if (ch == '\t') {
+				if (tabs) {
+					rtf += RTF_TAB;
+				} else {
+					const int ts = tabSize - (column % tabSize);
+					rtf.append(ts, ' ');
+					column += ts - 1;
 				}
-				column += ts - 1;
-			}
-		} else if (ch == '\n') {
-			if (!prevCR) {
-				os << RTF_EOLN;
+			} else if (ch == '\n') {
+				if (!prevCR) {
+					rtf += RTF_EOLN;
+					column = -1;
+				}
+			} else if (ch == '\r') {
+				rtf += RTF_EOLN;
 				column = -1;
-			}
-		} else if (ch == '\r') {
-			os << RTF_EOLN;
-			column = -1;
-		} else if (isUTF8 && !IsASCII(ch)) {
-			const SA::Position nextPosition = wEditor.PositionAfter(iPos);
-			wEditor.SetTarget(SA::Range(iPos, nextPosition));
-			char u8Char[5] = "";
-			wEditor.TargetAsUTF8(u8Char);
-			const unsigned int u32 = UTF32Character(u8Char);
-			if (u32 < 0x10000) {
-				os << "\\u" << static_cast<short>(u32) << "?";
+			} else if (isUTF8 && !IsASCII(ch)) {
+				const SA::Position nextPosition = iPos + UTF8CharacterLength(reader, iPos);
+				char u8Char[5] = "";
+				const std::string_view u8 = reader.Range(iPos, nextPosition);
+				u8.copy(u8Char, u8.length());
+				const unsigned int u32 = UTF32Character(u8Char);
+				if (u32 < 0x10000) {
+					rtf += "\\u" + std::to_string(static_cast<short>(u32)) + "?";
+				} else {
+					rtf += "\\u" + std::to_string(static_cast<short>(((u32 - 0x10000) >> 10) + 0xD800)) + "?";
+					rtf += "\\u" + std::to_string(static_cast<short>((u32 & 0x3ff) + 0xDC00)) + "?";
+				}
+				iPos = nextPosition - 1;
 			} else {
-				os << "\\u" << static_cast<short>(((u32 - 0x10000) >> 10) + 0xD800) << "?";
-				os << "\\u" << static_cast<short>((u32 & 0x3ff) + 0xDC00) << "?";
+				// Copy the characters up to the next one needing attention in one piece
+				SA::Position endPlain = iPos + 1;
+				while (endPlain < runEnd && IsPlainRTF(reader.CharAt(endPlain), isUTF8))
+					endPlain++;
+				rtf += reader.Range(iPos, endPlain);
+				column += static_cast<int>(endPlain - iPos - 1);
+				iPos = endPlain - 1;
 			}
-			iPos = nextPosition - 1;
-		} else {
-			os << ch;
+			column++;
+			prevCR = ch == '\r';
 		}
-		column++;
-		prevCR = ch == '\r';
 	}
-	os << RTF_BODYCLOSE;
+	rtf += RTF_BODYCLOSE;
+	return rtf;
 }
 
-void SciTEBase::SaveToRTF(const FilePath &saveName, SA::Position start, SA::Position end) {
-	FILE *fp = saveName.Open(GUI_TEXT("wt"));
-	bool failedWrite = fp == nullptr;
-	if (fp) {
-		try {
-			std::ostringstream oss;
-			SaveToStreamRTF(oss, start, end);
-			const std::string rtf = oss.str();
-			if (fwrite(rtf.c_str(), 1, rtf.length(), fp) != rtf.length()) {
-				failedWrite = true;
-			}
-			if (fclose(fp) != 0) {
-				failedWrite = true;
-			}
-		} catch (std::exception &) {
-			failedWrite = true;
-		}
+}
+
+std::unique_ptr<ExportGenerator> SciTEBase::RTFGeneratorFromRange(SA::Position start, SA::Position end) {
+	RemoveFindMarks();
+	wEditor.ColouriseAll();
+
+	StyleDefinition defaultStyle = StyleDefinitionFor(StyleDefault);
+
+	int tabSize = props.GetInt("export.rtf.tabsize", props.GetInt("tabsize"));
+	std::string fontFace = props.GetExpandedString("export.rtf.font.face");
+	if (fontFace.length()) {
+		defaultStyle.font = fontFace;
+	} else if (defaultStyle.font.length() == 0) {
+		defaultStyle.font = RTF_FONTFACE;
 	}
-	if (failedWrite) {
-		FailedSaveMessageBox(saveName);
+	const int fontSize = props.GetInt("export.rtf.font.size", 0);
+	if (fontSize > 0) {
+		defaultStyle.size = fontSize << 1;
+	} else if (defaultStyle.size == 0) {
+		defaultStyle.size = 10 << 1;
+	} else {
+		defaultStyle.size <<= 1;
+	}
+	if (tabSize == 0)
+		tabSize = 4;
+
+	std::unique_ptr<RTFGenerator> generator = std::make_unique<RTFGenerator>(wEditor, start, end, defaultStyle);
+	generator->tabSize = tabSize;
+	generator->wysiwyg = props.GetInt("export.rtf.wysiwyg", 1);
+	generator->tabs = props.GetInt("export.rtf.tabs", 0);
+	generator->isUTF8 = wEditor.CodePage() == SA::CpUtf8;
+	generator->characterset = props.GetInt("character.set", static_cast<int>(SA::CharacterSet::Default));
+	for (int istyle = 0; istyle <= StyleMax; istyle++) {
+		generator->styleDefinitions.push_back(StyleDefinitionFor(istyle));
 	}
+	return generator;
 }
 
+std::string SciTEBase::RTFFromRange(SA::Position start, SA::Position end) {
+	return RTFGeneratorFromRange(start, end)->Generate(nullptr);
+}
+
+void SciTEBase::SaveToStreamRTF(std::ostream &os, SA::Position start, SA::Position end) {
+	const std::string rtf = RTFFromRange(start, end);
+	os.write(rtf.data(), rtf.length());
+}
+
+void SciTEBase::SaveToRTF(const FilePath &saveName, SA::Position start, SA::Position end, SaveFlags sf) {
+	try {
+		SaveExport(saveName, GUI_TEXT("wt"), RTFGeneratorFromRange(start, end), sf);
+	} catch (std::exception &) {
+		FailedSaveMessageBox(saveName);
+	}
+}
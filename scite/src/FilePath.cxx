@@ -6,6 +6,7 @@
 // The License.txt file describes the conditions under which this software may be distributed.
 
 #include <cstdlib>
+#include <cstdint>
 #include <cstring>
 #include <cstdio>
 #include <ctime>
@@ -23,6 +24,7 @@
 
 #include <unistd.h>
 #include <dirent.h>
+#include <sys/mman.h>
 
 #endif
 
@@ -265,6 +267,10 @@ static int unlink(const wchar_t *filename) noexcept {
 	return _wunlink(filename);
 }
 
+static int rename(const wchar_t *oldname, const wchar_t *newname) noexcept {
+	return _wrename(oldname, newname);
+}
+
 static int access(const wchar_t *path, int mode) noexcept {
 	return _waccess(path, mode);
 }
@@ -454,6 +460,14 @@ void FilePath::Remove() const noexcept {
 	unlink(AsInternal());
 }
 
+bool FilePath::Rename(const FilePath &newName) const noexcept {
+#ifdef WIN32
+	// Windows will not rename over an existing file
+	unlink(newName.AsInternal());
+#endif
+	return rename(AsInternal(), newName.AsInternal()) == 0;
+}
+
 #ifndef R_OK
 // Microsoft does not define the constants used to call access
 #define R_OK 4
@@ -672,6 +686,73 @@ bool FilePath::CaseSensitive() noexcept {
 #endif
 }
 
+bool SeekFile(FILE *fp, long long position) noexcept {
+#if defined(__unix__) || defined(__APPLE__)
+	return fseeko(fp, static_cast<off_t>(position), SEEK_SET) == 0;
+#else
+	return _fseeki64(fp, position, SEEK_SET) == 0;
+#endif
+}
+
+FileMapping::FileMapping(FILE *fp_) noexcept : fp(fp_) {
+#if defined(__unix__) || defined(__APPLE__)
+	const int fd = fileno(fp);
+	struct stat statusFile;
+	if ((fstat(fd, &statusFile) == -1) || (statusFile.st_size <= 0) ||
+		(static_cast<unsigned long long>(statusFile.st_size) > SIZE_MAX))
+		return;
+	const size_t sizeFile = static_cast<size_t>(statusFile.st_size);
+	void *mapped = mmap(nullptr, sizeFile, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (mapped == MAP_FAILED)
+		return;
+#if defined(MADV_SEQUENTIAL)
+	madvise(mapped, sizeFile, MADV_SEQUENTIAL);
+#endif
+	data = static_cast<const char *>(mapped);
+	size = sizeFile;
+#else
+	HANDLE hFile = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(fp)));
+	LARGE_INTEGER liSize;
+	if ((hFile == INVALID_HANDLE_VALUE) || !::GetFileSizeEx(hFile, &liSize) ||
+		(liSize.QuadPart <= 0) || (static_cast<unsigned long long>(liSize.QuadPart) > SIZE_MAX))
+		return;
+	hMapping = ::CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!hMapping)
+		return;
+	data = static_cast<const char *>(::MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0));
+	if (data) {
+		size = static_cast<size_t>(liSize.QuadPart);
+	}
+#endif
+}
+
+FileMapping::~FileMapping() {
+#if defined(__unix__) || defined(__APPLE__)
+	if (data) {
+		munmap(const_cast<char *>(data), size);
+	}
+#else
+	if (data) {
+		::UnmapViewOfFile(data);
+	}
+	if (hMapping) {
+		::CloseHandle(hMapping);
+	}
+#endif
+}
+
+size_t FileMapping::FileSize() const noexcept {
+#if defined(__unix__) || defined(__APPLE__)
+	struct stat statusFile;
+	if ((fstat(fileno(fp), &statusFile) == -1) || (statusFile.st_size < 0))
+		return 0;
+	return std::min(static_cast<size_t>(statusFile.st_size), size);
+#else
+	// Windows does not allow a mapped file to be truncated
+	return size;
+#endif
+}
+
 std::string CommandExecute(const GUI::gui_char *command, const GUI::gui_char *directoryForRun) {
 	std::string output;
 #ifdef _WIN32
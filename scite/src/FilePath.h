@@ -64,6 +64,7 @@ public:
 	FILE *Open(const GUI::gui_char *mode) const noexcept;
 	std::string Read() const;
 	void Remove() const noexcept;
+	bool Rename(const FilePath &newName) const noexcept;
 	time_t ModifiedTime() const;
 	long long GetFileLength() const noexcept;
 	bool Exists() const noexcept;
@@ -72,6 +73,39 @@ public:
 	static bool CaseSensitive() noexcept;
 };
 
+/// Positions a file opened by FilePath::Open, including beyond 2GB.
+bool SeekFile(FILE *fp, long long position) noexcept;
+
+/// Read-only view of the whole contents of an open file mapped into memory.
+/// Invalid when the file is empty or can not be mapped.
+class FileMapping {
+	FILE *fp;
+	const char *data = nullptr;
+	size_t size = 0;
+#if !(defined(__unix__) || defined(__APPLE__))
+	void *hMapping = nullptr;
+#endif
+public:
+	explicit FileMapping(FILE *fp) noexcept;
+	FileMapping(const FileMapping &) = delete;
+	FileMapping(FileMapping &&) = delete;
+	FileMapping &operator=(const FileMapping &) = delete;
+	FileMapping &operator=(FileMapping &&) = delete;
+	~FileMapping();
+	bool IsValid() const noexcept {
+		return data != nullptr;
+	}
+	const char *Data() const noexcept {
+		return data;
+	}
+	size_t Size() const noexcept {
+		return size;
+	}
+	// The current length of the file which is less than Size when it has been truncated.
+	// Reading the mapping past the end of the file raises SIGBUS on Unix.
+	size_t FileSize() const noexcept;
+};
+
 std::string CommandExecute(const GUI::gui_char *command, const GUI::gui_char *directoryForRun);
 
 #endif
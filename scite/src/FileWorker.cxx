@@ -11,7 +11,9 @@
 #include <cstdio>
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <algorithm>
 #include <memory>
 #include <chrono>
 #include <atomic>
@@ -19,12 +21,16 @@
 
 #include "ILoader.h"
 
+#include "ScintillaTypes.h"
+#include "ScintillaCall.h"
+
 #include "GUI.h"
 
 #include "FilePath.h"
 #include "Cookie.h"
 #include "Worker.h"
 #include "FileWorker.h"
+#include "StyleWriter.h"
 #include "Utf8_16.h"
 
 constexpr double timeBetweenProgress = 0.4;
@@ -41,14 +47,72 @@ double FileWorker::Duration() noexcept {
 }
 
 FileLoader::FileLoader(WorkerListener *pListener_, ILoader *pLoader_, const FilePath &path_, size_t size_, FILE *fp_) :
-	FileWorker(pListener_, path_, size_, fp_), pLoader(pLoader_), readSoFar(0), unicodeMode(uni8Bit) {
+	FileWorker(pListener_, path_, size_, fp_), pLoader(pLoader_), readSoFar(0), unicodeMode(uni8Bit), mapFile(false),
+	firstInvalid(Utf8_16::k_noInvalid) {
 	SetSizeJob(size);
 }
 
 FileLoader::~FileLoader() {
 }
 
+// Load directly from a memory mapping of the file, avoiding the copies through
+// a read buffer and the transcoder. Only used for 8-bit and UTF-8 files so
+// returns false without consuming any data for UTF-16 files or when the file
+// can not be mapped.
+bool FileLoader::LoadMapped() {
+	const FileMapping mapping(fp);
+	if (!mapping.IsValid())
+		return false;
+	std::string_view text(mapping.Data(), mapping.Size());
+	for (const Utf8_16::encodingType encoding : { Utf8_16::eUtf16BigEndian, Utf8_16::eUtf16LittleEndian }) {
+		if ((text.length() > 1) &&
+			(static_cast<unsigned char>(text[0]) == Utf8_16::k_Boms[encoding][0]) &&
+			(static_cast<unsigned char>(text[1]) == Utf8_16::k_Boms[encoding][1]))
+			return false;
+	}
+	// Check the first two lines for coding cookies
+	const UniMode umCodingCookie = CodingCookieValue(text.substr(0, blockSize));
+	const std::string_view bomUTF8(reinterpret_cast<const char *>(Utf8_16::k_Boms[Utf8_16::eUtf8]), 3);
+	if (text.substr(0, bomUTF8.length()) == bomUTF8) {
+		unicodeMode = uniUTF8;
+		text.remove_prefix(bomUTF8.length());
+	} else {
+		unicodeMode = umCodingCookie;
+	}
+	// Larger blocks than when reading as each block is added without copying
+	constexpr size_t mappedBlockSize = blockSize * 64;
+	while (!text.empty() && (err == 0) && (!Cancelling())) {
+		GUI::SleepMilliseconds(sleepTime);
+		const size_t lenBlock = std::min(text.length(), mappedBlockSize);
+		const size_t offset = text.data() - mapping.Data();
+		if (mapping.FileSize() < offset + lenBlock) {
+			// Truncated while loading, such as by log rotation with copytruncate, so read
+			// whatever remains as reading the mapping past the end of the file would crash
+			std::vector<char> data(blockSize);
+			size_t lenRead = SeekFile(fp, offset) ? fread(data.data(), 1, blockSize, fp) : 0;
+			while ((lenRead > 0) && (err == 0) && (!Cancelling())) {
+				err = pLoader->AddData(data.data(), lenRead);
+				IncrementProgress(lenRead);
+				lenRead = fread(data.data(), 1, blockSize, fp);
+			}
+			break;
+		}
+		err = pLoader->AddData(text.data(), lenBlock);
+		IncrementProgress(lenBlock);
+		if (et.Duration() > nextProgress) {
+			nextProgress = et.Duration() + timeBetweenProgress;
+			pListener->PostOnMainThread(WORK_FILEPROGRESS, this);
+		}
+		text.remove_prefix(lenBlock);
+	}
+	return true;
+}
+
 void FileLoader::Execute() {
+	if (fp && mapFile && LoadMapped()) {
+		fclose(fp);
+		fp = nullptr;
+	}
 	if (fp) {
 		Utf8_16_Read convert;
 		std::vector<char> data(blockSize);
@@ -78,6 +142,7 @@ void FileLoader::Execute() {
 		fp = nullptr;
 		unicodeMode = static_cast<UniMode>(
 				      static_cast<int>(convert.getEncoding()));
+		firstInvalid = convert.getFirstInvalid();
 		// Check the first two lines for coding cookies
 		if (unicodeMode == uni8Bit) {
 			unicodeMode = umCodingCookie;
@@ -96,7 +161,7 @@ void FileLoader::Cancel() {
 FileStorer::FileStorer(WorkerListener *pListener_, const char *documentBytes_, const FilePath &path_,
 		       size_t size_, FILE *fp_, UniMode unicodeMode_, bool visibleProgress_) :
 	FileWorker(pListener_, path_, size_, fp_), documentBytes(documentBytes_), writtenSoFar(0),
-	unicodeMode(unicodeMode_), visibleProgress(visibleProgress_) {
+	unicodeMode(unicodeMode_), visibleProgress(visibleProgress_), firstInvalid(Utf8_16::k_noInvalid) {
 	SetSizeJob(size);
 }
 
@@ -143,6 +208,7 @@ void FileStorer::Execute() {
 				break;
 			}
 		}
+		firstInvalid = convert.getFirstInvalid();
 		if (convert.fclose() != 0) {
 			err = 1;
 		}
@@ -154,3 +220,49 @@ void FileStorer::Execute() {
 void FileStorer::Cancel() {
 	FileWorker::Cancel();
 }
+
+FileExporter::FileExporter(WorkerListener *pListener_, std::unique_ptr<ExportGenerator> &&generator_, const FilePath &path_, FILE *fp_) :
+	FileWorker(pListener_, path_, 0, fp_), generator(std::move(generator_)) {
+	// Generating is counted like writing the source
+	SetSizeJob(2 * generator->SizeSource());
+}
+
+FileExporter::~FileExporter() {
+}
+
+void FileExporter::Execute() {
+	if (fp) {
+		std::string output;
+		try {
+			output = generator->Generate(this);
+		} catch (std::exception &) {
+			err = 1;
+		}
+		generator.reset();
+		size = output.length();
+		const size_t sizeGenerate = SizeJob() / 2;
+		IncrementProgress(sizeGenerate);
+		SetSizeJob(sizeGenerate + size);
+		size_t grabSize;
+		for (size_t i = 0; i < size && !err && !Cancelling(); i += grabSize) {
+			GUI::SleepMilliseconds(sleepTime);
+			grabSize = std::min(size - i, blockSize);
+			const size_t written = fwrite(output.data() + i, 1, grabSize, fp);
+			IncrementProgress(grabSize);
+			if (et.Duration() > nextProgress) {
+				nextProgress = et.Duration() + timeBetweenProgress;
+				pListener->PostOnMainThread(WORK_FILEPROGRESS, this);
+			}
+			if (written != grabSize) {
+				err = 1;
+				break;
+			}
+		}
+		if (fclose(fp) != 0) {
+			err = 1;
+		}
+		fp = nullptr;
+	}
+	SetCompleted();
+	pListener->PostOnMainThread(WORK_FILEEXPORTED, this);
+}
@@ -35,9 +35,12 @@ public:
 	ILoader *pLoader;
 	size_t readSoFar;
 	UniMode unicodeMode;
+	bool mapFile;
+	size_t firstInvalid;	// Offset of the first unpaired surrogate in a UTF-16 file
 
 	FileLoader(WorkerListener *pListener_, ILoader *pLoader_, const FilePath &path_, size_t size_, FILE *fp_);
 	~FileLoader() override;
+	bool LoadMapped();
 	void Execute() override;
 	void Cancel() override;
 	bool IsLoading() const noexcept override {
@@ -51,6 +54,7 @@ public:
 	size_t writtenSoFar;
 	UniMode unicodeMode;
 	bool visibleProgress;
+	size_t firstInvalid;	// Offset of the first malformed UTF-8 written to a UTF-16 file
 
 	FileStorer(WorkerListener *pListener_, const char *documentBytes_, const FilePath &path_,
 		   size_t size_, FILE *fp_, UniMode unicodeMode_, bool visibleProgress_);
@@ -62,10 +66,26 @@ public:
 	}
 };
 
+class ExportGenerator;
+
+// Generates the output of an exporter then writes it.
+class FileExporter : public FileWorker {
+public:
+	std::unique_ptr<ExportGenerator> generator;
+
+	FileExporter(WorkerListener *pListener_, std::unique_ptr<ExportGenerator> &&generator_, const FilePath &path_, FILE *fp_);
+	~FileExporter() override;
+	void Execute() override;
+	bool IsLoading() const noexcept override {
+		return false;
+	}
+};
+
 enum {
 	WORK_FILEREAD = 1,
 	WORK_FILEWRITTEN = 2,
 	WORK_FILEPROGRESS = 3,
+	WORK_FILEEXPORTED = 4,
 	WORK_PLATFORM = 100
 };
 
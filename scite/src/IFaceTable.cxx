@@ -2316,6 +2316,9 @@ static IFaceConstant ifaceConstants[] = {
 	{"SCI_GETPASTECONVERTENDINGS",2468},
 	{"SCI_GETPHASESDRAW",2673},
 	{"SCI_GETPOSITIONCACHE",2515},
+	{"SCI_GETPOSITIONCACHEHITS",2752},
+	{"SCI_GETPOSITIONCACHEMISSES",2753},
+	{"SCI_GETPOSITIONCACHESHARED",2751},
 	{"SCI_GETPRIMARYSTYLEFROMSTYLE",4028},
 	{"SCI_GETPRINTCOLOURMODE",2149},
 	{"SCI_GETPRINTMAGNIFICATION",2147},
@@ -2502,6 +2505,7 @@ static IFaceConstant ifaceConstants[] = {
 	{"SCI_SETPASTECONVERTENDINGS",2467},
 	{"SCI_SETPHASESDRAW",2674},
 	{"SCI_SETPOSITIONCACHE",2514},
+	{"SCI_SETPOSITIONCACHESHARED",2750},
 	{"SCI_SETPRINTCOLOURMODE",2148},
 	{"SCI_SETPRINTMAGNIFICATION",2146},
 	{"SCI_SETPRINTWRAPMODE",2406},
@@ -2840,6 +2844,7 @@ static IFaceConstant ifaceConstants[] = {
 	{"SC_FOLDLEVELWHITEFLAG",0x1000},
 	{"SC_FONT_SIZE_MULTIPLIER",100},
 	{"SC_IDLESTYLING_AFTERVISIBLE",2},
+	{"SC_IDLESTYLING_AHEAD",4},
 	{"SC_IDLESTYLING_ALL",3},
 	{"SC_IDLESTYLING_NONE",0},
 	{"SC_IDLESTYLING_TOVISIBLE",1},
@@ -3483,6 +3488,9 @@ static IFaceProperty ifaceProperties[] = {
 	{"PasteConvertEndings", 2468, 2467, iface_bool, iface_void},
 	{"PhasesDraw", 2673, 2674, iface_int, iface_void},
 	{"PositionCache", 2515, 2514, iface_int, iface_void},
+	{"PositionCacheHits", 2752, 0, iface_position, iface_void},
+	{"PositionCacheMisses", 2753, 0, iface_position, iface_void},
+	{"PositionCacheShared", 2751, 2750, iface_position, iface_void},
 	{"PrimaryStyleFromStyle", 4028, 0, iface_int, iface_int},
 	{"PrintColourMode", 2149, 2148, iface_int, iface_void},
 	{"PrintMagnification", 2147, 2146, iface_int, iface_void},
@@ -3572,8 +3580,8 @@ static IFaceProperty ifaceProperties[] = {
 
 enum {
 	ifaceFunctionCount = 313,
-	ifaceConstantCount = 2881,
-	ifacePropertyCount = 243
+	ifaceConstantCount = 2886,
+	ifacePropertyCount = 246
 };
 
 //--Autogenerated
@@ -12,8 +12,12 @@
 #include <string>
 #include <string_view>
 #include <vector>
+#include <unordered_map>
+#include <algorithm>
 #include <chrono>
 
+#include "Scintilla.h"
+
 #include "ScintillaTypes.h"
 #include "ScintillaMessages.h"
 #include "ScintillaCall.h"
@@ -103,6 +107,7 @@ LuaExtension &LuaExtension::Instance() {
 static ExtensionAPI::Pane check_pane_object(lua_State *L, int index);
 static void push_pane_object(lua_State *L, ExtensionAPI::Pane p) noexcept;
 static int iface_function_helper(lua_State *L, const IFaceFunction &func);
+static int iface_function_helper(lua_State *L, ExtensionAPI::Pane p, const IFaceFunction &func);
 
 inline bool IFaceTypeIsScriptable(IFaceType t, int index) noexcept {
 	return t < iface_stringresult || (index==1 && t == iface_stringresult);
@@ -219,6 +224,30 @@ static void *checkudata(lua_State *L, int ud, const char *tname) noexcept {
 	return nullptr;
 }
 
+// Finds the function or property accessor for a message number. The map is built on
+// first use as the linear scans were too slow for scripts calling scite.SendEditor in loops.
+static const IFaceFunction *FunctionForMessage(int message) {
+	static const std::unordered_map<int, IFaceFunction> functionsByMessage = [] {
+		std::unordered_map<int, IFaceFunction> functions;
+		// emplace does not replace so the first match is retained as the scans did
+		for (int funcIdx = 0; funcIdx < IFaceTable::functionCount; ++funcIdx) {
+			functions.emplace(IFaceTable::functions[funcIdx].value, IFaceTable::functions[funcIdx]);
+		}
+		for (int propIdx = 0; propIdx < IFaceTable::propertyCount; ++propIdx) {
+			const IFaceProperty &prop = IFaceTable::properties[propIdx];
+			if (prop.getter)
+				functions.emplace(prop.getter, prop.GetterFunction());
+			if (prop.setter)
+				functions.emplace(prop.setter, prop.SetterFunction());
+		}
+		return functions;
+	}();
+	const std::unordered_map<int, IFaceFunction>::const_iterator it = functionsByMessage.find(message);
+	if ((it == functionsByMessage.end()) || (it->second.value == 0))
+		return nullptr;
+	return &it->second;
+}
+
 static int cf_scite_send(lua_State *L) {
 	// This is reinstated as a replacement for the old <pane>:send, which was removed
 	// due to safety concerns.  Is now exposed as scite.SendEditor / scite.SendOutput.
@@ -232,29 +261,10 @@ static int cf_scite_send(lua_State *L) {
 	lua_pushvalue(L, paneIndex);
 	lua_replace(L, 1);
 
-	IFaceFunction func = { "", 0, iface_void, {iface_void, iface_void} };
-	for (int funcIdx = 0; funcIdx < IFaceTable::functionCount; ++funcIdx) {
-		if (IFaceTable::functions[funcIdx].value == message) {
-			func = IFaceTable::functions[funcIdx];
-			break;
-		}
-	}
-
-	if (func.value == 0) {
-		for (int propIdx = 0; propIdx < IFaceTable::propertyCount; ++propIdx) {
-			if (IFaceTable::properties[propIdx].getter == message) {
-				func = IFaceTable::properties[propIdx].GetterFunction();
-				break;
-			} else if (IFaceTable::properties[propIdx].setter == message) {
-				func = IFaceTable::properties[propIdx].SetterFunction();
-				break;
-			}
-		}
-	}
-
-	if (func.value != 0) {
-		if (IFaceFunctionIsScriptable(func)) {
-			return iface_function_helper(L, func);
+	const IFaceFunction *func = FunctionForMessage(message);
+	if (func) {
+		if (IFaceFunctionIsScriptable(*func)) {
+			return iface_function_helper(L, *func);
 		} else {
 			raise_error(L, "Cannot call send for this function: not scriptable.");
 			return 0;
@@ -336,6 +346,11 @@ static int cf_scite_strip_value(lua_State *L) {
 	return 1;
 }
 
+static void check_pane_accessible(lua_State *L, ExtensionAPI::Pane p) {
+	if ((p == ExtensionAPI::paneEditor) && (curBufferIndex < 0))
+		raise_error(L, "Editor pane is not accessible at this time.");
+}
+
 static ExtensionAPI::Pane check_pane_object(lua_State *L, int index) {
 	ExtensionAPI::Pane *pPane = static_cast<ExtensionAPI::Pane *>(checkudata(L, index, "SciTE_MT_Pane"));
 
@@ -348,9 +363,7 @@ static ExtensionAPI::Pane check_pane_object(lua_State *L, int index) {
 	}
 
 	if (pPane) {
-		if ((*pPane == ExtensionAPI::paneEditor) && (curBufferIndex < 0))
-			raise_error(L, "Editor pane is not accessible at this time.");
-
+		check_pane_accessible(L, *pPane);
 		return *pPane;
 	}
 
@@ -365,24 +378,69 @@ static ExtensionAPI::Pane check_pane_object(lua_State *L, int index) {
 	return ExtensionAPI::paneOutput; // this line never reached
 }
 
+// Limits a range passed from a script to the document.
+static SA::Range checked_range(lua_State *L, SA::ScintillaCall &sc, const char *method) {
+	if (lua_gettop(L) < 3) {
+		lua_pushfstring(L, "Not enough arguments for <pane>:%s", method);
+		raise_error(L);
+	}
+	const SA::Position cpMin = luaL_checkinteger(L, 2);
+	const SA::Position cpMax = luaL_checkinteger(L, 3);
+	if (cpMax < 0) {
+		lua_pushfstring(L, "Invalid argument 2 for <pane>:%s.  Positive number or zero expected.", method);
+		raise_error(L);
+	}
+	const SA::Position length = sc.Length();
+	const SA::Position end = std::min(cpMax, length);
+	const SA::Position start = std::clamp<SA::Position>(cpMin, 0, end);
+	return SA::Range(start, end);
+}
+
 static int cf_pane_textrange(lua_State *L) {
 	const ExtensionAPI::Pane p = check_pane_object(L, 1);
+	SA::ScintillaCall &sc = host->PaneCaller(p);
+	const SA::Range range = checked_range(L, sc, "textrange");
+	const SA::Position lengthRange = range.end - range.start;
+	// Copied directly from the document into the Lua string
+	const char *text = lengthRange ? static_cast<const char *>(sc.RangePointer(range.start, lengthRange)) : "";
+	lua_pushlstring(L, text, lengthRange);
+	return 1;
+}
 
-	if (lua_gettop(L) >= 3) {
-		const SA::Position cpMin = luaL_checkinteger(L, 2);
-		const SA::Position cpMax = luaL_checkinteger(L, 3);
-		if (cpMax >= 0) {
-			std::string range = host->Range(p, SA::Range(cpMin, cpMax));
-			lua_pushstring(L, range.c_str());
-			return 1;
-		} else {
-			raise_error(L, "Invalid argument 2 for <pane>:textrange.  Positive number or zero expected.");
-		}
-	} else {
-		raise_error(L, "Not enough arguments for <pane>:textrange");
-	}
+static int cf_pane_stylerange(lua_State *L) {
+	const ExtensionAPI::Pane p = check_pane_object(L, 1);
+	SA::ScintillaCall &sc = host->PaneCaller(p);
+	const SA::Range range = checked_range(L, sc, "stylerange");
+	const SA::Position lengthRange = range.end - range.start;
+	// GETSTYLEDTEXT interleaves characters and styles and adds two terminating NULs
+	std::vector<char> styledText(2 * lengthRange + 2);
+	Sci_TextRange tr;
+	tr.chrg.cpMin = static_cast<Sci_PositionCR>(range.start);
+	tr.chrg.cpMax = static_cast<Sci_PositionCR>(range.end);
+	tr.lpstrText = styledText.data();
+	sc.GetStyledText(&tr);
+	luaL_Buffer b;
+	char *styles = luaL_buffinitsize(L, &b, lengthRange);
+	for (SA::Position i = 0; i < lengthRange; i++) {
+		styles[i] = styledText[2 * i + 1];
+	}
+	luaL_pushresultsize(&b, lengthRange);
+	return 1;
+}
 
-	return 0;
+static int cf_pane_linestarts(lua_State *L) {
+	const ExtensionAPI::Pane p = check_pane_object(L, 1);
+	SA::ScintillaCall &sc = host->PaneCaller(p);
+	const SA::Line lineCount = sc.LineCount();
+	const SA::Line lineFirst = std::max<SA::Line>(luaL_optinteger(L, 2, 0), 0);
+	const SA::Line lineLast = std::min<SA::Line>(luaL_optinteger(L, 3, lineCount - 1), lineCount - 1);
+	const int countLines = lineLast >= lineFirst ? static_cast<int>(lineLast - lineFirst + 1) : 0;
+	lua_createtable(L, countLines, 0);
+	for (int i = 0; i < countLines; i++) {
+		lua_pushinteger(L, sc.LineStart(lineFirst + i));
+		lua_rawseti(L, -2, i + 1);
+	}
+	return 1;
 }
 
 static int cf_pane_insert(lua_State *L) {
@@ -867,8 +925,11 @@ static bool CallNamedFunction(const char *name, int numberArg, int numberArg2) {
 }
 
 static int iface_function_helper(lua_State *L, const IFaceFunction &func) {
-	const ExtensionAPI::Pane p = check_pane_object(L, 1);
+	return iface_function_helper(L, check_pane_object(L, 1), func);
+}
 
+// Arguments start at index 2 whatever is at index 1.
+static int iface_function_helper(lua_State *L, ExtensionAPI::Pane p, const IFaceFunction &func) {
 	int arg = 2;
 
 	intptr_t params[2] = {0, 0};
@@ -980,13 +1041,12 @@ static int cf_ifaceprop_metatable_index(lua_State *L) {
 		raise_error(L, "Attempt to read a write-only indexed property");
 		return 0;
 	}
+	check_pane_accessible(L, ipb->pane);
 	const IFaceFunction func = ipb->prop->GetterFunction();
 
-	// rewrite the stack to match what the function expects.  put pane at index 1; param is already at index 2.
-	push_pane_object(L, ipb->pane);
-	lua_replace(L, 1);
+	// param is already at index 2
 	lua_settop(L, 2);
-	return iface_function_helper(L, func);
+	return iface_function_helper(L, ipb->pane, func);
 }
 
 static int cf_ifaceprop_metatable_newindex(lua_State *L) {
@@ -999,14 +1059,12 @@ static int cf_ifaceprop_metatable_newindex(lua_State *L) {
 		raise_error(L, "Attempt to write a read-only indexed property");
 		return 0;
 	}
+	check_pane_accessible(L, ipb->pane);
 	const IFaceFunction func = ipb->prop->SetterFunction();
 
-	// rewrite the stack to match what the function expects.
-	// pane at index 1; param at index 2, value at index 3
-	push_pane_object(L, ipb->pane);
-	lua_replace(L, 1);
+	// param at index 2, value at index 3
 	lua_settop(L, 3);
-	return iface_function_helper(L, func);
+	return iface_function_helper(L, ipb->pane, func);
 }
 
 static int cf_pane_iface_function(lua_State *L) {
@@ -1026,12 +1084,6 @@ static int push_iface_function(lua_State *L, const char *name) {
 		if (IFaceFunctionIsScriptable(IFaceTable::functions[i])) {
 			lua_pushlightuserdata(L, const_cast<IFaceFunction *>(IFaceTable::functions+i));
 			lua_pushcclosure(L, cf_pane_iface_function, 1);
-
-			// Since Lua experts say it is inefficient to create closures / cfunctions
-			// in an inner loop, I tried caching the closures in the metatable, and looking
-			// for them there first.  However, it made very little difference and did not
-			// seem worth the added complexity. - WBD
-
 			return 1;
 		}
 	}
@@ -1104,12 +1156,40 @@ static int cf_pane_metatable_index(lua_State *L) {
 	if (lua_isstring(L, 2)) {
 		const char *name = lua_tostring(L, 2);
 
+		// Function closures and indexed property bindings do not change so are cached
+		// by name in a table for each pane. The tables are held in the first upvalue.
+		int cacheIndex = 0;
+		const ExtensionAPI::Pane *pPane = static_cast<ExtensionAPI::Pane *>(checkudata(L, 1, "SciTE_MT_Pane"));
+		if (pPane) {
+			lua_rawgeti(L, lua_upvalueindex(1), *pPane);
+			if (lua_isnil(L, -1)) {
+				lua_pop(L, 1);
+				lua_newtable(L);
+				lua_pushvalue(L, -1);
+				lua_rawseti(L, lua_upvalueindex(1), *pPane);
+			}
+			cacheIndex = lua_gettop(L);
+			lua_pushvalue(L, 2);
+			lua_rawget(L, cacheIndex);
+			if (!lua_isnil(L, -1))
+				return 1;
+			lua_pop(L, 1);
+		}
+
 		// these return the number of values pushed (possibly 0), or -1 if no match
 		int results = push_iface_function(L, name);
-		if (results < 0)
+		bool cacheable = results == 1;
+		if (results < 0) {
 			results = push_iface_propval(L, name);
+			cacheable = (results == 1) && checkudata(L, -1, "SciTE_MT_IFacePropertyBinding");
+		}
 
 		if (results >= 0) {
+			if (cacheable && cacheIndex) {
+				lua_pushvalue(L, 2);
+				lua_pushvalue(L, -2);
+				lua_rawset(L, cacheIndex);
+			}
 			return results;
 		} else if (name[0] != '_') {
 			lua_getmetatable(L, 1);
@@ -1167,7 +1247,8 @@ static int cf_pane_metatable_newindex(lua_State *L) {
 void push_pane_object(lua_State *L, ExtensionAPI::Pane p) noexcept {
 	*static_cast<ExtensionAPI::Pane *>(lua_newuserdata(L, sizeof(p))) = p;
 	if (luaL_newmetatable(L, "SciTE_MT_Pane")) {
-		lua_pushcfunction(L, cf_pane_metatable_index);
+		lua_newtable(L);
+		lua_pushcclosure(L, cf_pane_metatable_index, 1);
 		lua_setfield(L, -2, "__index");
 		lua_pushcfunction(L, cf_pane_metatable_newindex);
 		lua_setfield(L, -2, "__newindex");
@@ -1179,6 +1260,10 @@ void push_pane_object(lua_State *L, ExtensionAPI::Pane p) noexcept {
 		lua_setfield(L, -2, "findtext");
 		lua_pushcfunction(L, cf_pane_textrange);
 		lua_setfield(L, -2, "textrange");
+		lua_pushcfunction(L, cf_pane_stylerange);
+		lua_setfield(L, -2, "stylerange");
+		lua_pushcfunction(L, cf_pane_linestarts);
+		lua_setfield(L, -2, "linestarts");
 		lua_pushcfunction(L, cf_pane_insert);
 		lua_setfield(L, -2, "insert");
 		lua_pushcfunction(L, cf_pane_remove);
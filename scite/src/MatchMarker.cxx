@@ -8,6 +8,7 @@
 #include <string>
 #include <string_view>
 #include <vector>
+#include <algorithm>
 #include <chrono>
 
 #include "ScintillaTypes.h"
@@ -42,42 +43,65 @@ std::vector<LineRange> LinesBreak(SA::ScintillaCall *pSci) {
 }
 
 MatchMarker::MatchMarker() :
-	pSci(nullptr), styleMatch(-1), flagsMatch(static_cast<SA::FindOption>(0)), indicator(0), bookMark(-1) {
+	pSci(nullptr), document(nullptr), styleMatch(-1), flagsMatch(static_cast<SA::FindOption>(0)), indicator(0), bookMark(-1),
+	matchesSorted(true), stepMatch(0), stepLength(0) {
 }
 
 void MatchMarker::StartMatch(SA::ScintillaCall *pSci_,
 			     const std::string &textMatch_, SA::FindOption flagsMatch_, int styleMatch_,
 			     int indicator_, int bookMark_) {
-	lineRanges.clear();
+	rangesToSearch.clear();
+	matches.clear();
+	matchesSorted = true;
+	stepMatch = 0;
+	stepLength = 0;
 	pSci = pSci_;
+	document = pSci->DocPointer();
 	textMatch = textMatch_;
 	flagsMatch = flagsMatch_;
 	styleMatch = styleMatch_;
 	indicator = indicator_;
 	bookMark = bookMark_;
-	lineRanges = LinesBreak(pSci);
+	for (const LineRange &lineRange : LinesBreak(pSci)) {
+		rangesToSearch.emplace_back(pSci->LineStart(lineRange.lineStart), pSci->LineStart(lineRange.lineEnd));
+	}
 	// Perform the initial marking immediately to avoid flashing
 	Continue();
 }
 
+bool MatchMarker::Matching(SA::ScintillaCall *pSci_,
+			   const std::string &textMatch_, SA::FindOption flagsMatch_, int styleMatch_) {
+	return Tracking(pSci_) &&
+		(textMatch == textMatch_) && (flagsMatch == flagsMatch_) && (styleMatch == styleMatch_);
+}
+
 bool MatchMarker::Complete() const noexcept {
-	return lineRanges.empty();
+	return rangesToSearch.empty();
 }
 
 void MatchMarker::Continue() {
-	constexpr int segment = 200;
+	constexpr SA::Line segment = 200;
+	// Limit the search duration to 250 ms to avoid freezing the editor on huge lines.
+	// The rest of the range is searched on the next call.
+	constexpr double maxDuration = 0.25;
+
+	if (pSci->DocPointer() != document) {
+		// Another document has been switched into the window
+		Stop();
+		return;
+	}
 
 	// Remove old indicators if any exist.
 	pSci->SetIndicatorCurrent(indicator);
 
-	const LineRange rangeSearch = lineRanges[0];
-	SA::Line lineEndSegment = rangeSearch.lineStart + segment;
-	if (lineEndSegment > rangeSearch.lineEnd)
-		lineEndSegment = rangeSearch.lineEnd;
+	const SA::Range rangeSearch = rangesToSearch[0];
+	const SA::Position positionStart = rangeSearch.start;
+	SA::Position positionEnd = rangeSearch.end;
+	const SA::Line lineEndSegment = pSci->LineFromPosition(positionStart) + segment;
+	if (lineEndSegment < pSci->LineCount())
+		positionEnd = std::min(positionEnd, pSci->LineStart(lineEndSegment));
 
 	pSci->SetSearchFlags(flagsMatch);
-	const SA::Position positionStart = pSci->LineStart(rangeSearch.lineStart);
-	const SA::Position positionEnd = pSci->LineStart(lineEndSegment);
 	pSci->SetTarget(SA::Range(positionStart, positionEnd));
 	pSci->IndicatorClearRange(positionStart, positionEnd - positionStart);
 
@@ -85,44 +109,200 @@ void MatchMarker::Continue() {
 	GUI::ElapsedTime searchElapsedTime;
 
 	// Find the first occurrence of word.
+	SA::Position positionSearched = positionEnd;
 	SA::Range rangeFound = pSci->RangeSearchInTarget(textMatch);
 	while (rangeFound.start >= 0) {
-		// Limit the search duration to 250 ms. Avoid to freeze editor for huge lines.
-		if (searchElapsedTime.Duration() > 0.25) {
-			// Clear all indicators because timer has expired.
-			pSci->IndicatorClearRange(0, pSci->Length());
-			lineRanges.clear();
-			break;
-		}
-
 		if ((styleMatch < 0) || (styleMatch == pSci->UnsignedStyleAt(rangeFound.start))) {
 			pSci->IndicatorFillRange(rangeFound.start, rangeFound.Length());
+			ApplyStep(matches.size());
+			if (!matches.empty() && (rangeFound.start < matches.back().start))
+				matchesSorted = false;
+			matches.push_back(rangeFound);
 			if (bookMark >= 0) {
-				pSci->MarkerAdd(
-					pSci->LineFromPosition(rangeFound.start), bookMark);
+				const SA::Line line = pSci->LineFromPosition(rangeFound.start);
+				if (!(pSci->MarkerGet(line) & (1 << bookMark)))
+					pSci->MarkerAdd(line, bookMark);
 			}
 		}
 		if (rangeFound.Length() == 0) {
 			// Empty matches are possible for regex
 			rangeFound.end = pSci->PositionAfter(rangeFound.end);
 		}
+		if (searchElapsedTime.Duration() > maxDuration) {
+			positionSearched = rangeFound.end;
+			break;
+		}
 		// Try to find next occurrence of word.
 		pSci->SetTarget(SA::Range(rangeFound.end, positionEnd));
 		rangeFound = pSci->RangeSearchInTarget(textMatch);
 	}
 
-	// Retire searched lines
-	if (!lineRanges.empty()) {
+	// Retire searched text
+	if (!rangesToSearch.empty()) {
 		// Check in case of re-entrance
-		if (lineEndSegment >= rangeSearch.lineEnd) {
-			lineRanges.erase(lineRanges.begin());
+		if (positionSearched >= rangeSearch.end) {
+			rangesToSearch.erase(rangesToSearch.begin());
 		} else {
-			lineRanges[0].lineStart = lineEndSegment;
+			rangesToSearch[0].start = positionSearched;
+		}
+	}
+}
+
+bool MatchMarker::Tracking(const SA::ScintillaCall *pSci_) const noexcept {
+	return pSci && (pSci == pSci_) && (document == pSci->DocPointer());
+}
+
+SA::Range MatchMarker::MatchAt(size_t index) const noexcept {
+	SA::Range range = matches[index];
+	if (index >= stepMatch) {
+		range.start += stepLength;
+		range.end += stepLength;
+	}
+	return range;
+}
+
+// Move the step so that matches before matchUpTo hold their real positions.
+void MatchMarker::ApplyStep(size_t matchUpTo) noexcept {
+	if (stepLength != 0) {
+		for (; stepMatch < matchUpTo; stepMatch++) {
+			matches[stepMatch].start += stepLength;
+			matches[stepMatch].end += stepLength;
+		}
+		while (stepMatch > matchUpTo) {
+			stepMatch--;
+			matches[stepMatch].start -= stepLength;
+			matches[stepMatch].end -= stepLength;
+		}
+	}
+	stepMatch = matchUpTo;
+	if (stepMatch >= matches.size())
+		stepLength = 0;
+}
+
+void MatchMarker::SortMatches() {
+	if (!matchesSorted) {
+		ApplyStep(matches.size());
+		std::sort(matches.begin(), matches.end(), [](const SA::Range &a, const SA::Range &b) noexcept {
+			return a.start < b.start;
+		});
+		// Ranges searched more than once may have found the same match again
+		matches.erase(std::unique(matches.begin(), matches.end(), [](const SA::Range &a, const SA::Range &b) noexcept {
+			return a.start == b.start;
+		}), matches.end());
+		matchesSorted = true;
+		stepMatch = matches.size();
+	}
+}
+
+// Forget the matches in the lines from startChange to endChange, which were endChange - delta
+// before the change, move the later matches by delta and queue the lines to be searched again.
+void MatchMarker::SearchAgain(SA::Position startChange, SA::Position endChange, SA::Position delta) {
+	// Merge queued ranges when editing quickly adds many
+	constexpr size_t maxRangesToSearch = 100;
+
+	const SA::Position endChangeBefore = endChange - delta;
+
+	SortMatches();
+	const auto partitionPoint = [this](size_t first, size_t last, auto predicate) noexcept {
+		while (first < last) {
+			const size_t middle = first + (last - first) / 2;
+			if (predicate(MatchAt(middle)))
+				first = middle + 1;
+			else
+				last = middle;
 		}
+		return first;
+	};
+	const size_t matchFirst = partitionPoint(0, matches.size(), [startChange](const SA::Range &range) noexcept {
+		return (range.start < startChange) && (range.end <= startChange);
+	});
+	const size_t matchLast = partitionPoint(matchFirst, matches.size(), [endChangeBefore](const SA::Range &range) noexcept {
+		return range.start < endChangeBefore;
+	});
+	if (matchFirst != matchLast) {
+		// Matches may extend over several lines
+		startChange = std::min(startChange, MatchAt(matchFirst).start);
+		endChange = std::max(endChange, MatchAt(matchLast - 1).end + delta);
 	}
+	// Later matches move with the step which only passes over the matches since the previous change
+	ApplyStep(matchLast);
+	matches.erase(matches.begin() + matchFirst, matches.begin() + matchLast);
+	stepMatch = matchFirst;
+	stepLength += delta;
+	if (stepMatch >= matches.size())
+		stepLength = 0;
+
+	// Ranges that reach into the changed lines are merged so no search starts inside a match
+	SA::Range rangeChange(startChange, endChange);
+	bool merged = true;
+	while (merged) {
+		merged = false;
+		for (SA::Range &range : rangesToSearch) {
+			if ((range.start < range.end) && (range.start <= rangeChange.end) && (range.end >= rangeChange.start)) {
+				rangeChange.start = std::min(rangeChange.start, range.start);
+				rangeChange.end = std::max(rangeChange.end, range.end);
+				range.end = range.start;
+				merged = true;
+			}
+		}
+	}
+	rangesToSearch.erase(std::remove_if(rangesToSearch.begin(), rangesToSearch.end(), [](const SA::Range &range) noexcept {
+		return range.start >= range.end;
+	}), rangesToSearch.end());
+	rangesToSearch.insert(rangesToSearch.begin(), rangeChange);
+	if (rangesToSearch.size() > maxRangesToSearch) {
+		SA::Range rangeAll = rangesToSearch[0];
+		for (const SA::Range &range : rangesToSearch) {
+			rangeAll.start = std::min(rangeAll.start, range.start);
+			rangeAll.end = std::max(rangeAll.end, range.end);
+		}
+		rangesToSearch.assign(1, rangeAll);
+	}
+}
+
+// Called after text is inserted or deleted in a window.
+// Matches after the change are moved and the lines containing the change are queued to be searched again.
+// Returns true if the window is being marked.
+bool MatchMarker::Modified(SA::ScintillaCall *pSci_, SA::Position position, SA::Position length, bool insertion) {
+	if (!Tracking(pSci_))
+		return false;
+
+	const auto moved = [position, length, insertion](SA::Position pos) noexcept {
+		if (insertion)
+			return (pos > position) ? pos + length : pos;
+		if (pos > position + length)
+			return pos - length;
+		return std::min(pos, position);
+	};
+	for (SA::Range &range : rangesToSearch) {
+		range.start = moved(range.start);
+		range.end = moved(range.end);
+	}
+
+	const SA::Position startChange = pSci->LineStart(pSci->LineFromPosition(position));
+	const SA::Position endChange = pSci->LineStart(pSci->LineFromPosition(insertion ? position + length : position) + 1);
+	SearchAgain(startChange, endChange, insertion ? length : -length);
+	return true;
+}
+
+// Called after styles change in a window, possibly on lines that were not edited.
+// When matching by style, the restyled lines are queued to be searched again.
+// Returns true if the window is being marked.
+bool MatchMarker::Restyled(SA::ScintillaCall *pSci_, SA::Position position, SA::Position length) {
+	if ((styleMatch < 0) || !Tracking(pSci_))
+		return false;
+	const SA::Position startChange = pSci->LineStart(pSci->LineFromPosition(position));
+	const SA::Position endChange = pSci->LineStart(pSci->LineFromPosition(position + length) + 1);
+	SearchAgain(startChange, endChange, 0);
+	return true;
 }
 
 void MatchMarker::Stop() noexcept {
 	pSci = nullptr;
-	lineRanges.clear();
+	document = nullptr;
+	rangesToSearch.clear();
+	matches.clear();
+	matchesSorted = true;
+	stepMatch = 0;
+	stepLength = 0;
 }
@@ -18,19 +18,39 @@ std::vector<LineRange> LinesBreak(Scintilla::API::ScintillaCall *pSci);
 
 class MatchMarker {
 	Scintilla::API::ScintillaCall *pSci;
+	void *document;
 	std::string textMatch;
 	int styleMatch;
 	Scintilla::API::FindOption flagsMatch;
 	int indicator;
 	int bookMark;
-	std::vector<LineRange> lineRanges;
+	// Matches found so far, sorted when matchesSorted.
+	std::vector<Scintilla::API::Range> matches;
+	bool matchesSorted;
+	// Matches from stepMatch on are really stepLength after their stored positions
+	// so a change only updates the matches between it and the previous change.
+	size_t stepMatch;
+	Scintilla::API::Position stepLength;
+	// Ranges still to be searched, the first is searched next.
+	std::vector<Scintilla::API::Range> rangesToSearch;
+	bool Tracking(const Scintilla::API::ScintillaCall *pSci_) const noexcept;
+	Scintilla::API::Range MatchAt(size_t index) const noexcept;
+	void ApplyStep(size_t matchUpTo) noexcept;
+	void SortMatches();
+	void SearchAgain(Scintilla::API::Position startChange, Scintilla::API::Position endChange, Scintilla::API::Position delta);
 public:
 	MatchMarker();	// Not noexcept as std::vector constructor throws
 	void StartMatch(Scintilla::API::ScintillaCall *pSci_,
 			const std::string &textMatch_, Scintilla::API::FindOption flagsMatch_, int styleMatch_,
 			int indicator_, int bookMark_);
+	bool Matching(Scintilla::API::ScintillaCall *pSci_,
+		      const std::string &textMatch_, Scintilla::API::FindOption flagsMatch_, int styleMatch_);
 	bool Complete() const noexcept;
 	void Continue();
+	bool Modified(Scintilla::API::ScintillaCall *pSci_, Scintilla::API::Position position,
+		      Scintilla::API::Position length, bool insertion);
+	bool Restyled(Scintilla::API::ScintillaCall *pSci_, Scintilla::API::Position position,
+		      Scintilla::API::Position length);
 	void Stop() noexcept;
 };
 
@@ -7,6 +7,7 @@
 
 #include <cstddef>
 #include <cstdlib>
+#include <cstdint>
 #include <cassert>
 #include <cstring>
 #include <cstdio>
@@ -14,10 +15,12 @@
 
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <set>
 #include <algorithm>
+#include <memory>
 #include <chrono>
 #include <sstream>
 
@@ -61,12 +64,98 @@ bool ImportFilter::IsValid(const std::string &name) const {
 	}
 }
 
+bool ImportFilter::operator==(const ImportFilter &other) const {
+	return (excludes == other.excludes) && (includes == other.includes);
+}
+
+/**
+ * Remembers the results of GetWild for each keybase and file name.
+ * A result depends on the keys starting with the keybase and on the variables used in those
+ * keys, so changing such a key in the owning set drops just the results for that keybase.
+ * Any change to a base set in the chain drops all results.
+ */
+class WildCache {
+public:
+	struct Keybase {
+		std::map<std::string, std::string, std::less<>> values;	// By file name
+		std::set<std::string> variables;
+	};
+	std::map<std::string, Keybase, std::less<>> keybases;
+	std::map<std::string, std::set<std::string>, std::less<>> keybasesUsingVariable;
+	std::vector<std::pair<const PropSetFile *, int>> bases;
+	bool caseSensitiveFilenames = false;
+	size_t entries = 0;
+	static constexpr size_t maxEntries = 0x10000;
+
+	void Clear() noexcept {
+		keybases.clear();
+		keybasesUsingVariable.clear();
+		bases.clear();
+		entries = 0;
+	}
+	// Record that results for keybase depend on var and the variables its value refers to.
+	// Returns false when the expansion can not be followed, such as for nested or evaluated
+	// variables, so the result should not be remembered.
+	bool AddDependencies(const PropSetFile &props, const std::string &var, const std::string &keybase, Keybase &cached) {
+		if (var.find_first_of(" $(") != std::string::npos) {
+			return false;
+		}
+		if (!cached.variables.insert(var).second) {
+			return true;
+		}
+		keybasesUsingVariable[var].insert(keybase);
+		const std::string val = props.GetString(var.c_str());
+		size_t varStart = val.find("$(");
+		while (varStart != std::string::npos) {
+			const size_t varEnd = val.find(')', varStart + 2);
+			if (varEnd == std::string::npos) {
+				break;
+			}
+			if (!AddDependencies(props, val.substr(varStart + 2, varEnd - varStart - 2), keybase, cached)) {
+				return false;
+			}
+			varStart = val.find("$(", varEnd);
+		}
+		return true;
+	}
+	void Drop(std::string_view keybase) {
+		std::map<std::string, Keybase, std::less<>>::iterator it = keybases.find(keybase);
+		if (it != keybases.end()) {
+			entries -= it->second.values.size();
+			keybases.erase(it);
+		}
+	}
+};
+
+/**
+ * The files, directories and conditions that reading a set depended on, recorded so
+ * that a snapshot of the result can be checked against them later without parsing.
+ */
+class PropSetInputs {
+public:
+	struct Input {
+		std::string path;
+		long long size;
+		long long modified;
+	};
+	std::vector<Input> files;	// The first is the file read, then imports and listed directories
+	std::vector<std::pair<std::string, bool>> conditions;
+	std::vector<std::string> imports;
+
+	static Input InputFor(const FilePath &path) {
+		return { path.AsUTF8(), path.GetFileLength(), static_cast<long long>(path.ModifiedTime()) };
+	}
+	void Add(const FilePath &path) {
+		files.push_back(InputFor(path));
+	}
+};
+
 bool PropSetFile::caseSensitiveFilenames = false;
 
-PropSetFile::PropSetFile(bool lowerKeys_) : lowerKeys(lowerKeys_), superPS(nullptr) {
+PropSetFile::PropSetFile(bool lowerKeys_) : lowerKeys(lowerKeys_), changes(0), superPS(nullptr) {
 }
 
-PropSetFile::PropSetFile(const PropSetFile &copy) : lowerKeys(copy.lowerKeys), props(copy.props), superPS(copy.superPS) {
+PropSetFile::PropSetFile(const PropSetFile &copy) : lowerKeys(copy.lowerKeys), props(copy.props), changes(0), superPS(copy.superPS) {
 }
 
 PropSetFile::~PropSetFile() {
@@ -78,15 +167,45 @@ PropSetFile &PropSetFile::operator=(const PropSetFile &assign) {
 	if (this != &assign) {
 		lowerKeys = assign.lowerKeys;
 		superPS = assign.superPS;
-		props = assign.props;
+		if (props != assign.props) {
+			props = assign.props;
+			changes++;
+			wildCache.reset();
+		}
 	}
 	return *this;
 }
 
+// Drop any remembered wild results that may depend on key.
+void PropSetFile::Changed(std::string_view key) {
+	changes++;
+	if (wildCache) {
+		for (size_t len = 0; len <= key.length(); len++) {
+			wildCache->Drop(key.substr(0, len));
+		}
+		std::map<std::string, std::set<std::string>, std::less<>>::iterator it =
+			wildCache->keybasesUsingVariable.find(key);
+		if (it != wildCache->keybasesUsingVariable.end()) {
+			for (const std::string &keybase : it->second) {
+				wildCache->Drop(keybase);
+			}
+			wildCache->keybasesUsingVariable.erase(it);
+		}
+	}
+}
+
 void PropSetFile::Set(std::string_view key, std::string_view val) {
 	if (key.empty())	// Empty keys are not supported
 		return;
-	props[std::string(key)] = std::string(val);
+	std::string sKey(key);
+	mapss::iterator keyPos = props.find(sKey);
+	if (keyPos == props.end()) {
+		props.emplace(std::move(sKey), std::string(val));
+		Changed(key);
+	} else if (keyPos->second != val) {
+		keyPos->second = std::string(val);
+		Changed(key);
+	}
 }
 
 void PropSetFile::SetLine(const char *keyVal) {
@@ -113,8 +232,10 @@ void PropSetFile::Unset(std::string_view key) {
 	if (key.empty())	// Empty keys are not supported
 		return;
 	mapss::iterator keyPos = props.find(std::string(key));
-	if (keyPos != props.end())
+	if (keyPos != props.end()) {
 		props.erase(keyPos);
+		Changed(key);
+	}
 }
 
 bool PropSetFile::Exists(const char *key) const {
@@ -314,7 +435,12 @@ long long PropSetFile::GetLongLong(const char *key, long long defaultValue) cons
 }
 
 void PropSetFile::Clear() noexcept {
-	props.clear();
+	if (!props.empty()) {
+		props.clear();
+		changes++;
+	}
+	wildCache.reset();
+	inputs.reset();
 }
 
 /**
@@ -374,12 +500,25 @@ void PropSetFile::Import(const FilePath &filename, const FilePath &directoryForI
 	if (depth > 20)	// Possibly recursive import so give up to avoid crash
 		return;
 	if (Read(filename, directoryForImports, filter, imports, depth)) {
+		if (inputs) {
+			inputs->imports.push_back(filename.AsUTF8());
+		}
 		if (imports && (std::find(imports->begin(), imports->end(), filename) == imports->end())) {
 			imports->push_back(filename);
 		}
 	}
 }
 
+bool PropSetFile::ConditionTrue(const char *expr) const {
+	const std::string value = Expand(expr);
+	if (value == "0" || value == "") {
+		return false;
+	} else if (value == "1") {
+		return true;
+	}
+	return GetInt(value.c_str()) != 0;
+}
+
 PropSetFile::ReadLineState PropSetFile::ReadLine(const char *lineBuffer, ReadLineState rls, const FilePath &directoryForImports,
 		const ImportFilter &filter, FilePathSet *imports, size_t depth) {
 	//UnSlash(lineBuffer);
@@ -399,19 +538,20 @@ PropSetFile::ReadLineState PropSetFile::ReadLine(const char *lineBuffer, ReadLin
 	}
 	if (isprefix(lineBuffer, "if ")) {
 		const char *expr = lineBuffer + strlen("if") + 1;
-		std::string value = Expand(expr);
-		if (value == "0" || value == "") {
-			rls = rlConditionFalse;
-		} else if (value == "1") {
-			rls = rlActive;
-		} else {
-			rls = (GetInt(value.c_str()) != 0) ? rlActive : rlConditionFalse;
+		const bool active = ConditionTrue(expr);
+		if (inputs) {
+			inputs->conditions.emplace_back(expr, active);
 		}
+		rls = active ? rlActive : rlConditionFalse;
 	} else if (isprefix(lineBuffer, "import ")) {
 		if (directoryForImports.IsSet()) {
 			std::string importName(lineBuffer + strlen("import") + 1);
 			if (importName == "*") {
 				// Import all .properties files in this directory except for system properties
+				if (inputs) {
+					// Adding or removing a file changes the directory's modification time
+					inputs->Add(directoryForImports);
+				}
 				FilePathSet directories;
 				FilePathSet files;
 				directoryForImports.List(directories, files);
@@ -455,6 +595,10 @@ void PropSetFile::ReadFromMemory(const char *data, size_t len, const FilePath &d
 
 bool PropSetFile::Read(const FilePath &filename, const FilePath &directoryForImports,
 		       const ImportFilter &filter, FilePathSet *imports, size_t depth) {
+	if (inputs) {
+		// Before reading so a change made while reading is seen as a change
+		inputs->Add(filename);
+	}
 	const std::string propsData = filename.Read();
 	const size_t lenFile = propsData.size();
 	if (lenFile > 0) {
@@ -471,6 +615,274 @@ bool PropSetFile::Read(const FilePath &filename, const FilePath &directoryForImp
 
 namespace {
 
+// Snapshots are only read on the machine that wrote them so values are in native byte order.
+// After the header come the import filter, the inputs with their sizes and modification times,
+// the conditions with their results, the imported files, then the keys and values in map order.
+
+class SnapshotWriter {
+public:
+	std::string data;
+	template <typename T>
+	void Value(T value) {
+		data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+	}
+	void String(std::string_view sv) {
+		Value(static_cast<uint32_t>(sv.length()));
+		data.append(sv);
+	}
+};
+
+class SnapshotReader {
+	std::string_view data;
+public:
+	bool valid = true;
+	explicit SnapshotReader(std::string_view data_) noexcept : data(data_) {
+	}
+	template <typename T>
+	T Value() noexcept {
+		T value {};
+		if (data.length() < sizeof(value)) {
+			valid = false;
+		} else {
+			memcpy(&value, data.data(), sizeof(value));
+			data.remove_prefix(sizeof(value));
+		}
+		return value;
+	}
+	std::string_view String() noexcept {
+		const uint32_t length = Value<uint32_t>();
+		if (!valid || (data.length() < length)) {
+			valid = false;
+			return {};
+		}
+		const std::string_view sv = data.substr(0, length);
+		data.remove_prefix(length);
+		return sv;
+	}
+	bool AtEnd() const noexcept {
+		return data.empty();
+	}
+};
+
+// Reading the same file with different options gives a different set so they start the snapshot.
+std::string SnapshotHeader(bool lowerKeys, std::string_view rootPath) {
+	SnapshotWriter writer;
+	writer.data = "SciTEPS2";
+	writer.Value<uint8_t>(lowerKeys);
+	writer.String(rootPath);
+	return writer.data;
+}
+
+// The filter follows the header as the filter to use may only be known after reading the snapshot.
+// Any filter is accepted when filterSnapshot is not null and the snapshot's filter is returned there.
+bool ParseSnapshot(std::string_view data, std::string_view header, const ImportFilter &filter,
+		   ImportFilter *filterSnapshot, PropSetInputs &recorded, mapss &propsRead) {
+	if (!StartsWith(data, header)) {
+		return false;
+	}
+	SnapshotReader reader(data.substr(header.length()));
+	ImportFilter filterRead;
+	for (std::set<std::string> *names : { &filterRead.excludes, &filterRead.includes }) {
+		const uint32_t count = reader.Value<uint32_t>();
+		for (uint32_t i = 0; (i < count) && reader.valid; i++) {
+			names->emplace(reader.String());
+		}
+	}
+	if (!reader.valid) {
+		return false;
+	}
+	if (filterSnapshot) {
+		*filterSnapshot = filterRead;
+	} else if (!(filterRead == filter)) {
+		return false;
+	}
+	const uint32_t files = reader.Value<uint32_t>();
+	for (uint32_t i = 0; (i < files) && reader.valid; i++) {
+		const std::string path(reader.String());
+		const long long size = reader.Value<int64_t>();
+		const long long modified = reader.Value<int64_t>();
+		if (reader.valid) {
+			const PropSetInputs::Input current = PropSetInputs::InputFor(FilePath(GUI::StringFromUTF8(path)));
+			if ((current.size != size) || (current.modified != modified)) {
+				return false;
+			}
+		}
+	}
+	const uint32_t conditions = reader.Value<uint32_t>();
+	for (uint32_t i = 0; (i < conditions) && reader.valid; i++) {
+		const std::string_view expr = reader.String();
+		const bool result = reader.Value<uint8_t>() != 0;
+		recorded.conditions.emplace_back(expr, result);
+	}
+	const uint32_t imports = reader.Value<uint32_t>();
+	for (uint32_t i = 0; (i < imports) && reader.valid; i++) {
+		recorded.imports.emplace_back(reader.String());
+	}
+	const uint32_t entries = reader.Value<uint32_t>();
+	for (uint32_t i = 0; (i < entries) && reader.valid; i++) {
+		const std::string_view key = reader.String();
+		const std::string_view val = reader.String();
+		// Written in map order so each goes at the end
+		propsRead.emplace_hint(propsRead.end(), key, val);
+	}
+	return reader.valid && reader.AtEnd();
+}
+
+}
+
+// Start recording the inputs of the following Read calls for WriteSnapshot.
+void PropSetFile::RecordInputs() {
+	inputs = std::make_unique<PropSetInputs>();
+}
+
+/**
+ * Replace the contents with those of a snapshot of reading filename with filter if none of the
+ * files and directories read have changed since and the conditions evaluated while reading
+ * still have the same results. Returns false, leaving the set empty, if the file should be read.
+ * When filterSnapshot is not null, a snapshot read with any filter is used and its filter returned.
+ */
+bool PropSetFile::ReadSnapshot(const FilePath &snapshot, const FilePath &filename, const ImportFilter &filter,
+			       FilePathSet *imports, ImportFilter *filterSnapshot) {
+	Clear();
+	// Inputs recorded by an earlier read are not those of the contents
+	inputs.reset();
+	FILE *fp = snapshot.Open(fileRead);
+	if (!fp) {
+		return false;
+	}
+	PropSetInputs recorded;
+	mapss propsRead;
+	bool parsed = false;
+	{
+		const FileMapping mapping(fp);
+		if (mapping.IsValid()) {
+			parsed = ParseSnapshot(std::string_view(mapping.Data(), mapping.Size()),
+					       SnapshotHeader(lowerKeys, filename.AsUTF8()), filter, filterSnapshot, recorded, propsRead);
+		}
+	}
+	fclose(fp);
+	if (!parsed) {
+		return false;
+	}
+	props = std::move(propsRead);
+	changes++;
+	// Conditions are checked against the complete set rather than as it was part way through
+	// reading. This only differs when a value used by a condition is set again after it.
+	for (const std::pair<std::string, bool> &condition : recorded.conditions) {
+		if (ConditionTrue(condition.first.c_str()) != condition.second) {
+			Clear();
+			return false;
+		}
+	}
+	if (imports) {
+		for (const std::string &import : recorded.imports) {
+			const FilePath importPath(GUI::StringFromUTF8(import));
+			if (std::find(imports->begin(), imports->end(), importPath) == imports->end()) {
+				imports->push_back(importPath);
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * Write the contents and the inputs recorded since RecordInputs to snapshot. Not written when
+ * an input was modified so recently that another change may not alter its modification time.
+ */
+bool PropSetFile::WriteSnapshot(const FilePath &snapshot, const ImportFilter &filter) {
+	const std::unique_ptr<PropSetInputs> recorded = std::move(inputs);
+	if (!recorded || recorded->files.empty()) {
+		return false;
+	}
+	const long long now = time(nullptr);
+	for (const PropSetInputs::Input &input : recorded->files) {
+		if (input.modified >= now - 1) {
+			return false;
+		}
+	}
+
+	SnapshotWriter writer;
+	writer.data = SnapshotHeader(lowerKeys, recorded->files.front().path);
+	for (const std::set<std::string> *names : { &filter.excludes, &filter.includes }) {
+		writer.Value(static_cast<uint32_t>(names->size()));
+		for (const std::string &name : *names) {
+			writer.String(name);
+		}
+	}
+	writer.Value(static_cast<uint32_t>(recorded->files.size()));
+	for (const PropSetInputs::Input &input : recorded->files) {
+		writer.String(input.path);
+		writer.Value<int64_t>(input.size);
+		writer.Value<int64_t>(input.modified);
+	}
+	writer.Value(static_cast<uint32_t>(recorded->conditions.size()));
+	for (const std::pair<std::string, bool> &condition : recorded->conditions) {
+		writer.String(condition.first);
+		writer.Value<uint8_t>(condition.second);
+	}
+	writer.Value(static_cast<uint32_t>(recorded->imports.size()));
+	for (const std::string &import : recorded->imports) {
+		writer.String(import);
+	}
+	writer.Value(static_cast<uint32_t>(props.size()));
+	for (const std::pair<const std::string, std::string> &keyVal : props) {
+		writer.String(keyVal.first);
+		writer.String(keyVal.second);
+	}
+
+	// Write then rename so another instance never sees, or has mapped, a partial snapshot
+	const FilePath temporary(GUI::gui_string(snapshot.AsInternal()) + GUI_TEXT(".new"));
+	FILE *fp = temporary.Open(fileWrite);
+	if (!fp) {
+		return false;
+	}
+	const bool written = fwrite(writer.data.data(), 1, writer.data.size(), fp) == writer.data.size();
+	if ((fclose(fp) != 0) || !written || !temporary.Rename(snapshot)) {
+		temporary.Remove();
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Read each set, from its snapshot when possible, with the import filter set by the properties
+ * read. When that differs from the filter used, which is at first the one already in propsFinal,
+ * they are read once more. On that first pass the filter of the first snapshot is taken so
+ * a snapshot written with a filter set by the files is used and then found to agree.
+ * Returns the number of passes made.
+ */
+int FilteredReader::Read(const PropSetFile &propsFinal, const std::vector<SnapshotRead> &reads,
+			 ImportFilter &filter, FilePathSet &imports) {
+	int attempt = 0;
+	for (; attempt < 2; attempt++) {
+		ImportFilter filterRead;
+		filterRead.SetFilter(propsFinal.GetString("imports.exclude"), propsFinal.GetString("imports.include"));
+		if ((attempt > 0) && (filterRead == filter)) {
+			break;
+		}
+		filter = filterRead;
+		imports.clear();
+		ReadWithoutSnapshot(filter);
+		for (const SnapshotRead &read : reads) {
+			const bool takeFilter = (attempt == 0) && (&read == &reads.front());
+			ImportFilter filterSnapshot;
+			if (read.props->ReadSnapshot(read.snapshot, read.filename, filter, &imports,
+						     takeFilter ? &filterSnapshot : nullptr)) {
+				if (takeFilter && !(filterSnapshot == filter)) {
+					filter = filterSnapshot;
+					ReadWithoutSnapshot(filter);
+				}
+			} else {
+				read.props->RecordInputs();
+				read.props->Read(read.filename, read.filename.Directory(), filter, &imports, 0);
+			}
+		}
+	}
+	return attempt;
+}
+
+namespace {
+
 bool StringEqual(std::string_view a, std::string_view b, bool caseSensitive) noexcept {
 	if (caseSensitive) {
 		return a == b;
@@ -528,7 +940,8 @@ bool startswith(const std::string &s, const char *keybase) noexcept {
 
 }
 
-std::string PropSetFile::GetWildUsingStart(const PropSetFile &psStart, const char *keybase, const char *filename) {
+std::string PropSetFile::GetWildUsingStart(const PropSetFile &psStart, const char *keybase, const char *filename,
+	std::vector<std::string> *variables) {
 	const std::string sKeybase(keybase);
 	const PropSetFile *psf = this;
 	while (psf) {
@@ -543,6 +956,9 @@ std::string PropSetFile::GetWildUsingStart(const PropSetFile &psStart, const cha
 				const size_t endVar = orgkeyfile.find_first_of(')');
 				if (endVar != std::string_view::npos) {
 					const std::string var(orgkeyfile.substr(2, endVar-2));
+					if (variables) {
+						variables->push_back(var);
+					}
 					key = psStart.GetExpandedString(var.c_str());
 					keyFile = key;
 				}
@@ -570,7 +986,48 @@ std::string PropSetFile::GetWildUsingStart(const PropSetFile &psStart, const cha
 }
 
 std::string PropSetFile::GetWild(const char *keybase, const char *filename) {
-	return GetWildUsingStart(*this, keybase, filename);
+	if (!wildCache) {
+		wildCache = std::make_unique<WildCache>();
+	}
+	// Results are only valid while the base sets and file name case sensitivity are unchanged.
+	bool basesSame = wildCache->caseSensitiveFilenames == caseSensitiveFilenames;
+	size_t base = 0;
+	for (const PropSetFile *psf = superPS; psf && basesSame; psf = psf->superPS, base++) {
+		basesSame = (base < wildCache->bases.size()) &&
+			(wildCache->bases[base] == std::pair<const PropSetFile *, int>(psf, psf->changes));
+	}
+	if (!basesSame || (base != wildCache->bases.size()) || (wildCache->entries > WildCache::maxEntries)) {
+		wildCache->Clear();
+		wildCache->caseSensitiveFilenames = caseSensitiveFilenames;
+		for (const PropSetFile *psf = superPS; psf; psf = psf->superPS) {
+			wildCache->bases.emplace_back(psf, psf->changes);
+		}
+	}
+
+	const std::string_view sKeybase(keybase);
+	std::map<std::string, WildCache::Keybase, std::less<>>::iterator itKeybase = wildCache->keybases.find(sKeybase);
+	if (itKeybase != wildCache->keybases.end()) {
+		std::map<std::string, std::string, std::less<>>::const_iterator itValue =
+			itKeybase->second.values.find(std::string_view(filename));
+		if (itValue != itKeybase->second.values.end()) {
+			return itValue->second;
+		}
+	}
+
+	std::vector<std::string> variables;
+	std::string val = GetWildUsingStart(*this, keybase, filename, &variables);
+
+	if (itKeybase == wildCache->keybases.end()) {
+		itKeybase = wildCache->keybases.emplace(std::string(sKeybase), WildCache::Keybase()).first;
+	}
+	for (const std::string &var : variables) {
+		if (!wildCache->AddDependencies(*this, var, itKeybase->first, itKeybase->second)) {
+			return val;
+		}
+	}
+	itKeybase->second.values.emplace(filename, val);
+	wildCache->entries++;
+	return val;
 }
 
 // GetNewExpandString does not use Expand as it has to use GetWild with the filename for each
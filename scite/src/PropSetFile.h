@@ -19,13 +19,23 @@ public:
 	std::set<std::string> includes;
 	void SetFilter(const std::string &sExcludes, const std::string &sIncludes);
 	bool IsValid(const std::string &name) const;
+	bool operator==(const ImportFilter &other) const;
 };
 
+class WildCache;
+class PropSetInputs;
+
 class PropSetFile {
 	bool lowerKeys;
-	std::string GetWildUsingStart(const PropSetFile &psStart, const char *keybase, const char *filename);
+	std::string GetWildUsingStart(const PropSetFile &psStart, const char *keybase, const char *filename,
+				      std::vector<std::string> *variables=nullptr);
 	static bool caseSensitiveFilenames;
 	mapss props;
+	int changes;
+	std::unique_ptr<WildCache> wildCache;
+	std::unique_ptr<PropSetInputs> inputs;
+	void Changed(std::string_view key);
+	bool ConditionTrue(const char *expr) const;
 public:
 	PropSetFile *superPS;
 	explicit PropSetFile(bool lowerKeys_=false);
@@ -55,6 +65,10 @@ public:
 		    FilePathSet *imports, size_t depth);
 	bool Read(const FilePath &filename, const FilePath &directoryForImports, const ImportFilter &filter,
 		  FilePathSet *imports, size_t depth);
+	void RecordInputs();
+	bool ReadSnapshot(const FilePath &snapshot, const FilePath &filename, const ImportFilter &filter,
+			  FilePathSet *imports, ImportFilter *filterSnapshot=nullptr);
+	bool WriteSnapshot(const FilePath &snapshot, const ImportFilter &filter);
 	std::string GetWild(const char *keybase, const char *filename);
 	std::string GetNewExpandString(const char *keybase, const char *filename = "");
 	bool GetFirst(const char *&key, const char *&val);
@@ -64,6 +78,25 @@ public:
 	}
 };
 
+// A properties file read into a set, from its snapshot when that is still valid.
+struct SnapshotRead {
+	PropSetFile *props;
+	FilePath filename;
+	FilePath snapshot;
+};
+
+/**
+ * Reads property sets whose imports are filtered by imports.exclude and imports.include
+ * which may be set in the files being read. Subclasses read any sets without snapshots.
+ */
+class FilteredReader {
+public:
+	virtual ~FilteredReader() = default;
+	virtual void ReadWithoutSnapshot(const ImportFilter &filter) = 0;
+	int Read(const PropSetFile &propsFinal, const std::vector<SnapshotRead> &reads,
+		 ImportFilter &filter, FilePathSet &imports);
+};
+
 constexpr const char *extensionProperties = ".properties";
 bool IsPropertiesFile(const FilePath &filename);
 
@@ -154,6 +154,7 @@ SciTEBase::SciTEBase(Extension *ext) : apis(true), pwFocussed(&wEditor), extende
 
 	allowMenuActions = true;
 	scrollOutput = 1;
+	outputMaxLines = 0;
 	returnOutputToCommand = true;
 
 	ptStartDrag.x = 0;
@@ -172,6 +173,8 @@ SciTEBase::SciTEBase(Extension *ext) : apis(true), pwFocussed(&wEditor), extende
 	indentExamine = SA::IndentView::LookBoth;
 	autoCompleteIgnoreCase = false;
 	imeAutoComplete = false;
+	undoRedoLazy = false;
+	wordIndexUsed = false;
 	callTipUseEscapes = false;
 	callTipIgnoreCase = false;
 	autoCCausedByOnlyOne = false;
@@ -204,6 +207,8 @@ SciTEBase::SciTEBase(Extension *ext) : apis(true), pwFocussed(&wEditor), extende
 
 	needReadProperties = false;
 	quitting = false;
+	pFileExporter = nullptr;
+	prefetchRemaining = 0;
 
 	timerMask = 0;
 	delayBeforeAutoSave = 0;
@@ -212,6 +217,13 @@ SciTEBase::SciTEBase(Extension *ext) : apis(true), pwFocussed(&wEditor), extende
 }
 
 SciTEBase::~SciTEBase() {
+	if (pFileExporter) {
+		// Let a background export complete as the file would be incomplete otherwise
+		while (!pFileExporter->FinishedJob()) {
+			GUI::SleepMilliseconds(10);
+		}
+		delete pFileExporter;
+	}
 	if (extender)
 		extender->Finalise();
 	popup.Destroy();
@@ -246,6 +258,10 @@ void SciTEBase::WorkerCommand(int cmd, Worker *pWorker) {
 	case WORK_FILEPROGRESS:
 		UpdateProgress(pWorker);
 		break;
+	case WORK_FILEEXPORTED:
+		ExportWritten(static_cast<FileWorker *>(pWorker));
+		UpdateProgress(pWorker);
+		break;
 	}
 }
 
@@ -751,35 +767,44 @@ void SciTEBase::HighlightCurrentWord(bool highlight) {
 		return;
 	}
 	GUI::ScintillaWindow &wCurrent = wOutput.HasFocus() ? wOutput : wEditor;
+	const SA::FindOption searchFlags = SA::FindOption::MatchCase | SA::FindOption::WholeWord;
+	std::string wordToFind;
+	int selectedStyle = -1;
+	bool delayHighlight = false;
+	if (highlight) {
+		// Get start & end selection.
+		SA::Range sel = wCurrent.SelectionRange();
+		const bool noUserSelection = sel.start == sel.end;
+		const std::string sWordToFind = RangeExtendAndGrab(wCurrent, sel,
+					  &SciTEBase::islexerwordcharforsel);
+		// No highlight when no selection or multi-lines selection.
+		if (sWordToFind.length() && (sWordToFind.find_first_of("\n\r ") == std::string::npos)) {
+			// Get style of the current word to highlight only word with same style.
+			if (currentWordHighlight.isOnlyWithSameStyle)
+				selectedStyle = wCurrent.UnsignedStyleAt(sel.start);
+			// Manage word with DBCS.
+			wordToFind = EncodeString(sWordToFind);
+			// Manage delay before highlight when no user selection but there is word at the caret.
+			delayHighlight = noUserSelection && currentWordHighlight.statesOfDelay == currentWordHighlight.noDelay;
+		}
+	}
+	if (!wordToFind.empty() && matchMarker.Matching(&wCurrent, wordToFind, searchFlags, selectedStyle)) {
+		// Already highlighting this word so keep the existing indicators to avoid flicker
+		return;
+	}
 	// Remove old indicators if any exist.
+	matchMarker.Stop();
 	wCurrent.SetIndicatorCurrent(indicatorHighlightCurrentWord);
 	const SA::Position lenDoc = wCurrent.Length();
 	wCurrent.IndicatorClearRange(0, lenDoc);
-	if (!highlight)
+	if (wordToFind.empty())
 		return;
-	// Get start & end selection.
-	SA::Range sel = wCurrent.SelectionRange();
-	const bool noUserSelection = sel.start == sel.end;
-	std::string sWordToFind = RangeExtendAndGrab(wCurrent, sel,
-				  &SciTEBase::islexerwordcharforsel);
-	if (sWordToFind.length() == 0 || (sWordToFind.find_first_of("\n\r ") != std::string::npos))
-		return; // No highlight when no selection or multi-lines selection.
-	if (noUserSelection && currentWordHighlight.statesOfDelay == currentWordHighlight.noDelay) {
-		// Manage delay before highlight when no user selection but there is word at the caret.
+	if (delayHighlight) {
 		currentWordHighlight.statesOfDelay = currentWordHighlight.delay;
 		// Reset timer
 		currentWordHighlight.elapsedTimes.Duration(true);
 		return;
 	}
-	// Get style of the current word to highlight only word with same style.
-	int selectedStyle = wCurrent.UnsignedStyleAt(sel.start);
-	if (!currentWordHighlight.isOnlyWithSameStyle)
-		selectedStyle = -1;
-
-	// Manage word with DBCS.
-	const std::string wordToFind = EncodeString(sWordToFind);
-
-	const SA::FindOption searchFlags = SA::FindOption::MatchCase | SA::FindOption::WholeWord;
 	matchMarker.StartMatch(&wCurrent, wordToFind,
 			       searchFlags, selectedStyle,
 			       indicatorHighlightCurrentWord, -1);
@@ -1301,6 +1326,7 @@ void SciTEBase::OutputAppendString(const char *s, SA::Position len) {
 	if (len == -1)
 		len = strlen(s);
 	wOutput.AppendText(len, s);
+	OutputLimitLines();
 	if (scrollOutput) {
 		const SA::Line line = wOutput.LineCount();
 		const SA::Position lineStart = wOutput.LineStart(line);
@@ -1308,6 +1334,23 @@ void SciTEBase::OutputAppendString(const char *s, SA::Position len) {
 	}
 }
 
+// Remove lines from the start of the output pane so it retains at most output.max.lines lines.
+void SciTEBase::OutputLimitLines() {
+	if (outputMaxLines <= 0)
+		return;
+	const SA::Line lines = wOutput.LineCount();
+	if (lines > outputMaxLines) {
+		const SA::Position lengthRemoved = wOutput.LineStart(lines - outputMaxLines);
+		wOutput.DeleteRange(0, lengthRemoved);
+		OutputTrimmed(lengthRemoved);
+	}
+}
+
+// Null except on platforms that remember positions in the output pane, such as the start
+// of the current command's output, which move back by lengthRemoved.
+void SciTEBase::OutputTrimmed(SA::Position) {
+}
+
 void SciTEBase::OutputAppendStringSynchronised(const char *s, SA::Position len) {
 	// This may be called from secondary thread so always use Send instead of Call
 	if (len == -1)
@@ -1320,6 +1363,12 @@ void SciTEBase::OutputAppendStringSynchronised(const char *s, SA::Position len)
 	}
 }
 
+// Null except on platforms where OutputAppendStringSynchronised queues output.
+// Called before the output pane is changed or read directly so that queued output is
+// appended first and is not reordered after operations such as clearing the pane.
+void SciTEBase::OutputFlushQueued() noexcept {
+}
+
 void SciTEBase::Execute() {
 	props.Set("CurrentMessage", "");
 	dirNameForExecute = FilePath();
@@ -1350,6 +1399,7 @@ void SciTEBase::Execute() {
 	}
 
 	if (jobQueue.ClearBeforeExecute()) {
+		OutputFlushQueued();
 		wOutput.ClearAll();
 	}
 
@@ -1707,49 +1757,39 @@ bool SciTEBase::StartAutoCompleteWord(bool onlyOneWord) {
 		return true;
 	const std::string root = line.substr(startword, current - startword);
 	const SA::Position rootLength = root.length();
-	const SA::Position doclen = LengthDocument();
-	const SA::FindOption flags =
-		SA::FindOption::WordStart | (autoCompleteIgnoreCase ? SA::FindOption::None : SA::FindOption::MatchCase);
-	const SA::Position posCurrentWord = wEditor.CurrentPos() - rootLength;
-	SA::Position minWordLength = 0;
-	unsigned int nwords = 0;
-
-	// wordsNear contains a list of words separated by single spaces and with a space
-	// at the start and end. This makes it easy to search for words.
-	std::string wordsNear;
-	wordsNear.append("\n");
-
-	wEditor.SetTarget(SA::Range(0, doclen));
-	wEditor.SetSearchFlags(flags);
-	SA::Position posFind = wEditor.SearchInTarget(root);
-	TextReader acc(wEditor);
-	while (posFind >= 0 && posFind < doclen) {	// search all the document
-		SA::Position wordEnd = posFind + rootLength;
-		if (posFind != posCurrentWord) {
-			while (Contains(wordCharacters, acc.SafeGetCharAt(wordEnd)))
-				wordEnd++;
-			const SA::Position wordLength = wordEnd - posFind;
-			if (wordLength > rootLength) {
-				std::string word = wEditor.StringOfRange(SA::Range(posFind, wordEnd));
-				word.insert(0, "\n");
-				word.append("\n");
-				if (wordsNear.find(word.c_str()) == std::string::npos) {	// add a new entry
-					wordsNear += word.c_str() + 1;
-					if (minWordLength < wordLength)
-						minWordLength = wordLength;
-
-					nwords++;
-					if (onlyOneWord && nwords > 1) {
-						return true;
-					}
-				}
-			}
-		}
-		wEditor.SetTarget(SA::Range(wordEnd, doclen));
-		posFind = wEditor.SearchInTarget(root);
+	// The word being typed is only offered if it also occurs elsewhere
+	SA::Position endword = current;
+	while (endword < static_cast<SA::Position>(line.length()) && Contains(wordCharacters, line[endword]))
+		endword++;
+	const std::string wordCurrent = line.substr(startword, endword - startword);
+
+	WordIndex &wordIndex = CurrentBuffer()->wordIndex;
+	if (!wordIndex.IsValid(wordCharacters)) {
+		const char *text = static_cast<const char *>(wEditor.CharacterPointer());
+		wordIndex.Build(std::string_view(text, LengthDocument()), wordCharacters);
+		if (!wordIndexUsed) {
+			// undo.redo.lazy leaves insert and delete notifications off until they are needed
+			wordIndexUsed = true;
+			wEditor.SetModEventMask(wEditor.ModEventMask() |
+				SA::ModificationFlags::InsertText |
+				SA::ModificationFlags::DeleteText);
+		}
+	}
+	const std::vector<std::string> words = wordIndex.WordsStartingWith(
+			root, autoCompleteIgnoreCase, wordCurrent, onlyOneWord ? 2 : 0);
+	if (onlyOneWord && words.size() > 1) {
+		return true;
 	}
-	const size_t length = wordsNear.length();
-	if ((length > 2) && (!onlyOneWord || (minWordLength > rootLength))) {
+
+	if (!words.empty()) {
+		// wordsNear contains a list of words separated by line ends and with a line end
+		// at the start and end.
+		std::string wordsNear;
+		wordsNear.append("\n");
+		for (const std::string &word : words) {
+			wordsNear += word;
+			wordsNear.append("\n");
+		}
 		// Protect spaces by temporarily transforming to \001
 		std::replace(wordsNear.begin(), wordsNear.end(), ' ', '\001');
 		StringList wl(true);
@@ -3417,6 +3457,7 @@ void SciTEBase::MenuCommand(int cmdID, int source) {
 		break;
 
 	case IDM_CLEAROUTPUT:
+		OutputFlushQueued();
 		wOutput.ClearAll();
 		break;
 
@@ -3521,6 +3562,7 @@ void SciTEBase::MenuCommand(int cmdID, int source) {
 		break;
 
 	case IDM_STOPEXECUTE:
+		CancelExport();
 		StopExecute();
 		break;
 
@@ -3866,14 +3908,68 @@ void SciTEBase::UpdateUI(const SCNotification *notification) {
 	}
 }
 
+void SciTEBase::UpdateWordIndex(const SCNotification *notification) {
+	// Large modifications are cheaper to handle by rebuilding the index when next needed
+	constexpr SA::Position maxIndexedModification = 1000000;
+	WordIndex &wordIndex = CurrentBuffer()->wordIndex;
+	if (!wordIndex.IsValid())
+		return;
+	// Deleted text is not available when undo collection is off
+	if (!notification->text || (notification->length > maxIndexedModification)) {
+		wordIndex.Invalidate();
+		return;
+	}
+	const bool insertion = FlagIsSet(static_cast<SA::ModificationFlags>(notification->modificationType),
+		SA::ModificationFlags::InsertText);
+	const SA::Position position = notification->position;
+	const SA::Position positionAfter = insertion ? position + notification->length : position;
+	// Include the word characters around the modification as words may be joined or split
+	TextReader acc(wEditor);
+	SA::Position wordStart = position;
+	while (wordStart > 0 && Contains(wordCharacters, acc.SafeGetCharAt(wordStart - 1)))
+		wordStart--;
+	SA::Position wordEnd = positionAfter;
+	while (Contains(wordCharacters, acc.SafeGetCharAt(wordEnd)))
+		wordEnd++;
+	const std::string before = wEditor.StringOfRange(SA::Range(wordStart, position));
+	const std::string after = wEditor.StringOfRange(SA::Range(positionAfter, wordEnd));
+	const std::string textWithout = before + after;
+	const std::string textWith = before + std::string(notification->text, notification->length) + after;
+	if (insertion) {
+		wordIndex.Replace(textWithout, textWith);
+	} else {
+		wordIndex.Replace(textWith, textWithout);
+	}
+}
+
 void SciTEBase::Modified(const SCNotification *notification) {
 	const SA::ModificationFlags modificationType =
 		static_cast<SA::ModificationFlags>(notification->modificationType);
 	const bool textWasModified = FlagIsSet(modificationType, SA::ModificationFlags::InsertText) ||
 		FlagIsSet(modificationType, SA::ModificationFlags::DeleteText);
-	if ((notification->nmhdr.idFrom == IDM_SRCWIN) && textWasModified)
+	if ((notification->nmhdr.idFrom == IDM_SRCWIN) && textWasModified) {
 		CurrentBuffer()->DocumentModified();
-	if (FlagIsSet(modificationType, SA::ModificationFlags::LastStepInUndoRedo)) {
+		UpdateWordIndex(notification);
+	}
+	bool findMarksUpdated = false;
+	if (textWasModified) {
+		// Matches on the changed lines are marked again when idle
+		GUI::ScintillaWindow &wModified = (notification->nmhdr.idFrom == IDM_SRCWIN) ? wEditor : wOutput;
+		const bool insertion = FlagIsSet(modificationType, SA::ModificationFlags::InsertText);
+		findMarksUpdated = findMarker.Modified(&wModified, notification->position, notification->length, insertion);
+		const bool currentWordUpdated = matchMarker.Modified(&wModified, notification->position, notification->length, insertion);
+		if (findMarksUpdated || currentWordUpdated)
+			SetIdler(true);
+	}
+	if (FlagIsSet(modificationType, SA::ModificationFlags::ChangeStyle)) {
+		// Words matched by style are checked again where styles changed
+		GUI::ScintillaWindow &wModified = (notification->nmhdr.idFrom == IDM_SRCWIN) ? wEditor : wOutput;
+		if (matchMarker.Restyled(&wModified, notification->position, notification->length))
+			SetIdler(true);
+	}
+	if (undoRedoLazy) {
+		// Insert and delete notifications are only for the word index, if any
+	} else if (FlagIsSet(modificationType, SA::ModificationFlags::LastStepInUndoRedo)) {
 		// When the user hits undo or redo, several normal insert/delete
 		// notifications may fire, but we will end up here in the end
 		EnableAMenuItem(IDM_UNDO, CallFocusedElseDefault(true, SA::Message::CanUndo));
@@ -3885,7 +3981,7 @@ void SciTEBase::Modified(const SCNotification *notification) {
 		// This will be called a lot, and usually means "typing".
 		EnableAMenuItem(IDM_UNDO, true);
 		EnableAMenuItem(IDM_REDO, false);
-		if (CurrentBuffer()->findMarks == Buffer::fmMarked) {
+		if ((CurrentBuffer()->findMarks == Buffer::fmMarked) && !findMarksUpdated) {
 			CurrentBuffer()->findMarks = Buffer::fmModified;
 		}
 	}
@@ -4126,7 +4222,7 @@ void SciTEBase::CheckMenus() {
 	EnableAMenuItem(IDM_OPENDIRECTORYPROPERTIES, props.GetInt("properties.directory.enable") != 0);
 	for (int toolItem = 0; toolItem < toolMax; toolItem++)
 		EnableAMenuItem(IDM_TOOLS + toolItem, ToolIsImmediate(toolItem) || !jobQueue.IsExecuting());
-	EnableAMenuItem(IDM_STOPEXECUTE, jobQueue.IsExecuting());
+	EnableAMenuItem(IDM_STOPEXECUTE, jobQueue.IsExecuting() || pFileExporter);
 	if (buffers.size() > 0) {
 		TabSelect(buffers.Current());
 		for (int bufferItem = 0; bufferItem < buffers.lengthVisible; bufferItem++) {
@@ -4229,6 +4325,9 @@ void SciTEBase::OnTimer() {
 		}
 		SetDocumentAt(currentBuffer);
 	}
+	if ((timerMask & timerTailFollow) && (0 == dialogsOnScreen)) {
+		CheckTail();
+	}
 }
 
 void SciTEBase::SetIdler(bool on) {
@@ -4730,28 +4829,31 @@ bool SciTEBase::ProcessCommandLine(const GUI::gui_string &args, int phase) {
 intptr_t SciTEBase::Send(Pane p, SA::Message msg, uintptr_t wParam, intptr_t lParam) {
 	if (p == paneEditor)
 		return wEditor.Call(msg, wParam, lParam);
-	else
-		return wOutput.Call(msg, wParam, lParam);
+	OutputFlushQueued();
+	return wOutput.Call(msg, wParam, lParam);
 }
 std::string SciTEBase::Range(Pane p, SA::Range range) {
 	if (p == paneEditor)
 		return wEditor.StringOfRange(range);
-	else
-		return wOutput.StringOfRange(range);
+	OutputFlushQueued();
+	return wOutput.StringOfRange(range);
 }
 void SciTEBase::Remove(Pane p, SA::Position start, SA::Position end) {
 	if (p == paneEditor) {
 		wEditor.DeleteRange(start, end-start);
 	} else {
+		OutputFlushQueued();
 		wOutput.DeleteRange(start, end-start);
 	}
 }
 
 void SciTEBase::Insert(Pane p, SA::Position pos, const char *s) {
-	if (p == paneEditor)
+	if (p == paneEditor) {
 		wEditor.InsertText(pos, s);
-	else
+	} else {
+		OutputFlushQueued();
 		wOutput.InsertText(pos, s);
+	}
 }
 
 void SciTEBase::Trace(const char *s) {
@@ -4803,8 +4905,8 @@ void SciTEBase::DoMenuCommand(int cmdID) {
 SA::ScintillaCall &SciTEBase::PaneCaller(Pane p) noexcept {
 	if (p == paneEditor)
 		return wEditor;
-	else
-		return wOutput;
+	OutputFlushQueued();
+	return wOutput;
 }
 
 void SciTEBase::SetFindInFilesOptions() {
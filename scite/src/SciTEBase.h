@@ -86,6 +86,24 @@ public:
 };
 
 struct FileWorker;
+class FileExporter;
+class ExportGenerator;
+
+/// The end of the file contents loaded into a buffer, so growth of the file by
+/// appending can be recognised and loaded without reading the whole file again.
+struct FileTail {
+	long long length = -1;	///< Bytes of the file in the buffer or -1 when not known
+	size_t lengthHashed = 0;	///< Bytes before length covered by hash
+	uint64_t hash = 0;
+	bool Valid() const noexcept {
+		return length >= 0;
+	}
+	void Invalidate() noexcept {
+		length = -1;
+		lengthHashed = 0;
+		hash = 0;
+	}
+};
 
 class Buffer {
 public:
@@ -95,7 +113,7 @@ public:
 	bool isReadOnly;
 	bool failedSave;
 	bool useMonoFont;
-	enum { empty, reading, readAll, opened } lifeState;
+	enum { empty, deferred, reading, readAll, opened } lifeState;
 	UniMode unicodeMode;
 	time_t fileModTime;
 	time_t fileModLastAsk;
@@ -106,6 +124,8 @@ public:
 	std::vector<SA::Line> bookmarks;
 	FileWorker *pFileWorker;
 	PropSetFile props;
+	WordIndex wordIndex;	///< Words in the document for autocompletion, built on first use
+	FileTail tail;
 	enum FutureDo { fdNone=0, fdFinishSave=1 } futureDo;
 	Buffer() :
 		file(), doc(nullptr), isDirty(false), isReadOnly(false), failedSave(false), useMonoFont(false), lifeState(empty),
@@ -129,6 +149,8 @@ public:
 		foldState.clear();
 		bookmarks.clear();
 		pFileWorker = nullptr;
+		wordIndex.Invalidate();
+		tail.Invalidate();
 		futureDo = fdNone;
 	}
 
@@ -137,6 +159,8 @@ public:
 		fileModLastAsk = fileModTime;
 		documentModTime = fileModTime;
 		failedSave = false;
+		// The document may not match the file until the tail is recorded again
+		tail.Invalidate();
 	}
 
 	void DocumentModified() noexcept;
@@ -191,6 +215,9 @@ public:
 	int StackPrev();
 	void CommitStackSelection();
 	void MoveToStackTop(int index);
+	int StackAt(int position) const noexcept {
+		return stack[position];
+	}
 	void ShiftTo(int indexFrom, int indexTo);
 	void Swap(int indexA, int indexB);
 	bool SingleBuffer() const noexcept;
@@ -356,6 +383,7 @@ public:
 
 class IEditorConfig;
 struct SCNotification;
+class GlobalReader;
 
 struct SystemAppearance {
 	bool dark;
@@ -366,6 +394,7 @@ struct SystemAppearance {
 };
 
 class SciTEBase : public ExtensionAPI, public Searcher, public WorkerListener {
+	friend class GlobalReader;
 protected:
 	bool needIdle;
 	GUI::gui_string windowName;
@@ -470,9 +499,10 @@ protected:
 	Extension *extender;
 	bool needReadProperties;
 	bool quitting;
+	int prefetchRemaining;
 
 	int timerMask;
-	enum { timerAutoSave=1 };
+	enum { timerAutoSave=1, timerTailFollow=2 };
 	int delayBeforeAutoSave;
 
 	int heightOutput;
@@ -492,6 +522,8 @@ protected:
 	SA::IndentView indentExamine;
 	bool autoCompleteIgnoreCase;
 	bool imeAutoComplete;
+	bool undoRedoLazy;
+	bool wordIndexUsed;	///< A word index has been built so insert and delete notifications are needed
 	bool callTipUseEscapes;
 	bool callTipIgnoreCase;
 	bool autoCCausedByOnlyOne;
@@ -526,6 +558,7 @@ protected:
 
 	bool allowMenuActions;
 	int scrollOutput;
+	int outputMaxLines;
 	bool returnOutputToCommand;
 	JobQueue jobQueue;
 
@@ -556,6 +589,7 @@ protected:
 
 	enum { bufferMax = IDM_IMPORT - IDM_BUFFER };
 	BufferList buffers;
+	FileExporter *pFileExporter;	// Export being written in the background
 
 	// Handle buffers
 	void *GetDocumentAt(int index);
@@ -622,6 +656,8 @@ protected:
 	FilePath UserFilePath(const GUI::gui_char *name);
 	void LoadSessionFile(const GUI::gui_char *sessionName);
 	void RestoreRecentMenu();
+	bool AddDeferredBuffer(const BufferState &bufferState);
+	void LoadDeferred();
 	void RestoreFromSession(const Session &session);
 	void RestoreSession();
 	void SaveSessionFile(const GUI::gui_char *sessionName);
@@ -635,7 +671,10 @@ protected:
 	void DiscoverEOLSetting();
 	void DiscoverIndentSetting();
 	std::string DiscoverLanguage();
+	SA::DocumentOption DocumentOptionsForSize(long long fileSize);
 	void OpenCurrentFile(long long fileSize, bool suppressMessage, bool asynchronous);
+	bool PrefetchBuffer(int index);
+	void PrefetchDeferred();
 	virtual void OpenUriList(const char *) {}
 	virtual bool OpenDialog(const FilePath &directory, const GUI::gui_char *filesFilter) = 0;
 	virtual bool SaveAsDialog() = 0;
@@ -652,6 +691,7 @@ protected:
 	};
 	void TextRead(FileWorker *pFileWorker);
 	void TextWritten(FileWorker *pFileWorker);
+	void MalformedTextMessage(const FilePath &path, size_t offset, bool saving);
 	void UpdateProgress(Worker *pWorker);
 	void PerformDeferredTasks();
 	enum OpenCompletion { ocSynchronous, ocCompleteCurrent, ocCompleteSwitch };
@@ -678,16 +718,21 @@ protected:
 	virtual bool Save(SaveFlags sf = sfProgressVisible);
 	void SaveAs(const GUI::gui_char *file, bool fixCase);
 	virtual void SaveACopy() = 0;
-	void SaveToHTML(const FilePath &saveName);
+	void SaveToHTML(const FilePath &saveName, SaveFlags sf = sfSynchronous);
 	void StripTrailingSpaces();
 	void EnsureFinalNewLine();
 	bool PrepareBufferForSave(const FilePath &saveName);
 	bool SaveBuffer(const FilePath &saveName, SaveFlags sf);
+	void SaveExport(const FilePath &saveName, const GUI::gui_char *mode, std::unique_ptr<ExportGenerator> &&generator, SaveFlags sf);
+	void ExportWritten(FileWorker *pFileWorker);
+	void CancelExport();
 	virtual void SaveAsHTML() = 0;
+	std::unique_ptr<ExportGenerator> RTFGeneratorFromRange(SA::Position start, SA::Position end);
+	std::string RTFFromRange(SA::Position start, SA::Position end);
 	void SaveToStreamRTF(std::ostream &os, SA::Position start = 0, SA::Position end = -1);
-	void SaveToRTF(const FilePath &saveName, SA::Position start = 0, SA::Position end = -1);
+	void SaveToRTF(const FilePath &saveName, SA::Position start = 0, SA::Position end = -1, SaveFlags sf = sfSynchronous);
 	virtual void SaveAsRTF() = 0;
-	void SaveToPDF(const FilePath &saveName);
+	void SaveToPDF(const FilePath &saveName, SaveFlags sf = sfSynchronous);
 	virtual void SaveAsPDF() = 0;
 	void SaveToTEX(const FilePath &saveName);
 	virtual void SaveAsTEX() = 0;
@@ -783,7 +828,10 @@ protected:
 	void GoMatchingPreprocCond(int direction, bool select);
 	virtual void FindReplace(bool replace) = 0;
 	void OutputAppendString(const char *s, SA::Position len = -1);
+	void OutputLimitLines();
+	virtual void OutputTrimmed(SA::Position lengthRemoved);
 	virtual void OutputAppendStringSynchronised(const char *s, SA::Position len = -1);
+	virtual void OutputFlushQueued() noexcept;
 	virtual void Execute();
 	virtual void StopExecute() = 0;
 	void ShowMessages(SA::Line line);
@@ -845,6 +893,7 @@ protected:
 	void NewLineInOutput();
 	virtual void SetStatusBarText(const char *s) = 0;
 	void UpdateUI(const SCNotification *notification);
+	void UpdateWordIndex(const SCNotification *notification);
 	void Modified(const SCNotification *notification);
 	virtual void Notify(SCNotification *notification);
 	virtual void ShowToolBar() = 0;
@@ -927,6 +976,9 @@ protected:
 	static void SetOneIndicator(GUI::ScintillaWindow &win, int indicator, const IndicatorDefinition &ind);
 	void ReloadProperties();
 
+	void RecordFileTail();
+	bool FollowTail();
+	void CheckTail();
 	void CheckReload();
 	void Activate(bool activeApp);
 	GUI::Rectangle GetClientRectangle();
@@ -372,6 +372,7 @@ void SciTEBase::SwitchDocumentAt(int index, void *pdoc) {
 	}
 	void *pdocOld = buffers.buffers[index].doc;
 	buffers.buffers[index].doc = pdoc;
+	buffers.buffers[index].wordIndex.Invalidate();
 	if (pdocOld) {
 		wEditor.ReleaseDocument(pdocOld);
 	}
@@ -409,6 +410,20 @@ void SciTEBase::SetDocumentAt(int index, bool updateStack) {
 	propsDiscovered = bufferNext.props;
 	propsDiscovered.superPS = &propsLocal;
 	wEditor.SetDocPointer(GetDocumentAt(buffers.Current()));
+	if (bufferNext.lifeState == Buffer::deferred) {
+		// Restored lazily from a session so read the file now which restores its state
+		TabSelect(index);
+		LoadDeferred();
+		CheckMenus();
+		if (extender) {
+			extender->OnSwitchFile(filePath.AsUTF8().c_str());
+		}
+		return;
+	}
+	if (bufferNext.lifeState == Buffer::reading) {
+		// Being prefetched in the background
+		wEditor.SetReadOnly(true);
+	}
 	const bool restoreBookmarks = bufferNext.lifeState == Buffer::readAll;
 	PerformDeferredTasks();
 	if (bufferNext.lifeState == Buffer::readAll) {
@@ -442,7 +457,9 @@ void SciTEBase::SetDocumentAt(int index, bool updateStack) {
 void SciTEBase::UpdateBuffersCurrent() {
 	const int currentbuf = buffers.Current();
 
-	if ((buffers.length > 0) && (currentbuf >= 0) && (buffers.GetVisible(currentbuf))) {
+	// A deferred buffer is not yet shown so keeps the file and state from the session
+	if ((buffers.length > 0) && (currentbuf >= 0) && (buffers.GetVisible(currentbuf)) &&
+			(buffers.buffers[currentbuf].lifeState != Buffer::deferred)) {
 		Buffer &bufferCurrent = buffers.buffers[currentbuf];
 		bufferCurrent.file.Set(filePath);
 		if (bufferCurrent.lifeState != Buffer::reading && bufferCurrent.lifeState != Buffer::readAll) {
@@ -622,12 +639,78 @@ std::string StringFromLines(const std::vector<SA::Line> &lines) {
 
 }
 
+bool SciTEBase::AddDeferredBuffer(const BufferState &bufferState) {
+	// Add a buffer for a file without reading it. Return false if a buffer can not be
+	// made without closing another so the caller should open it normally.
+	if (!bufferState.file.IsNotLocal() && !bufferState.file.Exists()) {
+		return true;	// Ignored like AddFileToBuffer
+	}
+	const FilePath absPath = bufferState.file.AbsolutePath();
+	if (buffers.GetDocumentByName(absPath) >= 0) {
+		return true;
+	}
+	const Buffer *current = CurrentBufferConst();
+	int index = buffers.Current();
+	if ((buffers.length == 1) && current->file.IsUntitled() && !current->isDirty &&
+			!current->pFileWorker && (wEditor.Length() == 0)) {
+		// Replace the initial empty buffer as New would
+	} else if (IsBufferAvailable()) {
+		index = buffers.Add();
+		if (extender) {
+			extender->InitBuffer(index);
+			extender->ActivateBuffer(buffers.Current());
+		}
+	} else {
+		return false;
+	}
+	Buffer &buffer = buffers.buffers[index];
+	buffer.file = bufferState.file;
+	buffer.file.Set(absPath);
+	buffer.foldState = bufferState.foldState;
+	buffer.bookmarks = bufferState.bookmarks;
+	buffer.lifeState = Buffer::deferred;
+	return true;
+}
+
+void SciTEBase::LoadDeferred() {
+	// Read the current buffer's file now it is shown. Open finds the buffer by name
+	// and loads into it, then AddFileToBuffer restores position, folds and bookmarks.
+	Buffer *buffer = CurrentBuffer();
+	BufferState bufferState;
+	bufferState.file = buffer->file;
+	bufferState.foldState = buffer->foldState;
+	bufferState.bookmarks = buffer->bookmarks;
+	buffer->lifeState = Buffer::empty;
+	if (!AddFileToBuffer(bufferState)) {
+		// Removed or refused since the session was saved so leave an empty buffer
+		CurrentBuffer()->lifeState = Buffer::opened;
+		SetBuffersMenu();
+		UpdateStatusBar(true);
+	}
+}
+
 void SciTEBase::RestoreFromSession(const Session &session) {
-	for (const BufferState &buffer : session.buffers)
-		AddFileToBuffer(buffer);
-	const int iBuffer = buffers.GetDocumentByName(session.pathActive);
+	// With session.lazy, only the active file is read now and the others when first shown
+	const bool lazy = props.GetInt("session.lazy") && (buffers.size() > 1);
+	FilePath pathActive = session.pathActive;
+	if (lazy && !pathActive.IsSet() && !session.buffers.empty()) {
+		pathActive = session.buffers.back().file;
+	}
+	for (const BufferState &buffer : session.buffers) {
+		if (!lazy || buffer.file.SameNameAs(pathActive) || !AddDeferredBuffer(buffer))
+			AddFileToBuffer(buffer);
+	}
+	const int iBuffer = buffers.GetDocumentByName(pathActive);
 	if (iBuffer >= 0)
 		SetDocumentAt(iBuffer);
+	if (lazy) {
+		if (CurrentBuffer()->lifeState == Buffer::deferred) {
+			LoadDeferred();
+		}
+		SetBuffersMenu();
+		prefetchRemaining = props.GetInt("session.lazy.prefetch");
+		PrefetchDeferred();
+	}
 }
 
 void SciTEBase::RestoreSession() {
@@ -1006,9 +1089,13 @@ void SciTEBase::Close(bool updateUI, bool loadingSession, bool makingRoomForNew)
 			ClearDocument();
 		}
 		if (updateUI) {
-			CheckReload();
-			RestoreState(bufferNext, false);
-			DisplayAround(bufferNext.file);
+			if (bufferNext.lifeState == Buffer::deferred) {
+				LoadDeferred();
+			} else {
+				CheckReload();
+				RestoreState(bufferNext, false);
+				DisplayAround(bufferNext.file);
+			}
 		}
 	}
 
@@ -250,6 +250,20 @@ void SciTEBase::DiscoverIndentSetting() {
 	}
 }
 
+SA::DocumentOption SciTEBase::DocumentOptionsForSize(long long fileSize) {
+	SA::DocumentOption docOptions = SA::DocumentOption::Default;
+
+	const long long sizeLarge = props.GetLongLong("file.size.large");
+	if (sizeLarge && (fileSize > sizeLarge))
+		docOptions = SA::DocumentOption::TextLarge;
+
+	const long long sizeNoStyles = props.GetLongLong("file.size.no.styles");
+	if (sizeNoStyles && (fileSize > sizeNoStyles))
+		docOptions = static_cast<SA::DocumentOption>(
+				     static_cast<int>(docOptions) | static_cast<int>(SA::DocumentOption::StylesNone));
+	return docOptions;
+}
+
 void SciTEBase::OpenCurrentFile(long long fileSize, bool suppressMessage, bool asynchronous) {
 	if (CurrentBuffer()->pFileWorker) {
 		// Already performing an asynchronous load or save so do not restart load
@@ -285,27 +299,19 @@ void SciTEBase::OpenCurrentFile(long long fileSize, bool suppressMessage, bool a
 		assert(CurrentBufferConst()->pFileWorker == nullptr);
 		ILoader *pdocLoad;
 		try {
-			SA::DocumentOption docOptions = SA::DocumentOption::Default;
-
-			const long long sizeLarge = props.GetLongLong("file.size.large");
-			if (sizeLarge && (fileSize > sizeLarge))
-				docOptions = SA::DocumentOption::TextLarge;
-
-			const long long sizeNoStyles = props.GetLongLong("file.size.no.styles");
-			if (sizeNoStyles && (fileSize > sizeNoStyles))
-				docOptions = static_cast<SA::DocumentOption>(
-						     static_cast<int>(docOptions) | static_cast<int>(SA::DocumentOption::StylesNone));
-
 			pdocLoad = static_cast<ILoader *>(
 					   wEditor.CreateLoader(static_cast<SA::Position>(fileSize) + 1000,
-								docOptions));
+								DocumentOptionsForSize(fileSize)));
 		} catch (...) {
 			wEditor.SetStatus(SA::Status::Ok);
 			return;
 		}
-		CurrentBuffer()->pFileWorker = new FileLoader(this, pdocLoad, filePath, static_cast<size_t>(fileSize), fp);
-		CurrentBuffer()->pFileWorker->sleepTime = props.GetInt("asynchronous.sleep");
-		PerformOnNewThread(CurrentBuffer()->pFileWorker);
+		FileLoader *pFileLoader = new FileLoader(this, pdocLoad, filePath, static_cast<size_t>(fileSize), fp);
+		pFileLoader->sleepTime = props.GetInt("asynchronous.sleep");
+		const long long sizeMapped = props.GetLongLong("load.mmap.size");
+		pFileLoader->mapFile = sizeMapped && (fileSize > sizeMapped);
+		CurrentBuffer()->pFileWorker = pFileLoader;
+		PerformOnNewThread(pFileLoader);
 	} else {
 		wEditor.Allocate(static_cast<SA::Position>(fileSize) + 1000);
 
@@ -338,6 +344,7 @@ void SciTEBase::OpenCurrentFile(long long fileSize, bool suppressMessage, bool a
 		}
 
 		CompleteOpen(ocSynchronous);
+		MalformedTextMessage(filePath, convert.getFirstInvalid(), false);
 	}
 }
 
@@ -366,7 +373,67 @@ void SciTEBase::TextRead(FileWorker *pFileWorker) {
 			DisplayAround(buffers.buffers[iBuffer].file);
 			wEditor.ScrollCaret();
 		}
+		MalformedTextMessage(pFileLoader->path, pFileLoader->firstInvalid, false);
+	}
+	PrefetchDeferred();
+}
+
+bool SciTEBase::PrefetchBuffer(int index) {
+	// Start reading a buffer restored by session.lazy into a document that is not shown.
+	// When finished, TextRead leaves it as readAll so SetDocumentAt completes the open.
+	Buffer &buffer = buffers.buffers[index];
+	const long long fileSize = buffer.file.GetFileLength();
+	const long long maxSize = props.GetLongLong("max.file.size", 2000000000LL);
+	if ((fileSize > INTPTR_MAX) || (maxSize > 0 && fileSize > maxSize) ||
+			props.GetString("command.discover.properties").length()) {
+		// Needs a question or a discovery command so wait until shown
+		return false;
+	}
+	FILE *fp = buffer.file.Open(fileRead);
+	if (!fp) {
+		return false;
+	}
+	ILoader *pdocLoad;
+	try {
+		pdocLoad = static_cast<ILoader *>(
+				   wEditor.CreateLoader(static_cast<SA::Position>(fileSize) + 1000,
+							DocumentOptionsForSize(fileSize)));
+	} catch (...) {
+		fclose(fp);
+		return false;
+	}
+	FileLoader *pFileLoader = new FileLoader(this, pdocLoad, buffer.file, static_cast<size_t>(fileSize), fp);
+	pFileLoader->sleepTime = props.GetInt("asynchronous.sleep");
+	const long long sizeMapped = props.GetLongLong("load.mmap.size");
+	pFileLoader->mapFile = sizeMapped && (fileSize > sizeMapped);
+	buffer.SetTimeFromFile();
+	buffer.isReadOnly = props.GetInt("read.only");
+	buffer.lifeState = Buffer::reading;
+	buffer.pFileWorker = pFileLoader;
+	PerformOnNewThread(pFileLoader);
+	return true;
+}
+
+void SciTEBase::PrefetchDeferred() {
+	if (prefetchRemaining <= 0) {
+		return;
+	}
+	// Only one prefetch at a time so foreground loads are not slowed
+	for (int i = 0; i < buffers.length; i++) {
+		if (buffers.buffers[i].lifeState == Buffer::reading) {
+			return;
+		}
 	}
+	for (int position = 0; position < buffers.length; position++) {
+		const int index = buffers.StackAt(position);
+		if ((index != buffers.Current()) && (buffers.buffers[index].lifeState == Buffer::deferred)) {
+			prefetchRemaining--;
+			if (PrefetchBuffer(index) || (prefetchRemaining <= 0)) {
+				return;
+			}
+		}
+	}
+	prefetchRemaining = 0;
 }
 
 void SciTEBase::PerformDeferredTasks() {
@@ -425,6 +492,7 @@ void SciTEBase::CompleteOpen(OpenCompletion oc) {
 	wEditor.GotoPos(0);
 
 	CurrentBuffer()->CompleteLoading();
+	RecordFileTail();
 
 	Redraw();
 }
@@ -435,6 +503,7 @@ void SciTEBase::TextWritten(FileWorker *pFileWorker) {
 
 	FilePath pathSaved = pFileStorer->path;
 	const int errSaved = pFileStorer->err;
+	const size_t firstInvalidSaved = pFileStorer->firstInvalid;
 	const bool cancelledSaved = pFileStorer->Cancelling();
 
 	// May not be found if save cancelled or buffer closed
@@ -475,6 +544,8 @@ void SciTEBase::TextWritten(FileWorker *pFileWorker) {
 
 	if (errSaved) {
 		FailedSaveMessageBox(pathSaved);
+	} else {
+		MalformedTextMessage(pathSaved, firstInvalidSaved, true);
 	}
 
 	if (IsPropertiesFile(pathSaved)) {
@@ -489,9 +560,28 @@ void SciTEBase::TextWritten(FileWorker *pFileWorker) {
 	}
 }
 
+// Text that is not well-formed is converted as well as possible so the file
+// differs from what was read or shown. Say where in the output pane.
+void SciTEBase::MalformedTextMessage(const FilePath &path, size_t offset, bool saving) {
+	if (offset == Utf8_16::k_noInvalid)
+		return;
+	const GUI::gui_string msg = LocaliseMessage(saving ?
+		"Malformed UTF-8 converted when saving '^0' at byte ^1." :
+		"Unpaired UTF-16 surrogate in '^0' at byte ^1.",
+		path.AsInternal(), GUI::StringFromLongLong(offset).c_str());
+	OutputAppendStringSynchronised((">" + GUI::UTF8FromString(msg) + "\n").c_str());
+	SetOutputVisibility(true);
+}
+
 void SciTEBase::UpdateProgress(Worker *) {
 	GUI::gui_string prog;
 	BackgroundActivities bgActivities = buffers.CountBackgroundActivities();
+	if (pFileExporter && !pFileExporter->FinishedJob()) {
+		bgActivities.storers++;
+		bgActivities.fileNameLast = pFileExporter->path.AsInternal();
+		bgActivities.totalWork += pFileExporter->SizeJob();
+		bgActivities.totalProgress += pFileExporter->ProgressMade();
+	}
 	const int countBoth = bgActivities.loaders + bgActivities.storers;
 	if (countBoth == 0) {
 		// Should hide UI
@@ -767,7 +857,108 @@ void SciTEBase::Revert() {
 	}
 }
 
+namespace {
+
+// Enough of the end of a file to be confident it has not been changed before appending
+constexpr size_t tailHashSize = 4096;
+
+// FNV-1a
+uint64_t HashTail(std::string_view text) noexcept {
+	uint64_t hash = 14695981039346656037ULL;
+	for (const char ch : text) {
+		hash = (hash ^ static_cast<unsigned char>(ch)) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+}
+
+/**
+ * Remember how much of the file is in the current buffer and a hash of its last bytes.
+ * Only possible when the document holds the file's bytes unchanged so not for UTF-16.
+ */
+void SciTEBase::RecordFileTail() {
+	Buffer *buffer = CurrentBuffer();
+	buffer->tail.Invalidate();
+	if ((buffer->unicodeMode == uni16BE) || (buffer->unicodeMode == uni16LE))
+		return;
+	const SA::Position length = wEditor.Length();
+	const SA::Position lengthHashed = std::min<SA::Position>(length, tailHashSize);
+	const char *text = static_cast<const char *>(wEditor.RangePointer(length - lengthHashed, lengthHashed));
+	if (lengthHashed && !text)
+		return;
+	// The byte order mark is removed when reading
+	const long long lengthBOM = (buffer->unicodeMode == uniUTF8) ? 3 : 0;
+	buffer->tail.length = length + lengthBOM;
+	buffer->tail.lengthHashed = lengthHashed;
+	buffer->tail.hash = HashTail(std::string_view(text, lengthHashed));
+}
+
+/**
+ * When tail.follow is set and the file has only grown by having text appended since
+ * it was loaded, append the new text to the end of the document instead of reloading.
+ * Styling continues from the previous end and the caret follows the end of the file
+ * when it was there and tail.follow.scroll is set.
+ * Returns false when the whole file should be checked for reloading instead.
+ */
+bool SciTEBase::FollowTail() {
+	Buffer *buffer = CurrentBuffer();
+	if (!props.GetInt("tail.follow") || !buffer->tail.Valid() || buffer->isDirty ||
+			buffer->pFileWorker || (buffer->lifeState != Buffer::opened))
+		return false;
+	const long long lengthFile = filePath.GetFileLength();
+	if (lengthFile <= buffer->tail.length)
+		return false;
+	FILE *fp = filePath.Open(fileRead);
+	if (!fp)
+		return false;
+	std::vector<char> data(blockSize);
+	const size_t lengthHashed = buffer->tail.lengthHashed;
+	if (!SeekFile(fp, buffer->tail.length - lengthHashed) ||
+			(fread(data.data(), 1, lengthHashed, fp) != lengthHashed) ||
+			(HashTail(std::string_view(data.data(), lengthHashed)) != buffer->tail.hash)) {
+		// Changed before the previous end so not just appended to
+		fclose(fp);
+		return false;
+	}
+
+	const bool caretAtEnd = wEditor.CurrentPos() == wEditor.Length();
+	const bool readOnly = wEditor.ReadOnly();
+	wEditor.SetReadOnly(false);
+	// The appended text is part of the file, not an edit that can be undone
+	wEditor.SetUndoCollection(false);
+	long long remaining = lengthFile - buffer->tail.length;
+	while (remaining > 0) {
+		const size_t lenBlock = fread(data.data(), 1,
+			static_cast<size_t>(std::min<long long>(remaining, data.size())), fp);
+		if (lenBlock == 0)
+			break;
+		wEditor.AppendText(lenBlock, data.data());
+		remaining -= lenBlock;
+	}
+	fclose(fp);
+	wEditor.SetUndoCollection(true);
+	wEditor.SetSavePoint();
+	wEditor.SetReadOnly(readOnly);
+
+	buffer->SetTimeFromFile();
+	RecordFileTail();
+	if (caretAtEnd && props.GetInt("tail.follow.scroll")) {
+		wEditor.DocumentEnd();
+	}
+	return true;
+}
+
+/// Called periodically or when the file changes while tail.follow is set.
+void SciTEBase::CheckTail() {
+	if (!FollowTail() && !CurrentBuffer()->isDirty) {
+		CheckReload();
+	}
+}
+
 void SciTEBase::CheckReload() {
+	if (FollowTail())
+		return;
 	if (props.GetInt("load.on.activate")) {
 		// Make a copy of fullPath as otherwise it gets aliased in Open
 		const time_t newModTime = filePath.ModifiedTime();
@@ -894,7 +1085,12 @@ SciTEBase::SaveResult SciTEBase::SaveIfUnsureAll() {
 	if (extender && extender->NeedsOnClose()) {
 		// Ensure extender is told about each buffer closing
 		for (int k = 0; k < buffers.lengthVisible; k++) {
-			SetDocumentAt(k);
+			if (buffers.buffers[k].lifeState == Buffer::deferred) {
+				// Not read since the session was restored and switching to it would read it
+				filePath = buffers.buffers[k].file;
+			} else {
+				SetDocumentAt(k);
+			}
 			extender->OnClose(filePath.AsUTF8().c_str());
 		}
 	}
@@ -1135,9 +1331,13 @@ bool SciTEBase::SaveBuffer(const FilePath &saveName, SaveFlags sf) {
 						break;
 					}
 				}
+				const size_t firstInvalid = convert.getFirstInvalid();
 				if (convert.fclose() != 0) {
 					retVal = false;
 				}
+				if (retVal) {
+					MalformedTextMessage(saveName, firstInvalid, true);
+				}
 			}
 		}
 	}
@@ -1149,6 +1349,65 @@ bool SciTEBase::SaveBuffer(const FilePath &saveName, SaveFlags sf) {
 	return retVal;
 }
 
+/**
+ * Writes the output of an exporter to the given filename.
+ * When the document is larger than background.save.size, the output is generated and
+ * written by another thread unless synchronous writing is requested. Only one export is
+ * performed in the background at a time so a further export while that is in progress
+ * is performed synchronously.
+ */
+void SciTEBase::SaveExport(const FilePath &saveName, const GUI::gui_char *mode, std::unique_ptr<ExportGenerator> &&generator, SaveFlags sf) {
+	FILE *fp = saveName.Open(mode);
+	if (!fp) {
+		FailedSaveMessageBox(saveName);
+		return;
+	}
+	if (!(sf & sfSynchronous) && !pFileExporter &&
+			(static_cast<SA::Position>(generator->SizeSource()) > props.GetInt("background.save.size", -1))) {
+		pFileExporter = new FileExporter(this, std::move(generator), saveName, fp);
+		pFileExporter->sleepTime = props.GetInt("asynchronous.sleep");
+		if (!PerformOnNewThread(pFileExporter)) {
+			// Completion is still reported through WorkerCommand
+			pFileExporter->Execute();
+		}
+		UpdateProgress(pFileExporter);
+		CheckMenus();
+		return;
+	}
+	const std::string output = generator->Generate(nullptr);
+	bool failedWrite = fwrite(output.data(), 1, output.length(), fp) != output.length();
+	if (fclose(fp) != 0) {
+		failedWrite = true;
+	}
+	if (failedWrite) {
+		FailedSaveMessageBox(saveName);
+	}
+}
+
+void SciTEBase::ExportWritten(FileWorker *pFileWorker) {
+	if (!pFileExporter || (pFileWorker != pFileExporter))
+		return;
+	const FilePath pathSaved = pFileExporter->path;
+	const bool cancelled = pFileExporter->Cancelling();
+	const bool failed = pFileExporter->err && !cancelled;
+	delete pFileExporter;
+	pFileExporter = nullptr;
+	CheckMenus();
+	if (cancelled) {
+		// Do not leave incomplete output behind
+		pathSaved.Remove();
+	} else if (failed) {
+		FailedSaveMessageBox(pathSaved);
+	}
+}
+
+void SciTEBase::CancelExport() {
+	// Stops writing, the exporter is released when its completion arrives
+	if (pFileExporter) {
+		pFileExporter->Cancel();
+	}
+}
+
 void SciTEBase::ReloadProperties() {
 	ReadGlobalPropFile();
 	SetImportMenu();
@@ -1204,6 +1463,7 @@ bool SciTEBase::Save(SaveFlags sf) {
 			CurrentBuffer()->SetTimeFromFile();
 			if (sf & sfSynchronous) {
 				wEditor.SetSavePoint();
+				RecordFileTail();
 				if (IsPropertiesFile(filePath)) {
 					ReloadProperties();
 				}
@@ -1288,6 +1548,7 @@ void SciTEBase::OpenFromStdin(bool UseOutputPane) {
 
 	Open(FilePath());
 	if (UseOutputPane) {
+		OutputFlushQueued();
 		wOutput.ClearAll();
 	} else {
 		wEditor.BeginUndoAction();	// Group together clear and insert
@@ -137,6 +137,21 @@ void SciTEBase::ReadEnvironment() {
 	}
 }
 
+// Snapshots of the global and user properties with their imports, kept in the user directory.
+const GUI::gui_char propGlobalSnapshotName[] = GUI_TEXT("SciTEGlobal.snapshot");
+const GUI::gui_char propUserSnapshotName[] = GUI_TEXT("SciTEUser.snapshot");
+
+// The embedded properties are read without a snapshot.
+class GlobalReader : public FilteredReader {
+	SciTEBase *pSciTE;
+public:
+	explicit GlobalReader(SciTEBase *pSciTE_) noexcept : pSciTE(pSciTE_) {
+	}
+	void ReadWithoutSnapshot(const ImportFilter &) override {
+		pSciTE->ReadEmbeddedProperties();
+	}
+};
+
 /**
 Read global and user properties files.
 */
@@ -146,35 +161,22 @@ void SciTEBase::ReadGlobalPropFile() {
 	propsPlatform.Set("Appearance", StdStringFromInteger(appearance.dark));
 	propsPlatform.Set("Contrast", StdStringFromInteger(appearance.highContrast));
 
-	std::string excludes;
-	std::string includes;
-
 	// Want to apply imports.exclude and imports.include but these may well be in
 	// user properties.
+	const std::vector<SnapshotRead> reads {
+		{ &propsBase, GetDefaultPropertiesFileName(), UserFilePath(propGlobalSnapshotName) },
+		{ &propsUser, GetUserPropertiesFileName(), UserFilePath(propUserSnapshotName) },
+	};
+	GlobalReader reader(this);
+	reader.Read(props, reads, filter, importFiles);
 
-	for (int attempt=0; attempt<2; attempt++) {
-
-		std::string excludesRead = props.GetString("imports.exclude");
-		std::string includesRead = props.GetString("imports.include");
-		if ((attempt > 0) && ((excludesRead == excludes) && (includesRead == includes)))
-			break;
-
-		excludes = excludesRead;
-		includes = includesRead;
-
-		filter.SetFilter(excludes.c_str(), includes.c_str());
-
-		importFiles.clear();
-
-		ReadEmbeddedProperties();
-
-		propsBase.Clear();
-		FilePath propfileBase = GetDefaultPropertiesFileName();
-		propsBase.Read(propfileBase, propfileBase.Directory(), filter, &importFiles, 0);
-
-		propsUser.Clear();
-		FilePath propfileUser = GetUserPropertiesFileName();
-		propsUser.Read(propfileUser, propfileUser.Directory(), filter, &importFiles, 0);
+	// Only sets that were parsed have recorded their inputs so are written
+	if (props.GetInt("properties.snapshot")) {
+		propsBase.WriteSnapshot(UserFilePath(propGlobalSnapshotName), filter);
+		propsUser.WriteSnapshot(UserFilePath(propUserSnapshotName), filter);
+	} else {
+		UserFilePath(propGlobalSnapshotName).Remove();
+		UserFilePath(propUserSnapshotName).Remove();
 	}
 
 	if (!localiser.read) {
@@ -187,6 +189,17 @@ void SciTEBase::ReadAbbrevPropFile() {
 	propsAbbrev.Read(pathAbbreviations, pathAbbreviations.Directory(), filter, &importFiles, 0);
 }
 
+// Read into a copy and only assign when the contents differ so that switching between files
+// with the same local properties does not discard the remembered wild property results.
+static void ReadReplacingWhenChanged(PropSetFile &propsTarget, const FilePath *propfile, const ImportFilter &filter) {
+	PropSetFile propsRead(propsTarget);	// Same superPS and lowerKeys for conditions
+	propsRead.Clear();
+	if (propfile) {
+		propsRead.Read(*propfile, propfile->Directory(), filter, nullptr, 0);
+	}
+	propsTarget = propsRead;
+}
+
 /**
 Reads the directory properties file depending on the variable
 "properties.directory.enable". Also sets the variable $(SciteDirectoryHome) to the path
@@ -194,13 +207,13 @@ where this property file is found. If it is not found $(SciteDirectoryHome) will
 be set to $(FilePath).
 */
 void SciTEBase::ReadDirectoryPropFile() {
-	propsDirectory.Clear();
-
 	if (props.GetInt("properties.directory.enable") != 0) {
 		FilePath propfile = GetDirectoryPropertiesFileName();
 		props.Set("SciteDirectoryHome", propfile.Directory().AsUTF8().c_str());
 
-		propsDirectory.Read(propfile, propfile.Directory(), filter, nullptr, 0);
+		ReadReplacingWhenChanged(propsDirectory, &propfile, filter);
+	} else {
+		ReadReplacingWhenChanged(propsDirectory, nullptr, filter);
 	}
 }
 
@@ -214,8 +227,7 @@ void SciTEBase::ReadLocalPropFile() {
 
 	FilePath propfile = GetLocalPropertiesFileName();
 
-	propsLocal.Clear();
-	propsLocal.Read(propfile, propfile.Directory(), filter, nullptr, 0);
+	ReadReplacingWhenChanged(propsLocal, &propfile, filter);
 
 	props.Set("Chrome", "#C0C0C0");
 	props.Set("ChromeHighlight", "#FFFFFF");
@@ -1075,6 +1087,9 @@ void SciTEBase::ReadProperties() {
 				       props.GetInt("cache.layout", static_cast<int>(SA::LineCache::Caret))));
 	wOutput.SetLayoutCache(static_cast<SA::LineCache>(
 				       props.GetInt("output.cache.layout", static_cast<int>(SA::LineCache::Caret))));
+	const int positionCacheShared = props.GetInt("cache.positions.shared", -1);
+	if (positionCacheShared >= 0)
+		wEditor.SetPositionCacheShared(positionCacheShared);
 
 	bracesCheck = props.GetInt("braces.check");
 	bracesSloppy = props.GetInt("braces.sloppy");
@@ -1191,6 +1206,7 @@ void SciTEBase::ReadProperties() {
 
 
 	scrollOutput = props.GetInt("output.scroll", 1);
+	outputMaxLines = props.GetInt("output.max.lines");
 
 	tabHideOne = props.GetInt("tabbar.hide.one");
 
@@ -1203,7 +1219,14 @@ void SciTEBase::ReadProperties() {
 
 	wEditor.SetModEventMask(SA::ModificationFlags::ChangeFold);
 
-	if (0==props.GetInt("undo.redo.lazy")) {
+	undoRedoLazy = props.GetInt("undo.redo.lazy") != 0;
+	if (wordIndexUsed) {
+		// Keep the autocompletion word index up to date.
+		wEditor.SetModEventMask(wEditor.ModEventMask() |
+			SA::ModificationFlags::InsertText |
+			SA::ModificationFlags::DeleteText);
+	}
+	if (!undoRedoLazy) {
 		// Trap for insert/delete notifications (also fired by undo
 		// and redo) so that the buttons can be enabled if needed.
 		const SA::ModificationFlags flagsCurrent = wEditor.ModEventMask();
@@ -1404,6 +1427,10 @@ void SciTEBase::ReadProperties() {
 		SetOneIndicator(wEditor, indicatorHighlightCurrentWord, highlightCurrentWordIndicator);
 		SetOneIndicator(wOutput, indicatorHighlightCurrentWord, highlightCurrentWordIndicator);
 		currentWordHighlight.isOnlyWithSameStyle = props.GetInt("highlight.current.word.by.style", 0) == 1;
+		if (currentWordHighlight.isOnlyWithSameStyle) {
+			// Lexing may change the styles of lines that were not edited so which words match
+			wEditor.SetModEventMask(wEditor.ModEventMask() | SA::ModificationFlags::ChangeStyle);
+		}
 		HighlightCurrentWord(true);
 	}
 
@@ -1475,6 +1502,11 @@ void SciTEBase::ReadProperties() {
 	} else {
 		TimerEnd(timerAutoSave);
 	}
+	if (props.GetInt("tail.follow")) {
+		TimerStart(timerTailFollow);
+	} else {
+		TimerEnd(timerTailFollow);
+	}
 
 	firstPropertiesRead = false;
 	needReadProperties = false;
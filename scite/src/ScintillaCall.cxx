@@ -2451,6 +2451,22 @@ int ScintillaCall::PositionCache() {
 	return static_cast<int>(Call(Message::GetPositionCache));
 }
 
+void ScintillaCall::SetPositionCacheShared(Position bytes) {
+	Call(Message::SetPositionCacheShared, bytes);
+}
+
+Position ScintillaCall::PositionCacheShared() {
+	return Call(Message::GetPositionCacheShared);
+}
+
+Position ScintillaCall::PositionCacheHits() {
+	return Call(Message::GetPositionCacheHits);
+}
+
+Position ScintillaCall::PositionCacheMisses() {
+	return Call(Message::GetPositionCacheMisses);
+}
+
 void ScintillaCall::CopyAllowLine() {
 	Call(Message::CopyAllowLine);
 }
@@ -627,6 +627,10 @@ public:
 	Position IndicatorEnd(int indicator, Position pos);
 	void SetPositionCache(int size);
 	int PositionCache();
+	void SetPositionCacheShared(Position bytes);
+	Position PositionCacheShared();
+	Position PositionCacheHits();
+	Position PositionCacheMisses();
 	void CopyAllowLine();
 	void *CharacterPointer();
 	void *RangePointer(Position start, Position lengthRange);
@@ -578,6 +578,10 @@ enum class Message {
 	IndicatorEnd = 2509,
 	SetPositionCache = 2514,
 	GetPositionCache = 2515,
+	SetPositionCacheShared = 2750,
+	GetPositionCacheShared = 2751,
+	GetPositionCacheHits = 2752,
+	GetPositionCacheMisses = 2753,
 	CopyAllowLine = 2519,
 	GetCharacterPointer = 2520,
 	GetRangePointer = 2643,
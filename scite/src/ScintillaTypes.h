@@ -270,6 +270,7 @@ enum class IdleStyling {
 	ToVisible = 1,
 	AfterVisible = 2,
 	All = 3,
+	Ahead = 4,
 };
 
 enum class Wrap {
@@ -10,6 +10,7 @@
 #include <cstring>
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <set>
@@ -261,3 +262,93 @@ std::string StringList::GetNearestWords(
 		return GetMatches(words.begin(), words.end(), wordStart, otherSeparator, exactLen, CompareString(searchLen));
 	}
 }
+
+bool WordIndex::CompareNoCaseThenCase::operator()(std::string_view a, std::string_view b) const noexcept {
+	const size_t len = std::min(a.length(), b.length());
+	for (size_t i = 0; i < len; i++) {
+		const char upperA = MakeUpperCase(a[i]);
+		const char upperB = MakeUpperCase(b[i]);
+		if (upperA != upperB)
+			return upperA < upperB;
+	}
+	if (a.length() != b.length())
+		return a.length() < b.length();
+	return a < b;
+}
+
+void WordIndex::AddWords(std::string_view text, int delta) {
+	size_t i = 0;
+	while (i < text.length()) {
+		while (i < text.length() && !isWordCharacter[static_cast<unsigned char>(text[i])])
+			i++;
+		const size_t start = i;
+		while (i < text.length() && isWordCharacter[static_cast<unsigned char>(text[i])])
+			i++;
+		if (i > start) {
+			const std::string_view word = text.substr(start, i - start);
+			std::map<std::string, int, CompareNoCaseThenCase>::iterator it = words.find(word);
+			if (it != words.end()) {
+				it->second += delta;
+				if (it->second <= 0)
+					words.erase(it);
+			} else if (delta > 0) {
+				words.emplace(std::string(word), delta);
+			}
+		}
+	}
+}
+
+void WordIndex::Invalidate() noexcept {
+	words.clear();
+	valid = false;
+}
+
+void WordIndex::Build(std::string_view text, const std::string &wordCharacters_) {
+	words.clear();
+	wordCharacters = wordCharacters_;
+	for (bool &isWord : isWordCharacter) {
+		isWord = false;
+	}
+	for (const char ch : wordCharacters) {
+		isWordCharacter[static_cast<unsigned char>(ch)] = true;
+	}
+	AddWords(text, 1);
+	valid = true;
+}
+
+/**
+ * Update for a modification of the document. Both texts should include any word
+ * characters adjacent to the modification so that words joined or split by the
+ * modification are counted correctly.
+ */
+void WordIndex::Replace(std::string_view textRemoved, std::string_view textAdded) {
+	if (valid) {
+		AddWords(textRemoved, -1);
+		AddWords(textAdded, 1);
+	}
+}
+
+/**
+ * Return the words that are longer than @a root and start with it, in index order.
+ * @a wordCurrent is the word being typed so is only returned when it also occurs elsewhere.
+ * Stops after @a maxWords words unless @a maxWords is 0.
+ */
+std::vector<std::string> WordIndex::WordsStartingWith(std::string_view root, bool ignoreCase,
+	std::string_view wordCurrent, size_t maxWords) const {
+	std::vector<std::string> found;
+	for (std::map<std::string, int, CompareNoCaseThenCase>::const_iterator it = words.lower_bound(root);
+		it != words.end(); ++it) {
+		const std::string &word = it->first;
+		if ((word.length() < root.length()) ||
+			!EqualCaseInsensitive(std::string_view(word).substr(0, root.length()), root))
+			break;
+		if ((word.length() > root.length()) &&
+			(ignoreCase || StartsWith(word, root)) &&
+			((word != wordCurrent) || (it->second > 1))) {
+			found.push_back(word);
+			if (maxWords && (found.size() >= maxWords))
+				break;
+		}
+	}
+	return found;
+}
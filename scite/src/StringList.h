@@ -35,4 +35,31 @@ public:
 				    bool ignoreCase, char otherSeparator='\0', bool exactLen=false);
 };
 
+/// Index of the words in a document with the number of times each occurs.
+/// Kept up to date as the document is modified so words starting with a
+/// prefix can be found without searching the whole document.
+class WordIndex {
+	/// Orders words ignoring ASCII case then by case so that the words starting with
+	/// a prefix are contiguous both when matching case and when ignoring case.
+	struct CompareNoCaseThenCase {
+		using is_transparent = void;
+		bool operator()(std::string_view a, std::string_view b) const noexcept;
+	};
+	std::map<std::string, int, CompareNoCaseThenCase> words;
+	std::string wordCharacters;
+	bool isWordCharacter[256] = {};
+	bool valid = false;
+	void AddWords(std::string_view text, int delta);
+public:
+	bool IsValid() const noexcept { return valid; }
+	bool IsValid(const std::string &wordCharacters_) const noexcept {
+		return valid && (wordCharacters == wordCharacters_);
+	}
+	void Invalidate() noexcept;
+	void Build(std::string_view text, const std::string &wordCharacters_);
+	void Replace(std::string_view textRemoved, std::string_view textAdded);
+	std::vector<std::string> WordsStartingWith(std::string_view root, bool ignoreCase,
+		std::string_view wordCurrent, size_t maxWords) const;
+};
+
 #endif
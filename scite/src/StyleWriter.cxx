@@ -7,10 +7,14 @@
 
 #include <cstdint>
 
+#include <algorithm>
 #include <string>
 #include <string_view>
+#include <vector>
 #include <chrono>
 
+#include "Scintilla.h"
+
 #include "ScintillaTypes.h"
 #include "ScintillaCall.h"
 
@@ -82,6 +86,53 @@ int TextReader::GetLineState(SA::Line line) {
 	return sc.LineState(line);
 }
 
+StyledTextReader::StyledTextReader(SA::ScintillaCall &sc, SA::Position start_, SA::Position end, bool withLevels) :
+	start(start_) {
+	if (end < 0)
+		end = sc.Length();
+	if (end > start) {
+		text.assign(static_cast<const char *>(sc.RangePointer(start, end - start)), end - start);
+		styles.resize(end - start);
+		// GETSTYLEDTEXT interleaves characters and styles and adds two terminating NULs
+		std::vector<char> styledText;
+		for (SA::Position startBlock = start; startBlock < end; startBlock += styleBlockSize) {
+			const SA::Position endBlock = std::min(startBlock + styleBlockSize, end);
+			const SA::Position lengthBlock = endBlock - startBlock;
+			styledText.resize(2 * lengthBlock + 2);
+			Sci_TextRange tr;
+			tr.chrg.cpMin = static_cast<Sci_PositionCR>(startBlock);
+			tr.chrg.cpMax = static_cast<Sci_PositionCR>(endBlock);
+			tr.lpstrText = styledText.data();
+			sc.GetStyledText(&tr);
+			for (SA::Position i = 0; i < lengthBlock; i++) {
+				styles[startBlock - start + i] = styledText[2 * i + 1];
+			}
+		}
+	}
+	if (withLevels) {
+		const SA::Line lineCount = sc.LineCount();
+		levels.reserve(lineCount);
+		for (SA::Line line = 0; line < lineCount; line++) {
+			levels.push_back(sc.FoldLevel(line));
+		}
+	}
+}
+
+SA::Position StyledTextReader::StyleRunEnd(SA::Position position, SA::Position last) const noexcept {
+	const int style = StyleAt(position);
+	const SA::Position limit = std::min(last, End());
+	SA::Position pos = position + 1;
+	while (pos < limit && styles[pos - start] == style)
+		pos++;
+	return std::min(pos, last);
+}
+
+SA::FoldLevel StyledTextReader::LevelAt(SA::Line line) const noexcept {
+	if (line < 0 || line >= static_cast<SA::Line>(levels.size()))
+		return SA::FoldLevel::Base;
+	return levels[line];
+}
+
 StyleWriter::StyleWriter(SA::ScintillaCall &sc_) noexcept :
 	TextReader(sc_),
 	validLen(0),
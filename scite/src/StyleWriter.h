@@ -65,6 +65,70 @@ public:
 	int GetLineState(Scintilla::API::Line line);
 };
 
+// A copy of the text, styles and optionally fold levels of a range of a document for exporters.
+// It is made on the GUI thread and may then be read on a worker thread.
+class StyledTextReader {
+	static constexpr Scintilla::API::Position styleBlockSize = 128 * 1024;
+	Scintilla::API::Position start;
+	std::string text;
+	std::vector<unsigned char> styles;
+	std::vector<Scintilla::API::FoldLevel> levels;
+public:
+	/** An @a end of -1 copies to the end of the document. Fold levels are copied for every
+	 * line when @a withLevels is true. */
+	StyledTextReader(Scintilla::API::ScintillaCall &sc, Scintilla::API::Position start_, Scintilla::API::Position end, bool withLevels);
+	// Deleted so StyledTextReader objects can not be copied.
+	StyledTextReader(const StyledTextReader &source) = delete;
+	StyledTextReader &operator=(const StyledTextReader &) = delete;
+	Scintilla::API::Position Start() const noexcept {
+		return start;
+	}
+	Scintilla::API::Position End() const noexcept {
+		return start + text.length();
+	}
+	/** Returns '\0' outside the range so look ahead needs no bounds check. */
+	char CharAt(Scintilla::API::Position position) const noexcept {
+		if (position < start || position >= End())
+			return '\0';
+		return text[position - start];
+	}
+	std::string_view Range(Scintilla::API::Position first, Scintilla::API::Position last) const noexcept {
+		return std::string_view(text.data() + first - start, last - first);
+	}
+	/** Returns 0 outside the range. */
+	int StyleAt(Scintilla::API::Position position) const noexcept {
+		if (position < start || position >= End())
+			return 0;
+		return styles[position - start];
+	}
+	/** Returns the end of the run of characters with the same style starting at position,
+	 * not going past last. */
+	Scintilla::API::Position StyleRunEnd(Scintilla::API::Position position, Scintilla::API::Position last) const noexcept;
+	/** Returns FoldLevel::Base for lines without a copied level. */
+	Scintilla::API::FoldLevel LevelAt(Scintilla::API::Line line) const noexcept;
+};
+
+struct Worker;
+
+// Generates the output of an exporter from a StyledTextReader so may run on a worker thread.
+class ExportGenerator {
+protected:
+	StyledTextReader reader;
+public:
+	ExportGenerator(Scintilla::API::ScintillaCall &sc, Scintilla::API::Position start, Scintilla::API::Position end, bool withLevels) :
+		reader(sc, start, end, withLevels) {
+	}
+	// Deleted so ExportGenerator objects can not be copied.
+	ExportGenerator(const ExportGenerator &) = delete;
+	ExportGenerator &operator=(const ExportGenerator &) = delete;
+	virtual ~ExportGenerator() = default;
+	size_t SizeSource() const noexcept {
+		return reader.End() - reader.Start();
+	}
+	/** Generation stops early, leaving incomplete output, when @a pWorker is cancelling. */
+	virtual std::string Generate(const Worker *pWorker) = 0;
+};
+
 // Adds methods needed to write styles and folding
 class StyleWriter : public TextReader {
 protected:
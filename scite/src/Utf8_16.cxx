@@ -13,6 +13,14 @@
 #include <cstring>
 #include <cstdio>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UTF8_16_SSE2
+#include <emmintrin.h>
+#elif (defined(__aarch64__) && !defined(__AARCH64EB__)) || defined(_M_ARM64)
+#define UTF8_16_NEON
+#include <arm_neon.h>
+#endif
+
 #include "Utf8_16.h"
 
 const Utf8_16::utf8 Utf8_16::k_Boms[][3] = {
@@ -28,6 +36,183 @@ enum { SURROGATE_TRAIL_FIRST = 0xDC00 };
 enum { SURROGATE_TRAIL_LAST = 0xDFFF };
 enum { SURROGATE_FIRST_VALUE = 0x10000 };
 
+namespace {
+
+typedef Utf8_16::ubyte ubyte;
+typedef Utf8_16::utf16 utf16;
+
+// Swap the two low order bytes of an integer value
+int swapped(int v) noexcept {
+	return ((v & 0xFF) << 8) + (v >> 8);
+}
+
+unsigned int ReadUnit(const ubyte *p, bool bigEndian) noexcept {
+	return bigEndian ? ((p[0] << 8) | p[1]) : (p[0] | (p[1] << 8));
+}
+
+bool IsLeadSurrogate(unsigned int unit) noexcept {
+	return unit >= SURROGATE_LEAD_FIRST && unit <= SURROGATE_LEAD_LAST;
+}
+
+bool IsTrailSurrogate(unsigned int unit) noexcept {
+	return unit >= SURROGATE_TRAIL_FIRST && unit <= SURROGATE_TRAIL_LAST;
+}
+
+bool IsTrailByte(unsigned int ch) noexcept {
+	return (ch & 0xC0) == 0x80;
+}
+
+void PutSupplementary(ubyte *&pOut, unsigned int lead, unsigned int trail) noexcept {
+	const unsigned int codePoint = (((lead & 0x3ff) << 10) | (trail & 0x3ff)) + SURROGATE_FIRST_VALUE;
+	*pOut++ = static_cast<ubyte>(0xF0 | (codePoint >> 18));
+	*pOut++ = static_cast<ubyte>(0x80 | ((codePoint >> 12) & 0x3F));
+	*pOut++ = static_cast<ubyte>(0x80 | ((codePoint >> 6) & 0x3F));
+	*pOut++ = static_cast<ubyte>(0x80 | (codePoint & 0x3F));
+}
+
+// Convert well-formed UTF-16 to UTF-8, stopping at the first unpaired surrogate
+// or odd trailing byte. Returns the number of input bytes converted.
+// Runs of ASCII are narrowed 8 units at a time where SIMD is available.
+size_t UTF8FromUTF16(const ubyte *pIn, size_t lenIn, bool bigEndian, ubyte *&pOut) noexcept {
+	const ubyte *p = pIn;
+	const ubyte *end = pIn + (lenIn & ~static_cast<size_t>(1));
+#if defined(UTF8_16_SSE2)
+	const __m128i vNotASCII = _mm_set1_epi16(static_cast<short>(0xFF80));
+	const __m128i vZero = _mm_setzero_si128();
+#endif
+	while (p < end) {
+#if defined(UTF8_16_SSE2)
+		while (end - p >= 16) {
+			__m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+			if (bigEndian)
+				units = _mm_or_si128(_mm_slli_epi16(units, 8), _mm_srli_epi16(units, 8));
+			if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(units, vNotASCII), vZero)) != 0xFFFF)
+				break;
+			_mm_storel_epi64(reinterpret_cast<__m128i *>(pOut), _mm_packus_epi16(units, units));
+			p += 16;
+			pOut += 8;
+		}
+#elif defined(UTF8_16_NEON)
+		while (end - p >= 16) {
+			uint8x16_t bytes = vld1q_u8(p);
+			if (bigEndian)
+				bytes = vrev16q_u8(bytes);
+			const uint16x8_t units = vreinterpretq_u16_u8(bytes);
+			if (vmaxvq_u16(units) >= 0x80)
+				break;
+			vst1_u8(pOut, vmovn_u16(units));
+			p += 16;
+			pOut += 8;
+		}
+#endif
+		if (p >= end)
+			break;
+		const unsigned int unit = ReadUnit(p, bigEndian);
+		if (unit < 0x80) {
+			*pOut++ = static_cast<ubyte>(unit);
+		} else if (unit < 0x800) {
+			*pOut++ = static_cast<ubyte>(0xC0 | (unit >> 6));
+			*pOut++ = static_cast<ubyte>(0x80 | (unit & 0x3F));
+		} else if (unit < SURROGATE_LEAD_FIRST || unit > SURROGATE_TRAIL_LAST) {
+			*pOut++ = static_cast<ubyte>(0xE0 | (unit >> 12));
+			*pOut++ = static_cast<ubyte>(0x80 | ((unit >> 6) & 0x3F));
+			*pOut++ = static_cast<ubyte>(0x80 | (unit & 0x3F));
+		} else {
+			if (!IsLeadSurrogate(unit) || (end - p) < 4)
+				break;
+			const unsigned int trail = ReadUnit(p + 2, bigEndian);
+			if (!IsTrailSurrogate(trail))
+				break;
+			PutSupplementary(pOut, unit, trail);
+			p += 2;
+		}
+		p += 2;
+	}
+	return p - pIn;
+}
+
+void PutUnit(utf16 *&pOut, int unit, bool bigEndian) noexcept {
+	*pOut++ = static_cast<utf16>(bigEndian ? swapped(unit) : unit);
+}
+
+// Convert well-formed UTF-8 to UTF-16, stopping at the first stray trail byte,
+// truncated sequence or invalid lead byte. Returns the number of input bytes converted.
+// Overlong forms are not rejected as they are converted the same way by Utf8_Iter.
+// Runs of ASCII are widened 16 bytes at a time where SIMD is available.
+size_t UTF16FromUTF8(const ubyte *pIn, size_t lenIn, bool bigEndian, utf16 *&pOut) noexcept {
+	const ubyte *p = pIn;
+	const ubyte *end = pIn + lenIn;
+#if defined(UTF8_16_SSE2)
+	const __m128i vZero = _mm_setzero_si128();
+#endif
+	while (p < end) {
+#if defined(UTF8_16_SSE2)
+		while (end - p >= 16) {
+			const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+			if (_mm_movemask_epi8(bytes) != 0)
+				break;
+			const __m128i low = bigEndian ? _mm_unpacklo_epi8(vZero, bytes) : _mm_unpacklo_epi8(bytes, vZero);
+			const __m128i high = bigEndian ? _mm_unpackhi_epi8(vZero, bytes) : _mm_unpackhi_epi8(bytes, vZero);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(pOut), low);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(pOut + 8), high);
+			p += 16;
+			pOut += 16;
+		}
+#elif defined(UTF8_16_NEON)
+		while (end - p >= 16) {
+			const uint8x16_t bytes = vld1q_u8(p);
+			if (vmaxvq_u8(bytes) >= 0x80)
+				break;
+			uint8x16_t low = vreinterpretq_u8_u16(vmovl_u8(vget_low_u8(bytes)));
+			uint8x16_t high = vreinterpretq_u8_u16(vmovl_u8(vget_high_u8(bytes)));
+			if (bigEndian) {
+				low = vrev16q_u8(low);
+				high = vrev16q_u8(high);
+			}
+			vst1q_u8(reinterpret_cast<uint8_t *>(pOut), low);
+			vst1q_u8(reinterpret_cast<uint8_t *>(pOut + 8), high);
+			p += 16;
+			pOut += 16;
+		}
+#endif
+		if (p >= end)
+			break;
+		const unsigned int lead = *p;
+		if (lead < 0x80) {
+			PutUnit(pOut, lead, bigEndian);
+			p++;
+		} else if (lead < 0xC0 || lead >= 0xF8) {
+			break;
+		} else if (lead < 0xE0) {
+			if ((end - p) < 2 || !IsTrailByte(p[1]))
+				break;
+			PutUnit(pOut, ((lead & 0x1F) << 6) | (p[1] & 0x3F), bigEndian);
+			p += 2;
+		} else if (lead < 0xF0) {
+			if ((end - p) < 3 || !IsTrailByte(p[1]) || !IsTrailByte(p[2]))
+				break;
+			PutUnit(pOut, ((lead & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F), bigEndian);
+			p += 3;
+		} else {
+			if ((end - p) < 4 || !IsTrailByte(p[1]) || !IsTrailByte(p[2]) || !IsTrailByte(p[3]))
+				break;
+			const int codePoint = ((lead & 0x7) << 18) | ((p[1] & 0x3F) << 12) |
+				((p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+			if (codePoint >= SURROGATE_FIRST_VALUE) {
+				const int value = codePoint - SURROGATE_FIRST_VALUE;
+				PutUnit(pOut, (value >> 10) + SURROGATE_LEAD_FIRST, bigEndian);
+				PutUnit(pOut, (value & 0x3ff) + SURROGATE_TRAIL_FIRST, bigEndian);
+			} else {
+				PutUnit(pOut, codePoint, bigEndian);
+			}
+			p += 4;
+		}
+	}
+	return p - pIn;
+}
+
+}
+
 // ==================================================================
 
 Utf8_16_Read::Utf8_16_Read() {
@@ -36,9 +221,12 @@ Utf8_16_Read::Utf8_16_Read() {
 	m_pBuf = nullptr;
 	m_pNewBuf = nullptr;
 	m_bFirstRead = true;
+	m_bLeadSurrogate = false;
 	m_nLen = 0;
 	m_leadSurrogate[0] = 0;
 	m_leadSurrogate[1] = 0;
+	m_nOffset = 0;
+	m_nFirstInvalid = k_noInvalid;
 }
 
 Utf8_16_Read::~Utf8_16_Read() {
@@ -81,33 +269,71 @@ size_t Utf8_16_Read::convert(char *buf, size_t len) {
 	}
 
 	ubyte *pCur = m_pNewBuf;
-
-	ubyte endSurrogate[2] = { 0, 0 };
-	ubyte *pbufPrependSurrogate = nullptr;
-	if (m_leadSurrogate[0]) {
-		pbufPrependSurrogate = new ubyte[len - nSkip + 2];
-		memcpy(pbufPrependSurrogate, m_leadSurrogate, 2);
-		if (m_pBuf)
-			memcpy(pbufPrependSurrogate + 2, m_pBuf + nSkip, len - nSkip);
-		m_Iter16.set(pbufPrependSurrogate, len - nSkip + 2, m_eEncoding, endSurrogate);
-	} else {
-		if (!m_pBuf)
-			return 0;
-		m_Iter16.set(m_pBuf + nSkip, len - nSkip, m_eEncoding, endSurrogate);
+	const bool bigEndian = m_eEncoding == eUtf16BigEndian;
+
+	// Offset in the file of the start of this block
+	const size_t offsetBlock = m_nOffset;
+	const ubyte *pRead = m_pBuf ? m_pBuf + nSkip : nullptr;
+	size_t lenRead = m_pBuf ? len - nSkip : 0;
+	if (m_pBuf)
+		m_nOffset += len;
+
+	// A lead surrogate ending the block is held back to be paired with the start of the next block.
+	// A held lead surrogate counts towards the block so a block of one unit may be cut.
+	const bool leadHeld = m_bLeadSurrogate;
+	ubyte leadSurrogate[2] = { m_leadSurrogate[0], m_leadSurrogate[1] };
+	m_bLeadSurrogate = false;
+	if ((lenRead >= 2) && !(lenRead & 1) && (lenRead + (leadHeld ? 2 : 0) > 2) &&
+		IsLeadSurrogate(ReadUnit(pRead + lenRead - 2, bigEndian))) {
+		m_leadSurrogate[0] = pRead[lenRead - 2];
+		m_leadSurrogate[1] = pRead[lenRead - 1];
+		m_bLeadSurrogate = true;
+		lenRead -= 2;
 	}
 
-	for (; m_Iter16; ++m_Iter16) {
-		*pCur++ = m_Iter16.get();
+	if (leadHeld) {
+		const unsigned int lead = ReadUnit(leadSurrogate, bigEndian);
+		if (lenRead >= 2 && IsTrailSurrogate(ReadUnit(pRead, bigEndian))) {
+			PutSupplementary(pCur, lead, ReadUnit(pRead, bigEndian));
+			pRead += 2;
+			lenRead -= 2;
+		} else {
+			markInvalid(offsetBlock - 2);
+			ubyte unpaired[4] = { leadSurrogate[0], leadSurrogate[1], 0, 0 };
+			const size_t lenFollowing = (lenRead >= 2) ? 2 : 0;
+			if (lenFollowing)
+				memcpy(unpaired + 2, pRead, lenFollowing);
+			m_Iter16.set(unpaired, 2 + lenFollowing, m_eEncoding, nullptr);
+			for (; m_Iter16; ++m_Iter16) {
+				*pCur++ = m_Iter16.get();
+			}
+			pRead += lenFollowing;
+			lenRead -= lenFollowing;
+		}
 	}
 
-	delete []pbufPrependSurrogate;
+	if (!pRead)
+		return pCur - m_pNewBuf;
 
-	memcpy(m_leadSurrogate, endSurrogate, 2);
+	const size_t lenConverted = UTF8FromUTF16(pRead, lenRead, bigEndian, pCur);
+	if (lenConverted < lenRead) {
+		// Malformed text is converted by the iterator from the first problem to the end of the block
+		markInvalid(offsetBlock + (pRead - m_pBuf) + lenConverted);
+		m_Iter16.set(pRead + lenConverted, lenRead - lenConverted, m_eEncoding, nullptr);
+		for (; m_Iter16; ++m_Iter16) {
+			*pCur++ = m_Iter16.get();
+		}
+	}
 
 	// Return number of bytes written out
 	return pCur - m_pNewBuf;
 }
 
+void Utf8_16_Read::markInvalid(size_t offset) noexcept {
+	if (m_nFirstInvalid == k_noInvalid)
+		m_nFirstInvalid = offset;
+}
+
 int Utf8_16_Read::determineEncoding() noexcept {
 	m_eEncoding = eUnknown;
 
@@ -137,6 +363,8 @@ Utf8_16_Write::Utf8_16_Write() {
 	m_pBuf = nullptr;
 	m_bFirstWrite = true;
 	m_nBufSize = 0;
+	m_nOffset = 0;
+	m_nFirstInvalid = k_noInvalid;
 }
 
 Utf8_16_Write::~Utf8_16_Write() {
@@ -149,11 +377,8 @@ void Utf8_16_Write::setfile(FILE *pFile) noexcept {
 	m_pFile = pFile;
 
 	m_bFirstWrite = true;
-}
-
-// Swap the two low order bytes of an integer value
-static int swapped(int v) noexcept {
-	return ((v & 0xFF) << 8) + (v >> 8);
+	m_nOffset = 0;
+	m_nFirstInvalid = k_noInvalid;
 }
 
 size_t Utf8_16_Write::fwrite(const void *p, size_t _size) {
@@ -188,28 +413,35 @@ size_t Utf8_16_Write::fwrite(const void *p, size_t _size) {
 		m_bFirstWrite = false;
 	}
 
-	Utf8_Iter iter8;
-	iter8.set(static_cast<const ubyte *>(p), _size, m_eEncoding);
-
+	const ubyte *pIn = static_cast<const ubyte *>(p);
 	utf16 *pCur = m_pBuf;
-
-	for (; iter8; ++iter8) {
-		if (iter8.canGet()) {
-			int codePoint = iter8.get();
-			if (codePoint >= SURROGATE_FIRST_VALUE) {
-				codePoint -= SURROGATE_FIRST_VALUE;
-				const int lead = (codePoint >> 10) + SURROGATE_LEAD_FIRST;
-				*pCur++ = static_cast<utf16>((m_eEncoding == eUtf16BigEndian) ?
-							     swapped(lead) : lead);
-				const int trail = (codePoint & 0x3ff) + SURROGATE_TRAIL_FIRST;
-				*pCur++ = static_cast<utf16>((m_eEncoding == eUtf16BigEndian) ?
-							     swapped(trail) : trail);
-			} else {
-				*pCur++ = static_cast<utf16>((m_eEncoding == eUtf16BigEndian) ?
-							     swapped(codePoint) : codePoint);
+	const size_t lenConverted = UTF16FromUTF8(pIn, _size, m_eEncoding == eUtf16BigEndian, pCur);
+	if (lenConverted < _size) {
+		// Malformed text is converted by the iterator from the first problem to the end of the block
+		if (m_nFirstInvalid == k_noInvalid)
+			m_nFirstInvalid = m_nOffset + lenConverted;
+		Utf8_Iter iter8;
+		iter8.set(pIn + lenConverted, _size - lenConverted, m_eEncoding);
+
+		for (; iter8; ++iter8) {
+			if (iter8.canGet()) {
+				int codePoint = iter8.get();
+				if (codePoint >= SURROGATE_FIRST_VALUE) {
+					codePoint -= SURROGATE_FIRST_VALUE;
+					const int lead = (codePoint >> 10) + SURROGATE_LEAD_FIRST;
+					*pCur++ = static_cast<utf16>((m_eEncoding == eUtf16BigEndian) ?
+								     swapped(lead) : lead);
+					const int trail = (codePoint & 0x3ff) + SURROGATE_TRAIL_FIRST;
+					*pCur++ = static_cast<utf16>((m_eEncoding == eUtf16BigEndian) ?
+								     swapped(trail) : trail);
+				} else {
+					*pCur++ = static_cast<utf16>((m_eEncoding == eUtf16BigEndian) ?
+								     swapped(codePoint) : codePoint);
+				}
 			}
 		}
 	}
+	m_nOffset += _size;
 
 	const size_t ret = ::fwrite(m_pBuf,
 				    reinterpret_cast<const char *>(pCur) - reinterpret_cast<const char *>(m_pBuf),
@@ -314,7 +546,7 @@ void Utf16_Iter::set
 	m_pRead = pBuf;
 	m_pEnd = pBuf + nLen;
 	m_eEncoding = eEncoding;
-	if (nLen > 2) {
+	if (endSurrogate && nLen > 2) {
 		const utf16 lastElement = read(m_pEnd-2);
 		if (lastElement >= SURROGATE_LEAD_FIRST && lastElement <= SURROGATE_LEAD_LAST) {
 			// Buffer ends with lead surrogate so cut off buffer and store
@@ -28,9 +28,12 @@ public:
 		eLast
 	};
 	static const utf8 k_Boms[eLast][3];
+	// Returned by getFirstInvalid when all text was well-formed
+	static constexpr size_t k_noInvalid = static_cast<size_t>(-1);
 };
 
 // Reads UTF-16 and outputs UTF-8
+// When endSurrogate is not null, a lead surrogate ending the buffer is moved there.
 class Utf16_Iter : public Utf8_16 {
 public:
 	Utf16_Iter() noexcept;
@@ -101,16 +104,22 @@ public:
 	char *getNewBuf() noexcept { return reinterpret_cast<char *>(m_pNewBuf); }
 
 	encodingType getEncoding() const noexcept { return m_eEncoding; }
+	// Byte offset in the file of the first unpaired surrogate
+	size_t getFirstInvalid() const noexcept { return m_nFirstInvalid; }
 protected:
 	int determineEncoding() noexcept;
+	void markInvalid(size_t offset) noexcept;
 private:
 	encodingType m_eEncoding;
 	ubyte *m_pBuf;
 	ubyte *m_pNewBuf;
 	size_t m_nBufSize;
 	bool m_bFirstRead;
+	bool m_bLeadSurrogate;
 	ubyte m_leadSurrogate[2];
 	size_t m_nLen;
+	size_t m_nOffset;
+	size_t m_nFirstInvalid;
 	Utf16_Iter m_Iter16;
 };
 
@@ -125,12 +134,16 @@ public:
 	void setfile(FILE *pFile) noexcept;
 	size_t fwrite(const void *p, size_t _size);
 	int fclose() noexcept;
+	// Byte offset in the written text of the first malformed UTF-8 sequence
+	size_t getFirstInvalid() const noexcept { return m_nFirstInvalid; }
 protected:
 	encodingType m_eEncoding;
 	FILE *m_pFile;
 	utf16 *m_pBuf;
 	size_t m_nBufSize;
 	bool m_bFirstWrite;
+	size_t m_nOffset;
+	size_t m_nFirstInvalid;
 };
 
 #endif
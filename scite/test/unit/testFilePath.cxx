@@ -0,0 +1,57 @@
+// Unit Tests for SciTE internal data structures
+
+#include <cstdio>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+#include "GUI.h"
+#include "FilePath.h"
+
+#include "catch.hpp"
+
+namespace fs = std::filesystem;
+
+// Test FileMapping.
+
+TEST_CASE("FileMapping") {
+
+	const fs::path path = fs::temp_directory_path() / "SciTEUnitTestMapping.txt";
+	const std::string contents(100000, 'x');
+	std::ofstream(path, std::ios::binary) << contents;
+
+	SECTION("Mapped") {
+		FILE *fp = FilePath(path.native()).Open(GUI_TEXT("rb"));
+		REQUIRE(fp);
+		{
+			const FileMapping mapping(fp);
+			REQUIRE(mapping.IsValid());
+			REQUIRE(mapping.Size() == contents.length());
+			REQUIRE(mapping.FileSize() == contents.length());
+			REQUIRE(std::string_view(mapping.Data(), mapping.Size()) == contents);
+		}
+		fclose(fp);
+	}
+
+#if defined(__unix__) || defined(__APPLE__)
+	SECTION("Truncated") {
+		// The loader checks FileSize so it does not read the mapping past the end of the file
+		FILE *fp = FilePath(path.native()).Open(GUI_TEXT("rb"));
+		REQUIRE(fp);
+		{
+			const FileMapping mapping(fp);
+			REQUIRE(mapping.IsValid());
+			fs::resize_file(path, 1000);
+			REQUIRE(mapping.Size() == contents.length());
+			REQUIRE(mapping.FileSize() == 1000);
+		}
+		fclose(fp);
+	}
+#endif
+
+	fs::remove(path);
+}
@@ -0,0 +1,144 @@
+// Unit Tests for SciTE internal data structures
+
+#include <cstdio>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <set>
+#include <memory>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+#include "GUI.h"
+#include "FilePath.h"
+#include "PropSetFile.h"
+
+#include "catch.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Files with modification times in the past so snapshots of them are written.
+void WriteProperties(const fs::path &path, const char *contents) {
+	std::ofstream(path, std::ios::binary) << contents;
+	fs::last_write_time(path, fs::file_time_type::clock::now() - std::chrono::minutes(10));
+}
+
+// Change contents without changing size or modification time so only a parse sees the change.
+void RewriteUnnoticed(const fs::path &path, const char *contents) {
+	const fs::file_time_type modified = fs::last_write_time(path);
+	std::ofstream(path, std::ios::binary) << contents;
+	fs::last_write_time(path, modified);
+}
+
+FilePath PathFor(const fs::path &path) {
+	return FilePath(path.native());
+}
+
+// Embedded properties are read from memory with the filter like on Windows.
+class TestReader : public FilteredReader {
+public:
+	PropSetFile propsEmbed;
+	FilePath directory;
+	int readsEmbedded = 0;
+	void ReadWithoutSnapshot(const ImportFilter &filter) override {
+		readsEmbedded++;
+		propsEmbed.Clear();
+		const std::string_view embedded = "embedded=1\nimport c\n";
+		propsEmbed.ReadFromMemory(embedded.data(), embedded.length(), directory, filter, nullptr, 0);
+	}
+};
+
+// Global and user properties with their snapshots, the global file excludes two imports.
+class GlobalProperties {
+public:
+	fs::path directory;
+	TestReader reader;
+	PropSetFile propsBase;
+	PropSetFile propsUser;
+	ImportFilter filter;
+	FilePathSet imports;
+	std::vector<SnapshotRead> reads;
+	explicit GlobalProperties(const fs::path &directory_) : directory(directory_) {
+		reader.directory = PathFor(directory);
+		propsBase.superPS = &reader.propsEmbed;
+		propsUser.superPS = &propsBase;
+		reads = {
+			{ &propsBase, PathFor(directory / "global.properties"), PathFor(directory / "global.snapshot") },
+			{ &propsUser, PathFor(directory / "user.properties"), PathFor(directory / "user.snapshot") },
+		};
+	}
+	int Read() {
+		return reader.Read(propsUser, reads, filter, imports);
+	}
+	void WriteSnapshots() {
+		REQUIRE(propsBase.WriteSnapshot(reads[0].snapshot, filter));
+		REQUIRE(propsUser.WriteSnapshot(reads[1].snapshot, filter));
+	}
+};
+
+}
+
+// Test FilteredReader with snapshots.
+
+TEST_CASE("FilteredReader") {
+
+	const fs::path directory = fs::temp_directory_path() / "SciTEUnitTestProperties";
+	fs::remove_all(directory);
+	fs::create_directories(directory);
+	WriteProperties(directory / "global.properties", "imports.exclude=b c\nimport a\nimport b\nglobal=1\n");
+	WriteProperties(directory / "user.properties", "user=1\n");
+	WriteProperties(directory / "a.properties", "a=1\n");
+	WriteProperties(directory / "b.properties", "b=1\n");
+	WriteProperties(directory / "c.properties", "c=1\n");
+
+	{
+		// Starting with no filter, the second pass applies the filter read in the first
+		GlobalProperties first(directory);
+		REQUIRE(first.Read() == 2);
+		REQUIRE(first.propsUser.GetString("a") == "1");
+		REQUIRE(!first.propsUser.Exists("b"));
+		REQUIRE(!first.propsUser.Exists("c"));
+		REQUIRE(first.propsUser.GetString("embedded") == "1");
+		REQUIRE(first.imports.size() == 1);
+		first.WriteSnapshots();
+	}
+
+	SECTION("SnapshotUsedOnFirstPass") {
+		RewriteUnnoticed(directory / "a.properties", "a=2\n");
+		GlobalProperties second(directory);
+		// The filter is taken from the snapshot and confirmed so there is no second pass
+		REQUIRE(second.Read() == 1);
+		// From the snapshot although it was written with a different filter to the initial one
+		REQUIRE(second.propsUser.GetString("a") == "1");
+		REQUIRE(!second.propsUser.Exists("b"));
+		REQUIRE(!second.propsUser.Exists("c"));
+		REQUIRE(second.filter.excludes == std::set<std::string> { "b", "c" });
+		REQUIRE(second.imports.size() == 1);
+		// Embedded properties read once with no filter then again with the snapshot's filter
+		REQUIRE(second.reader.readsEmbedded == 2);
+		// Nothing was parsed so there is no new snapshot to write
+		REQUIRE(!second.propsBase.WriteSnapshot(second.reads[0].snapshot, second.filter));
+		REQUIRE(!second.propsUser.WriteSnapshot(second.reads[1].snapshot, second.filter));
+	}
+
+	SECTION("SnapshotFilterNotConfirmed") {
+		// User properties now exclude a different set so the global snapshot does not apply
+		WriteProperties(directory / "user.properties", "imports.exclude=c\nuser=1\n");
+		RewriteUnnoticed(directory / "a.properties", "a=2\n");
+		GlobalProperties second(directory);
+		REQUIRE(second.Read() == 2);
+		REQUIRE(second.propsUser.GetString("a") == "2");
+		REQUIRE(second.propsUser.GetString("b") == "1");
+		REQUIRE(!second.propsUser.Exists("c"));
+		REQUIRE(second.filter.excludes == std::set<std::string> { "c" });
+		REQUIRE(second.imports.size() == 2);
+		REQUIRE(second.propsBase.WriteSnapshot(second.reads[0].snapshot, second.filter));
+	}
+
+	fs::remove_all(directory);
+}
@@ -0,0 +1,151 @@
+// Unit Tests for SciTE internal data structures
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <random>
+#include <chrono>
+
+#include "GUI.h"
+#include "StringList.h"
+
+#include "catch.hpp"
+
+namespace {
+
+const std::string wordCharacters = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
+
+using Words = std::vector<std::string>;
+
+Words AllStartingWith(const WordIndex &wordIndex, std::string_view root, bool ignoreCase) {
+	return wordIndex.WordsStartingWith(root, ignoreCase, "", 0);
+}
+
+// Index built from scratch to compare with one that was updated.
+WordIndex Built(std::string_view text) {
+	WordIndex wordIndex;
+	wordIndex.Build(text, wordCharacters);
+	return wordIndex;
+}
+
+// Replace text in a document the way SciTE does, with the word characters
+// around the modification included on both sides.
+void ReplaceInDocument(WordIndex &wordIndex, std::string &document, size_t position, size_t lengthRemoved, std::string_view textAdded) {
+	size_t wordStart = position;
+	while (wordStart > 0 && wordCharacters.find(document[wordStart - 1]) != std::string::npos)
+		wordStart--;
+	size_t wordEnd = position + lengthRemoved;
+	while (wordEnd < document.length() && wordCharacters.find(document[wordEnd]) != std::string::npos)
+		wordEnd++;
+	const std::string before = document.substr(wordStart, position - wordStart);
+	const std::string after = document.substr(position + lengthRemoved, wordEnd - position - lengthRemoved);
+	const std::string removed = document.substr(position, lengthRemoved);
+	wordIndex.Replace(before + removed + after, before + std::string(textAdded) + after);
+	document.replace(position, lengthRemoved, textAdded);
+}
+
+}
+
+// Test WordIndex.
+
+TEST_CASE("WordIndex") {
+
+	SECTION("Invalid") {
+		WordIndex wordIndex;
+		REQUIRE(!wordIndex.IsValid());
+		wordIndex.Replace("", "alpha");
+		REQUIRE(!wordIndex.IsValid());
+		REQUIRE(AllStartingWith(wordIndex, "a", false).empty());
+		wordIndex.Build("alpha", wordCharacters);
+		REQUIRE(wordIndex.IsValid());
+		REQUIRE(wordIndex.IsValid(wordCharacters));
+		REQUIRE(!wordIndex.IsValid("abc"));
+		wordIndex.Invalidate();
+		REQUIRE(!wordIndex.IsValid());
+		REQUIRE(AllStartingWith(wordIndex, "a", false).empty());
+	}
+
+	SECTION("StartingWith") {
+		const WordIndex wordIndex = Built("beta alpha, Alphabet alpha(ALPHA) al alpine+beta");
+		REQUIRE(AllStartingWith(wordIndex, "al", false) == Words{"alpha", "alpine"});
+		REQUIRE(AllStartingWith(wordIndex, "al", true) == Words{"ALPHA", "alpha", "Alphabet", "alpine"});
+		REQUIRE(AllStartingWith(wordIndex, "AL", false) == Words{"ALPHA"});
+		REQUIRE(AllStartingWith(wordIndex, "Alpha", false) == Words{"Alphabet"});
+		// Only words longer than the root
+		REQUIRE(AllStartingWith(wordIndex, "alpine", true).empty());
+		REQUIRE(AllStartingWith(wordIndex, "x", true).empty());
+		REQUIRE(AllStartingWith(wordIndex, "", false) == Words{"al", "ALPHA", "alpha", "Alphabet", "alpine", "beta"});
+	}
+
+	SECTION("MaxWords") {
+		const WordIndex wordIndex = Built("alpha alpine alto");
+		REQUIRE(wordIndex.WordsStartingWith("al", false, "", 2) == Words{"alpha", "alpine"});
+		REQUIRE(wordIndex.WordsStartingWith("al", false, "", 1) == Words{"alpha"});
+	}
+
+	SECTION("WordCurrent") {
+		// The word being typed is only offered when it occurs elsewhere
+		WordIndex wordIndex = Built("alpha alpine");
+		REQUIRE(wordIndex.WordsStartingWith("al", false, "alpha", 0) == Words{"alpine"});
+		wordIndex.Replace("", " alpha");
+		REQUIRE(wordIndex.WordsStartingWith("al", false, "alpha", 0) == Words{"alpha", "alpine"});
+	}
+
+	SECTION("WordCharacters") {
+		const WordIndex wordIndex = [] {
+			WordIndex index;
+			index.Build("a-b a_b a.b", "ab-");
+			return index;
+		}();
+		REQUIRE(AllStartingWith(wordIndex, "a", false) == Words{"a-b"});
+	}
+
+	SECTION("Replace") {
+		std::string document = "one two three";
+		WordIndex wordIndex = Built(document);
+		// Joining two words
+		ReplaceInDocument(wordIndex, document, 3, 1, "");
+		REQUIRE(document == "onetwo three");
+		REQUIRE(AllStartingWith(wordIndex, "", false) == Words{"onetwo", "three"});
+		// Splitting a word
+		ReplaceInDocument(wordIndex, document, 2, 0, " ");
+		REQUIRE(AllStartingWith(wordIndex, "", false) == Words{"etwo", "on", "three"});
+		REQUIRE(AllStartingWith(wordIndex, "", false) == AllStartingWith(Built(document), "", false));
+		// Removing the last occurrence
+		ReplaceInDocument(wordIndex, document, 0, document.length(), "three");
+		REQUIRE(AllStartingWith(wordIndex, "", false) == Words{"three"});
+		// Counts are kept so a word stays until its last occurrence is removed
+		ReplaceInDocument(wordIndex, document, 5, 0, " three");
+		REQUIRE(wordIndex.WordsStartingWith("th", false, "three", 0) == Words{"three"});
+		ReplaceInDocument(wordIndex, document, 0, 6, "");
+		REQUIRE(document == "three");
+		REQUIRE(AllStartingWith(wordIndex, "", false) == Words{"three"});
+		REQUIRE(wordIndex.WordsStartingWith("th", false, "three", 0).empty());
+	}
+
+	SECTION("SameAsBuilt") {
+		// Random modifications leave the same index as building from the result.
+		const char pieces[] = "ab AB_ x.y \n1";
+		std::mt19937 generator(11);
+		std::string document = "alpha Beta gamma_1 alpha\ndelta";
+		WordIndex wordIndex = Built(document);
+		for (int i = 0; i < 2000; i++) {
+			const size_t position = std::uniform_int_distribution<size_t>(0, document.length())(generator);
+			const size_t lengthRemoved = std::uniform_int_distribution<size_t>(0, std::min<size_t>(4, document.length() - position))(generator);
+			std::string textAdded;
+			const int lengthAdded = std::uniform_int_distribution<int>(0, 4)(generator);
+			for (int j = 0; j < lengthAdded; j++) {
+				textAdded += pieces[std::uniform_int_distribution<size_t>(0, sizeof(pieces) - 2)(generator)];
+			}
+			ReplaceInDocument(wordIndex, document, position, lengthRemoved, textAdded);
+			for (const char *root : {"", "a", "B", "ab"}) {
+				REQUIRE(AllStartingWith(wordIndex, root, false) == AllStartingWith(Built(document), root, false));
+				REQUIRE(AllStartingWith(wordIndex, root, true) == AllStartingWith(Built(document), root, true));
+				// Words occurring once are left out when current so this compares counts
+				REQUIRE(wordIndex.WordsStartingWith(root, true, "ab", 0) == Built(document).WordsStartingWith(root, true, "ab", 0));
+			}
+		}
+	}
+}
@@ -0,0 +1,321 @@
+// Unit Tests for SciTE internal data structures
+
+#include <cstddef>
+#include <cassert>
+#include <cstdio>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#include "Utf8_16.h"
+
+#include "catch.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t blockSize = 128 * 1024;
+
+// Read file contents through Utf8_16_Read a block at a time like FileLoader.
+std::string Read(std::string_view contents, size_t lenBlock, size_t &firstInvalid) {
+	Utf8_16_Read convert;
+	std::string result;
+	std::vector<char> data(lenBlock);
+	while (!contents.empty()) {
+		const size_t lenRead = std::min(contents.length(), lenBlock);
+		contents.copy(data.data(), lenRead);
+		contents.remove_prefix(lenRead);
+		const size_t lenConverted = convert.convert(data.data(), lenRead);
+		result.append(convert.getNewBuf(), lenConverted);
+	}
+	// A lead surrogate may be held at the end
+	const size_t lenTrail = convert.convert(nullptr, 0);
+	if (lenTrail)
+		result.append(convert.getNewBuf(), lenTrail);
+	firstInvalid = convert.getFirstInvalid();
+	return result;
+}
+
+std::string Read(std::string_view contents) {
+	size_t firstInvalid = 0;
+	return Read(contents, blockSize, firstInvalid);
+}
+
+// Convert UTF-16 after its BOM with Utf16_Iter alone, as was done before the bulk conversion.
+std::string ReadIterator(std::string_view contents) {
+	const Utf8_16::encodingType encoding = (static_cast<unsigned char>(contents[0]) == 0xFE) ?
+		Utf8_16::eUtf16BigEndian : Utf8_16::eUtf16LittleEndian;
+	std::string result;
+	Utf16_Iter iter16;
+	iter16.set(reinterpret_cast<const Utf8_16::ubyte *>(contents.data()) + 2, contents.length() - 2, encoding, nullptr);
+	for (; iter16; ++iter16) {
+		result.push_back(static_cast<char>(iter16.get()));
+	}
+	return result;
+}
+
+// Write UTF-8 through Utf8_16_Write in the given pieces like FileStorer.
+void WriteFile(const fs::path &path, const std::vector<std::string_view> &pieces, Utf8_16::encodingType encoding,
+	size_t &firstInvalid) {
+	FILE *fp = fopen(path.string().c_str(), "wb");
+	REQUIRE(fp);
+	Utf8_16_Write convert;
+	convert.setEncoding(encoding);
+	convert.setfile(fp);
+	for (const std::string_view piece : pieces) {
+		REQUIRE(convert.fwrite(piece.data(), piece.length()) == 1);
+	}
+	firstInvalid = convert.getFirstInvalid();
+	REQUIRE(convert.fclose() == 0);
+}
+
+// Write pieces and return the file.
+std::string Write(const std::vector<std::string_view> &pieces, Utf8_16::encodingType encoding, size_t &firstInvalid) {
+	const fs::path path = fs::temp_directory_path() / "SciTEUnitTestUtf8_16.txt";
+	WriteFile(path, pieces, encoding, firstInvalid);
+	std::string contents(static_cast<size_t>(fs::file_size(path)), '\0');
+	std::ifstream(path, std::ios::binary).read(contents.data(), contents.length());
+	fs::remove(path);
+	return contents;
+}
+
+std::string Write(std::string_view text, Utf8_16::encodingType encoding) {
+	size_t firstInvalid = 0;
+	return Write({ text }, encoding, firstInvalid);
+}
+
+// Convert UTF-8 with Utf8_Iter alone, as was done before the bulk conversion.
+std::string WriteIterator(std::string_view text, Utf8_16::encodingType encoding) {
+	const bool bigEndian = encoding == Utf8_16::eUtf16BigEndian;
+	std::string result(reinterpret_cast<const char *>(Utf8_16::k_Boms[encoding]), 2);
+	auto put = [&result, bigEndian](int unit) {
+		const char low = static_cast<char>(unit & 0xFF);
+		const char high = static_cast<char>((unit >> 8) & 0xFF);
+		result.push_back(bigEndian ? high : low);
+		result.push_back(bigEndian ? low : high);
+	};
+	Utf8_Iter iter8;
+	iter8.set(reinterpret_cast<const Utf8_16::ubyte *>(text.data()), text.length(), encoding);
+	for (; iter8; ++iter8) {
+		if (iter8.canGet()) {
+			const int codePoint = iter8.get();
+			if (codePoint >= 0x10000) {
+				put(((codePoint - 0x10000) >> 10) + 0xD800);
+				put(((codePoint - 0x10000) & 0x3ff) + 0xDC00);
+			} else {
+				put(codePoint);
+			}
+		}
+	}
+	return result;
+}
+
+// UTF-16 file contents with a BOM from a sequence of code units.
+std::string UTF16(const std::vector<unsigned int> &units, bool bigEndian) {
+	std::string result(bigEndian ? "\xFE\xFF" : "\xFF\xFE");
+	for (const unsigned int unit : units) {
+		const char low = static_cast<char>(unit & 0xFF);
+		const char high = static_cast<char>(unit >> 8);
+		result.push_back(bigEndian ? high : low);
+		result.push_back(bigEndian ? low : high);
+	}
+	return result;
+}
+
+// Code units mixing runs of ASCII, other BMP characters, surrogate pairs and
+// optionally unpaired surrogates.
+std::vector<unsigned int> RandomUnits(std::mt19937 &generator, size_t length, bool unpaired) {
+	std::uniform_int_distribution<unsigned int> kind(0, 9);
+	std::uniform_int_distribution<unsigned int> runLength(1, 40);
+	std::uniform_int_distribution<unsigned int> ascii(0x20, 0x7E);
+	// Characters from 0xD800 are moved up past the surrogates
+	std::uniform_int_distribution<unsigned int> bmp(0x80, 0xF7FF);
+	std::uniform_int_distribution<unsigned int> surrogate(0xD800, 0xDFFF);
+	std::vector<unsigned int> units;
+	while (units.size() < length) {
+		switch (kind(generator)) {
+		case 0:
+			if (unpaired)
+				units.push_back(surrogate(generator));
+			break;
+		case 1:
+		case 2:
+			units.push_back(0xD800 + (bmp(generator) & 0x3FF));
+			units.push_back(0xDC00 + (bmp(generator) & 0x3FF));
+			break;
+		case 3:
+		case 4: {
+				const unsigned int ch = bmp(generator);
+				units.push_back((ch >= 0xD800) ? ch + 0x800 : ch);
+			}
+			break;
+		default:
+			for (unsigned int i = runLength(generator); i > 0; i--) {
+				units.push_back(ascii(generator));
+			}
+		}
+	}
+	return units;
+}
+
+// UTF-8 mostly made from valid sequences of every length with some stray bytes.
+std::string RandomUTF8(std::mt19937 &generator, size_t length) {
+	static const char *pieces[] = {
+		"a", "Code ", "0123456789abcdef0123456789", "\xC3\xA9", "\xE4\xB8\xAD", "\xF0\x9F\x98\x80",
+		"\x80", "\xC3", "\xE4\xB8", "\xFF",
+	};
+	std::uniform_int_distribution<size_t> piece(0, std::size(pieces) - 1);
+	std::string result;
+	while (result.length() < length) {
+		result += pieces[piece(generator)];
+	}
+	return result;
+}
+
+}
+
+// Test Utf8_16_Read.
+
+TEST_CASE("Utf8_16_Read") {
+
+	SECTION("PassThrough") {
+		REQUIRE(Read("plain text") == "plain text");
+		REQUIRE(Read("\xEF\xBB\xBFUTF-8 \xC3\xA9") == "UTF-8 \xC3\xA9");
+	}
+
+	SECTION("UTF16") {
+		// a, e acute, CJK, grinning face
+		const std::vector<unsigned int> units { 'a', 0xE9, 0x4E2D, 0xD83D, 0xDE00 };
+		const std::string expected = "a\xC3\xA9\xE4\xB8\xAD\xF0\x9F\x98\x80";
+		REQUIRE(Read(UTF16(units, false)) == expected);
+		REQUIRE(Read(UTF16(units, true)) == expected);
+	}
+
+	SECTION("SurrogatePairAcrossBlocks") {
+		const std::string contents = UTF16({ 'a', 0xD83D, 0xDE00, 'b' }, false);
+		size_t firstInvalid = 0;
+		// The first block ends with the lead surrogate
+		REQUIRE(Read(contents, 6, firstInvalid) == "a\xF0\x9F\x98\x80" "b");
+		REQUIRE(firstInvalid == Utf8_16::k_noInvalid);
+		// Little-endian lead surrogates like 0xD800 start with a zero byte
+		REQUIRE(Read(UTF16({ 'a', 0xD800, 0xDC00 }, false), 6, firstInvalid) == "a\xF0\x90\x80\x80");
+		REQUIRE(firstInvalid == Utf8_16::k_noInvalid);
+	}
+
+	SECTION("FirstInvalid") {
+		size_t firstInvalid = 0;
+		Read(UTF16({ 'a', 'b', 0xD800, 'c', 0xDC00 }, false), blockSize, firstInvalid);
+		REQUIRE(firstInvalid == 6);
+		Read(UTF16({ 'a', 'b', 0xDC00, 'c' }, true), blockSize, firstInvalid);
+		REQUIRE(firstInvalid == 6);
+		// Lead surrogate held at the end of a block
+		Read(UTF16({ 'a', 0xD800, 'x' }, false), 6, firstInvalid);
+		REQUIRE(firstInvalid == 4);
+		// Lead surrogate at the end of the file
+		Read(UTF16({ 'a', 'b', 0xD800 }, false), 6, firstInvalid);
+		REQUIRE(firstInvalid == 6);
+	}
+
+	SECTION("SameAsIterator") {
+		std::mt19937 generator(1);
+		for (int i = 0; i < 200; i++) {
+			const std::string contents = UTF16(RandomUnits(generator, 1 + i * 13, false), i % 2 == 0);
+			const std::string expected = ReadIterator(contents);
+			// Blocks hold at least 2 units after the BOM as a lead surrogate is not held back
+			// from a block of one unit
+			for (const size_t lenBlock : { static_cast<size_t>(6), static_cast<size_t>(34), blockSize }) {
+				size_t firstInvalid = 0;
+				REQUIRE(Read(contents, lenBlock, firstInvalid) == expected);
+				REQUIRE(firstInvalid == Utf8_16::k_noInvalid);
+			}
+			// Unpaired surrogates are only converted the same as the iterator within a block
+			// since the iterator takes any unit after a lead surrogate as its trail
+			const std::string contentsUnpaired = UTF16(RandomUnits(generator, 1 + i * 13, true), i % 2 == 0);
+			REQUIRE(Read(contentsUnpaired) == ReadIterator(contentsUnpaired));
+		}
+	}
+}
+
+// Test Utf8_16_Write.
+
+TEST_CASE("Utf8_16_Write") {
+
+	SECTION("UTF16") {
+		const std::string text = "a\xC3\xA9\xE4\xB8\xAD\xF0\x9F\x98\x80";
+		REQUIRE(Write(text, Utf8_16::eUtf16LittleEndian) == UTF16({ 'a', 0xE9, 0x4E2D, 0xD83D, 0xDE00 }, false));
+		REQUIRE(Write(text, Utf8_16::eUtf16BigEndian) == UTF16({ 'a', 0xE9, 0x4E2D, 0xD83D, 0xDE00 }, true));
+		REQUIRE(Write(text, Utf8_16::eUtf8) == "\xEF\xBB\xBF" + text);
+	}
+
+	SECTION("FirstInvalid") {
+		size_t firstInvalid = 0;
+		Write({ "ab\x80" "cd" }, Utf8_16::eUtf16LittleEndian, firstInvalid);
+		REQUIRE(firstInvalid == 2);
+		Write({ "abc", "d\xE4\xB8" }, Utf8_16::eUtf16BigEndian, firstInvalid);
+		REQUIRE(firstInvalid == 4);
+		Write({ "abc", "\xC3\xA9" }, Utf8_16::eUtf16BigEndian, firstInvalid);
+		REQUIRE(firstInvalid == Utf8_16::k_noInvalid);
+	}
+
+	SECTION("SameAsIterator") {
+		std::mt19937 generator(1);
+		for (int i = 0; i < 200; i++) {
+			const std::string text = RandomUTF8(generator, 1 + i * 13);
+			const Utf8_16::encodingType encoding = (i % 2 == 0) ?
+				Utf8_16::eUtf16LittleEndian : Utf8_16::eUtf16BigEndian;
+			REQUIRE(Write(text, encoding) == WriteIterator(text, encoding));
+		}
+	}
+}
+
+// Throughput of reading and writing a 16 megabyte UTF-16 file.
+// Hidden so only run when asked for with: unitTest [benchmark]
+
+TEST_CASE("Utf8_16Benchmark", "[.][benchmark]") {
+
+	constexpr size_t lengthText = 16 * 1024 * 1024;
+	std::mt19937 generator(1);
+
+	const std::string asciiUTF16 = UTF16(std::vector<unsigned int>(lengthText / 2, 'x'), false);
+	const std::string mixedUTF16 = UTF16(RandomUnits(generator, lengthText / 2, false), false);
+	const std::string ascii(lengthText, 'x');
+	const std::string mixed = Read(mixedUTF16);
+
+	// Written in blocks of whole characters like FileStorer
+	auto blocks = [](std::string_view text) {
+		std::vector<std::string_view> pieces;
+		while (!text.empty()) {
+			size_t lenBlock = std::min(text.length(), blockSize);
+			while ((lenBlock < text.length()) && ((static_cast<unsigned char>(text[lenBlock]) & 0xC0) == 0x80))
+				lenBlock--;
+			pieces.push_back(text.substr(0, lenBlock));
+			text.remove_prefix(lenBlock);
+		}
+		return pieces;
+	};
+	const std::vector<std::string_view> asciiBlocks = blocks(ascii);
+	const std::vector<std::string_view> mixedBlocks = blocks(mixed);
+	const fs::path path = fs::temp_directory_path() / "SciTEUnitTestUtf8_16.txt";
+
+	size_t firstInvalid = 0;
+	BENCHMARK("Read 16MB of ASCII UTF-16") {
+		Read(asciiUTF16, blockSize, firstInvalid);
+	}
+	BENCHMARK("Read 16MB of mixed UTF-16") {
+		Read(mixedUTF16, blockSize, firstInvalid);
+	}
+	BENCHMARK("Write 16MB of ASCII as UTF-16") {
+		WriteFile(path, asciiBlocks, Utf8_16::eUtf16LittleEndian, firstInvalid);
+	}
+	BENCHMARK("Write 16MB of mixed text as UTF-16") {
+		WriteFile(path, mixedBlocks, Utf8_16::eUtf16LittleEndian, firstInvalid);
+	}
+	fs::remove(path);
+}
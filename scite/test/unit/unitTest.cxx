@@ -0,0 +1,44 @@
+// Unit Tests for SciTE internal data structures
+
+/*
+    Currently tested:
+        FileMapping, PropSetFile, Utf8_16_Read, Utf8_16_Write, WordIndex
+*/
+
+#include <string>
+#include <string_view>
+#include <chrono>
+
+#include "GUI.h"
+
+#if defined(__GNUC__)
+// Want to avoid misleading indentation warnings in catch.hpp but the pragma
+// may not be available so protect by turning off pragma warnings
+#pragma GCC diagnostic ignored "-Wunknown-pragmas"
+#pragma GCC diagnostic ignored "-Wpragmas"
+#if !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmisleading-indentation"
+#endif
+#endif
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+// Needed by the code being tested, normally provided by the platform layer.
+// Strings are UTF-8 on OS X and Linux.
+
+namespace GUI {
+
+gui_string StringFromUTF8(const char *s) {
+	return s ? gui_string(s) : gui_string();
+}
+
+gui_string StringFromUTF8(const std::string &s) {
+	return s;
+}
+
+std::string UTF8FromString(const gui_string &s) {
+	return s;
+}
+
+}
@@ -1316,6 +1316,11 @@ void SciTEWin::Execute() {
 	}
 }
 
+void SciTEWin::OutputTrimmed(SA::Position lengthRemoved) {
+	// Text before the start of the current command's output was removed for output.max.lines
+	cmdWorker.originalEnd = std::max<SA::Position>(cmdWorker.originalEnd - lengthRemoved, 0);
+}
+
 void SciTEWin::StopExecute() {
 	if (hWriteSubProcess && (hWriteSubProcess != INVALID_HANDLE_VALUE)) {
 		const char stop[] = "\032";
@@ -382,6 +382,7 @@ public:
 	void ShellExec(const std::string &cmd, const char *dir);
 	void Execute() override;
 	void StopExecute() override;
+	void OutputTrimmed(SA::Position lengthRemoved) override;
 	void AddCommand(const std::string &cmd, const std::string &dir, JobSubsystem jobType, const std::string &input = "", int flags = 0) override;
 
 	void PostOnMainThread(int cmd, Worker *pWorker) override;
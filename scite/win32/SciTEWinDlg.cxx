@@ -339,7 +339,7 @@ void SciTEWin::SaveAsHTML() {
 	FilePath path = ChooseSaveName(filePath.Directory(), "Export File As HTML",
 				       GUI_TEXT("Web (.html;.htm)\0*.html;*.htm\0"), ".html");
 	if (path.IsSet()) {
-		SaveToHTML(path);
+		SaveToHTML(path, sfNone);
 	}
 }
 
@@ -347,7 +347,7 @@ void SciTEWin::SaveAsRTF() {
 	FilePath path = ChooseSaveName(filePath.Directory(), "Export File As RTF",
 				       GUI_TEXT("RTF (.rtf)\0*.rtf\0"), ".rtf");
 	if (path.IsSet()) {
-		SaveToRTF(path);
+		SaveToRTF(path, 0, -1, sfNone);
 	}
 }
 
@@ -355,7 +355,7 @@ void SciTEWin::SaveAsPDF() {
 	FilePath path = ChooseSaveName(filePath.Directory(), "Export File As PDF",
 				       GUI_TEXT("PDF (.pdf)\0*.pdf\0"), ".pdf");
 	if (path.IsSet()) {
-		SaveToPDF(path);
+		SaveToPDF(path, sfNone);
 	}
 }
 
@@ -363,11 +363,14 @@ FileWorker.o: \
 	../src/FileWorker.cxx \
 	../../scintilla/include/ILoader.h \
 	../../scintilla/include/Sci_Position.h \
+	../src/ScintillaTypes.h \
+	../src/ScintillaCall.h \
 	../src/GUI.h \
 	../src/FilePath.h \
 	../src/Cookie.h \
 	../src/Worker.h \
 	../src/FileWorker.h \
+	../src/StyleWriter.h \
 	../src/Utf8_16.h
 IFaceTable.o: \
 	../src/IFaceTable.cxx \